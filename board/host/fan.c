@@ -39,11 +39,11 @@ int fan_get_enabled(int ch)
 }
 
 static int mock_percent;
-void fan_set_duty(int ch, int percent)
+test_mockable void fan_set_duty(int ch, int percent)
 {
 	mock_percent = percent;
 }
-int fan_get_duty(int ch)
+test_mockable int fan_get_duty(int ch)
 {
 	return mock_percent;
 }
@@ -63,7 +63,7 @@ void fan_set_rpm_target(int ch, int rpm)
 {
 	mock_rpm = rpm;
 }
-int fan_get_rpm_actual(int ch)
+test_mockable int fan_get_rpm_actual(int ch)
 {
 	return mock_rpm;
 }
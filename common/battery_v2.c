@@ -6,6 +6,7 @@
  */
 
 #include "battery.h"
+#include "battery_smart.h"
 #include "charge_state.h"
 #include "common.h"
 #include "console.h"
@@ -13,6 +14,8 @@
 #include "host_command.h"
 #include "math_util.h"
 #include "printf.h"
+#include "sysjump.h"
+#include "system.h"
 #include "util.h"
 
 #define CPRINTF(format, args...) cprintf(CC_CHARGER, format, ##args)
@@ -25,6 +28,85 @@
 struct battery_static_info battery_static[CONFIG_BATTERY_COUNT];
 struct ec_response_battery_dynamic_info battery_dynamic[CONFIG_BATTERY_COUNT];
 
+/* Incremented each time the main battery's static info is read */
+static uint32_t static_generation;
+
+#ifdef CONFIG_BATTERY_STATIC_INFO_CACHE
+/* Set while battery_static[BATT_IDX_MAIN] holds complete info */
+static bool static_valid;
+/* Serial number of the battery the cached info was read from */
+static int static_serial;
+
+#define BATT_STATIC_SYSJUMP_TAG 0x4253 /* "BS" */
+#define BATT_STATIC_HOOK_VERSION 1
+
+struct battery_static_state {
+	uint32_t generation;
+	int32_t serial;
+	struct battery_static_info info;
+};
+BUILD_ASSERT(sizeof(struct battery_static_state) <= JUMP_TAG_MAX_SIZE);
+
+static void battery_static_preserve(void)
+{
+	struct battery_static_state state;
+
+	if (!static_valid)
+		return;
+
+	state.generation = static_generation;
+	state.serial = static_serial;
+	state.info = battery_static[BATT_IDX_MAIN];
+	system_add_jump_tag(BATT_STATIC_SYSJUMP_TAG, BATT_STATIC_HOOK_VERSION,
+			    sizeof(state), &state);
+}
+DECLARE_HOOK(HOOK_SYSJUMP, battery_static_preserve, HOOK_PRIO_DEFAULT);
+
+/* Restore before battery_init() publishes the info in the memory map */
+static void battery_static_restore(void)
+{
+	struct battery_static_state state;
+	const uint8_t *prev;
+	int version, size;
+
+	prev = system_get_jump_tag(BATT_STATIC_SYSJUMP_TAG, &version, &size);
+	if (!prev || version != BATT_STATIC_HOOK_VERSION ||
+	    size != sizeof(state))
+		return;
+
+	memcpy(&state, prev, sizeof(state));
+	static_generation = state.generation;
+	static_serial = state.serial;
+	battery_static[BATT_IDX_MAIN] = state.info;
+	static_valid = true;
+}
+DECLARE_HOOK(HOOK_INIT, battery_static_restore, HOOK_PRIO_PRE_DEFAULT);
+
+/*
+ * Check that the cached static info belongs to the battery attached now,
+ * and refresh the cycle count, the one field that changes over its life.
+ */
+static bool static_info_is_current(void)
+{
+	int serial, val;
+
+	if (!static_valid)
+		return false;
+
+	if (battery_serial_number(&serial) || serial != static_serial ||
+	    battery_cycle_count(&val))
+		return false;
+
+	battery_static[BATT_IDX_MAIN].cycle_count = val;
+	return true;
+}
+#endif /* CONFIG_BATTERY_STATIC_INFO_CACHE */
+
+uint32_t battery_static_info_generation(void)
+{
+	return static_generation;
+}
+
 #ifdef HAS_TASK_HOSTCMD
 static void battery_update(enum battery_index i)
 {
@@ -218,6 +300,18 @@ int update_static_battery_info(void)
 
 	struct battery_static_info *const bs = &battery_static[BATT_IDX_MAIN];
 
+#ifdef CONFIG_BATTERY_STATIC_INFO_CACHE
+	if (static_info_is_current()) {
+		memset(&battery_dynamic[BATT_IDX_MAIN], 0,
+		       sizeof(battery_dynamic[BATT_IDX_MAIN]));
+#ifdef HAS_TASK_HOSTCMD
+		battery_memmap_refresh(BATT_IDX_MAIN);
+#endif
+		return EC_SUCCESS;
+	}
+	static_valid = false;
+#endif
+
 	/* Clear all static information. */
 	memset(bs, 0, sizeof(*bs));
 
@@ -256,6 +350,18 @@ int update_static_battery_info(void)
 	/* Battery Type string */
 	rv |= battery_device_chemistry(bs->type_ext, sizeof(bs->type_ext));
 
+#if defined(CONFIG_BATTERY_STATIC_INFO_CACHE) && \
+	defined(CONFIG_BATTERY_VENDOR_PARAM)
+	/*
+	 * Fetch the vendor parameters too, so they are kept with the rest.
+	 * A failure isn't fatal: battery_get_vendor_param() retries the read.
+	 */
+	if (battery_get_info()->vendor_param_start &&
+	    sb_read_string(battery_get_info()->vendor_param_start,
+			   bs->vendor_param, sizeof(bs->vendor_param)))
+		bs->vendor_param[0] = 0;
+#endif
+
 	/*
 	 * b/181639264: Battery gauge follow SMBus SPEC and SMBus define
 	 * cumulative clock low extend time for both controller (master) and
@@ -282,6 +388,14 @@ int update_static_battery_info(void)
 	memset(&battery_dynamic[BATT_IDX_MAIN], 0,
 	       sizeof(battery_dynamic[BATT_IDX_MAIN]));
 
+	static_generation++;
+#ifdef CONFIG_BATTERY_STATIC_INFO_CACHE
+	if (!rv) {
+		static_serial = batt_serial;
+		static_valid = true;
+	}
+#endif
+
 	if (rv)
 		charge_problem(PR_STATIC_UPDATE, rv);
 
@@ -318,10 +432,15 @@ void update_dynamic_battery_info(void)
 		 * Require two consecutive updates with BP_NOT_SURE
 		 * before reporting it gone to the host.
 		 */
-		if (batt_present)
+		if (batt_present) {
 			tmp |= EC_BATT_FLAG_BATT_PRESENT;
-		else if (bd->flags & EC_BATT_FLAG_BATT_PRESENT)
+		} else if (bd->flags & EC_BATT_FLAG_BATT_PRESENT) {
 			send_batt_info_event++;
+#ifdef CONFIG_BATTERY_STATIC_INFO_CACHE
+			/* The battery may come back as a different one */
+			static_valid = false;
+#endif
+		}
 		batt_present = 0;
 	}
 
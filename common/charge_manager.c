@@ -18,6 +18,7 @@
 #include "hooks.h"
 #include "host_command.h"
 #include "system.h"
+#include "task.h"
 #include "tcpm/tcpm.h"
 #include "timer.h"
 #include "typec_control.h"
@@ -85,6 +86,13 @@ BUILD_ASSERT(ARRAY_SIZE(charge_supplier_name) == CHARGE_SUPPLIER_COUNT);
 static struct charge_port_info available_charge[CHARGE_SUPPLIER_COUNT]
 					       [CHARGE_PORT_COUNT];
 
+/*
+ * Ports with a non-zero available charge, per supplier. Lets port selection
+ * skip the (mostly empty) supplier rows of available_charge.
+ */
+static atomic_t available_port_mask[CHARGE_SUPPLIER_COUNT];
+BUILD_ASSERT(CHARGE_PORT_COUNT <= 32);
+
 /* Keep track of when the supplier on each port is registered. */
 static timestamp_t registration_time[CHARGE_PORT_COUNT];
 
@@ -116,6 +124,16 @@ static int override_port = OVERRIDE_OFF;
 static int delayed_override_port = OVERRIDE_OFF;
 static timestamp_t delayed_override_deadline;
 
+/*
+ * Refresh coalescing state, requested from several tasks, so kept under
+ * refresh_lock, and statistics.
+ */
+static bool refresh_pending;
+static uint32_t refresh_deadline;
+static K_MUTEX_DEFINE(refresh_lock);
+static atomic_t refresh_requests;
+static struct charge_manager_refresh_stats refresh_stats;
+
 /* Source-out Rp values for TCPMv1 */
 __maybe_unused static uint8_t source_port_rp[CONFIG_USB_PD_PORT_MAX_COUNT];
 
@@ -216,6 +234,22 @@ static int charge_manager_spoof_dualrole_capability(void)
 }
 #endif /* !CONFIG_CHARGE_MANAGER_DRP_CHARGING */
 
+/**
+ * Set available charge for a port / supplier and keep available_port_mask in
+ * sync with it.
+ */
+static void set_available_charge(int supplier, int port, int current,
+				 int voltage)
+{
+	available_charge[supplier][port].current = current;
+	available_charge[supplier][port].voltage = voltage;
+
+	if (current != 0 && voltage != 0)
+		atomic_or(&available_port_mask[supplier], BIT(port));
+	else
+		atomic_clear_bits(&available_port_mask[supplier], BIT(port));
+}
+
 /**
  * Initialize available charge. Run before board init, so board init can
  * initialize data, if needed.
@@ -227,12 +261,9 @@ static void charge_manager_init(void)
 	for (i = 0; i < CHARGE_PORT_COUNT; ++i) {
 		if (!is_valid_port(i))
 			continue;
-		for (j = 0; j < CHARGE_SUPPLIER_COUNT; ++j) {
-			available_charge[j][i].current =
-				CHARGE_CURRENT_UNINITIALIZED;
-			available_charge[j][i].voltage =
-				CHARGE_VOLTAGE_UNINITIALIZED;
-		}
+		for (j = 0; j < CHARGE_SUPPLIER_COUNT; ++j)
+			set_available_charge(j, i, CHARGE_CURRENT_UNINITIALIZED,
+					     CHARGE_VOLTAGE_UNINITIALIZED);
 		for (j = 0; j < CEIL_REQUESTOR_COUNT; ++j)
 			charge_ceil[i][j] = CHARGE_CEIL_NONE;
 		if (!is_pd_port(i))
@@ -538,9 +569,7 @@ charge_manager_fill_power_info(int port,
 			 * DPS enabled. This is to prevent the system think it's
 			 * using a low power charger.
 			 */
-			pd_find_pdo_index(pd_get_src_cap_cnt(port),
-					  pd_get_src_caps(port),
-					  pd_get_max_voltage(), &pdo);
+			pd_get_best_pdo(port, pd_get_max_voltage(), &pdo);
 			pd_extract_pdo_power(pdo, &max_ma, &max_mv, &unused);
 		} else {
 			max_mv = available_charge[sup][port].voltage;
@@ -696,7 +725,16 @@ static void charge_manager_get_best_port(int *new_port, int *new_supplier)
 	 * so make no assumptions about its consistency.
 	 */
 	for (i = 0; i < CHARGE_SUPPLIER_COUNT; ++i) {
+		uint32_t port_mask = available_port_mask[i];
+
+		/* Nothing is offered by this supplier on any port. */
+		if (!port_mask)
+			continue;
+
 		for (j = 0; j < CHARGE_PORT_COUNT; ++j) {
+			if (!(port_mask & BIT(j)))
+				continue;
+
 			/* Skip this port if it is not valid. */
 			if (!is_valid_port(j))
 				continue;
@@ -788,10 +826,9 @@ static void charge_manager_get_best_port(int *new_port, int *new_supplier)
 }
 
 /**
- * Charge manager refresh -- responsible for selecting the active charge port
- * and charge power. Called as a deferred task.
+ * Select the active charge port and charge power.
  */
-static void charge_manager_refresh(void)
+static void charge_manager_select_port(void)
 {
 	/* Always initialize charge port on first pass */
 	static int active_charge_port_initialized;
@@ -845,10 +882,8 @@ static void charge_manager_refresh(void)
 		 * available charge on the rejected port so that it is no longer
 		 * chosen.
 		 */
-		for (i = 0; i < CHARGE_SUPPLIER_COUNT; ++i) {
-			available_charge[i][new_port].current = 0;
-			available_charge[i][new_port].voltage = 0;
-		}
+		for (i = 0; i < CHARGE_SUPPLIER_COUNT; ++i)
+			set_available_charge(i, new_port, 0, 0);
 	}
 
 	active_charge_port_initialized = 1;
@@ -1011,10 +1046,8 @@ static void charge_manager_refresh(void)
 				 * Check if we can get more power from this
 				 * port. If yes, send new power request
 				 */
-				pd_find_pdo_index(
-					pd_get_src_cap_cnt(updated_new_port),
-					pd_get_src_caps(updated_new_port),
-					pd_get_max_voltage(), &pdo);
+				pd_get_best_pdo(updated_new_port,
+						pd_get_max_voltage(), &pdo);
 				pd_extract_pdo_power(pdo, &max_current,
 						     &max_voltage, &unused);
 
@@ -1042,8 +1075,71 @@ static void charge_manager_refresh(void)
 		pd_send_host_event(PD_EVENT_POWER_CHANGE);
 	}
 }
+
+/**
+ * Charge manager refresh -- responsible for selecting the active charge port
+ * and charge power. Called as a deferred task.
+ */
+static void charge_manager_refresh(void)
+{
+	int old_port = charge_port;
+	int old_supplier = charge_supplier;
+	timestamp_t start = get_time();
+	uint32_t duration;
+
+	/* Requests made from here on need another refresh */
+	mutex_lock(&refresh_lock);
+	refresh_pending = false;
+	mutex_unlock(&refresh_lock);
+
+	charge_manager_select_port();
+
+	duration = time_since32(start);
+	refresh_stats.refreshes++;
+	if (charge_port != old_port || charge_supplier != old_supplier)
+		refresh_stats.port_changes++;
+	refresh_stats.last_time_us = start.le.lo;
+	refresh_stats.last_duration_us = duration;
+	refresh_stats.max_duration_us =
+		MAX(refresh_stats.max_duration_us, duration);
+}
 DECLARE_DEFERRED(charge_manager_refresh);
 
+/**
+ * Schedule a charge manager refresh.
+ *
+ * Requests arriving while a refresh is pending are folded into it. The
+ * pending refresh runs at most window_ms after the earliest request, and is
+ * never pushed out by later requests.
+ *
+ * @param window_ms	Maximum time to wait for further requests.
+ */
+static void charge_manager_request_refresh(int window_ms)
+{
+	uint32_t now, deadline;
+	int32_t delay;
+
+	atomic_add(&refresh_requests, 1);
+
+	mutex_lock(&refresh_lock);
+	now = get_time().le.lo;
+	deadline = now + window_ms * MSEC;
+	if (!refresh_pending || (int32_t)(deadline - refresh_deadline) < 0)
+		refresh_deadline = deadline;
+	refresh_pending = true;
+
+	delay = (int32_t)(refresh_deadline - now);
+	hook_call_deferred(&charge_manager_refresh_data, MAX(delay, 0));
+	mutex_unlock(&refresh_lock);
+}
+
+void charge_manager_get_refresh_stats(
+	struct charge_manager_refresh_stats *stats)
+{
+	*stats = refresh_stats;
+	stats->requests = refresh_requests;
+}
+
 /**
  * Called when charge override times out waiting for power swap.
  */
@@ -1140,8 +1236,8 @@ static void charge_manager_make_change(enum charge_manager_change_type change,
 	}
 
 	if (change == CHANGE_CHARGE) {
-		available_charge[supplier][port].current = charge->current;
-		available_charge[supplier][port].voltage = charge->voltage;
+		set_available_charge(supplier, port, charge->current,
+				     charge->voltage);
 		registration_time[port] = get_time();
 
 		/*
@@ -1176,7 +1272,8 @@ static void charge_manager_make_change(enum charge_manager_change_type change,
 	 * attached.
 	 */
 	if (charge_manager_is_seeded())
-		hook_call_deferred(&charge_manager_refresh_data, 0);
+		charge_manager_request_refresh(
+			CONFIG_CHARGE_MANAGER_REFRESH_WINDOW_MS);
 }
 
 void pd_set_input_current_limit(int port, uint32_t max_ma,
@@ -1292,7 +1389,7 @@ void charge_manager_leave_safe_mode(void)
 	CPRINTS("%s()", __func__);
 	left_safe_mode = 1;
 	if (charge_manager_is_seeded())
-		hook_call_deferred(&charge_manager_refresh_data, 0);
+		charge_manager_request_refresh(0);
 }
 #endif
 
@@ -1304,7 +1401,7 @@ void charge_manager_set_ceil(int port, enum ceil_requestor requestor, int ceil)
 	if (charge_ceil[port][requestor] != ceil) {
 		charge_ceil[port][requestor] = ceil;
 		if (port == charge_port && charge_manager_is_seeded())
-			hook_call_deferred(&charge_manager_refresh_data, 0);
+			charge_manager_request_refresh(0);
 	}
 }
 
@@ -1360,8 +1457,7 @@ int charge_manager_set_override(int port)
 		if (override_port != port) {
 			override_port = port;
 			if (charge_manager_is_seeded())
-				hook_call_deferred(&charge_manager_refresh_data,
-						   0);
+				charge_manager_request_refresh(0);
 		}
 	}
 	/*
@@ -1708,6 +1804,7 @@ DECLARE_CONSOLE_COMMAND(chglim, command_external_power_limit,
 #ifdef CONFIG_CMD_CHARGE_SUPPLIER_INFO
 static int charge_supplier_info(int argc, const char **argv)
 {
+	struct charge_manager_refresh_stats stats;
 	int p, s;
 	int port_printed;
 
@@ -1739,6 +1836,13 @@ static int charge_supplier_info(int argc, const char **argv)
 	ccprintf("\n");
 	ccprintf("  %s safe mode\n", left_safe_mode ? "Left" : "In");
 	ccprintf("  Override port = P%d\n", charge_manager_get_override());
+	charge_manager_get_refresh_stats(&stats);
+	ccprintf("  Refresh: %u requested, %u run, %u port changes\n",
+		 stats.requests, stats.refreshes, stats.port_changes);
+	if (stats.refreshes)
+		ccprintf("  Last refresh %u us ago, took %u us (max %u us)\n",
+			 get_time().le.lo - stats.last_time_us,
+			 stats.last_duration_us, stats.max_duration_us);
 	ccprintf("\n");
 	return 0;
 }
@@ -51,6 +51,24 @@ test_mockable int chg_ramp_allowed(int port, int supplier)
 	return 0;
 }
 
+__overridable int chg_ramp_search_allowed(int port, int supplier)
+{
+	switch (supplier) {
+#ifdef CONFIG_USB_CHARGER
+	/*
+	 * These may be anything from a weak phone charger to a 2.4A+ brick,
+	 * so there is a lot of range to cover.
+	 */
+	case CHARGE_SUPPLIER_BC12_DCP:
+	case CHARGE_SUPPLIER_PROPRIETARY:
+	case CHARGE_SUPPLIER_OTHER:
+		return 1;
+#endif
+	default:
+		return 0;
+	}
+}
+
 test_mockable int chg_ramp_max(int port, int supplier, int sup_curr)
 {
 	switch (supplier) {
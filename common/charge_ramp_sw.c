@@ -11,6 +11,8 @@
 #include "common.h"
 #include "console.h"
 #include "ec_commands.h"
+#include "host_command.h"
+#include "ring_log.h"
 #include "task.h"
 #include "timer.h"
 #include "usb_pd.h"
@@ -77,9 +79,138 @@ static int stablize_sup;
 static int max_icl;
 static int min_icl;
 
+#ifdef CONFIG_CHARGE_RAMP_SEARCH
+/*
+ * Binary search state. The limits tried are min_icl plus a multiple of
+ * RAMP_CURR_INCR_MA, capped at max_icl, and are numbered by that multiple.
+ * search_lo is the highest step known to keep VBUS up, search_hi the highest
+ * step that isn't known to bring it down.
+ */
+enum search_limit {
+	SEARCH_LIMIT_NONE,
+	SEARCH_LIMIT_VBUS,
+	SEARCH_LIMIT_OC,
+};
+static bool searching;
+static int search_lo;
+static int search_hi;
+static int search_probe;
+static enum search_limit search_limit;
+#endif
+
+#ifdef CONFIG_CHARGE_RAMP_HISTORY
+static struct ec_chg_ramp_history_entry
+	history[CONFIG_USB_PD_PORT_MAX_COUNT][CONFIG_CHARGE_RAMP_HISTORY_SIZE];
+static atomic_t history_next[CONFIG_USB_PD_PORT_MAX_COUNT];
+
+#define HISTORY(port) RING_LOG(history[port], &history_next[port])
+#endif
+
+/* Current ramp, for the history */
+static bool ramping;
+static timestamp_t ramp_start_time;
+static enum ec_chg_ramp_method ramp_method;
+static int ramp_steps;
+
+static void ramp_done(enum ec_chg_ramp_result result, int icl)
+{
+#ifdef CONFIG_CHARGE_RAMP_HISTORY
+	struct ec_chg_ramp_history_entry *e;
+#endif
+	timestamp_t now = get_time();
+
+	/* A limit taken from the overcurrent history needs no ramp */
+	if (!ramping) {
+		ramp_start_time = now;
+		ramp_steps = 0;
+	}
+	ramping = false;
+	CPRINTS("Ramp done: %dmA in %d steps, %d ms", icl, ramp_steps,
+		(int)((now.val - ramp_start_time.val) / MSEC));
+
+#ifdef CONFIG_CHARGE_RAMP_HISTORY
+	if (active_port < 0 || active_port >= board_get_usb_pd_port_count())
+		return;
+
+	e = ring_log_append(&HISTORY(active_port));
+	e->time_us = ramp_start_time.le.lo;
+	e->duration_ms = (now.val - ramp_start_time.val) / MSEC;
+	e->icl_ma = MAX(icl, 0);
+	e->max_ma = MAX(max_icl, 0);
+	e->supplier = active_sup;
+	e->method = ramp_method;
+	e->result = result;
+	e->steps = MIN(ramp_steps, UINT8_MAX);
+#endif
+}
+
+#ifdef CONFIG_CHARGE_RAMP_SEARCH
+static int search_step_icl(int step)
+{
+	return MIN(min_icl + step * RAMP_CURR_INCR_MA, max_icl);
+}
+
+/*
+ * Start searching between min_icl and max_icl, below any limit that made
+ * this charger shut down recently.
+ *
+ * @return the first limit to try
+ */
+static int search_start(void)
+{
+	const struct oc_info *oc;
+	int i;
+
+	search_lo = 0;
+	search_hi = DIV_ROUND_UP(max_icl - min_icl, RAMP_CURR_INCR_MA);
+	search_limit = SEARCH_LIMIT_NONE;
+	for (i = 0; i < RAMP_COUNT; i++) {
+		oc = &oc_info[active_port][i];
+		if (!oc->oc_detected || oc->sup != active_sup ||
+		    oc->icl <= min_icl)
+			continue;
+		if ((oc->icl - min_icl - 1) / RAMP_CURR_INCR_MA < search_hi) {
+			search_hi = (oc->icl - min_icl - 1) / RAMP_CURR_INCR_MA;
+			search_limit = SEARCH_LIMIT_OC;
+		}
+	}
+
+	searching = search_hi > 0;
+	search_probe = (search_lo + search_hi + 1) / 2;
+
+	return search_step_icl(search_probe);
+}
+#endif
+
+/*
+ * Start a ramp for the active charger.
+ *
+ * @return the first input current limit to try
+ */
+static int ramp_start(void)
+{
+	ramping = true;
+	ramp_start_time = get_time();
+	ramp_steps = 1;
+	ramp_method = EC_CHG_RAMP_METHOD_LINEAR;
+
+#ifdef CONFIG_CHARGE_RAMP_SEARCH
+	searching = false;
+	if (chg_ramp_search_allowed(active_port, active_sup)) {
+		ramp_method = EC_CHG_RAMP_METHOD_SEARCH;
+		return search_start();
+	}
+#endif
+	return min_icl;
+}
+
 void chg_ramp_charge_supplier_change(int port, int supplier, int current,
 				     timestamp_t registration_time, int voltage)
 {
+	/* A supplier change while ramping ends the ramp */
+	if (ramp_st == CHG_RAMP_RAMP && ramping)
+		ramp_done(EC_CHG_RAMP_RESULT_INTERRUPTED, active_icl);
+
 	/*
 	 * If the last active port was a valid port and the port
 	 * has changed, then this may have been an over-current.
@@ -250,12 +381,15 @@ void chg_ramp_task(void *u)
 				active_icl_new =
 					ACTIVE_OC_INFO.icl - RAMP_ICL_BACKOFF;
 				ramp_st_new = CHG_RAMP_STABLE;
+				ramp_done(EC_CHG_RAMP_RESULT_OVERCURRENT,
+					  active_icl_new);
 			} else {
 				/*
 				 * Need to ramp to find OC threshold, start
-				 * at the minimum input current limit.
+				 * at the minimum input current limit, or in
+				 * the middle of the range when searching.
 				 */
-				active_icl_new = min_icl;
+				active_icl_new = ramp_start();
 				ramp_st_new = CHG_RAMP_RAMP;
 			}
 			break;
@@ -265,10 +399,75 @@ void chg_ramp_task(void *u)
 
 			/* Pause ramping if we are not drawing full current */
 			if (!charge_is_consuming_full_input_current()) {
+#ifdef CONFIG_CHARGE_RAMP_SEARCH
+				/*
+				 * The load doesn't need the limit being
+				 * tried, so searching higher tells us
+				 * nothing. Step up from here as the load
+				 * grows instead.
+				 */
+				searching = false;
+#endif
 				task_wait_time = CURRENT_DRAW_DELAY;
 				break;
 			}
 
+#ifdef CONFIG_CHARGE_RAMP_SEARCH
+			if (searching) {
+				if (board_is_vbus_too_low(
+					    active_port,
+					    CHG_RAMP_VBUS_RAMPING)) {
+					search_hi = search_probe - 1;
+					search_limit = SEARCH_LIMIT_VBUS;
+				} else {
+					search_lo = search_probe;
+				}
+
+				if (search_lo < search_hi) {
+					search_probe =
+						(search_lo + search_hi + 1) / 2;
+					active_icl_new =
+						search_step_icl(search_probe);
+					ramp_steps++;
+					break;
+				}
+
+				searching = false;
+				if (search_limit == SEARCH_LIMIT_VBUS) {
+					/*
+					 * Back off from the lowest limit
+					 * that made VBUS droop, as stepping
+					 * up does.
+					 */
+					CPRINTS("VBUS low");
+					active_icl_new = MAX(
+						min_icl,
+						search_step_icl(search_lo + 1) -
+							RAMP_ICL_BACKOFF);
+					ramp_st_new = CHG_RAMP_STABILIZE;
+					task_wait_time = STABLIZE_DELAY;
+					stablize_port = active_port;
+					stablize_sup = active_sup;
+					ramp_done(EC_CHG_RAMP_RESULT_VBUS_LOW,
+						  active_icl_new);
+				} else if (search_limit == SEARCH_LIMIT_OC) {
+					active_icl_new =
+						search_step_icl(search_lo);
+					ramp_st_new = CHG_RAMP_STABLE;
+					ramp_done(
+						EC_CHG_RAMP_RESULT_OVERCURRENT,
+						active_icl_new);
+				} else {
+					active_icl_new =
+						search_step_icl(search_lo);
+					ramp_st_new = CHG_RAMP_STABLE;
+					ramp_done(EC_CHG_RAMP_RESULT_MAX,
+						  active_icl_new);
+				}
+				break;
+			}
+#endif
+
 			/* If VBUS is sagging a lot, then stop ramping */
 			if (board_is_vbus_too_low(active_port,
 						  CHG_RAMP_VBUS_RAMPING)) {
@@ -279,16 +478,22 @@ void chg_ramp_task(void *u)
 				task_wait_time = STABLIZE_DELAY;
 				stablize_port = active_port;
 				stablize_sup = active_sup;
+				ramp_done(EC_CHG_RAMP_RESULT_VBUS_LOW,
+					  active_icl_new);
 				break;
 			}
 
 			/* Ramp the current limit if we haven't reached max */
-			if (active_icl == max_icl)
+			if (active_icl == max_icl) {
 				ramp_st_new = CHG_RAMP_STABLE;
-			else if (active_icl + RAMP_CURR_INCR_MA > max_icl)
+				ramp_done(EC_CHG_RAMP_RESULT_MAX, active_icl);
+			} else if (active_icl + RAMP_CURR_INCR_MA > max_icl) {
 				active_icl_new = max_icl;
-			else
+				ramp_steps++;
+			} else {
 				active_icl_new = active_icl + RAMP_CURR_INCR_MA;
+				ramp_steps++;
+			}
 			break;
 		case CHG_RAMP_STABILIZE:
 			/* Wait for current to stabilize after ramp is done */
@@ -322,7 +527,7 @@ void chg_ramp_task(void *u)
 				CPRINTS("VBUS low; Re-ramp");
 				max_icl = MAX(min_icl,
 					      max_icl - RAMP_ICL_BACKOFF);
-				active_icl_new = min_icl;
+				active_icl_new = ramp_start();
 				ramp_st_new = CHG_RAMP_RAMP;
 			}
 			task_wait_time = STABLE_VBUS_MONITOR_INTERVAL;
@@ -356,7 +561,63 @@ void chg_ramp_task(void *u)
 	}
 }
 
+#ifdef CONFIG_CHARGE_RAMP_HISTORY
+static enum ec_status hc_chg_ramp_history(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_chg_ramp_history *p = args->params;
+	struct ec_response_chg_ramp_history *r = args->response;
+	uint32_t first, total;
+	int count;
+
+	if (p->port >= board_get_usb_pd_port_count())
+		return EC_RES_INVALID_PARAM;
+
+	if (p->flags & EC_CHG_RAMP_HISTORY_FLAG_CLEAR) {
+		ring_log_clear(&HISTORY(p->port));
+		args->response_size = 0;
+		return EC_RES_SUCCESS;
+	}
+
+	count = ring_log_host_read(&HISTORY(p->port), args, sizeof(*r),
+				   p->offset, &first, &total);
+	if (count < 0)
+		return -count;
+
+	r->first = first;
+	r->total = total;
+	r->count = count;
+	r->reserved = 0;
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_CHG_RAMP_HISTORY, hc_chg_ramp_history,
+		     EC_VER_MASK(0));
+#endif
+
 #ifdef CONFIG_CMD_CHGRAMP
+#ifdef CONFIG_CHARGE_RAMP_HISTORY
+static void print_history(int port)
+{
+	static const char *const result_names[] = {
+		[EC_CHG_RAMP_RESULT_MAX] = "max",
+		[EC_CHG_RAMP_RESULT_VBUS_LOW] = "vbus_low",
+		[EC_CHG_RAMP_RESULT_OVERCURRENT] = "oc",
+		[EC_CHG_RAMP_RESULT_INTERRUPTED] = "interrupted",
+	};
+	struct ec_chg_ramp_history_entry e;
+	uint32_t i;
+
+	for (i = 0; ring_log_read(&HISTORY(port), i, &e, 1, NULL, NULL); i++) {
+		ccprintf("  Ramp %u: s%d %s %dmA/%dmA %s, %d steps, %u ms\n", i,
+			 e.supplier,
+			 e.method == EC_CHG_RAMP_METHOD_SEARCH ? "search" :
+								 "linear",
+			 e.icl_ma, e.max_ma, result_names[e.result], e.steps,
+			 e.duration_ms);
+	}
+}
+#endif
+
 static int command_chgramp(int argc, const char **argv)
 {
 	int i;
@@ -374,6 +635,9 @@ static int command_chgramp(int argc, const char **argv)
 				 oc_info[port][i].oc_detected,
 				 oc_info[port][i].icl);
 		}
+#ifdef CONFIG_CHARGE_RAMP_HISTORY
+		print_history(port);
+#endif
 	}
 
 	return EC_SUCCESS;
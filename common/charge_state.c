@@ -87,6 +87,12 @@ static struct current_limit {
 	uint32_t value; /* Charge limit to apply, in mA */
 	int soc; /* Minimum battery SoC at which the limit will be applied. */
 } current_limit = { -1U, 0 };
+static struct charge_loop_stats loop_stats;
+
+/* Task events, one per enum charge_wakeup_reason */
+#define CHARGE_EVENT(reason) (TASK_EVENT_CUSTOM_BIT(0) << (reason))
+#define CHARGE_EVENT_ALL (CHARGE_EVENT(CHARGE_WAKEUP_COUNT) - 1)
+BUILD_ASSERT(CHARGE_WAKEUP_COUNT <= 16);
 
 /* State which is reported out from the charger or updated externally */
 struct state {
@@ -225,6 +231,13 @@ static void battery_sustainer_disable(void)
 static const char *const state_list[] = { "idle", "discharge", "charge",
 					  "precharge" };
 BUILD_ASSERT(ARRAY_SIZE(state_list) == CHARGE_STATE_COUNT);
+static const char *const wakeup_list[] = {
+	"generic",
+	"ac",
+	"supply",
+	"chipset",
+};
+BUILD_ASSERT(ARRAY_SIZE(wakeup_list) == CHARGE_WAKEUP_COUNT);
 static const char *const batt_pres[] = {
 	"NO",
 	"YES",
@@ -311,6 +324,16 @@ static void dump_charge_state(void)
 	ccprintf("Battery sustainer = %s (%d%% ~ %d%%)\n",
 		 battery_sustainer_enabled() ? "on" : "off", sustain_soc.lower,
 		 sustain_soc.upper);
+	cflush();
+	ccprintf("poll period = %dms\n", loop_stats.sleep_usec / MSEC);
+	ccprintf("wakeups: timer=%u", loop_stats.timer_wakeups);
+	for (int i = 0; i < CHARGE_WAKEUP_COUNT; i++)
+		ccprintf(" %s=%u", wakeup_list[i], loop_stats.wakeups[i]);
+	ccprintf("\nloops/i2c:");
+	for (int i = 0; i < CHARGE_STATE_COUNT; i++)
+		ccprintf(" %s=%u/%u", state_list[i], loop_stats.loops[i],
+			 loop_stats.i2c_xfers[i]);
+	ccprintf("\n");
 #undef DUMP
 }
 
@@ -1007,13 +1030,38 @@ void charger_init(void)
 }
 DECLARE_HOOK(HOOK_INIT, charger_init, HOOK_PRIO_DEFAULT);
 
+void charge_wakeup_for(enum charge_wakeup_reason reason)
+{
+	task_set_event(TASK_ID_CHARGER, CHARGE_EVENT(reason));
+}
+
 void charge_wakeup(void)
 {
-	task_wake(TASK_ID_CHARGER);
+	charge_wakeup_for(CHARGE_WAKEUP_GENERIC);
+}
+
+static void charge_wakeup_chipset(void)
+{
+	charge_wakeup_for(CHARGE_WAKEUP_CHIPSET);
 }
-DECLARE_HOOK(HOOK_CHIPSET_RESUME, charge_wakeup, HOOK_PRIO_DEFAULT);
-DECLARE_HOOK(HOOK_AC_CHANGE, charge_wakeup, HOOK_PRIO_DEFAULT);
-DECLARE_HOOK(HOOK_POWER_SUPPLY_CHANGE, charge_wakeup, HOOK_PRIO_DEFAULT);
+DECLARE_HOOK(HOOK_CHIPSET_RESUME, charge_wakeup_chipset, HOOK_PRIO_DEFAULT);
+#ifdef CONFIG_CHARGE_STATE_ADAPTIVE_POLL
+/* The AC idle poll period depends on the chipset state */
+DECLARE_HOOK(HOOK_CHIPSET_SUSPEND, charge_wakeup_chipset, HOOK_PRIO_DEFAULT);
+#endif
+
+static void charge_wakeup_ac_change(void)
+{
+	charge_wakeup_for(CHARGE_WAKEUP_AC_CHANGE);
+}
+DECLARE_HOOK(HOOK_AC_CHANGE, charge_wakeup_ac_change, HOOK_PRIO_DEFAULT);
+
+static void charge_wakeup_power_supply(void)
+{
+	charge_wakeup_for(CHARGE_WAKEUP_POWER_SUPPLY);
+}
+DECLARE_HOOK(HOOK_POWER_SUPPLY_CHANGE, charge_wakeup_power_supply,
+	     HOOK_PRIO_DEFAULT);
 
 #ifdef CONFIG_THROTTLE_AP_ON_BAT_VOLTAGE
 static void bat_low_voltage_throttle_reset(void)
@@ -1081,6 +1129,11 @@ __test_only enum charge_state charge_get_state(void)
 	return curr.state;
 }
 
+__test_only const struct charge_loop_stats *charge_get_loop_stats(void)
+{
+	return &loop_stats;
+}
+
 static void deep_charge_battery(int *need_static)
 {
 	if ((curr.state == ST_IDLE) &&
@@ -1420,6 +1473,31 @@ static void adjust_requested_vi(const struct charger_info *const info,
 	}
 }
 
+/*
+ * Poll period while AC is present, for CONFIG_CHARGE_STATE_ADAPTIVE_POLL.
+ * Nothing needs regulating when the battery is full or not being charged, and
+ * the charge current barely moves during constant current charging. During the
+ * constant voltage taper the current falls steadily, so keep watching closely.
+ */
+static int adaptive_poll_period(void)
+{
+	if (curr.state == ST_IDLE || curr.state == ST_DISCHARGE ||
+	    local_state.is_full) {
+		if (chipset_in_state(CHIPSET_STATE_ANY_OFF |
+				     CHIPSET_STATE_ANY_SUSPEND))
+			return CHARGE_POLL_PERIOD_AC_IDLE_SUSPEND;
+		return CHARGE_POLL_PERIOD_AC_IDLE;
+	}
+
+	/* OCPC runs its control loop on every pass */
+	if (!IS_ENABLED(CONFIG_OCPC) && curr.state == ST_CHARGE &&
+	    !(curr.batt.flags & BATT_FLAG_BAD_VOLTAGE) &&
+	    curr.batt.voltage + CHARGE_CV_MARGIN_MV < curr.requested_voltage)
+		return CHARGE_POLL_PERIOD_CC;
+
+	return CHARGE_POLL_PERIOD_CHARGE;
+}
+
 /* Calculate the sleep duration, before we run around the task loop again */
 int calculate_sleep_dur(int battery_critical, int sleep_usec)
 {
@@ -1447,6 +1525,9 @@ int calculate_sleep_dur(int battery_critical, int sleep_usec)
 			else
 				/* Discharging, not too urgent */
 				sleep_usec = CHARGE_POLL_PERIOD_LONG;
+		} else if (IS_ENABLED(CONFIG_CHARGE_STATE_ADAPTIVE_POLL) &&
+			   curr.ac) {
+			sleep_usec = adaptive_poll_period();
 		} else {
 			/* AC present, so pay closer attention */
 			sleep_usec = CHARGE_POLL_PERIOD_CHARGE;
@@ -1471,6 +1552,35 @@ int calculate_sleep_dur(int battery_critical, int sleep_usec)
 	return sleep_usec;
 }
 
+/*
+ * Wait for an event for up to sleep_usec. With CONFIG_OCPC_LOOP_PERIOD_MS,
+ * step the OCPC loop at its own period meanwhile. It runs in this task, like
+ * the rest of the charge loop, since it updates curr.ocpc and the chargers.
+ */
+static uint32_t charge_wait_event(int sleep_usec)
+{
+#if defined(CONFIG_OCPC) && CONFIG_OCPC_LOOP_PERIOD_MS > 0
+	uint64_t deadline = get_time().val + sleep_usec;
+	uint32_t evt;
+	int next, rv;
+
+	while ((next = ocpc_loop_next_us()) >= 0 &&
+	       next < (int64_t)(deadline - get_time().val)) {
+		if (next > 0) {
+			evt = task_wait_event(next);
+			if (evt != TASK_EVENT_TIMER)
+				return evt;
+		}
+		rv = ocpc_loop_tick(&curr.desired_input_current, &curr.ocpc);
+		if (rv != EC_SUCCESS && rv != EC_ERROR_INVAL)
+			charge_problem(PR_CFG_SEC_CHG, rv);
+	}
+	sleep_usec = MAX((int64_t)(deadline - get_time().val),
+			 CHARGE_MIN_SLEEP_USEC);
+#endif
+	return task_wait_event(sleep_usec);
+}
+
 /* check external power and set curr.ac */
 static void check_extpower(int chgnum)
 {
@@ -1530,6 +1640,8 @@ void charger_task(void *u)
 	bool is_full = false; /* battery not accepting current */
 	bool prev_full = false;
 	int prev_bf = 0;
+	uint32_t i2c_start;
+	uint32_t evt;
 
 	/* Set up the task - note that charger_init() has already run. */
 	charger_setup(info);
@@ -1537,6 +1649,9 @@ void charger_task(void *u)
 	while (1) {
 		/* Let's see what's going on... */
 		curr.ts = get_time();
+		i2c_start = IS_ENABLED(CONFIG_I2C_CONTROLLER) ?
+				    i2c_get_xfer_count() :
+				    0;
 		sleep_usec = 0;
 		problems_exist = 0;
 		battery_critical = 0;
@@ -1592,7 +1707,23 @@ void charger_task(void *u)
 		local_state.is_full = is_full;
 
 		sleep_usec = calculate_sleep_dur(battery_critical, sleep_usec);
-		task_wait_event(sleep_usec);
+
+		/* Other tasks' transactions in the meantime are counted too */
+		loop_stats.loops[curr.state]++;
+		if (IS_ENABLED(CONFIG_I2C_CONTROLLER))
+			loop_stats.i2c_xfers[curr.state] +=
+				i2c_get_xfer_count() - i2c_start;
+		loop_stats.sleep_usec = sleep_usec;
+
+		evt = charge_wait_event(sleep_usec);
+		if (evt & TASK_EVENT_TIMER)
+			loop_stats.timer_wakeups++;
+		for (int i = 0; i < CHARGE_WAKEUP_COUNT; i++)
+			if (evt & CHARGE_EVENT(i))
+				loop_stats.wakeups[i]++;
+		/* Plain task_wake() from board code */
+		if (!(evt & (TASK_EVENT_TIMER | CHARGE_EVENT_ALL)))
+			loop_stats.wakeups[CHARGE_WAKEUP_GENERIC]++;
 	}
 }
 
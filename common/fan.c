@@ -51,6 +51,25 @@ void fan_set_count(int count)
 	fan_count = count;
 }
 
+/* Set the RPM the fan should run at, through the PID loop if it drives it */
+static void set_rpm_target(int fan, int rpm)
+{
+	if (IS_ENABLED(CONFIG_FAN_PID_CONTROL) &&
+	    is_thermal_control_enabled(fan))
+		fan_pid_set_target(fan, rpm);
+	else
+		fan_set_rpm_target(FAN_CH(fan), rpm);
+}
+
+static int get_rpm_target(int fan)
+{
+	if (IS_ENABLED(CONFIG_FAN_PID_CONTROL) &&
+	    is_thermal_control_enabled(fan))
+		return fan_pid_get_target(fan);
+
+	return fan_get_rpm_target(FAN_CH(fan));
+}
+
 #ifndef CONFIG_FAN_RPM_CUSTOM
 /* This is the default implementation. It's only called over [0,100].
  * Convert the percentage to a target RPM. We can't simply scale all
@@ -78,7 +97,7 @@ int temp_ratio_to_rpm_hysteresis(const struct fan_step_1_1 *fan_table,
 				 int temp_ratio, void (*on_change)(void))
 {
 	static int previous_temp_ratio;
-	const int previous_rpm = fan_get_rpm_target(FAN_CH(fan_index));
+	const int previous_rpm = get_rpm_target(fan_index);
 	int rpm;
 
 	if (temp_ratio <= fan_table[0].decreasing_temp_ratio_threshold) {
@@ -156,7 +175,7 @@ test_mockable void fan_set_percent_needed(int fan, int pct)
 	    new_rpm < fans[fan].rpm->rpm_start)
 		new_rpm = fans[fan].rpm->rpm_start;
 
-	fan_set_rpm_target(FAN_CH(fan), new_rpm);
+	set_rpm_target(fan, new_rpm);
 }
 
 static void set_enabled(int fan, int enable)
@@ -171,6 +190,12 @@ test_export_static void set_thermal_control_enabled(int fan, int enable)
 {
 	thermal_control_enabled[fan] = enable;
 
+	if (IS_ENABLED(CONFIG_FAN_PID_CONTROL)) {
+		/* The control loop drives the duty cycle itself */
+		fan_pid_enable(fan, enable);
+		return;
+	}
+
 	/* If controlling the fan, need it in RPM-control mode */
 	if (enable)
 		fan_set_rpm_mode(FAN_CH(fan), 1);
@@ -248,8 +273,7 @@ static int cc_faninfo(int argc, const char **argv)
 			ccprintf("\n");
 		ccprintf("%sActual: %4d rpm\n", leader,
 			 fan_get_rpm_actual(FAN_CH(fan)));
-		ccprintf("%sTarget: %4d rpm\n", leader,
-			 fan_get_rpm_target(FAN_CH(fan)));
+		ccprintf("%sTarget: %4d rpm\n", leader, get_rpm_target(fan));
 		ccprintf("%sDuty:   %d%%\n", leader, fan_get_duty(FAN_CH(fan)));
 		tmp = fan_get_status(FAN_CH(fan));
 		ccprintf("%sStatus: %d (%s)\n", leader, tmp, human_status[tmp]);
@@ -263,6 +287,8 @@ static int cc_faninfo(int argc, const char **argv)
 		if (is_pgood >= 0)
 			ccprintf("%sPower:  %s\n", leader,
 				 is_pgood ? "yes" : "no");
+		if (IS_ENABLED(CONFIG_FAN_PID_CONTROL))
+			fan_pid_print_info(fan, leader);
 	}
 
 	return EC_SUCCESS;
@@ -416,7 +442,7 @@ hc_pwm_get_fan_target_rpm(struct host_cmd_handler_args *args)
 		return EC_RES_ERROR;
 
 	/* TODO(crosbug.com/p/23803) */
-	r->rpm = fan_get_rpm_target(FAN_CH(0));
+	r->rpm = get_rpm_target(0);
 	args->response_size = sizeof(*r);
 
 	return EC_RES_SUCCESS;
@@ -554,9 +580,9 @@ test_export_static void pwm_fan_init(void)
 	for (fan = 0; fan < fan_count; fan++) {
 		fan_set_enabled(FAN_CH(fan),
 				state.flag & FAN_STATE_FLAG_ENABLED);
-		fan_set_rpm_target(FAN_CH(fan), state.rpm);
 		set_thermal_control_enabled(
 			fan, state.flag & FAN_STATE_FLAG_THERMAL);
+		set_rpm_target(fan, state.rpm);
 	}
 
 	/* Initialize memory-mapped data */
@@ -574,7 +600,9 @@ static void pwm_fan_second(void)
 	int fan;
 
 	for (fan = 0; fan < fan_count; fan++) {
-		if (fan_is_stalled(FAN_CH(fan))) {
+		if (fan_is_stalled(FAN_CH(fan)) ||
+		    (IS_ENABLED(CONFIG_FAN_PID_CONTROL) &&
+		     fan_pid_is_stalled(fan))) {
 			rpm = EC_FAN_SPEED_STALLED;
 			stalled = 1;
 			cprints(CC_PWM, "Fan %d stalled!", fan);
@@ -607,7 +635,7 @@ static void pwm_fan_preserve_state(void)
 		state.flag |= FAN_STATE_FLAG_ENABLED;
 	if (is_thermal_control_enabled(fan))
 		state.flag |= FAN_STATE_FLAG_THERMAL;
-	state.rpm = fan_get_rpm_target(FAN_CH(fan));
+	state.rpm = get_rpm_target(fan);
 
 	system_add_jump_tag(PWMFAN_SYSJUMP_TAG, PWM_HOOK_VERSION, sizeof(state),
 			    &state);
@@ -620,12 +648,12 @@ static void pwm_fan_control(int enable)
 
 	/* TODO(crosbug.com/p/23530): Still treating all fans as one. */
 	for (fan = 0; fan < fan_count; fan++) {
+		int rpm = enable ? fan_percent_to_rpm(FAN_CH(fan),
+						      CONFIG_FAN_INIT_SPEED) :
+				   0;
+
 		set_thermal_control_enabled(fan, enable);
-		fan_set_rpm_target(
-			FAN_CH(fan),
-			enable ? fan_percent_to_rpm(FAN_CH(fan),
-						    CONFIG_FAN_INIT_SPEED) :
-				 0);
+		set_rpm_target(fan, rpm);
 		set_enabled(fan, enable);
 	}
 }
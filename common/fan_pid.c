@@ -0,0 +1,238 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Closed-loop fan speed control using tachometer feedback */
+
+#include "atomic.h"
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "fan.h"
+#include "hooks.h"
+#include "host_command.h"
+#include "ring_log.h"
+#include "timer.h"
+#include "util.h"
+
+#define CPRINTS(format, args...) cprints(CC_PWM, format, ##args)
+
+/* Duty cycle is computed in 1/1000 % and applied in whole percent */
+#define DUTY_SCALE 1000
+#define DUTY_MAX (100 * DUTY_SCALE)
+#define INTEGRAL_LIMIT (DUTY_MAX / 2)
+
+#define RAMP_STEP_RPM \
+	(CONFIG_FAN_PID_RAMP_RPM_PER_SEC * CONFIG_FAN_PID_PERIOD_MS / 1000)
+BUILD_ASSERT(RAMP_STEP_RPM > 0);
+
+struct fan_pid {
+	bool enabled;
+	bool stalled;
+	/* RPM requested by the thermal engine */
+	int target;
+	/* RPM the loop is currently regulating to, moves towards target */
+	int setpoint;
+	/* Integral term and output, in 1/1000 % duty */
+	int integral;
+	int duty;
+	/* Time spent driven below rpm_min / 2 */
+	int slow_ms;
+	uint32_t stall_count;
+};
+
+static struct fan_pid pid[CONFIG_FANS];
+
+/* Set while fan_pid_update() is scheduled */
+static bool loop_running;
+
+static struct ec_fan_pid_trace_entry trace[CONFIG_FANS]
+					  [CONFIG_FAN_PID_TRACE_CAPACITY];
+static atomic_t trace_next[CONFIG_FANS];
+
+#define TRACE(fan) RING_LOG(trace[fan], &trace_next[fan])
+
+static void trace_append(int fan, int actual)
+{
+	const struct fan_pid *s = &pid[fan];
+	struct ec_fan_pid_trace_entry *entry = ring_log_append(&TRACE(fan));
+
+	entry->time_us = get_time().le.lo;
+	entry->target_rpm = MIN(s->target, UINT16_MAX);
+	entry->setpoint_rpm = MIN(s->setpoint, UINT16_MAX);
+	entry->actual_rpm = CLAMP(actual, 0, UINT16_MAX);
+	entry->duty = DIV_ROUND_NEAREST(s->duty, DUTY_SCALE);
+	entry->flags = s->stalled ? EC_FAN_PID_ENTRY_STALLED : 0;
+}
+
+static void fan_pid_step(int fan)
+{
+	struct fan_pid *s = &pid[fan];
+	const struct fan_rpm *rpm = fans[fan].rpm;
+	int actual = fan_get_rpm_actual(FAN_CH(fan));
+	int err, out;
+
+	/* A stopped fan is kicked at its start speed, then ramps. */
+	if (!s->target)
+		s->setpoint = 0;
+	else if (!s->setpoint)
+		s->setpoint = rpm->rpm_start;
+	else if (s->target > s->setpoint)
+		s->setpoint = MIN(s->target, s->setpoint + RAMP_STEP_RPM);
+	else
+		s->setpoint = MAX(s->target, s->setpoint - RAMP_STEP_RPM);
+
+	if (!s->setpoint) {
+		s->duty = 0;
+		s->integral = 0;
+		s->slow_ms = 0;
+		s->stalled = false;
+	} else {
+		/* Feed-forward assumes RPM is proportional to duty */
+		err = s->setpoint - actual;
+		out = s->setpoint * DUTY_MAX / rpm->rpm_max +
+		      CONFIG_FAN_PID_KP * err + s->integral;
+
+		/*
+		 * Only integrate once the ramp is done, since the fan always
+		 * lags a moving setpoint, and stop while the output is
+		 * saturated.
+		 */
+		if (s->setpoint == s->target && (out < DUTY_MAX || err < 0) &&
+		    (out > 0 || err > 0)) {
+			s->integral += CONFIG_FAN_PID_KI * err *
+				       CONFIG_FAN_PID_PERIOD_MS / 1000;
+			s->integral = CLAMP(s->integral, -INTEGRAL_LIMIT,
+					    INTEGRAL_LIMIT);
+		}
+		s->duty = CLAMP(out, 0, DUTY_MAX);
+
+		if (actual < rpm->rpm_min / 2) {
+			s->slow_ms += CONFIG_FAN_PID_PERIOD_MS;
+			if (s->slow_ms >= CONFIG_FAN_PID_STALL_MS &&
+			    !s->stalled) {
+				s->stalled = true;
+				s->stall_count++;
+				CPRINTS("Fan %d stalled at %d%% duty", fan,
+					DIV_ROUND_NEAREST(s->duty, DUTY_SCALE));
+			}
+		} else {
+			s->slow_ms = 0;
+			s->stalled = false;
+		}
+	}
+
+	fan_set_duty(FAN_CH(fan), DIV_ROUND_NEAREST(s->duty, DUTY_SCALE));
+	trace_append(fan, actual);
+}
+
+static void fan_pid_update(void);
+DECLARE_DEFERRED(fan_pid_update);
+
+static void fan_pid_update(void)
+{
+	bool active = false;
+	int fan;
+
+	for (fan = 0; fan < fan_get_count(); fan++) {
+		if (!pid[fan].enabled)
+			continue;
+
+		fan_pid_step(fan);
+		if (pid[fan].target || pid[fan].setpoint)
+			active = true;
+	}
+
+	/* Stop polling once all fans have spun down */
+	loop_running = active;
+	if (active)
+		hook_call_deferred(&fan_pid_update_data,
+				   CONFIG_FAN_PID_PERIOD_MS * MSEC);
+}
+
+static void start_loop(void)
+{
+	if (loop_running)
+		return;
+
+	loop_running = true;
+	hook_call_deferred(&fan_pid_update_data, 0);
+}
+
+void fan_pid_set_target(int fan, int rpm)
+{
+	pid[fan].target = MAX(rpm, 0);
+
+	if (pid[fan].enabled && pid[fan].target)
+		start_loop();
+}
+
+int fan_pid_get_target(int fan)
+{
+	return pid[fan].target;
+}
+
+void fan_pid_enable(int fan, int enable)
+{
+	struct fan_pid *s = &pid[fan];
+
+	if (enable) {
+		/* Resume from the current speed rather than from zero */
+		s->setpoint = fan_get_rpm_actual(FAN_CH(fan));
+		s->integral = 0;
+		s->slow_ms = 0;
+		s->stalled = false;
+		fan_set_rpm_mode(FAN_CH(fan), 0);
+	}
+	s->enabled = enable;
+
+	if (enable && (s->target || s->setpoint))
+		start_loop();
+}
+
+bool fan_pid_is_stalled(int fan)
+{
+	return pid[fan].enabled && pid[fan].stalled;
+}
+
+void fan_pid_print_info(int fan, const char *leader)
+{
+	const struct fan_pid *s = &pid[fan];
+
+	ccprintf("%sPID:    %s, setpoint %d rpm, duty %d.%03d%%, "
+		 "integral %d, stalls %u\n",
+		 leader, s->enabled ? "on" : "off", s->setpoint,
+		 s->duty / DUTY_SCALE, s->duty % DUTY_SCALE, s->integral,
+		 s->stall_count);
+}
+
+static enum ec_status hc_fan_pid_trace(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_fan_pid_trace *p = args->params;
+	struct ec_response_fan_pid_trace *r = args->response;
+	uint32_t first, total;
+	int count;
+
+	if (p->fan_idx >= fan_get_count())
+		return EC_RES_INVALID_PARAM;
+
+	if (p->flags & EC_FAN_PID_TRACE_FLAG_CLEAR) {
+		ring_log_clear(&TRACE(p->fan_idx));
+		args->response_size = 0;
+		return EC_RES_SUCCESS;
+	}
+
+	count = ring_log_host_read(&TRACE(p->fan_idx), args, sizeof(*r),
+				   p->offset, &first, &total);
+	if (count < 0)
+		return -count;
+
+	r->first = first;
+	r->total = total;
+	r->count = count;
+	r->reserved = 0;
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_FAN_PID_TRACE, hc_fan_pid_trace, EC_VER_MASK(0));
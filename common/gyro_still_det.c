@@ -208,9 +208,9 @@ void gyro_still_det_reset(struct gyro_still_det *gyro_still_det,
 		gyro_still_det->stillness_confidence;
 
 	/* Track changes in the mean estimate. */
-	if (gyro_still_det->num_acc_samples > INT_TO_FP(1))
-		tmp_denom =
-			fp_div(INT_TO_FP(1), gyro_still_det->num_acc_samples);
+	if (gyro_still_det->num_acc_samples > 1)
+		tmp_denom = fp_div(INT_TO_FP(1),
+				   INT_TO_FP(gyro_still_det->num_acc_samples));
 
 	gyro_still_det->prev_mean[X] =
 		fp_mul(gyro_still_det->mean[X], tmp_denom);
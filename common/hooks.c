@@ -9,6 +9,7 @@
 #include "console.h"
 #include "hooks.h"
 #include "link_defs.h"
+#include "system_boot_time.h"
 #include "timer.h"
 #include "util.h"
 
@@ -134,8 +135,19 @@ void hook_notify(enum hook_type type)
 
 		/* Call all the hooks with that priority */
 		for (p = start; p < end; p++) {
-			if (p->priority == prio) {
-				called++;
+			if (p->priority != prio)
+				continue;
+
+			called++;
+			if (type == HOOK_INIT) {
+				boot_time_mark(EC_BOOT_TIME_EVENT_HOOK_INIT,
+					       EC_BOOT_TIME_BEGIN,
+					       (uintptr_t)p->routine);
+				p->routine();
+				boot_time_mark(EC_BOOT_TIME_EVENT_HOOK_INIT,
+					       EC_BOOT_TIME_END,
+					       (uintptr_t)p->routine);
+			} else {
 				p->routine();
 			}
 		}
@@ -180,7 +192,11 @@ void hook_task(void *u)
 	hook_task_started = 1;
 
 	/* Call HOOK_INIT hooks. */
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+		       EC_BOOT_TIME_STAGE_HOOK_INIT);
 	hook_notify(HOOK_INIT);
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+		       EC_BOOT_TIME_STAGE_HOOK_INIT);
 
 	/* Now, enable the rest of the tasks. */
 	task_enable_all_tasks();
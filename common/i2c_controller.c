@@ -5,6 +5,7 @@
 
 /* I2C cross-platform code for Chrome EC */
 
+#include "atomic.h"
 #include "builtin/assert.h"
 #include "console.h"
 #include "crc8.h"
@@ -38,6 +39,9 @@ static mutex_t port_mutex[I2C_CONTROLLER_COUNT + I2C_BITBANG_PORT_COUNT];
 static volatile uint32_t i2c_port_active_list;
 BUILD_ASSERT(ARRAY_SIZE(port_mutex) < 32);
 
+/* Transactions started on any port, see i2c_get_xfer_count() */
+static atomic_t i2c_xfer_count;
+
 #ifdef CONFIG_ZEPHYR
 static int init_port_mutex(void)
 {
@@ -198,6 +202,8 @@ int i2c_xfer_unlocked(const int port, const uint16_t addr_flags,
 		return EC_ERROR_INVAL;
 	}
 
+	atomic_add(&i2c_xfer_count, 1);
+
 	for (i = 0; i <= CONFIG_I2C_NACK_RETRY_COUNT; i++) {
 #ifdef CONFIG_ZEPHYR
 		struct i2c_msg msg[2];
@@ -272,6 +278,11 @@ int i2c_xfer_unlocked(const int port, const uint16_t addr_flags,
 	return ret;
 }
 
+uint32_t i2c_get_xfer_count(void)
+{
+	return (uint32_t)i2c_xfer_count;
+}
+
 int i2c_xfer(const int port, const uint16_t addr_flags, const uint8_t *out,
 	     int out_size, uint8_t *in, int in_size)
 {
@@ -6,6 +6,7 @@
 #include "console.h"
 #include "hwtimer.h"
 #include "i2c_hid_touchpad.h"
+#include "task.h"
 #include "util.h"
 
 /* 2 bytes for length + 1 byte for report ID */
@@ -157,6 +158,24 @@ struct mouse_report {
 	int8_t y;
 } __packed;
 
+/* Input reports as sent on the wire, with the I2C HID header */
+struct touch_input {
+	uint8_t length[2];
+	uint8_t report_id;
+	struct touch_report report;
+} __packed;
+
+struct mouse_input {
+	uint8_t length[2];
+	uint8_t report_id;
+	struct mouse_report report;
+} __packed;
+
+BUILD_ASSERT(sizeof(struct touch_input) ==
+	     I2C_HID_HEADER_SIZE + sizeof(struct touch_report));
+BUILD_ASSERT(sizeof(struct mouse_input) ==
+	     I2C_HID_HEADER_SIZE + sizeof(struct mouse_report));
+
 /* HID input report descriptor
  *
  * For a complete reference, please see the following docs on usb.org
@@ -407,14 +426,33 @@ static struct i2c_hid_descriptor hid_desc = {
 static bool pending_probe;
 static bool pending_reset;
 
-/* Reports (double buffered) */
-#define MAX_REPORT_CNT 2
+/*
+ * Ring of input reports waiting for the host
+ *
+ * Each frame is compiled straight into its slot in both touch and mouse
+ * format, headers included, so a host read is a single copy of the slot in
+ * the current input mode. The slot before report_tail always holds the latest
+ * frame, which the next frame is compiled against, and which is what the host
+ * gets when it reads with nothing queued.
+ *
+ * Reports are queued from the touchpad task and read from the I2C interrupt,
+ * so the task holds irq_lock() while moving the indexes.
+ */
+#define REPORT_QUEUE_SIZE CONFIG_I2C_HID_TOUCHPAD_QUEUE_SIZE
+BUILD_ASSERT(REPORT_QUEUE_SIZE >= 2 && POWER_OF_TWO(REPORT_QUEUE_SIZE));
+
+static struct report_slot {
+	struct touch_input touch;
+	struct mouse_input mouse;
+	/* Time the frame was compiled, in us */
+	uint32_t time_us;
+} reports[REPORT_QUEUE_SIZE];
 
-static struct touch_report touch_reports[MAX_REPORT_CNT];
-static struct mouse_report mouse_reports[MAX_REPORT_CNT];
+/* Total reports queued and sent; the slot index is taken modulo */
+static uint32_t report_head;
+static uint32_t report_tail;
 
-/* Current active report buffer index */
-static int report_active_index;
+static struct i2c_hid_touchpad_stats stats;
 
 /* Current input mode */
 static uint8_t input_mode;
@@ -436,14 +474,80 @@ static int i2c_hid_touchpad_command_process(size_t len, uint8_t *buffer,
 					    void (*send_response)(int len),
 					    uint8_t *data);
 
-static size_t fill_report(uint8_t *buffer, uint8_t report_id, const void *data,
-			  size_t data_len)
+static struct report_slot *get_slot(uint32_t index)
 {
-	size_t response_len = I2C_HID_HEADER_SIZE + data_len;
+	return &reports[index % REPORT_QUEUE_SIZE];
+}
 
+static void histogram_add(uint32_t us)
+{
+	int i = 0;
+
+	while (i < I2C_HID_TOUCHPAD_LATENCY_BUCKETS - 1 &&
+	       us >= (I2C_HID_TOUCHPAD_LATENCY_BUCKET_BASE_US << i))
+		i++;
+
+	stats.latency_buckets[i]++;
+	stats.latency_sum_us += us;
+	stats.latency_max_us = MAX(stats.latency_max_us, us);
+}
+
+/* Send the oldest queued report, or the latest one again if none is queued */
+static size_t send_input_report(uint8_t *buffer)
+{
+	const struct report_slot *slot;
+	uint32_t latency;
+
+	if (report_head == report_tail) {
+		slot = get_slot(report_tail - 1);
+		stats.repeated++;
+	} else {
+		slot = get_slot(report_head++);
+		latency = __hw_clock_source_read() - slot->time_us;
+		stats.sent++;
+		if (latency > CONFIG_I2C_HID_TOUCHPAD_LATE_US)
+			stats.late++;
+		histogram_add(latency);
+	}
+
+	if (input_mode == INPUT_MODE_TOUCH) {
+		memcpy(buffer, &slot->touch, sizeof(slot->touch));
+		return sizeof(slot->touch);
+	}
+	memcpy(buffer, &slot->mouse, sizeof(slot->mouse));
+	return sizeof(slot->mouse);
+}
+
+/*
+ * Make room for a new frame by dropping the oldest unread one. Its mouse
+ * movement is carried over to the next report so the cursor doesn't lose
+ * distance. Must be called with irq_lock() held.
+ */
+static void drop_oldest_report(void)
+{
+	struct mouse_report *old = &get_slot(report_head)->mouse.report;
+	struct mouse_report *next = &get_slot(report_head + 1)->mouse.report;
+
+	next->x = CLAMP(next->x + old->x, -127, 127);
+	next->y = CLAMP(next->y + old->y, -127, 127);
+	report_head++;
+	stats.dropped++;
+}
+
+static void fill_header(uint8_t *buffer, uint8_t report_id,
+			size_t response_len)
+{
 	buffer[0] = response_len & 0xFF;
 	buffer[1] = (response_len >> 8) & 0xFF;
 	buffer[2] = report_id;
+}
+
+static size_t fill_report(uint8_t *buffer, uint8_t report_id, const void *data,
+			  size_t data_len)
+{
+	size_t response_len = I2C_HID_HEADER_SIZE + data_len;
+
+	fill_header(buffer, report_id, response_len);
 	memcpy(buffer + I2C_HID_HEADER_SIZE, data, data_len);
 	return response_len;
 }
@@ -483,10 +587,24 @@ static void extract_report(size_t len, const uint8_t *buffer, void *data,
 
 void i2c_hid_touchpad_init(void)
 {
+	uint32_t key;
+	int i;
+
 	input_mode = INPUT_MODE_MOUSE;
 	reporting.surface_switch = 1;
 	reporting.button_switch = 1;
-	report_active_index = 0;
+
+	key = irq_lock();
+	memset(reports, 0, sizeof(reports));
+	for (i = 0; i < REPORT_QUEUE_SIZE; i++) {
+		fill_header((uint8_t *)&reports[i].touch, REPORT_ID_TOUCH,
+			    sizeof(struct touch_input));
+		fill_header((uint8_t *)&reports[i].mouse, REPORT_ID_MOUSE,
+			    sizeof(struct mouse_input));
+	}
+	report_head = 0;
+	report_tail = 0;
+	irq_unlock(key);
 
 	// Respond probing requests for now.
 	pending_probe = true;
@@ -497,8 +615,6 @@ int i2c_hid_touchpad_process(unsigned int len, uint8_t *buffer,
 			     void (*send_response)(int len), uint8_t *data,
 			     int *reg, int *cmd)
 {
-	size_t response_len;
-
 	if (len == 0)
 		*reg = I2C_HID_INPUT_REPORT_REGISTER;
 	else
@@ -530,18 +646,7 @@ int i2c_hid_touchpad_process(unsigned int len, uint8_t *buffer,
 			break;
 		}
 		// Common input report requests.
-		if (input_mode == INPUT_MODE_TOUCH) {
-			response_len =
-				fill_report(buffer, REPORT_ID_TOUCH,
-					    &touch_reports[report_active_index],
-					    sizeof(struct touch_report));
-		} else {
-			response_len =
-				fill_report(buffer, REPORT_ID_MOUSE,
-					    &mouse_reports[report_active_index],
-					    sizeof(struct mouse_report));
-		}
-		send_response(response_len);
+		send_response(send_input_report(buffer));
 		break;
 	case I2C_HID_COMMAND_REGISTER:
 		*cmd = i2c_hid_touchpad_command_process(len, buffer,
@@ -576,16 +681,14 @@ static int i2c_hid_touchpad_command_process(size_t len, uint8_t *buffer,
 	case I2C_HID_CMD_GET_REPORT:
 		switch (report_id) {
 		case REPORT_ID_TOUCH:
-			response_len =
-				fill_report(buffer, report_id,
-					    &touch_reports[report_active_index],
-					    sizeof(struct touch_report));
+			response_len = sizeof(struct touch_input);
+			memcpy(buffer, &get_slot(report_tail - 1)->touch,
+			       response_len);
 			break;
 		case REPORT_ID_MOUSE:
-			response_len =
-				fill_report(buffer, report_id,
-					    &mouse_reports[report_active_index],
-					    sizeof(struct mouse_report));
+			response_len = sizeof(struct mouse_input);
+			memcpy(buffer, &get_slot(report_tail - 1)->mouse,
+			       response_len);
 			break;
 		case REPORT_ID_DEVICE_CAPS:
 			response_len = fill_report(buffer, report_id,
@@ -642,13 +745,26 @@ static int i2c_hid_touchpad_command_process(size_t len, uint8_t *buffer,
 	return command;
 }
 
-void i2c_hid_compile_report(struct touchpad_event *event)
+bool i2c_hid_compile_report(struct touchpad_event *event)
 {
-	/* Save report into back buffer */
-	struct touch_report *touch = &touch_reports[report_active_index ^ 1];
-	struct touch_report *touch_old = &touch_reports[report_active_index];
-	struct mouse_report *mouse = &mouse_reports[report_active_index ^ 1];
+	struct report_slot *slot;
+	struct touch_report *touch;
+	const struct touch_report *touch_old;
+	struct mouse_report *mouse;
 	int contact_num = 0;
+	uint32_t key;
+	bool was_empty;
+
+	key = irq_lock();
+	if (report_tail - report_head == REPORT_QUEUE_SIZE)
+		drop_oldest_report();
+	irq_unlock(key);
+
+	/* The host never reads the tail slot, so build the report there. */
+	slot = get_slot(report_tail);
+	touch = &slot->touch.report;
+	touch_old = &get_slot(report_tail - 1)->touch.report;
+	mouse = &slot->mouse.report;
 
 	/* Touch report. */
 	memset(touch, 0, sizeof(struct touch_report));
@@ -769,6 +885,65 @@ void i2c_hid_compile_report(struct touchpad_event *event)
 		mouse->y = 0;
 	}
 
-	/* Swap buffer */
-	report_active_index ^= 1;
+	slot->time_us = __hw_clock_source_read();
+
+	key = irq_lock();
+	was_empty = report_head == report_tail;
+	report_tail++;
+	stats.queued++;
+	irq_unlock(key);
+
+	return was_empty;
+}
+
+bool i2c_hid_touchpad_has_report(void)
+{
+	return report_head != report_tail;
+}
+
+void i2c_hid_touchpad_get_stats(struct i2c_hid_touchpad_stats *out)
+{
+	uint32_t key = irq_lock();
+
+	*out = stats;
+	irq_unlock(key);
+}
+
+void i2c_hid_touchpad_clear_stats(void)
+{
+	uint32_t key = irq_lock();
+
+	memset(&stats, 0, sizeof(stats));
+	irq_unlock(key);
+}
+
+static int command_tpstats(int argc, const char **argv)
+{
+	struct i2c_hid_touchpad_stats s;
+	int i;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "clear"))
+			return EC_ERROR_PARAM1;
+		i2c_hid_touchpad_clear_stats();
+		return EC_SUCCESS;
+	}
+
+	i2c_hid_touchpad_get_stats(&s);
+	ccprintf("queued %u sent %u dropped %u late %u repeated %u\n",
+		 s.queued, s.sent, s.dropped, s.late, s.repeated);
+	ccprintf("latency mean %u max %u us\n",
+		 s.sent ? (uint32_t)(s.latency_sum_us / s.sent) : 0,
+		 s.latency_max_us);
+	for (i = 0; i < I2C_HID_TOUCHPAD_LATENCY_BUCKETS - 1; i++)
+		ccprintf("  < %6u us: %u\n",
+			 I2C_HID_TOUCHPAD_LATENCY_BUCKET_BASE_US << i,
+			 s.latency_buckets[i]);
+	ccprintf("  >= %5u us: %u\n",
+		 I2C_HID_TOUCHPAD_LATENCY_BUCKET_BASE_US << (i - 1),
+		 s.latency_buckets[i]);
+
+	return EC_SUCCESS;
 }
+DECLARE_CONSOLE_COMMAND(tpstats, command_tpstats, "[clear]",
+			"Show I2C HID touchpad report statistics");
@@ -6,6 +6,7 @@
  */
 
 #include "atkbd_protocol.h"
+#include "atomic.h"
 #include "builtin/assert.h"
 #include "button.h"
 #include "chipset.h"
@@ -17,6 +18,7 @@
 #include "i8042_protocol.h"
 #include "keyboard_8042_sharedlib.h"
 #include "keyboard_config.h"
+#include "keyboard_latency.h"
 #include "keyboard_protocol.h"
 #include "keyboard_scan.h"
 #include "lightbar.h"
@@ -99,14 +101,37 @@ enum {
 	CHAN_AUX,
 	CHAN_CMD,
 };
+/* Set on the channel of the last byte of a key event */
+#define CHAN_KEY_END BIT(7)
 struct data_byte {
 	uint8_t chan;
 	uint8_t byte;
 };
 
-static struct queue const to_host = QUEUE_NULL(16, struct data_byte);
+static struct queue const to_host =
+	QUEUE_NULL(CONFIG_8042_TO_HOST_QUEUE_SIZE, struct data_byte);
 static struct queue const to_host_cmd = QUEUE_NULL(16, struct data_byte);
 
+/* Bytes dropped because there was no room to queue them, by channel */
+static atomic_t to_host_dropped[CHAN_CMD + 1];
+
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+/*
+ * Timestamps of the key events in to_host, oldest first. There is one entry
+ * per CHAN_KEY_END byte, so this can't fill up before to_host.
+ */
+struct key_stamp {
+	uint32_t detect_us;
+	uint32_t enqueue_us;
+};
+static struct queue const key_stamps =
+	QUEUE_NULL(CONFIG_8042_TO_HOST_QUEUE_SIZE, struct key_stamp);
+
+/* Key event whose last byte is waiting in the output buffer */
+static struct key_stamp read_stamp;
+static bool read_pending;
+#endif
+
 /* Queue command/data from the host */
 enum {
 	HOST_COMMAND = 0,
@@ -130,8 +155,22 @@ struct host_byte {
  */
 static struct queue const from_host = QUEUE_NULL(8, struct host_byte);
 
-/* Queue aux data to the host from interrupt context. */
-static struct queue const aux_to_host_queue = QUEUE_NULL(16, uint8_t);
+/*
+ * Queue aux data to the host from interrupt context. Bytes stay here while
+ * to_host is full, and are moved over as the host reads.
+ */
+static struct queue const aux_to_host_queue =
+	QUEUE_NULL(CONFIG_8042_AUX_QUEUE_SIZE, uint8_t);
+
+/*
+ * Room AUX bytes leave free in to_host, so that a steady AUX stream can't
+ * crowd out the next scan code.
+ */
+#define AUX_TO_HOST_RESERVE MAX_SCAN_CODE_LEN
+BUILD_ASSERT(CONFIG_8042_TO_HOST_QUEUE_SIZE > AUX_TO_HOST_RESERVE);
+
+static void send_aux_data_to_host_deferred(void);
+DECLARE_DEFERRED(send_aux_data_to_host_deferred);
 
 static int i8042_keyboard_irq_enabled;
 static int i8042_aux_irq_enabled;
@@ -278,6 +317,48 @@ static void aux_enable_irq(int enable)
 	i8042_aux_irq_enabled = enable;
 }
 
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+/* Timestamp a key event just added to to_host */
+static void key_stamp_add(void)
+{
+	struct key_stamp stamp = {
+		.detect_us = keyboard_latency_claim(),
+		.enqueue_us = get_time().le.lo,
+	};
+
+	queue_add_unit(&key_stamps, &stamp);
+}
+
+/* Account the key event in the output buffer once the host has read it */
+static void key_stamp_check_read(void)
+{
+	if (!read_pending || lpc_keyboard_has_char())
+		return;
+
+	read_pending = false;
+	keyboard_latency_record(EC_KB_LATENCY_PATH_8042, read_stamp.detect_us,
+				read_stamp.enqueue_us, get_time().le.lo);
+}
+
+/*
+ * Called after a byte was put in the output buffer. The buffer was empty, so
+ * a previous key event in it has been read even if we didn't see it yet.
+ */
+static void key_stamp_sent(bool key_end)
+{
+	if (read_pending) {
+		read_pending = false;
+		keyboard_latency_record(EC_KB_LATENCY_PATH_8042,
+					read_stamp.detect_us,
+					read_stamp.enqueue_us,
+					get_time().le.lo);
+	}
+
+	if (key_end && queue_remove_unit(&key_stamps, &read_stamp))
+		read_pending = true;
+}
+#endif /* CONFIG_KEYBOARD_LATENCY_STATS */
+
 /**
  * Send a scan code to the host.
  *
@@ -323,9 +404,22 @@ static void i8042_send_to_host(int len, const uint8_t *bytes, uint8_t chan,
 			kblog_put('t', queue->state->tail);
 			for (i = 0; i < len; i++) {
 				data.chan = chan;
+				if (i < len - 1)
+					data.chan &= ~CHAN_KEY_END;
 				data.byte = bytes[i];
 				queue_add_unit(queue, &data);
 			}
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+			if (chan & CHAN_KEY_END)
+				key_stamp_add();
+#endif
+		} else {
+			atomic_add(&to_host_dropped[chan & ~CHAN_KEY_END], len);
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+			if (chan & CHAN_KEY_END)
+				keyboard_latency_dropped(
+					EC_KB_LATENCY_PATH_8042, 1);
+#endif
 		}
 	}
 	mutex_unlock(&to_host_mutex);
@@ -453,6 +547,12 @@ void keyboard_clear_buffer(void)
 	kblog_put('x', queue_count(&to_host));
 	queue_init(&to_host);
 	queue_init(&to_host_cmd);
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+	keyboard_latency_dropped(EC_KB_LATENCY_PATH_8042,
+				 queue_count(&key_stamps) + read_pending);
+	queue_init(&key_stamps);
+	read_pending = false;
+#endif
 	mutex_unlock(&to_host_mutex);
 	lpc_keyboard_clear_buffer();
 }
@@ -496,7 +596,8 @@ test_mockable void keyboard_state_changed(int row, int col, int is_pressed)
 	if (ret == EC_SUCCESS) {
 		ASSERT(len > 0);
 		if (keystroke_enabled)
-			i8042_send_to_host(len, scan_code, CHAN_KBD, 0);
+			i8042_send_to_host(len, scan_code,
+					   CHAN_KBD | CHAN_KEY_END, 0);
 	}
 
 	if (is_pressed) {
@@ -966,6 +1067,10 @@ void keyboard_protocol_task(void *u)
 			/* Handle command/data write from host */
 			i8042_handle_from_host();
 
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+			key_stamp_check_read();
+#endif
+
 			/* Check if we have data to send to host */
 			if (queue_is_empty(&to_host) &&
 			    queue_is_empty(&to_host_cmd))
@@ -1058,28 +1163,54 @@ void keyboard_protocol_task(void *u)
 					entry.byte, i8042_keyboard_irq_enabled);
 				kblog_put('K', entry.byte);
 			}
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+			key_stamp_sent(entry.chan & CHAN_KEY_END);
+#endif
 			retries = 0;
+
+			/* Refill to_host with AUX bytes held back while full */
+			if (!queue_is_empty(&aux_to_host_queue))
+				hook_call_deferred(
+					&send_aux_data_to_host_deferred_data,
+					0);
 		}
 	}
 }
 
 static void send_aux_data_to_host_deferred(void)
 {
-	uint8_t data;
+	struct data_byte data = { .chan = CHAN_AUX };
+	int ignored = 0, moved = 0;
 
 	if (IS_ENABLED(CONFIG_DEVICE_EVENT) &&
 	    chipset_in_state(CHIPSET_STATE_ANY_SUSPEND))
 		device_set_single_event(EC_DEVICE_EVENT_TRACKPAD);
 
-	while (!queue_is_empty(&aux_to_host_queue)) {
-		queue_remove_unit(&aux_to_host_queue, &data);
-		if (aux_chan_enabled && IS_ENABLED(CONFIG_8042_AUX))
-			i8042_send_to_host(1, &data, CHAN_AUX, 0);
-		else
-			CPRINTS("AUX Callback ignored");
+	/*
+	 * Move as much of the burst as fits in one go, short of the room kept
+	 * for scan codes. Whatever doesn't fit waits here for the protocol
+	 * task to make room, rather than being dropped.
+	 */
+	mutex_lock(&to_host_mutex);
+	while (queue_peek_units(&aux_to_host_queue, &data.byte, 0, 1)) {
+		if (!aux_chan_enabled || !IS_ENABLED(CONFIG_8042_AUX)) {
+			ignored++;
+		} else if (queue_space(&to_host) <= AUX_TO_HOST_RESERVE) {
+			break;
+		} else {
+			kblog_put('a', data.byte);
+			queue_add_unit(&to_host, &data);
+			moved++;
+		}
+		queue_advance_head(&aux_to_host_queue, 1);
 	}
+	mutex_unlock(&to_host_mutex);
+
+	if (ignored)
+		CPRINTS("AUX Callback ignored");
+	if (moved)
+		task_wake(TASK_ID_KEYPROTO);
 }
-DECLARE_DEFERRED(send_aux_data_to_host_deferred);
 
 /**
  * Send aux data to host from interrupt context.
@@ -1088,7 +1219,8 @@ DECLARE_DEFERRED(send_aux_data_to_host_deferred);
  */
 void send_aux_data_to_host_interrupt(uint8_t data)
 {
-	queue_add_unit(&aux_to_host_queue, &data);
+	if (!queue_add_unit(&aux_to_host_queue, &data))
+		atomic_add(&to_host_dropped[CHAN_AUX], 1);
 	hook_call_deferred(&send_aux_data_to_host_deferred_data, 0);
 }
 
@@ -1297,6 +1429,11 @@ static int command_8042_internal(int argc, const char **argv)
 	}
 	ccprintf("}\n");
 
+	ccprintf("to_host dropped: kbd %u, aux %u, cmd %u\n",
+		 (uint32_t)to_host_dropped[CHAN_KBD],
+		 (uint32_t)to_host_dropped[CHAN_AUX],
+		 (uint32_t)to_host_dropped[CHAN_CMD]);
+
 	return EC_SUCCESS;
 }
 
@@ -1447,4 +1584,10 @@ void test_keyboard_8042_reset(void)
 
 	A20_status = 0;
 }
+
+uint32_t test_keyboard_8042_get_dropped_bytes(void)
+{
+	return to_host_dropped[CHAN_KBD] + to_host_dropped[CHAN_AUX] +
+	       to_host_dropped[CHAN_CMD];
+}
 #endif /* TEST_BUILD */
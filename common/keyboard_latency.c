@@ -0,0 +1,118 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Keypress-to-host latency statistics */
+
+#include "common.h"
+#include "ec_commands.h"
+#include "host_command.h"
+#include "keyboard_latency.h"
+#include "task.h"
+#include "timer.h"
+#include "util.h"
+
+struct latency_histogram {
+	uint64_t sum_us;
+	uint32_t max_us;
+	uint32_t buckets[EC_KB_LATENCY_BUCKETS];
+};
+
+static struct {
+	uint32_t events;
+	uint32_t dropped;
+	struct latency_histogram stage[EC_KB_LATENCY_STAGE_COUNT];
+} stats[EC_KB_LATENCY_PATH_COUNT];
+
+static K_MUTEX_DEFINE(stats_lock);
+
+/* Detection time of the changes not yet claimed by a protocol */
+static uint32_t mark_us;
+static bool mark_valid;
+
+void keyboard_latency_mark(uint32_t detect_us)
+{
+	if (!mark_valid || (int32_t)(detect_us - mark_us) < 0)
+		mark_us = detect_us;
+	mark_valid = true;
+}
+
+uint32_t keyboard_latency_claim(void)
+{
+	if (!mark_valid)
+		return get_time().le.lo;
+
+	mark_valid = false;
+	return mark_us;
+}
+
+static void histogram_add(struct latency_histogram *h, uint32_t us)
+{
+	int i = 0;
+
+	while (i < EC_KB_LATENCY_BUCKETS - 1 &&
+	       us >= (EC_KB_LATENCY_BUCKET_BASE_US << i))
+		i++;
+
+	h->buckets[i]++;
+	h->sum_us += us;
+	h->max_us = MAX(h->max_us, us);
+}
+
+void keyboard_latency_record(enum ec_kb_latency_path path, uint32_t detect_us,
+			     uint32_t enqueue_us, uint32_t read_us)
+{
+	struct latency_histogram *h = stats[path].stage;
+
+	mutex_lock(&stats_lock);
+	stats[path].events++;
+	histogram_add(&h[EC_KB_LATENCY_STAGE_QUEUE], enqueue_us - detect_us);
+	histogram_add(&h[EC_KB_LATENCY_STAGE_HOST], read_us - enqueue_us);
+	histogram_add(&h[EC_KB_LATENCY_STAGE_TOTAL], read_us - detect_us);
+	mutex_unlock(&stats_lock);
+}
+
+void keyboard_latency_dropped(enum ec_kb_latency_path path, int count)
+{
+	mutex_lock(&stats_lock);
+	stats[path].dropped += count;
+	mutex_unlock(&stats_lock);
+}
+
+static enum ec_status hc_keyboard_latency(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_keyboard_latency *p = args->params;
+	struct ec_response_keyboard_latency *r = args->response;
+	const struct latency_histogram *h;
+	int i;
+
+	if (p->path >= EC_KB_LATENCY_PATH_COUNT)
+		return EC_RES_INVALID_PARAM;
+
+	mutex_lock(&stats_lock);
+
+	if (p->flags & EC_KB_LATENCY_FLAG_CLEAR) {
+		memset(&stats[p->path], 0, sizeof(stats[p->path]));
+		mutex_unlock(&stats_lock);
+		args->response_size = 0;
+		return EC_RES_SUCCESS;
+	}
+
+	r->events = stats[p->path].events;
+	r->dropped = stats[p->path].dropped;
+	for (i = 0; i < EC_KB_LATENCY_STAGE_COUNT; i++) {
+		h = &stats[p->path].stage[i];
+		r->stage[i].mean_us = r->events ? h->sum_us / r->events : 0;
+		r->stage[i].max_us = h->max_us;
+		memcpy(r->stage[i].buckets, h->buckets, sizeof(h->buckets));
+	}
+
+	mutex_unlock(&stats_lock);
+
+	args->response_size = sizeof(*r);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_KEYBOARD_LATENCY, hc_keyboard_latency,
+		     EC_VER_MASK(0));
@@ -16,6 +16,7 @@
 #include "hooks.h"
 #include "host_command.h"
 #include "keyboard_config.h"
+#include "keyboard_latency.h"
 #include "keyboard_protocol.h"
 #include "keyboard_raw.h"
 #include "keyboard_scan.h"
@@ -132,6 +133,9 @@ static uint8_t scan_edge_index[KEYBOARD_COLS_MAX][KEYBOARD_ROWS];
 /* Minimum delay between keyboard scans based on current clock frequency */
 static uint32_t post_scan_clock_us;
 
+/* Polling scan counters */
+static struct keyboard_scan_stats scan_stats;
+
 /*
  * Print all keyboard scan state changes?  Off by default because it generates
  * a lot of debug output, which makes the saved EC console data less useful.
@@ -321,11 +325,79 @@ static bool power_button_raw_pressed(void)
 		return false;
 }
 
+#if defined(CONFIG_ZEPHYR) && defined(CONFIG_KEYBOARD_SCAN_SLEEP_SETTLE)
+#error "Zephyr sleeps are too coarse for CONFIG_KEYBOARD_SCAN_SLEEP_SETTLE"
+#endif
+
+/**
+ * Wait for a newly driven column to settle.
+ *
+ * @param us		Settle time
+ * @param can_sleep	True if called from the scan task, which may sleep
+ *			rather than spin when CONFIG_KEYBOARD_SCAN_SLEEP_SETTLE
+ *			is defined.
+ */
+static void column_settle(int us, bool can_sleep)
+{
+	if (IS_ENABLED(CONFIG_KEYBOARD_SCAN_SLEEP_SETTLE) && can_sleep)
+		crec_usleep(us);
+	else
+		udelay(us);
+}
+
+#ifdef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+BUILD_ASSERT(KEYBOARD_COLS_MAX <= 32);
+#ifdef CONFIG_KEYBOARD_SCAN_ADC
+#error "CONFIG_KEYBOARD_SCAN_INCREMENTAL reads rows without the ADC"
+#endif
+
+/* Row state of each column, as last read and before deghosting */
+static uint8_t raw_state[KEYBOARD_COLS_MAX];
+
+/* Scans since all columns were last read, 0 to read them all next time */
+static int scans_since_full;
+
+/**
+ * Choose the columns to read on this scan.
+ *
+ * Keys can only change in columns with keys down or debouncing, or by a new
+ * key going down. A new key in a row without keys down shows up when all
+ * columns are driven; one in a row that already has a key down doesn't, so
+ * all columns are still read every CONFIG_KEYBOARD_SCAN_FULL_INTERVAL scans.
+ *
+ * @return bitmask of the columns to read
+ */
+static uint32_t select_scan_columns(void)
+{
+	uint32_t all = BIT(keyboard_cols) - 1;
+	uint32_t cols = 0;
+	uint8_t rows = 0;
+	int c;
+
+	if (IS_ENABLED(CONFIG_KEYBOARD_TEST) || !scans_since_full ||
+	    scans_since_full >= CONFIG_KEYBOARD_SCAN_FULL_INTERVAL)
+		return all;
+
+	for (c = 0; c < keyboard_cols; c++) {
+		if (raw_state[c] || debouncing[c])
+			cols |= BIT(c);
+		rows |= raw_state[c];
+	}
+
+	keyboard_raw_drive_column(KEYBOARD_COLUMN_ALL);
+	column_settle(keyscan_config.output_settle_us + COL2_DELAY_US, true);
+	if (keyboard_raw_read_rows() & ~rows)
+		return all;
+
+	return cols;
+}
+#endif /* CONFIG_KEYBOARD_SCAN_INCREMENTAL */
+
 /**
  * Read the raw keyboard matrix state.
  *
- * Used in pre-init, so must not make task-switching-dependent calls; udelay()
- * is ok because it's a spin-loop.
+ * Used in pre-init, so must not make task-switching-dependent calls when
+ * at_boot is set; udelay() is ok because it's a spin-loop.
  *
  * @param state		Destination for new state (must be KEYBOARD_COLS_MAX
  *			long).
@@ -338,6 +410,14 @@ static int read_matrix(uint8_t *state, bool at_boot)
 	int c;
 	int pressed = 0;
 	int pb_pressed;
+	uint32_t start = get_time().le.lo;
+	uint32_t cols = BIT(keyboard_cols) - 1;
+	int columns_read = 0;
+
+#ifdef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+	if (!at_boot)
+		cols = select_scan_columns();
+#endif
 
 	pb_pressed = power_button_raw_pressed();
 
@@ -352,17 +432,29 @@ static int read_matrix(uint8_t *state, bool at_boot)
 		 */
 		if (!keyboard_scan_is_enabled()) {
 			state[c] = 0;
+#ifdef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+			raw_state[c] = 0;
+#endif
+			continue;
+		}
+
+#ifdef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+		/* Reuse the last reading of columns that can't have changed */
+		if (!(cols & BIT(c))) {
+			state[c] = raw_state[c];
 			continue;
 		}
+#endif
 
 		/* Select column, then wait a bit for it to settle */
+		columns_read++;
 		keyboard_raw_drive_column(c);
-		udelay(keyscan_config.output_settle_us);
+		column_settle(keyscan_config.output_settle_us, !at_boot);
 
 		/* Only add the extre delay when selecting or deselecting COL2
 		 */
 		if (c == COL2 || c == (COL2 + 1)) {
-			udelay(COL2_DELAY_US);
+			column_settle(COL2_DELAY_US, !at_boot);
 		}
 
 		/* Read the row state */
@@ -375,7 +467,24 @@ static int read_matrix(uint8_t *state, bool at_boot)
 		/* Use simulated keyscan sequence instead if testing active */
 		if (IS_ENABLED(CONFIG_KEYBOARD_TEST))
 			state[c] = keyscan_seq_get_scan(c, state[c]);
+
+#ifdef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+		raw_state[c] = state[c];
+#endif
+	}
+
+	if (!at_boot) {
+		scan_stats.scans++;
+		if (cols == BIT(keyboard_cols) - 1)
+			scan_stats.full_scans++;
+		scan_stats.columns += columns_read;
 	}
+#ifdef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+	if (cols == BIT(keyboard_cols) - 1)
+		scans_since_full = 1;
+	else
+		scans_since_full++;
+#endif
 
 	if (pb_pressed && at_boot) {
 		/* Check if KSI2 (or KSI3) is asserted on all columns */
@@ -446,6 +555,9 @@ static int read_matrix(uint8_t *state, bool at_boot)
 
 	keyboard_raw_drive_column(KEYBOARD_COLUMN_NONE);
 
+	if (!at_boot)
+		scan_stats.scan_us += get_time().le.lo - start;
+
 	return pressed ? 1 : 0;
 }
 
@@ -664,6 +776,10 @@ static int check_keys_changed(uint8_t *state)
 		scan_time_index = 0;
 	scan_time[scan_time_index] = tnow;
 
+	/* Drop a detect time the protocol didn't claim in the previous scan */
+	if (IS_ENABLED(CONFIG_KEYBOARD_LATENCY_STATS))
+		keyboard_latency_claim();
+
 	/* Read the raw key state */
 	any_pressed = read_matrix(new_state, false);
 
@@ -693,6 +809,9 @@ static int check_keys_changed(uint8_t *state)
 				/* Debounced but no difference. */
 				continue;
 			any_change = 1;
+			if (IS_ENABLED(CONFIG_KEYBOARD_LATENCY_STATS))
+				keyboard_latency_mark(
+					scan_time[scan_edge_index[c][i]]);
 			key_state_changed(i, c, new_state[c]);
 			/*
 			 * This makes state[c] == new_state[c] for row i.
@@ -713,6 +832,8 @@ static int check_keys_changed(uint8_t *state)
 
 			if (!IS_ENABLED(CONFIG_KEYBOARD_STRICT_DEBOUNCE)) {
 				any_change = 1;
+				if (IS_ENABLED(CONFIG_KEYBOARD_LATENCY_STATS))
+					keyboard_latency_mark(tnow);
 				key_state_changed(i, c, new_state[c]);
 			}
 		}
@@ -1160,7 +1281,10 @@ void keyboard_scan_task(void *u)
 		/* We're about to poll, so any existing forces are fulfilled */
 		force_poll = 0;
 
-		/* Enter polling mode */
+		/* Enter polling mode, reading all columns first */
+#ifdef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+		scans_since_full = 0;
+#endif
 		CPRINTS5("poll");
 		keyboard_raw_enable_interrupt(0);
 		keyboard_raw_drive_column(KEYBOARD_COLUMN_NONE);
@@ -1346,6 +1470,10 @@ static int command_ksstate(int argc, const char **argv)
 	print_state(debounced_state, "debounced ");
 	print_state(debouncing, "debouncing");
 
+	ccprintf("Polling scans: %u (%u full), %u columns read, %u us\n",
+		 scan_stats.scans, scan_stats.full_scans, scan_stats.columns,
+		 scan_stats.scan_us);
+
 	ccprintf("Keyboard scan disable mask: 0x%08x\n", disable_scanning_mask);
 	ccprintf("Keyboard scan state printing %s\n",
 		 print_state_changes ? "on" : "off");
@@ -1403,6 +1531,11 @@ DECLARE_CONSOLE_COMMAND(kbpress, command_keyboard_press, "[col row [0 | 1]]",
 #endif
 
 #ifdef TEST_BUILD
+__test_only void keyboard_scan_get_stats(struct keyboard_scan_stats *stats)
+{
+	*stats = scan_stats;
+}
+
 __test_only int keyboard_scan_get_print_state_changes(void)
 {
 	return print_state_changes;
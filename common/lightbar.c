@@ -8,6 +8,8 @@
 
 #ifdef LIGHTBAR_SIMULATION
 #include "simulation.h"
+
+#include "lightbyte.h"
 #else
 #include "battery.h"
 #include "charge_state.h"
@@ -19,6 +21,7 @@
 #include "lb_common.h"
 #include "lid_switch.h"
 #include "lightbar.h"
+#include "lightbyte.h"
 #include "motion_sense.h"
 #include "pwm.h"
 #include "system.h"
@@ -39,7 +42,7 @@
 #define CPUTS(outstr) cputs(CC_LIGHTBAR, outstr)
 #define CPRINTS(format, args...) cprints(CC_LIGHTBAR, format, ##args)
 
-#define FP_SCALE 10000
+#define FP_SCALE LB_FP_SCALE
 
 /******************************************************************************/
 /* Here's some state that we might want to maintain across sysjumps, just to
@@ -379,36 +382,6 @@ void demo_tap(void)
 /* Helper functions and data. */
 /******************************************************************************/
 
-#define F(x) (x * FP_SCALE)
-static const uint16_t _ramp_table[] = {
-	F(0.000000), F(0.002408), F(0.009607), F(0.021530), F(0.038060),
-	F(0.059039), F(0.084265), F(0.113495), F(0.146447), F(0.182803),
-	F(0.222215), F(0.264302), F(0.308658), F(0.354858), F(0.402455),
-	F(0.450991), F(0.500000), F(0.549009), F(0.597545), F(0.645142),
-	F(0.691342), F(0.735698), F(0.777785), F(0.817197), F(0.853553),
-	F(0.886505), F(0.915735), F(0.940961), F(0.961940), F(0.978470),
-	F(0.990393), F(0.997592), F(1.000000),
-};
-#undef F
-
-/* This function provides a smooth ramp up from 0.0 to 1.0 and back to 0.0,
- * for input from 0x00 to 0xff. */
-static inline int cycle_010(uint8_t i)
-{
-	uint8_t bucket, index;
-
-	if (i == 128)
-		return FP_SCALE;
-	else if (i > 128)
-		i = 256 - i;
-
-	bucket = i >> 2;
-	index = i & 0x3;
-
-	return _ramp_table[bucket] +
-	       ((_ramp_table[bucket + 1] - _ramp_table[bucket]) * index >> 2);
-}
-
 /******************************************************************************/
 /* Here's where we keep messages waiting to be delivered to the lightbar task.
  * If more than one is sent before the task responds, we only want to deliver
@@ -1110,436 +1083,58 @@ static uint32_t sequence_TAP(void)
 /* Lightbar bytecode interpreter: Lightbyte. */
 /****************************************************************************/
 
-/* When a program halts, return this. */
-#define PROGRAM_FINISHED 2
-
-static struct lightbar_program cur_prog;
 static struct lightbar_program next_prog;
-static uint8_t pc;
-
-static uint8_t led_desc[NUM_LEDS][LB_CONT_MAX][3];
-static uint32_t lb_wait_delay;
-static uint32_t lb_ramp_delay;
-/* Get one byte of data pointed to by the pc and advance
- * the pc forward.
- */
-static inline uint32_t decode_8(uint8_t *dest)
-{
-	if (pc >= cur_prog.size) {
-		CPRINTS("pc 0x%02x out of bounds", pc);
-		return EC_RES_INVALID_PARAM;
-	}
-	*dest = cur_prog.data[pc++];
-	return EC_SUCCESS;
-}
-
-/* Get four bytes of data pointed to by the pc and advance
- * the pc forward that amount.
- */
-static inline uint32_t decode_32(uint32_t *dest)
-{
-	if (pc >= cur_prog.size - 3) {
-		CPRINTS("pc 0x%02x near or out of bounds", pc);
-		return EC_RES_INVALID_PARAM;
-	}
-	*dest = cur_prog.data[pc++] << 24;
-	*dest |= cur_prog.data[pc++] << 16;
-	*dest |= cur_prog.data[pc++] << 8;
-	*dest |= cur_prog.data[pc++];
-	return EC_SUCCESS;
-}
-
-/* ON - turn on lightbar */
-static uint32_t lightbyte_ON(void)
-{
-	lb_on();
-	return EC_SUCCESS;
-}
-
-/* OFF - turn off lightbar */
-static uint32_t lightbyte_OFF(void)
-{
-	lb_off();
-	return EC_SUCCESS;
-}
+static struct lightbyte_inst prog_code[EC_LB_PROG_LEN];
+static struct lightbyte_vm prog_vm = { .code = prog_code };
 
-/* JUMP xx - jump to immediate location
- * Changes the pc to the one-byte immediate argument.
- */
-static uint32_t lightbyte_JUMP(void)
+int lightbyte_battery_level(void)
 {
-	return decode_8(&pc);
-}
-
-/* JUMP_BATTERY aa bb - switch on battery level
- * If the battery is low, changes pc to aa.
- * If the battery is high, changes pc to bb.
- * Otherwise, continues execution as normal.
- */
-static uint32_t lightbyte_JUMP_BATTERY(void)
-{
-	uint8_t low_pc, high_pc;
-	if (decode_8(&low_pc) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-	if (decode_8(&high_pc) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-
 	get_battery_level();
-	if (st.battery_level == 0)
-		pc = low_pc;
-	else if (st.battery_level == 3)
-		pc = high_pc;
-
-	return EC_SUCCESS;
-}
-
-/* JUMP_IF_CHARGING xx - conditional jump to location
- * Changes the pc to xx if the device is charging.
- */
-static uint32_t lightbyte_JUMP_IF_CHARGING(void)
-{
-	uint8_t charge_pc;
-	if (decode_8(&charge_pc) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-
-	if (st.battery_is_charging)
-		pc = charge_pc;
-
-	return EC_SUCCESS;
-}
-
-/* SET_WAIT_DELAY xx xx xx xx - set up to yield processor
- * Sets the wait delay to the given four-byte immediate, in
- * microseconds. Future WAIT instructions will wait for this
- * much time.
- */
-static uint32_t lightbyte_SET_WAIT_DELAY(void)
-{
-	return decode_32(&lb_wait_delay);
-}
-
-/* SET_RAMP_DELAY xx xx xx xx - change ramp speed
- * This sets the length of time between ramp/cycle steps to
- * the four-byte immediate argument, which represents a duration
- * in milliseconds.
- */
-static uint32_t lightbyte_SET_RAMP_DELAY(void)
-{
-	return decode_32(&lb_ramp_delay);
-}
-
-/* WAIT - yield processor for some time
- * Yields the processor for some amount of time set by the most
- * recent SET_WAIT_DELAY instruction.
- */
-static uint32_t lightbyte_WAIT(void)
-{
-	if (lb_wait_delay != 0)
-		WAIT_OR_RET(lb_wait_delay);
-
-	return EC_SUCCESS;
-}
-
-/* SET_BRIGHTNESS xx
- * Sets the current brightness to the given one-byte
- * immediate argument.
- */
-static uint32_t lightbyte_SET_BRIGHTNESS(void)
-{
-	uint8_t val;
-	if (decode_8(&val) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-
-	lb_set_brightness(val);
-	return EC_SUCCESS;
-}
-
-/* SET_COLOR_SINGLE cc xx
- * SET_COLOR_RGB cc rr gg bb
- * Stores a color value in the led_desc structure.
- * cc is a bit-packed location to perform the action on.
- *
- * The high four bits are a bitset for which LEDs to operate on.
- * LED 0 is the lowest of the four bits.
- *
- * The next two bits are the control bits. This should be a value
- * in lb_control that is not LB_CONT_MAX, and the corresponding
- * color will be the one the action is performed on.
- *
- * The last two bits are the color bits if this instruction is
- * SET_COLOR_SINGLE. They correspond to a LB_COL value for the
- * channel to set the color for using the next immediate byte.
- * In SET_COLOR_RGB, these bits are don't-cares, as there should
- * always be three bytes that follow, which correspond to a
- * complete RGB specification.
- */
-static uint32_t lightbyte_SET_COLOR_SINGLE(void)
-{
-	uint8_t packed_loc, led, control, color, value;
-	int i;
-	if (decode_8(&packed_loc) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-	if (decode_8(&value) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-
-	led = packed_loc >> 4;
-	control = (packed_loc >> 2) & 0x3;
-	color = packed_loc & 0x3;
-
-	if (control >= LB_CONT_MAX)
-		return EC_RES_INVALID_PARAM;
-
-	for (i = 0; i < NUM_LEDS; i++)
-		if (led & BIT(i))
-			led_desc[i][control][color] = value;
-
-	return EC_SUCCESS;
-}
-
-static uint32_t lightbyte_SET_COLOR_RGB(void)
-{
-	uint8_t packed_loc, r, g, b, led, control;
-	int i;
-
-	/* gross */
-	if (decode_8(&packed_loc) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-	if (decode_8(&r) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-	if (decode_8(&g) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-	if (decode_8(&b) != EC_SUCCESS)
-		return EC_RES_INVALID_PARAM;
-
-	led = packed_loc >> 4;
-	control = (packed_loc >> 2) & 0x3;
-
-	if (control >= LB_CONT_MAX)
-		return EC_RES_INVALID_PARAM;
-
-	for (i = 0; i < NUM_LEDS; i++)
-		if (led & BIT(i)) {
-			led_desc[i][control][LB_COL_RED] = r;
-			led_desc[i][control][LB_COL_GREEN] = g;
-			led_desc[i][control][LB_COL_BLUE] = b;
-		}
-
-	return EC_SUCCESS;
-}
-
-/* GET_COLORS - take current colors and push them to the state
- * Gets the current state of the LEDs and puts them in COLOR0.
- * Good for the beginning of a program if you need to fade in.
- */
-static uint32_t lightbyte_GET_COLORS(void)
-{
-	int i;
-	for (i = 0; i < NUM_LEDS; i++)
-		lb_get_rgb(i, &led_desc[i][LB_CONT_COLOR0][LB_COL_RED],
-			   &led_desc[i][LB_CONT_COLOR0][LB_COL_GREEN],
-			   &led_desc[i][LB_CONT_COLOR0][LB_COL_BLUE]);
-
-	return EC_SUCCESS;
-}
-
-/* SWAP_COLORS - swaps beginning and end colors in state
- * Exchanges COLOR0 and COLOR1 on all LEDs.
- */
-static uint32_t lightbyte_SWAP_COLORS(void)
-{
-	int i, j, tmp;
-	for (i = 0; i < NUM_LEDS; i++)
-		for (j = 0; j < 3; j++) {
-			tmp = led_desc[i][LB_CONT_COLOR0][j];
-			led_desc[i][LB_CONT_COLOR0][j] =
-				led_desc[i][LB_CONT_COLOR1][j];
-			led_desc[i][LB_CONT_COLOR1][j] = tmp;
-		}
-
-	return EC_SUCCESS;
-}
-
-static inline int get_interp_value(int led, int color, int interp)
-{
-	int base = led_desc[led][LB_CONT_COLOR0][color];
-	int delta = led_desc[led][LB_CONT_COLOR1][color] - base;
-	return base + (delta * interp / FP_SCALE);
-}
-
-static void set_all_leds(int color)
-{
-	int i, r, g, b;
-	for (i = 0; i < NUM_LEDS; i++) {
-		r = led_desc[i][color][LB_COL_RED];
-		g = led_desc[i][color][LB_COL_GREEN];
-		b = led_desc[i][color][LB_COL_BLUE];
-		lb_set_rgb(i, r, g, b);
-	}
+	return st.battery_level;
 }
 
-static uint32_t ramp_all_leds(int stop_at)
+int lightbyte_is_charging(void)
 {
-	int w, i, r, g, b, f;
-	for (w = 0; w < stop_at; w++) {
-		f = cycle_010(w);
-		for (i = 0; i < NUM_LEDS; i++) {
-			r = get_interp_value(i, LB_COL_RED, f);
-			g = get_interp_value(i, LB_COL_GREEN, f);
-			b = get_interp_value(i, LB_COL_BLUE, f);
-			lb_set_rgb(i, r, g, b);
-		}
-		WAIT_OR_RET(lb_ramp_delay);
-	}
-	return EC_SUCCESS;
-}
-
-/* RAMP_ONCE - simple gradient or color set
- * If the ramp delay is set to zero, then this sets the color of
- * all LEDs to their respective COLOR1.
- * If the ramp delay is nonzero, then this sets their color to
- * their respective COLOR0, and takes them via interpolation to
- * COLOR1, with the delay time passing in between each step.
- */
-static uint32_t lightbyte_RAMP_ONCE(void)
-{
-	/* special case for instantaneous set */
-	if (lb_ramp_delay == 0) {
-		set_all_leds(LB_CONT_COLOR1);
-		return EC_SUCCESS;
-	}
-
-	return ramp_all_leds(128);
+	return st.battery_is_charging;
 }
 
-/* CYCLE_ONCE - simple cycle or color set
- * If the ramp delay is zero, then this sets the color of all LEDs
- * to their respective COLOR0.
- * If the ramp delay is nonzero, this sets the color of all LEDs
- * to COLOR0, then performs a ramp (as in RAMP_ONCE) to COLOR1,
- * and finally back to COLOR0.
- */
-static uint32_t lightbyte_CYCLE_ONCE(void)
+uint64_t lightbyte_now(void)
 {
-	/* special case for instantaneous set */
-	if (lb_ramp_delay == 0) {
-		set_all_leds(LB_CONT_COLOR0);
-		return EC_SUCCESS;
-	}
-
-	return ramp_all_leds(256);
+	return get_time().val;
 }
 
-/* CYCLE - repeating cycle
- * Indefinitely ramps from COLOR0 to COLOR1, taking into
- * account the PHASE of each component of each color when
- * interpolating. (Different LEDs and different color channels
- * on a single LED can start at different places in the cycle,
- * though they will advance at the same rate.)
- *
- * If the ramp delay is zero, this instruction will error out.
- */
-static uint32_t lightbyte_CYCLE(void)
+uint32_t lightbyte_wait_until(uint64_t t)
 {
-	int w, i, r, g, b;
+	uint64_t now;
 
-	/* what does it mean to cycle indefinitely with 0 delay? */
-	if (lb_ramp_delay == 0)
-		return EC_RES_INVALID_PARAM;
+	/* Other events may wake us early */
+	while ((now = get_time().val) < t)
+		WAIT_OR_RET(t - now < INT32_MAX ? t - now : INT32_MAX);
 
-	for (w = 0;; w++) {
-		for (i = 0; i < NUM_LEDS; i++) {
-			r = get_interp_value(
-				i, LB_COL_RED,
-				cycle_010(
-					(w & 0xff) +
-					led_desc[i][LB_CONT_PHASE][LB_COL_RED]));
-			g = get_interp_value(
-				i, LB_COL_GREEN,
-				cycle_010((w & 0xff) +
-					  led_desc[i][LB_CONT_PHASE]
-						  [LB_COL_GREEN]));
-			b = get_interp_value(
-				i, LB_COL_BLUE,
-				cycle_010((w & 0xff) +
-					  led_desc[i][LB_CONT_PHASE]
-						  [LB_COL_BLUE]));
-			lb_set_rgb(i, r, g, b);
-		}
-		WAIT_OR_RET(lb_ramp_delay);
-	}
 	return EC_SUCCESS;
 }
 
-/* HALT - return with success
- * Show's over. Go back to what you were doing before.
- */
-static uint32_t lightbyte_HALT(void)
-{
-	return PROGRAM_FINISHED;
-}
-
-#undef GET_INTERP_VALUE
-
-#define OP(NAME, BYTES, MNEMONIC) NAME,
-#include "lightbar_opcode_list.h"
-enum lightbyte_opcode { LIGHTBAR_OPCODE_TABLE MAX_OPCODE };
-#undef OP
-
-#define OP(NAME, BYTES, MNEMONIC) lightbyte_##NAME,
-#include "lightbar_opcode_list.h"
-static uint32_t (*lightbyte_dispatch[])(void) = { LIGHTBAR_OPCODE_TABLE };
-#undef OP
-
-#define OP(NAME, BYTES, MNEMONIC) MNEMONIC,
-#include "lightbar_opcode_list.h"
-static const char *const lightbyte_names[] = { LIGHTBAR_OPCODE_TABLE };
-#undef OP
-
 static uint32_t sequence_PROGRAM(void)
 {
 	uint8_t saved_brightness;
-	uint8_t next_inst;
 	uint32_t rc;
-	uint8_t old_pc;
+	int bad_addr;
 
-	/* load next program */
-	memcpy(&cur_prog, &next_prog, sizeof(struct lightbar_program));
+	/* The program was checked when it was set, except from the console */
+	prog_vm.count = lightbyte_decode(&next_prog, prog_code, &bad_addr);
+	if (prog_vm.count < 0) {
+		CPRINTS("LB PROGRAM invalid at 0x%02x", bad_addr);
+		return EC_RES_INVALID_PARAM;
+	}
 
-	/* reset program state */
 	saved_brightness = lb_get_brightness();
-	pc = 0;
-	memset(led_desc, 0, sizeof(led_desc));
-	lb_wait_delay = 0;
-	lb_ramp_delay = 0;
-
 	lb_on();
 	lb_set_brightness(255);
 
-	/* decode-execute loop */
-	for (;;) {
-		old_pc = pc;
-		if (decode_8(&next_inst) != EC_SUCCESS)
-			return EC_RES_INVALID_PARAM;
+	rc = lightbyte_run(&prog_vm);
 
-		if (next_inst >= MAX_OPCODE) {
-			CPRINTS("LB PROGRAM pc: 0x%02x, "
-				"found invalid opcode 0x%02x",
-				old_pc, next_inst);
-			lb_set_brightness(saved_brightness);
-			return EC_RES_INVALID_PARAM;
-		} else {
-			CPRINTS("LB PROGRAM pc: 0x%02x, opcode 0x%02x -> %s",
-				old_pc, next_inst, lightbyte_names[next_inst]);
-			rc = lightbyte_dispatch[next_inst]();
-			if (rc) {
-				lb_set_brightness(saved_brightness);
-				return rc;
-			}
-		}
-
-		/* yield processor in case we are stuck in a tight loop */
-		WAIT_OR_RET(100);
-	}
+	lb_set_brightness(saved_brightness);
+	return rc;
 }
 
 /****************************************************************************/
@@ -1741,6 +1336,8 @@ static enum ec_status lpc_cmd_lightbar(struct host_cmd_handler_args *args)
 		break;
 	case LIGHTBAR_CMD_SET_PROGRAM:
 		CPRINTS("LB_set_program");
+		if (lightbyte_decode(&in->set_program, NULL, NULL) < 0)
+			return EC_RES_INVALID_PARAM;
 		memcpy(&next_prog, &in->set_program,
 		       sizeof(struct lightbar_program));
 		break;
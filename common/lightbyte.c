@@ -0,0 +1,367 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Lightbar bytecode (lightbyte) decoder and interpreter */
+
+#ifdef LIGHTBAR_SIMULATION
+#include "simulation.h"
+#else
+#include "common.h"
+#include "ec_commands.h"
+#include "lb_common.h"
+#include "lightbar.h"
+#endif
+#include "lightbyte.h"
+
+#include <string.h>
+
+#define OP(NAME, BYTES, MNEMONIC) BYTES,
+#include "lightbar_opcode_list.h"
+static const uint8_t num_operands[] = { LIGHTBAR_OPCODE_TABLE };
+#undef OP
+
+#define F(x) ((uint16_t)(x * LB_FP_SCALE))
+static const uint16_t _ramp_table[] = {
+	F(0.000000), F(0.002408), F(0.009607), F(0.021530), F(0.038060),
+	F(0.059039), F(0.084265), F(0.113495), F(0.146447), F(0.182803),
+	F(0.222215), F(0.264302), F(0.308658), F(0.354858), F(0.402455),
+	F(0.450991), F(0.500000), F(0.549009), F(0.597545), F(0.645142),
+	F(0.691342), F(0.735698), F(0.777785), F(0.817197), F(0.853553),
+	F(0.886505), F(0.915735), F(0.940961), F(0.961940), F(0.978470),
+	F(0.990393), F(0.997592), F(1.000000),
+};
+#undef F
+
+int cycle_010(uint8_t i)
+{
+	uint8_t bucket, index;
+
+	if (i == 128)
+		return LB_FP_SCALE;
+	else if (i > 128)
+		i = 256 - i;
+
+	bucket = i >> 2;
+	index = i & 0x3;
+
+	return _ramp_table[bucket] +
+	       ((_ramp_table[bucket + 1] - _ramp_table[bucket]) * index >> 2);
+}
+
+/****************************************************************************/
+/* Decoder */
+
+/* Marks a byte address that doesn't start an instruction */
+#define NOT_INST 0xff
+
+/* Fields of the location byte of SET_COLOR_* */
+#define LOC_LED(loc) ((loc) >> 4)
+#define LOC_CONTROL(loc) (((loc) >> 2) & 0x3)
+#define LOC_COLOR(loc) ((loc) & 0x3)
+
+BUILD_ASSERT(sizeof(struct lightbyte_inst) == 5);
+
+int lightbyte_decode(const struct lightbar_program *prog,
+		     struct lightbyte_inst *code, int *bad_addr)
+{
+	uint8_t inst_at[EC_LB_PROG_LEN];
+	struct lightbyte_inst inst;
+	const uint8_t *arg;
+	int addr = EC_LB_PROG_LEN, count = 0, i;
+
+	if (prog->size > EC_LB_PROG_LEN)
+		goto invalid;
+
+	/* Find where the instructions start, so jumps can be checked. */
+	memset(inst_at, NOT_INST, sizeof(inst_at));
+	for (addr = 0; addr < prog->size;
+	     addr += 1 + num_operands[prog->data[addr]]) {
+		if (prog->data[addr] >= MAX_OPCODE ||
+		    addr + num_operands[prog->data[addr]] >= prog->size)
+			goto invalid;
+		inst_at[addr] = count++;
+	}
+
+	for (addr = 0; addr < prog->size; addr += 1 + num_operands[inst.op]) {
+		memset(&inst, 0, sizeof(inst));
+		inst.op = prog->data[addr];
+		arg = &prog->data[addr + 1];
+
+		switch (inst.op) {
+		case JUMP_BATTERY:
+		case JUMP:
+		case JUMP_IF_CHARGING:
+			for (i = 0; i < num_operands[inst.op]; i++) {
+				if (arg[i] >= prog->size ||
+				    inst_at[arg[i]] == NOT_INST)
+					goto invalid;
+				inst.target[i] = inst_at[arg[i]];
+			}
+			break;
+		case SET_WAIT_DELAY:
+		case SET_RAMP_DELAY:
+			memcpy(inst.delay, arg, sizeof(inst.delay));
+			break;
+		case SET_BRIGHTNESS:
+			inst.value = arg[0];
+			break;
+		case SET_COLOR_SINGLE:
+		case SET_COLOR_RGB:
+			/* The lb_color is only used by SET_COLOR_SINGLE */
+			if (LOC_CONTROL(arg[0]) >= LB_CONT_MAX ||
+			    (inst.op == SET_COLOR_SINGLE &&
+			     LOC_COLOR(arg[0]) >= LB_COL_ALL))
+				goto invalid;
+			memcpy(&inst.color, arg, 1 + num_operands[inst.op]);
+			break;
+		default:
+			break;
+		}
+
+		if (code)
+			code[inst_at[addr]] = inst;
+	}
+
+	return count;
+
+invalid:
+	if (bad_addr)
+		*bad_addr = addr;
+	return -1;
+}
+
+/****************************************************************************/
+/* Interpreter */
+
+static uint32_t get_delay(const struct lightbyte_inst *inst)
+{
+	return (uint32_t)inst->delay[0] << 24 | inst->delay[1] << 16 |
+	       inst->delay[2] << 8 | inst->delay[3];
+}
+
+static inline int get_interp_value(const struct lightbyte_vm *vm, int led,
+				   int color, int interp)
+{
+	int base = vm->led_desc[led][LB_CONT_COLOR0][color];
+	int delta = vm->led_desc[led][LB_CONT_COLOR1][color] - base;
+
+	return base + (delta * interp / LB_FP_SCALE);
+}
+
+static void set_all_leds(const struct lightbyte_vm *vm, int control)
+{
+	int i;
+
+	for (i = 0; i < NUM_LEDS; i++)
+		lb_set_rgb(i, vm->led_desc[i][control][LB_COL_RED],
+			   vm->led_desc[i][control][LB_COL_GREEN],
+			   vm->led_desc[i][control][LB_COL_BLUE]);
+}
+
+/*
+ * Start the next timed step at the scheduled time, unless the program has
+ * fallen more than a step behind. Then catching up would rush the following
+ * steps, so start from now instead.
+ */
+static uint64_t step_start(struct lightbyte_vm *vm, uint32_t step_us)
+{
+	uint64_t now = lightbyte_now();
+
+	if (vm->tick + step_us < now)
+		vm->tick = now;
+	vm->waited = true;
+
+	return vm->tick;
+}
+
+/* Wait for the next frame, but no later than the end of the current step */
+static uint32_t wait_frame(uint64_t step_end, uint64_t end)
+{
+	uint64_t t = lightbyte_now() + LIGHTBYTE_FRAME_US;
+
+	if (t < step_end)
+		t = step_end;
+	if (end && t > end)
+		t = end;
+
+	return lightbyte_wait_until(t);
+}
+
+/*
+ * Move the LEDs through cycle_010() in steps of vm->ramp_delay. The colors
+ * are computed from the time, once per frame, so a slow LED update skips
+ * steps instead of stretching the ramp. stop_at == 0 cycles forever with
+ * each color channel shifted by its phase.
+ */
+static uint32_t ramp_all_leds(struct lightbyte_vm *vm, int stop_at)
+{
+	const uint64_t start = step_start(vm, vm->ramp_delay);
+	const uint64_t end = start + (uint64_t)stop_at * vm->ramp_delay;
+	uint64_t w;
+	uint32_t rc;
+	int c[3];
+	int i, j, f;
+
+	for (;;) {
+		w = (lightbyte_now() - start) / vm->ramp_delay;
+		if (stop_at && w >= stop_at)
+			break;
+
+		for (i = 0; i < NUM_LEDS; i++) {
+			const uint8_t *phase = vm->led_desc[i][LB_CONT_PHASE];
+
+			for (j = 0; j < 3; j++) {
+				f = cycle_010(w + (stop_at ? 0 : phase[j]));
+				c[j] = get_interp_value(vm, i, j, f);
+			}
+			lb_set_rgb(i, c[LB_COL_RED], c[LB_COL_GREEN],
+				   c[LB_COL_BLUE]);
+		}
+
+		rc = wait_frame(start + (w + 1) * vm->ramp_delay,
+				stop_at ? end : 0);
+		if (rc)
+			return rc;
+	}
+
+	vm->tick = end;
+	return EC_SUCCESS;
+}
+
+/* Execute one instruction and advance the pc. */
+static uint32_t lightbyte_step(struct lightbyte_vm *vm)
+{
+	const struct lightbyte_inst *inst = &vm->code[vm->pc++];
+	/* Only meaningful for SET_COLOR_* */
+	const uint8_t loc = inst->color.loc;
+	const int control = LOC_CONTROL(loc);
+	int i, j, tmp, next = -1;
+
+	switch (inst->op) {
+	case ON:
+		lb_on();
+		break;
+	case OFF:
+		lb_off();
+		break;
+	case JUMP:
+		next = inst->target[0];
+		break;
+	case JUMP_BATTERY:
+		switch (lightbyte_battery_level()) {
+		case 0:
+			next = inst->target[0];
+			break;
+		case 3:
+			next = inst->target[1];
+			break;
+		}
+		break;
+	case JUMP_IF_CHARGING:
+		if (lightbyte_is_charging())
+			next = inst->target[0];
+		break;
+	case SET_WAIT_DELAY:
+		vm->wait_delay = get_delay(inst);
+		break;
+	case SET_RAMP_DELAY:
+		vm->ramp_delay = get_delay(inst);
+		break;
+	case WAIT:
+		if (vm->wait_delay) {
+			vm->tick = step_start(vm, vm->wait_delay) +
+				   vm->wait_delay;
+			return lightbyte_wait_until(vm->tick);
+		}
+		break;
+	case SET_BRIGHTNESS:
+		lb_set_brightness(inst->value);
+		break;
+	case SET_COLOR_SINGLE:
+		for (i = 0; i < NUM_LEDS; i++)
+			if (LOC_LED(loc) & BIT(i))
+				vm->led_desc[i][control][LOC_COLOR(loc)] =
+					inst->color.rgb[0];
+		break;
+	case SET_COLOR_RGB:
+		for (i = 0; i < NUM_LEDS; i++)
+			if (LOC_LED(loc) & BIT(i))
+				memcpy(vm->led_desc[i][control],
+				       inst->color.rgb, sizeof(inst->color.rgb));
+		break;
+	case GET_COLORS:
+		/* Good for the beginning of a program that fades in */
+		for (i = 0; i < NUM_LEDS; i++)
+			lb_get_rgb(i, &vm->led_desc[i][LB_CONT_COLOR0][0],
+				   &vm->led_desc[i][LB_CONT_COLOR0][1],
+				   &vm->led_desc[i][LB_CONT_COLOR0][2]);
+		break;
+	case SWAP_COLORS:
+		for (i = 0; i < NUM_LEDS; i++)
+			for (j = 0; j < 3; j++) {
+				tmp = vm->led_desc[i][LB_CONT_COLOR0][j];
+				vm->led_desc[i][LB_CONT_COLOR0][j] =
+					vm->led_desc[i][LB_CONT_COLOR1][j];
+				vm->led_desc[i][LB_CONT_COLOR1][j] = tmp;
+			}
+		break;
+	case RAMP_ONCE:
+		/* Without a ramp delay, just set the colors */
+		if (!vm->ramp_delay) {
+			set_all_leds(vm, LB_CONT_COLOR1);
+			break;
+		}
+		return ramp_all_leds(vm, 128);
+	case CYCLE_ONCE:
+		if (!vm->ramp_delay) {
+			set_all_leds(vm, LB_CONT_COLOR0);
+			break;
+		}
+		return ramp_all_leds(vm, 256);
+	case CYCLE:
+		/* Cycling forever with no delay means nothing */
+		if (!vm->ramp_delay)
+			return EC_RES_INVALID_PARAM;
+		return ramp_all_leds(vm, 0);
+	case HALT:
+		return LIGHTBYTE_FINISHED;
+	}
+
+	if (next < 0)
+		return EC_SUCCESS;
+
+	/* Give up the CPU in a loop that doesn't wait by itself */
+	if (next < vm->pc && !vm->waited) {
+		vm->pc = next;
+		return lightbyte_wait_until(lightbyte_now() +
+					    LIGHTBYTE_YIELD_US);
+	}
+	if (next < vm->pc)
+		vm->waited = false;
+	vm->pc = next;
+
+	return EC_SUCCESS;
+}
+
+uint32_t lightbyte_run(struct lightbyte_vm *vm)
+{
+	uint32_t rc;
+
+	vm->pc = 0;
+	memset(vm->led_desc, 0, sizeof(vm->led_desc));
+	vm->wait_delay = 0;
+	vm->ramp_delay = 0;
+	vm->tick = lightbyte_now();
+	vm->waited = false;
+
+	do {
+		/* Running off the end of the program is an error */
+		if (vm->pc >= vm->count)
+			return EC_RES_INVALID_PARAM;
+		rc = lightbyte_step(vm);
+	} while (!rc);
+
+	return rc;
+}
@@ -0,0 +1 @@
+lightbyte.c
\ No newline at end of file
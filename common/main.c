@@ -32,6 +32,7 @@
 #include "panic.h"
 #include "rwsig.h"
 #include "system.h"
+#include "system_boot_time.h"
 #include "task.h"
 #include "timer.h"
 #include "uart.h"
@@ -144,6 +145,8 @@ test_mockable __keep int main(void)
 		system_compensate_rtc();
 
 	/* Main initialization stage.  Modules may enable interrupts here. */
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+		       EC_BOOT_TIME_STAGE_CHIP_INIT);
 	cpu_init();
 
 #ifdef CONFIG_DMA_CROS
@@ -153,6 +156,8 @@ test_mockable __keep int main(void)
 
 	/* Initialize UART.  Console output functions may now be used. */
 	uart_init();
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+		       EC_BOOT_TIME_STAGE_CHIP_INIT);
 
 	/* We wait to report the failure until here where we have console. */
 	if (mpu_pre_init_rv != EC_SUCCESS)
@@ -206,6 +211,8 @@ test_mockable __keep int main(void)
 		 * Some devices (like the I2C keyboards, CBI) need I2C access
 		 * pretty early, so let's initialize the controller now.
 		 */
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+			       EC_BOOT_TIME_STAGE_I2C_INIT);
 		i2c_init();
 
 		if (IS_ENABLED(CONFIG_I2C_BITBANG)) {
@@ -218,14 +225,22 @@ test_mockable __keep int main(void)
 			/* Board level pre-task I2C peripheral initialization */
 			board_pre_task_i2c_peripheral_init();
 		}
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+			       EC_BOOT_TIME_STAGE_I2C_INIT);
 	}
 
 	/*
 	 * Copy this line in case you need even earlier hooks instead of moving
 	 * it. Callbacks of this type are expected to handle multiple calls.
 	 */
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+		       EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY);
 	hook_notify(HOOK_INIT_EARLY);
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+		       EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY);
 
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+		       EC_BOOT_TIME_STAGE_KEYBOARD_INIT);
 #ifdef HAS_TASK_KEYSCAN
 
 #ifdef CONFIG_KEYBOARD_SCAN_ADC
@@ -242,6 +257,8 @@ test_mockable __keep int main(void)
 #if defined(CONFIG_DEDICATED_RECOVERY_BUTTON) || defined(CONFIG_VOLUME_BUTTONS)
 	button_init();
 #endif /* defined(CONFIG_DEDICATED_RECOVERY_BUTTON | CONFIG_VOLUME_BUTTONS) */
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+		       EC_BOOT_TIME_STAGE_KEYBOARD_INIT);
 
 	/* Make sure recovery boot won't be paused. */
 	if (IS_ENABLED(CONFIG_POWER_BUTTON_INIT_IDLE) &&
@@ -251,6 +268,8 @@ test_mockable __keep int main(void)
 		system_clear_reset_flags(EC_RESET_FLAG_AP_IDLE);
 	}
 
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+		       EC_BOOT_TIME_STAGE_VERIFIED_BOOT);
 #if defined(CONFIG_VBOOT_EFS) || defined(CONFIG_VBOOT_EFS2)
 	/*
 	 * Execute PMIC reset in case we're here after watchdog reset to unwedge
@@ -287,6 +306,8 @@ test_mockable __keep int main(void)
 		}
 	}
 #endif /* !CONFIG_VBOOT_EFS && CONFIG_RWSIG && !HAS_TASK_RWSIG */
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+		       EC_BOOT_TIME_STAGE_VERIFIED_BOOT);
 
 	/*
 	 * Disable I2C raw mode for the ports which needed pre-task i2c
@@ -302,6 +323,8 @@ test_mockable __keep int main(void)
 	 * the majority of the time.
 	 */
 	CPRINTS("Inits done");
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, 0,
+		       EC_BOOT_TIME_STAGE_TASK_START);
 
 	/* Launch task scheduling (never returns) */
 	return task_start();
@@ -8,11 +8,13 @@
 #include "atomic.h"
 #include "common.h"
 #include "keyboard_config.h"
+#include "keyboard_latency.h"
 #include "keyboard_scan.h"
 #include "mkbp_event.h"
 #include "mkbp_fifo.h"
 #include "system.h"
 #include "task.h"
+#include "timer.h"
 #include "util.h"
 
 /* Console output macros */
@@ -33,6 +35,14 @@ static atomic_t fifo_entries; /* number of existing entries */
 static uint8_t fifo_max_depth = FIFO_DEPTH;
 static struct ec_response_get_next_event_v3 fifo[FIFO_DEPTH];
 
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+/* Timestamps of the keyboard entries, indexed like fifo[] */
+static struct {
+	uint32_t detect_us;
+	uint32_t enqueue_us;
+} key_stamp[FIFO_DEPTH];
+#endif
+
 #ifdef CONFIG_KEYBOARD_PROTOCOL_MKBP
 /* Check the FIFO size from the keyboard perspective. */
 BUILD_ASSERT(sizeof(fifo[0].data) >= KEYBOARD_COLS_MAX);
@@ -139,8 +149,12 @@ void mkbp_fifo_clear_keyboard(void)
 		int cur = (fifo_start + i) % FIFO_DEPTH;
 
 		/* Drop keyboard events */
-		if (fifo[cur].event_type == EC_MKBP_EVENT_KEY_MATRIX)
+		if (fifo[cur].event_type == EC_MKBP_EVENT_KEY_MATRIX) {
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+			keyboard_latency_dropped(EC_KB_LATENCY_PATH_MKBP, 1);
+#endif
 			continue;
+		}
 
 		/* And move other events to the front */
 		memmove(&fifo[fifo_end], &fifo[cur], sizeof(fifo[cur]));
@@ -185,6 +199,10 @@ test_mockable int mkbp_fifo_add(uint8_t event_type, const uint8_t *buffp)
 	if (fifo_entries >= fifo_max_depth) {
 		mutex_unlock(&fifo_add_mutex);
 		CPRINTS("MKBP common FIFO depth %d reached", fifo_max_depth);
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+		if (event_type == EC_MKBP_EVENT_KEY_MATRIX)
+			keyboard_latency_dropped(EC_KB_LATENCY_PATH_MKBP, 1);
+#endif
 
 		return EC_ERROR_OVERFLOW;
 	}
@@ -192,6 +210,12 @@ test_mockable int mkbp_fifo_add(uint8_t event_type, const uint8_t *buffp)
 	size = get_data_size(event_type);
 	fifo[fifo_end].event_type = event_type;
 	memcpy(&fifo[fifo_end].data, buffp, size);
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+	if (event_type == EC_MKBP_EVENT_KEY_MATRIX) {
+		key_stamp[fifo_end].detect_us = keyboard_latency_claim();
+		key_stamp[fifo_end].enqueue_us = get_time().le.lo;
+	}
+#endif
 	fifo_end = (fifo_end + 1) % FIFO_DEPTH;
 	atomic_add(&fifo_entries, 1);
 
@@ -200,8 +224,13 @@ test_mockable int mkbp_fifo_add(uint8_t event_type, const uint8_t *buffp)
 	 * asleep. In this case, we don't want to queue our event, except if
 	 * another event just woke the host (and wake is already in progress).
 	 */
-	if (!mkbp_send_event(event_type) && fifo_entries == 1)
+	if (!mkbp_send_event(event_type) && fifo_entries == 1) {
 		fifo_remove(NULL);
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+		if (event_type == EC_MKBP_EVENT_KEY_MATRIX)
+			keyboard_latency_dropped(EC_KB_LATENCY_PATH_MKBP, 1);
+#endif
+	}
 
 	mutex_unlock(&fifo_add_mutex);
 	return EC_SUCCESS;
@@ -229,6 +258,14 @@ int mkbp_fifo_get_next_event(uint8_t *out, enum ec_mkbp_event evt)
 		return -EC_ERROR_BUSY;
 	}
 
+#ifdef CONFIG_KEYBOARD_LATENCY_STATS
+	if (t == EC_MKBP_EVENT_KEY_MATRIX)
+		keyboard_latency_record(EC_KB_LATENCY_PATH_MKBP,
+					key_stamp[fifo_start].detect_us,
+					key_stamp[fifo_start].enqueue_us,
+					get_time().le.lo);
+#endif
+
 	fifo_remove(out);
 
 	/* Keep sending events if FIFO is not empty */
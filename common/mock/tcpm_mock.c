@@ -32,6 +32,7 @@ int tcpm_dequeue_message(int port, uint32_t *payload, int *header)
 	*header = mock_tcpm[port].mock_header;
 	memcpy(payload, mock_tcpm[port].mock_rx_chk_buf,
 	       sizeof(mock_tcpm[port].mock_rx_chk_buf));
+	mock_tcpm[port].mock_has_pending_message = 0;
 
 	return EC_SUCCESS;
 }
@@ -46,6 +46,12 @@ static int lid_angle_deg;
 
 static int lid_angle_is_reliable;
 
+/* Confidence in the current lid angle, in percent. */
+static int lid_angle_confidence;
+
+/* Earliest time to publish a new lid angle, see CONFIG_LID_ANGLE_PUBLISH_MS */
+static timestamp_t next_publish;
+
 /* Smoothed vectors to increase accurency. */
 static intv3_t smoothed_base, smoothed_lid;
 
@@ -71,6 +77,13 @@ static intv3_t smoothed_base, smoothed_lid;
  */
 #define NOISY_MAGNITUDE_DEVIATION ((int)(MOTION_SCALING_FACTOR / MOTION_ONE_G))
 
+/*
+ * Difference between the squared magnitude of a vector and 1g^2 that costs
+ * 1% of confidence: at 100%, the vector is rejected as too noisy.
+ */
+#define MAGNITUDE_DEVIATION_PER_PERCENT \
+	(2 * MOTION_SCALING_FACTOR * NOISY_MAGNITUDE_DEVIATION / 100)
+
 /*
  * Even with noise, any measurement greater than 1g on any axis is not suitable
  * for lid calculation. It means the device is moving.
@@ -286,16 +299,18 @@ static void motion_lid_set_dptf_profile(int reliable)
  * @param base Base accel vector
  * @param lid  Lid accel vector
  * @param lid_angle Pointer to location to store lid angle result
+ * @param confidence Pointer to location to store the confidence in the
+ *		     result, in percent
  *
  * @return flag representing if resulting lid angle calculation is reliable.
  */
 static int calculate_lid_angle(const intv3_t base, const intv3_t lid,
-			       int *lid_angle)
+			       int *lid_angle, int *confidence)
 {
 	intv3_t cross, proj_lid, proj_base, scaled_base, scaled_lid;
 	fp_t lid_to_base_fp, smoothed_ratio;
 	int base_magnitude2, lid_magnitude2, largest_hinge_accel;
-	int reliable = 1, i;
+	int reliable = 1, conf = 0, i;
 
 	/*
 	 * Scale the vectors by their range, to be able to compare them.
@@ -373,6 +388,17 @@ static int calculate_lid_angle(const intv3_t base, const intv3_t lid,
 		goto end_calculate_lid_angle;
 	}
 
+	/*
+	 * Trust the angle less as the magnitudes move away from 1g, and as the
+	 * hinge gets vertical and the smoothing takes over.
+	 */
+	conf = 100 - MAX(ABS(MOTION_SCALING_FACTOR2 - base_magnitude2),
+			 ABS(MOTION_SCALING_FACTOR2 - lid_magnitude2)) /
+			     MAGNITUDE_DEVIATION_PER_PERCENT;
+	conf = MIN(conf, FP_TO_INT(fp_mul(INT_TO_FP(100),
+					  INT_TO_FP(1) - smoothed_ratio)));
+	conf = MAX(conf, 0);
+
 	/* Smooth input to reduce calculation error due to noise. */
 	vector_scale(smoothed_base, smoothed_ratio);
 	vector_scale(smoothed_lid, smoothed_ratio);
@@ -472,6 +498,7 @@ end_calculate_lid_angle:
 	if (reliable)
 		*lid_angle = FP_TO_INT(lid_to_base_fp + FLOAT_TO_FP(0.5));
 #endif
+	*confidence = reliable ? conf : 0;
 	return reliable;
 }
 
@@ -483,14 +510,32 @@ int motion_lid_get_angle(void)
 		return LID_ANGLE_UNRELIABLE;
 }
 
+int motion_lid_get_confidence(void)
+{
+	return lid_angle_is_reliable ? lid_angle_confidence : 0;
+}
+
 /*
  * Calculate lid angle and massage the results
  */
 void motion_lid_calc(void)
 {
+	timestamp_t now = get_time();
+	int angle = lid_angle_deg, confidence, reliable;
+
 	/* Calculate angle of lid accel. */
-	lid_angle_is_reliable = calculate_lid_angle(
-		accel_base->xyz, accel_lid->xyz, &lid_angle_deg);
+	reliable = calculate_lid_angle(accel_base->xyz, accel_lid->xyz, &angle,
+				       &confidence);
+
+	/* Tablet mode was updated above, only the published angle waits. */
+	if (reliable == lid_angle_is_reliable &&
+	    !timestamp_expired(next_publish, &now))
+		return;
+
+	next_publish.val = now.val + CONFIG_LID_ANGLE_PUBLISH_MS * MSEC;
+	lid_angle_deg = angle;
+	lid_angle_is_reliable = reliable;
+	lid_angle_confidence = confidence;
 
 	if (IS_ENABLED(CONFIG_LID_ANGLE_UPDATE))
 		lid_angle_update(motion_lid_get_angle());
@@ -533,6 +578,13 @@ enum ec_status host_cmd_motion_lid(struct host_cmd_handler_args *args)
 	case MOTIONSENSE_CMD_LID_ANGLE:
 		if (IS_ENABLED(CONFIG_LID_ANGLE)) {
 			out->lid_angle.value = motion_lid_get_angle();
+			/* Older hosts only have room for the angle. */
+			if (args->response_max < sizeof(out->lid_angle)) {
+				args->response_size =
+					sizeof(out->lid_angle.value);
+				break;
+			}
+			out->lid_angle.confidence = motion_lid_get_confidence();
 			args->response_size = sizeof(out->lid_angle);
 		} else {
 			return EC_RES_INVALID_PARAM;
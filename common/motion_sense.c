@@ -44,7 +44,10 @@ static atomic_t motion_sense_task_loops;
 /* When we started the task the last time */
 static timestamp_t ts_begin_task;
 
-/* Minimum time in between running motion sense task loop. */
+/*
+ * Minimum time in between the start of two motion sense task loops. Sensors
+ * due within that time are read early, in the same loop.
+ */
 unsigned int motion_min_interval = CONFIG_MOTION_MIN_SENSE_WAIT_TIME * MSEC;
 STATIC_IF(CONFIG_CMD_ACCEL_INFO) int accel_disp;
 
@@ -63,6 +66,9 @@ test_export_static enum chipset_state_mask sensor_active;
  */
 test_export_static int wait_us;
 
+/* Read timing of the sensors in forced mode, shown by accelinfo */
+test_export_static struct motion_sense_jitter sensor_jitter[MAX_MOTION_SENSORS];
+
 STATIC_IF(CONFIG_ACCEL_SPOOF_MODE) void print_spoof_mode_status(int id);
 STATIC_IF(CONFIG_GESTURE_DETECTION)
 void check_and_queue_gestures(uint32_t *event);
@@ -92,7 +98,6 @@ __attribute__((weak)) int sensor_board_is_lid_angle_available(void)
 }
 #endif
 
-STATIC_IF_NOT(CONFIG_TEST)
 enum sensor_config motion_sense_get_ec_config(void)
 {
 	switch (sensor_active) {
@@ -638,6 +643,29 @@ static int motion_sense_read(struct motion_sensor_t *sensor)
 	return sensor->drv->read(sensor, sensor->raw_xyz);
 }
 
+static void record_jitter(const struct motion_sensor_t *sensor,
+			  const timestamp_t *ts)
+{
+	struct motion_sense_jitter *j = &sensor_jitter[sensor - motion_sensors];
+	int32_t delta = time_until(sensor->next_collection, ts->le.lo);
+	uint32_t us = ABS(delta);
+	int i = 0;
+
+	while (i < MOTION_SENSE_JITTER_BUCKETS - 1 &&
+	       us >= (MOTION_SENSE_JITTER_BUCKET_BASE_US << i))
+		i++;
+
+	j->samples++;
+	j->buckets[i]++;
+	if (delta < 0) {
+		j->early++;
+		j->max_early_us = MAX(j->max_early_us, us);
+	} else if (delta > 0) {
+		j->late++;
+		j->max_late_us = MAX(j->max_late_us, us);
+	}
+}
+
 static inline void increment_sensor_collection(struct motion_sensor_t *sensor,
 					       const timestamp_t *ts)
 {
@@ -752,6 +780,9 @@ static int motion_sense_process(struct motion_sensor_t *sensor, uint32_t *event,
 
 	if (motion_sensor_in_forced_mode(sensor)) {
 		if (motion_sensor_time_to_read(ts, sensor)) {
+			timestamp_t now = get_time();
+
+			record_jitter(sensor, &now);
 			/*
 			 * Since motion_sense_read can sleep, other task may be
 			 * scheduled. In particular if suspend is called by
@@ -889,6 +920,63 @@ static void check_and_queue_gestures(uint32_t *event)
 }
 #endif
 
+/*
+ * The task waits at least this fraction of motion_min_interval after a loop,
+ * and longer unless a sensor in forced mode is due sooner.
+ */
+#define MOTION_MIN_WAIT_FRACTION 4
+
+/*
+ * Time to wait for the next sensor in forced mode to be due, or -1 if none
+ * is. Interrupts from the other sensors wake the task on their own.
+ */
+static int motion_sense_next_wait(const timestamp_t *ts_end)
+{
+	enum sensor_config cfg_index = motion_sense_get_ec_config();
+	uint32_t deadline, ec_deadline, wake = 0;
+	bool found = false;
+	int i, wait;
+
+	for (i = 0; i < motion_sensor_count; i++) {
+		const struct motion_sensor_t *sensor = &motion_sensors[i];
+
+		if (!motion_sensor_in_forced_mode(sensor) ||
+		    sensor->collection_rate == 0)
+			continue;
+
+		deadline = sensor->next_collection;
+		if (IS_ENABLED(CONFIG_SENSOR_EC_RATE_FORCE_MODE) &&
+		    cfg_index != SENSOR_CONFIG_EC_S0) {
+			/* Don't poll faster than the EC rate when suspended */
+			ec_deadline = ts_end->le.lo +
+				      sensor->config[cfg_index].ec_rate;
+			if (time_after(ec_deadline, deadline))
+				deadline = ec_deadline;
+		}
+
+		if (!found || time_after(wake, deadline))
+			wake = deadline;
+		found = true;
+	}
+
+	if (!found)
+		return -1;
+
+	/*
+	 * Sensors due before the minimum interval was up were read early in
+	 * this loop, so the earliest deadline left is normally past it.
+	 */
+	if (time_after(ts_begin_task.le.lo + motion_min_interval, wake))
+		wake = ts_begin_task.le.lo + motion_min_interval;
+
+	/*
+	 * Guarantee some delay after the loop to allow other lower priority
+	 * tasks to run, even when a sensor is already due.
+	 */
+	wait = time_until(ts_end->le.lo, wake);
+	return MAX(wait, (int)motion_min_interval / MOTION_MIN_WAIT_FRACTION);
+}
+
 /*
  * Motion Sense Task
  * Requirement: motion_sensors[] are defined in board.c file.
@@ -900,7 +988,6 @@ void motion_sense_task(void *u)
 {
 	int i, ret, sample_id = 0;
 	timestamp_t ts_end_task;
-	int32_t time_diff;
 	uint32_t event = 0;
 	uint16_t ready_status = 0;
 	struct motion_sensor_t *sensor;
@@ -997,46 +1084,18 @@ void motion_sense_task(void *u)
 		}
 
 		ts_end_task = get_time();
-		wait_us = -1;
-
-		for (i = 0; i < motion_sensor_count; i++) {
-			struct motion_sensor_t *sensor = &motion_sensors[i];
-			enum sensor_config cfg_index =
-				motion_sense_get_ec_config();
-			int ec_rate = 0;
-
-			if (!motion_sensor_in_forced_mode(sensor) ||
-			    sensor->collection_rate == 0)
-				continue;
-
-			if (IS_ENABLED(CONFIG_SENSOR_EC_RATE_FORCE_MODE) &&
-			    cfg_index != SENSOR_CONFIG_EC_S0) {
-				ec_rate = sensor->config[cfg_index].ec_rate;
-			}
-
-			time_diff = MAX(time_until(ts_end_task.le.lo,
-						   sensor->next_collection),
-					ec_rate);
-
-			/* We missed our collection time so wake soon */
-			if (time_diff <= 0) {
-				wait_us = 0;
-				break;
-			}
-
-			if (wait_us == -1 || wait_us > time_diff)
-				wait_us = time_diff;
-		}
-
-		if (wait_us >= 0 && wait_us < motion_min_interval) {
-			/*
-			 * Guarantee some minimum delay to allow other lower
-			 * priority tasks to run.
-			 */
-			wait_us = motion_min_interval;
-		}
+		wait_us = motion_sense_next_wait(&ts_end_task);
 
 		event = task_wait_event(wait_us);
+
+		/*
+		 * Samples batched in the hardware FIFOs must reach the AP
+		 * before the flush event: run the irq handlers, which drain
+		 * their FIFO when they see the pending flush.
+		 */
+		if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH) &&
+		    (event & TASK_EVENT_MOTION_FLUSH_PENDING))
+			event |= TASK_EVENT_MOTION_INTERRUPT_MASK;
 	}
 }
 
@@ -1178,6 +1237,11 @@ static enum ec_status host_cmd_motion_sense(struct host_cmd_handler_args *args)
 					MAX(new_ec_rate, motion_min_interval);
 			sensor->config[SENSOR_CONFIG_AP].ec_rate = new_ec_rate;
 
+			/* Let the driver resize its hardware FIFO batch. */
+			if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH))
+				atomic_or(&odr_event_required,
+					  BIT(sensor - motion_sensors));
+
 			/* Force a collection to purge old events.  */
 			task_set_event(TASK_ID_MOTIONSENSE,
 				       TASK_EVENT_MOTION_ODR_CHANGE);
@@ -1814,6 +1878,28 @@ static int command_accel_init(int argc, const char **argv)
 DECLARE_CONSOLE_COMMAND(accelinit, command_accel_init, "id", "Init sensor");
 
 #ifdef CONFIG_CMD_ACCEL_INFO
+static void print_jitter(int id)
+{
+	const struct motion_sense_jitter *jit = &sensor_jitter[id];
+	uint32_t limit;
+	int i;
+
+	if (!jit->samples)
+		return;
+
+	ccprintf("jitter: %u reads, %u early (max %uus), %u late (max %uus)\n",
+		 jit->samples, jit->early, jit->max_early_us, jit->late,
+		 jit->max_late_us);
+	for (i = 0; i < MOTION_SENSE_JITTER_BUCKETS; i++) {
+		limit = MOTION_SENSE_JITTER_BUCKET_BASE_US << i;
+		if (i < MOTION_SENSE_JITTER_BUCKETS - 1)
+			ccprintf("  <  %5uus: %u\n", limit, jit->buckets[i]);
+		else
+			ccprintf("  >= %5uus: %u\n", limit / 2,
+				 jit->buckets[i]);
+	}
+}
+
 static int command_display_accel_info(int argc, const char **argv)
 {
 	int val, i, j;
@@ -1821,6 +1907,11 @@ static int command_display_accel_info(int argc, const char **argv)
 	if (argc >= 3)
 		return EC_ERROR_PARAM_COUNT;
 
+	if (argc == 2 && !strcasecmp(argv[1], "clear")) {
+		memset(sensor_jitter, 0, sizeof(sensor_jitter));
+		return EC_SUCCESS;
+	}
+
 	ccprintf("Motion sensors count = %d\n", motion_sensor_count);
 
 	/* Print motion sensor info. */
@@ -1843,6 +1934,7 @@ static int command_display_accel_info(int argc, const char **argv)
 					 ~ROUND_UP_FLAG,
 				 motion_sensors[i].config[j].ec_rate);
 		}
+		print_jitter(i);
 	}
 
 	/* First argument is on/off whether to display accel data. */
@@ -1855,7 +1947,7 @@ static int command_display_accel_info(int argc, const char **argv)
 
 	return EC_SUCCESS;
 }
-DECLARE_CONSOLE_COMMAND(accelinfo, command_display_accel_info, "on/off",
+DECLARE_CONSOLE_COMMAND(accelinfo, command_display_accel_info, "on/off|clear",
 			"Print motion sensor info, lid angle calculations.");
 #endif /* CONFIG_CMD_ACCEL_INFO */
 
@@ -27,12 +27,17 @@
  *	currently staged.
  * @requires_spreading: Flag used to shortcut the commit process. This should be
  *	true iff at least one of sample_count[] > 1
+ * @batch: The staged data was batched in a hardware FIFO, see
+ *	motion_sense_fifo_mark_batch().
+ * @started: Mask of the sensors whose first timestamp is staged.
  */
 struct fifo_staged {
 	uint32_t read_ts;
 	uint16_t count;
 	uint8_t sample_count[MAX_MOTION_SENSORS];
 	uint8_t requires_spreading;
+	uint8_t batch;
+	uint32_t started;
 };
 
 /**
@@ -281,6 +286,7 @@ fifo_stage_unit(struct ec_response_motion_sensor_data *data,
 		next_timestamp[data->sensor_num].next =
 			next_timestamp[data->sensor_num].prev = data->timestamp;
 		next_timestamp_initialized |= BIT(data->sensor_num);
+		fifo_staged.started |= BIT(data->sensor_num);
 	}
 
 	/* For valid sensors, check if AP really needs this data */
@@ -494,7 +500,9 @@ void motion_sense_fifo_stage_data(struct ec_response_motion_sensor_data *data,
 void motion_sense_fifo_commit_data(void)
 {
 	struct ec_response_motion_sensor_data *data;
-	int i, window, sensor_num;
+	uint8_t batch_left[MAX_MOTION_SENSORS] = { 0 };
+	int i, window = 0, sensor_num, period;
+	bool skip_ahead;
 
 	/* Nothing staged, no work to do. */
 	if (!fifo_staged.count)
@@ -527,21 +535,23 @@ void motion_sense_fifo_commit_data(void)
 
 	/* Update the data_periods as needed for this flush. */
 	for (i = 0; i < MAX_MOTION_SENSORS; i++) {
-		int period;
-
 		/* Skip empty sensors. */
 		if (!fifo_staged.sample_count[i])
 			continue;
 
 		period = expected_data_periods[i];
-		/*
-		 * Clamp the sample period to the MIN of collection_rate and the
-		 * window length / (sample count - 1).
-		 */
-		if (window && fifo_staged.sample_count[i] > 1)
+		if (fifo_staged.batch) {
+			/* A batch was taken at the sensor rate, keep it. */
+			batch_left[i] = fifo_staged.sample_count[i];
+		} else if (window && fifo_staged.sample_count[i] > 1) {
+			/*
+			 * Clamp the sample period to the MIN of collection_rate
+			 * and the window length / (sample count - 1).
+			 */
 			period =
 				MIN(period,
 				    window / (fifo_staged.sample_count[i] - 1));
+		}
 		data_periods[i] = period;
 	}
 
@@ -587,9 +597,24 @@ commit_data_end:
 		 * sensor or the timestamp is after our computed next, skip
 		 * ahead.
 		 */
-		if (is_new_timestamp(sensor_num) ||
-		    time_after(data->timestamp,
-			       next_timestamp[sensor_num].prev)) {
+		skip_ahead = is_new_timestamp(sensor_num);
+
+		/*
+		 * The last sample of a batch was taken between the interrupt
+		 * and the read, at most a period before the read: count the
+		 * earlier ones back from there. A sensor that just started has
+		 * no earlier sample to follow from.
+		 */
+		if (batch_left[sensor_num]) {
+			period = data_periods[sensor_num];
+			batch_left[sensor_num]--;
+			data->timestamp += MAX(window - period / 2, 0) -
+					   batch_left[sensor_num] * period;
+			skip_ahead |= !!(fifo_staged.started & BIT(sensor_num));
+		}
+
+		if (skip_ahead || time_after(data->timestamp,
+					     next_timestamp[sensor_num].prev)) {
 			next_timestamp[sensor_num].next = data->timestamp;
 			next_timestamp_initialized |= BIT(sensor_num);
 		}
@@ -655,6 +680,66 @@ static int motion_sense_get_next_event(uint8_t *out)
 /* LCOV_EXCL_STOP */
 DECLARE_EVENT_SOURCE(EC_MKBP_EVENT_SENSOR_FIFO, motion_sense_get_next_event);
 
+void motion_sense_fifo_mark_batch(void)
+{
+	/* The flag is cleared by the commit, which skips an empty stage. */
+	if (fifo_staged.count)
+		fifo_staged.batch = 1;
+}
+
+int motion_sense_fifo_batch_size(const struct motion_sensor_t *const *sensors,
+				 int count)
+{
+	const enum sensor_config configs[] = {
+		SENSOR_CONFIG_AP,
+		motion_sense_get_ec_config(),
+	};
+	const struct motion_sensor_t *s;
+	const struct motion_data_t *config;
+	uint32_t batch_us = UINT32_MAX;
+	uint64_t samples = 0;
+	int i, j, sensor_num;
+
+	if (!IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH))
+		return 1;
+
+	for (i = 0; i < count; i++) {
+		s = sensors[i];
+		if (!s || s->drv->get_data_rate(s) <= 0)
+			continue;
+
+		/* These look at every sample as it is read. */
+		sensor_num = s - motion_sensors;
+		if ((IS_ENABLED(CONFIG_BODY_DETECTION) &&
+		     sensor_num == CONFIG_BODY_DETECTION_SENSOR) ||
+		    (IS_ENABLED(CONFIG_GESTURE_SW_DETECTION) &&
+		     sensor_num == CONFIG_GESTURE_TAP_SENSOR))
+			return 1;
+
+		for (j = 0; j < ARRAY_SIZE(configs); j++) {
+			config = &s->config[configs[j]];
+			if (BASE_ODR(config->odr) == 0)
+				continue;
+			if (config->ec_rate == 0)
+				return 1;
+			batch_us = MIN(batch_us, config->ec_rate);
+		}
+	}
+	if (batch_us == UINT32_MAX)
+		return 1;
+
+	/* Rates are in mHz. */
+	for (i = 0; i < count; i++) {
+		s = sensors[i];
+		if (s)
+			samples += (uint64_t)batch_us *
+				   MAX(s->drv->get_data_rate(s), 0) /
+				   (SECOND * 1000);
+	}
+
+	return CLAMP(samples, 1, MOTION_SENSE_FIFO_BATCH_MAX);
+}
+
 inline int motion_sense_fifo_over_thres(void)
 {
 	int result;
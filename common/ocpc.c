@@ -5,6 +5,7 @@
 
 /* OCPC - One Charger IC Per Type-C module */
 
+#include "atomic.h"
 #include "battery.h"
 #include "battery_fuel_gauge.h"
 #include "charge_manager.h"
@@ -12,9 +13,13 @@
 #include "charger.h"
 #include "common.h"
 #include "console.h"
+#include "ec_commands.h"
 #include "hooks.h"
+#include "host_command.h"
 #include "math_util.h"
 #include "ocpc.h"
+#include "ring_log.h"
+#include "task.h"
 #include "timer.h"
 #include "usb_pd.h"
 #include "util.h"
@@ -58,6 +63,10 @@ static int k_d = KD;
 static int k_p_div = KP_DIV;
 static int k_i_div = KI_DIV;
 static int k_d_div = KD_DIV;
+/* The constants above as Q16 fixed point gains, see ocpc_update_gains() */
+static int32_t kp_q16 = (KP << 16) / KP_DIV;
+static int32_t ki_q16 = (KI << 16) / KI_DIV;
+static int32_t kd_q16 = (KD << 16) / KD_DIV;
 static int drive_limit = CONFIG_OCPC_DEF_DRIVELIMIT_MILLIVOLTS;
 static int debug_output;
 static int viz_output;
@@ -91,10 +100,85 @@ enum phase {
 	PHASE_CV_COMPLETE,
 };
 
+#ifdef CONFIG_OCPC_TRACE
+static struct ec_ocpc_trace_entry trace_entries[CONFIG_OCPC_TRACE_CAPACITY];
+static atomic_t trace_next;
+static const struct ring_log trace = RING_LOG_INIT(trace_entries, &trace_next);
+
+BUILD_ASSERT(PHASE_UNKNOWN + 1 == EC_OCPC_PHASE_UNKNOWN);
+BUILD_ASSERT(PHASE_CV_COMPLETE + 1 == EC_OCPC_PHASE_CV_COMPLETE);
+#endif
+
+#if CONFIG_OCPC_LOOP_PERIOD_MS > 0
+/*
+ * Latest targets from ocpc_config_secondary_charger(), which the charger task
+ * steps the loop towards every CONFIG_OCPC_LOOP_PERIOD_MS.
+ */
+static struct {
+	bool running;
+	int desired_batt_voltage_mv;
+	int desired_batt_current_ma;
+	/* When the loop is due to step next */
+	timestamp_t next;
+} loop;
+#endif
+
 __overridable void board_ocpc_init(struct ocpc_data *ocpc)
 {
 }
 
+/* The default gains must fit in Q16 */
+BUILD_ASSERT(KP / KP_DIV <= INT16_MAX && KI / KI_DIV <= INT16_MAX &&
+	     KD / KD_DIV <= INT16_MAX);
+
+static int32_t gain_q16(int k, int div)
+{
+	int64_t gain = div ? ((int64_t)k << 16) / div : 0;
+
+	/* Saturate gains set at runtime beyond the Q16 range */
+	return CLAMP(gain, INT32_MIN, INT32_MAX);
+}
+
+static void ocpc_update_gains(void)
+{
+	kp_q16 = gain_q16(k_p, k_p_div);
+	ki_q16 = gain_q16(k_i, k_i_div);
+	kd_q16 = gain_q16(k_d, k_d_div);
+}
+
+/* Multiply by a Q16 gain, rounding to the nearest integer */
+static int mul_q16(int32_t gain, int x)
+{
+	int64_t v = (int64_t)gain * x;
+
+	return (int)((v + (1 << 15)) >> 16);
+}
+
+#ifdef CONFIG_OCPC_TRACE
+static void ocpc_trace_add(const struct ocpc_data *ocpc,
+			   const struct batt_params *batt, enum phase ph,
+			   int i_ma, int vsys_target, int error,
+			   const int terms[3], uint8_t flags)
+{
+	struct ec_ocpc_trace_entry *e = ring_log_append(&trace);
+
+	e->time_us = get_time().le.lo;
+	e->vsys_target_mv = CLAMP(vsys_target, 0, UINT16_MAX);
+	e->vsys_mv = CLAMP(ocpc->vsys_aux_mv, 0, UINT16_MAX);
+	e->ibat_ma = CLAMP(batt->current, INT16_MIN, INT16_MAX);
+	e->ibat_target_ma = CLAMP(i_ma, 0, UINT16_MAX);
+	e->ibus_ma = CLAMP(ocpc->secondary_ibus_ma, 0, UINT16_MAX);
+	e->error_ma = CLAMP(error, INT16_MIN, INT16_MAX);
+	e->integral = CLAMP(ocpc->integral, INT16_MIN, INT16_MAX);
+	e->p_mv = CLAMP(terms[0], INT16_MIN, INT16_MAX);
+	e->i_mv = CLAMP(terms[1], INT16_MIN, INT16_MAX);
+	e->d_mv = CLAMP(terms[2], INT16_MIN, INT16_MAX);
+	e->phase = ph + 1;
+	e->flags = flags;
+	e->reserved = 0;
+}
+#endif
+
 static enum ec_error_list ocpc_precharge_enable(bool enable);
 
 static void calc_resistance_stats(struct ocpc_data *ocpc)
@@ -260,10 +344,9 @@ enum ec_error_list ocpc_calc_resistances(struct ocpc_data *ocpc,
 	return EC_SUCCESS;
 }
 
-int ocpc_config_secondary_charger(int *desired_charger_input_current,
-				  struct ocpc_data *ocpc,
-				  int desired_batt_voltage_mv,
-				  int desired_batt_current_ma)
+static int ocpc_loop_step(int *desired_charger_input_current,
+			  struct ocpc_data *ocpc, int desired_batt_voltage_mv,
+			  int desired_batt_current_ma)
 {
 	int rv = EC_SUCCESS;
 	struct batt_params batt;
@@ -276,6 +359,8 @@ int ocpc_config_secondary_charger(int *desired_charger_input_current,
 	int min_vsys_target;
 	int error = 0;
 	int derivative = 0;
+	/* Proportional, integral and derivative contributions to drive, mV */
+	int terms[3] = { 0 };
 	static enum phase ph;
 	static int prev_limited;
 	int chgnum;
@@ -508,9 +593,16 @@ int ocpc_config_secondary_charger(int *desired_charger_input_current,
 
 	/* Obtain the drive from our PID controller. */
 	if ((ocpc->last_vsys != OCPC_UNINIT) && (ph > PHASE_PRECHARGE)) {
-		drive = (k_p * error / k_p_div) +
-			(k_i * ocpc->integral / k_i_div) +
-			(k_d * derivative / k_d_div);
+		if (CONFIG_OCPC_LOOP_PERIOD_MS > 0) {
+			terms[0] = mul_q16(kp_q16, error);
+			terms[1] = mul_q16(ki_q16, ocpc->integral);
+			terms[2] = mul_q16(kd_q16, derivative);
+		} else {
+			terms[0] = k_p * error / k_p_div;
+			terms[1] = k_i * ocpc->integral / k_i_div;
+			terms[2] = k_d * derivative / k_d_div;
+		}
+		drive = terms[0] + terms[1] + terms[2];
 		/*
 		 * Let's limit upward transitions to 10mV.  It's okay to reduce
 		 * VSYS rather quickly, but we'll be conservative on
@@ -585,6 +677,10 @@ int ocpc_config_secondary_charger(int *desired_charger_input_current,
 		if (!prev_limited)
 			CPRINTS("Input limited! Not increasing VSYS");
 		prev_limited = 1;
+#ifdef CONFIG_OCPC_TRACE
+		ocpc_trace_add(ocpc, &batt, ph, i_ma, ocpc->last_vsys, error,
+			       terms, EC_OCPC_TRACE_ICL_LIMITED);
+#endif
 		return rv;
 	}
 	prev_limited = 0;
@@ -596,6 +692,14 @@ set_vsys:
 	if ((ABS(vsys_target - ocpc->last_vsys) > 10) || debug_output)
 		CPRINTS("OCPC: Target VSYS: %dmV", vsys_target);
 	charger_set_voltage(CHARGER_SECONDARY, vsys_target);
+#ifdef CONFIG_OCPC_TRACE
+	/* The battery isn't read when we're only holding VSYS */
+	if (desired_batt_current_ma)
+		ocpc_trace_add(ocpc, &batt, ph, i_ma, vsys_target, error, terms,
+			       ocpc->last_vsys == OCPC_UNINIT ?
+				       EC_OCPC_TRACE_FIRST :
+				       0);
+#endif
 	ocpc->last_vsys = vsys_target;
 
 	/*
@@ -619,6 +723,77 @@ set_vsys:
 	return rv;
 }
 
+#if CONFIG_OCPC_LOOP_PERIOD_MS > 0
+static int ocpc_loop_run(int *desired_charger_input_current,
+			 struct ocpc_data *ocpc)
+{
+	int rv;
+
+	loop.next = get_time();
+	loop.next.val += CONFIG_OCPC_LOOP_PERIOD_MS * MSEC;
+	rv = ocpc_loop_step(desired_charger_input_current, ocpc,
+			    loop.desired_batt_voltage_mv,
+			    loop.desired_batt_current_ma);
+	/* The secondary charger IC is no longer the active one. */
+	if (rv == EC_ERROR_INVAL)
+		loop.running = false;
+
+	return rv;
+}
+
+#endif
+
+int ocpc_loop_tick(int *desired_charger_input_current, struct ocpc_data *ocpc)
+{
+#if CONFIG_OCPC_LOOP_PERIOD_MS > 0
+	if (loop.running && timestamp_expired(loop.next, NULL))
+		return ocpc_loop_run(desired_charger_input_current, ocpc);
+#endif
+	return EC_SUCCESS;
+}
+
+int ocpc_loop_next_us(void)
+{
+#if CONFIG_OCPC_LOOP_PERIOD_MS > 0
+	timestamp_t now = get_time();
+
+	if (!loop.running)
+		return -1;
+	if (timestamp_expired(loop.next, &now))
+		return 0;
+
+	return loop.next.val - now.val;
+#else
+	return -1;
+#endif
+}
+
+int ocpc_config_secondary_charger(int *desired_charger_input_current,
+				  struct ocpc_data *ocpc,
+				  int desired_batt_voltage_mv,
+				  int desired_batt_current_ma)
+{
+#if CONFIG_OCPC_LOOP_PERIOD_MS > 0
+	bool started = loop.running;
+
+	/*
+	 * The charger task also gets here on events between two periods.
+	 * Latch the targets, but only step the loop when it is due so that
+	 * each step covers one period.
+	 */
+	loop.desired_batt_voltage_mv = desired_batt_voltage_mv;
+	loop.desired_batt_current_ma = desired_batt_current_ma;
+	loop.running = true;
+	if (started && !timestamp_expired(loop.next, NULL))
+		return EC_SUCCESS;
+
+	return ocpc_loop_run(desired_charger_input_current, ocpc);
+#else
+	return ocpc_loop_step(desired_charger_input_current, ocpc,
+			      desired_batt_voltage_mv, desired_batt_current_ma);
+#endif
+}
+
 void ocpc_get_adcs(struct ocpc_data *ocpc)
 {
 	int val;
@@ -682,6 +857,9 @@ void ocpc_reset(struct ocpc_data *ocpc)
 	struct batt_params batt;
 	int voltage;
 
+#if CONFIG_OCPC_LOOP_PERIOD_MS > 0
+	loop.running = false;
+#endif
 	battery_get_params(&batt);
 	ocpc->integral = 0;
 	ocpc->last_error = 0;
@@ -715,6 +893,7 @@ void ocpc_reset(struct ocpc_data *ocpc)
 test_export_static void ocpc_set_pid_constants(void)
 {
 	ocpc_get_pid_constants(&k_p, &k_p_div, &k_i, &k_i_div, &k_d, &k_d_div);
+	ocpc_update_gains();
 }
 DECLARE_HOOK(HOOK_INIT, ocpc_set_pid_constants, HOOK_PRIO_DEFAULT);
 
@@ -787,6 +966,7 @@ static int command_ocpcpid(int argc, const char **argv)
 
 		*num = atoi(argv[2]);
 		*denom = atoi(argv[3]);
+		ocpc_update_gains();
 	}
 
 	/* Print the current constants */
@@ -812,6 +992,40 @@ static int command_ocpcdrvlmt(int argc, const char **argv)
 DECLARE_SAFE_CONSOLE_COMMAND(ocpcdrvlmt, command_ocpcdrvlmt, "[<drive_limit>]",
 			     "Show/Set drive limit for OCPC PID loop");
 
+#ifdef CONFIG_OCPC_TRACE
+static enum ec_status hc_ocpc_trace(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_ocpc_trace *p = args->params;
+	struct ec_response_ocpc_trace *r = args->response;
+	uint32_t first, total;
+	int count;
+
+	if (p->flags & EC_OCPC_TRACE_FLAG_CLEAR) {
+		ring_log_clear(&trace);
+		args->response_size = 0;
+		return EC_RES_SUCCESS;
+	}
+
+	count = ring_log_host_read(&trace, args, sizeof(*r), p->offset, &first,
+				   &total);
+	if (count < 0)
+		return -count;
+
+	r->first = first;
+	r->total = total;
+	r->count = count;
+	r->reserved = 0;
+	r->period_ms = CONFIG_OCPC_LOOP_PERIOD_MS;
+	r->drive_limit_mv = drive_limit;
+	r->kp_q16 = kp_q16;
+	r->ki_q16 = ki_q16;
+	r->kd_q16 = kd_q16;
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_OCPC_TRACE, hc_ocpc_trace, EC_VER_MASK(0));
+#endif /* CONFIG_OCPC_TRACE */
+
 #ifdef TEST_BUILD
 int test_ocpc_get_viz_output(void)
 {
@@ -57,20 +57,16 @@ static int get_temperature(struct motion_sensor_t *sensor, int *temp)
 	return EC_SUCCESS;
 }
 
-static void data_int16_to_fp(const struct motion_sensor_t *s,
-			     const int16_t *data, fpv3_t out)
+static void data_int16_to_fp(struct motion_sensor_t *s, const int16_t *data,
+			     fpv3_t out)
 {
-	int i;
-	fp_t range = INT_TO_FP(s->current_range);
+	struct fpv3_int16_scale *scale = &s->online_calib_data->scale;
 
-	for (i = 0; i < 3; ++i) {
-		fp_t v = INT_TO_FP((int32_t)data[i]);
+	/* The range rarely changes, don't divide for every sample. */
+	if (scale->range != INT_TO_FP(s->current_range))
+		fpv3_int16_scale_init(scale, s->current_range);
 
-		out[i] = fp_div(v, INT_TO_FP((data[i] >= 0) ? 0x7fff : 0x8000));
-		out[i] = fp_mul(out[i], range);
-		/* Check for overflow */
-		out[i] = CLAMP(out[i], -range, range);
-	}
+	fpv3_from_int16(out, data, scale);
 }
 
 static void data_fp_to_int16(const struct motion_sensor_t *s, const fpv3_t data,
@@ -0,0 +1,287 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Input and battery power telemetry */
+
+#include "battery.h"
+#include "charge_manager.h"
+#include "charge_state.h"
+#include "charger.h"
+#include "chipset.h"
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "extpower.h"
+#include "hooks.h"
+#include "host_command.h"
+#include "ring_log.h"
+#include "task.h"
+#include "timer.h"
+#include "util.h"
+
+#define CPRINTS(format, args...) cprints(CC_CHARGER, format, ##args)
+
+BUILD_ASSERT(CONFIG_POWER_TRACE_MIN_PERIOD_MS > 0);
+
+static K_MUTEX_DEFINE(trace_lock);
+
+static uint16_t period_ms = CONFIG_POWER_TRACE_PERIOD_MS;
+
+static struct ec_power_trace_sample samples[CONFIG_POWER_TRACE_CAPACITY];
+static atomic_t sample_next;
+static const struct ring_log sample_log =
+	RING_LOG_INIT(samples, &sample_next);
+
+/* Energy totals in uJ and times in us, per enum ec_power_trace_state */
+static struct {
+	uint64_t time_us;
+	uint64_t input_uj;
+	uint64_t battery_time_us;
+	int64_t battery_uj;
+} energy[EC_POWER_TRACE_STATE_COUNT];
+
+/* Time of the previous sample, 0 if the next one starts a new series */
+static uint64_t last_sample_us;
+/* Time of the previous battery reading, if any in this series */
+static uint32_t last_batt_read_us;
+static bool batt_series;
+
+static enum ec_power_trace_state get_power_state(void)
+{
+	if (chipset_in_state(CHIPSET_STATE_ANY_SUSPEND))
+		return EC_POWER_TRACE_STATE_SUSPEND;
+	if (chipset_in_state(CHIPSET_STATE_ON))
+		return EC_POWER_TRACE_STATE_S0;
+	return EC_POWER_TRACE_STATE_OFF;
+}
+
+static bool read_input(int *ma, int *mv)
+{
+	int port = 0;
+
+	if (!extpower_is_present()) {
+		*ma = 0;
+		*mv = 0;
+		return true;
+	}
+
+	if (IS_ENABLED(CONFIG_CHARGE_MANAGER))
+		port = charge_manager_get_active_charge_port();
+	if (port < 0)
+		return false;
+
+	return charger_get_input_current(charge_get_active_chg_chip(), ma) ==
+		       EC_SUCCESS &&
+	       charger_get_vbus_voltage(port, mv) == EC_SUCCESS;
+}
+
+/*
+ * Take the battery current and voltage the charger task read last rather than
+ * reading the gauge again from the hook task. The gauge measures discharge
+ * current too, where the charger ADC usually only measures charge current.
+ *
+ * The charger task polls every 250 ms to 10 s, so most samples repeat the
+ * same reading; read_us tells when it was taken.
+ */
+static bool read_battery(int *ma, int *mv, uint32_t *read_us)
+{
+	struct batt_params batt = *charger_current_battery_params();
+
+	if (batt.flags & (BATT_FLAG_BAD_CURRENT | BATT_FLAG_BAD_VOLTAGE))
+		return false;
+	*ma = batt.current;
+	*mv = batt.voltage;
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+	*read_us = batt.read_time[BATT_PARAM_CURRENT];
+#else
+	/* The charger task reads the battery right after stamping its loop */
+	*read_us = charge_get_status()->ts.le.lo;
+#endif
+	return true;
+}
+
+static void power_trace_sample(void);
+DECLARE_DEFERRED(power_trace_sample);
+
+static void power_trace_sample(void)
+{
+	struct ec_power_trace_sample *s;
+	enum ec_power_trace_state state = get_power_state();
+	int input_ma, input_mv, batt_ma, batt_mv;
+	uint32_t batt_read_us;
+	bool input_ok = read_input(&input_ma, &input_mv);
+	bool batt_ok = read_battery(&batt_ma, &batt_mv, &batt_read_us);
+	bool batt_repeat;
+	uint64_t now = get_time().val;
+	uint64_t dt;
+
+	mutex_lock(&trace_lock);
+
+	if (!period_ms) {
+		mutex_unlock(&trace_lock);
+		return;
+	}
+	hook_call_deferred(&power_trace_sample_data, period_ms * MSEC);
+
+	/* Each reading stands for the power since the previous sample */
+	if (last_sample_us) {
+		dt = now - last_sample_us;
+		energy[state].time_us += dt;
+		if (input_ok)
+			energy[state].input_uj +=
+				(uint64_t)input_ma * input_mv * dt / SECOND;
+	} else {
+		batt_series = false;
+	}
+	last_sample_us = now;
+
+	/*
+	 * A battery reading stands for the power since the previous reading,
+	 * so count each one once, however many samples repeat it.
+	 */
+	batt_repeat = batt_ok && batt_series &&
+		      batt_read_us == last_batt_read_us;
+	if (batt_ok && !batt_repeat) {
+		if (batt_series) {
+			dt = batt_read_us - last_batt_read_us;
+			energy[state].battery_time_us += dt;
+			energy[state].battery_uj += (int64_t)batt_ma * batt_mv *
+						    (int64_t)dt / SECOND;
+		}
+		last_batt_read_us = batt_read_us;
+		batt_series = true;
+	}
+
+	s = ring_log_append(&sample_log);
+	s->time_us = (uint32_t)now;
+	s->state = state;
+	s->flags = 0;
+	if (input_ok) {
+		s->flags |= EC_POWER_TRACE_SAMPLE_INPUT;
+		s->input_ma = CLAMP(input_ma, 0, UINT16_MAX);
+		s->vbus_mv = CLAMP(input_mv, 0, UINT16_MAX);
+	} else {
+		s->input_ma = 0;
+		s->vbus_mv = 0;
+	}
+	if (batt_ok) {
+		s->flags |= EC_POWER_TRACE_SAMPLE_BATTERY;
+		if (batt_repeat)
+			s->flags |= EC_POWER_TRACE_SAMPLE_BATTERY_REPEAT;
+		s->battery_ma = CLAMP(batt_ma, INT16_MIN, INT16_MAX);
+		s->battery_mv = CLAMP(batt_mv, 0, UINT16_MAX);
+		s->battery_age_ms = MIN(((uint32_t)now - batt_read_us) / MSEC,
+					UINT16_MAX);
+	} else {
+		s->battery_ma = 0;
+		s->battery_mv = 0;
+		s->battery_age_ms = 0;
+	}
+
+	mutex_unlock(&trace_lock);
+}
+
+static void power_trace_set_period(int ms)
+{
+	mutex_lock(&trace_lock);
+
+	if (ms)
+		ms = CLAMP(ms, CONFIG_POWER_TRACE_MIN_PERIOD_MS, UINT16_MAX);
+	if (ms && !period_ms) {
+		/* Don't count the time spent stopped */
+		last_sample_us = 0;
+		hook_call_deferred(&power_trace_sample_data, 0);
+	} else if (!ms) {
+		hook_call_deferred(&power_trace_sample_data, -1);
+	}
+	period_ms = ms;
+
+	mutex_unlock(&trace_lock);
+
+	CPRINTS("Power trace period %d ms", ms);
+}
+
+static void power_trace_init(void)
+{
+	if (period_ms)
+		hook_call_deferred(&power_trace_sample_data, 0);
+}
+DECLARE_HOOK(HOOK_INIT, power_trace_init, HOOK_PRIO_DEFAULT);
+
+static enum ec_status
+power_trace_get_samples(const struct ec_params_power_trace *p,
+			struct host_cmd_handler_args *args)
+{
+	struct ec_response_power_trace_samples *r = args->response;
+	uint32_t first, total;
+	int count;
+
+	mutex_lock(&trace_lock);
+	count = ring_log_host_read(&sample_log, args, sizeof(*r), p->offset,
+				   &first, &total);
+	mutex_unlock(&trace_lock);
+	if (count < 0)
+		return -count;
+
+	r->first = first;
+	r->total = total;
+	r->count = count;
+	r->reserved = 0;
+
+	return EC_RES_SUCCESS;
+}
+
+static enum ec_status
+power_trace_get_energy(struct host_cmd_handler_args *args)
+{
+	struct ec_response_power_trace_energy *r = args->response;
+	int i;
+
+	if (args->response_max < sizeof(*r))
+		return EC_RES_RESPONSE_TOO_BIG;
+
+	mutex_lock(&trace_lock);
+	r->period_ms = period_ms;
+	r->reserved = 0;
+	r->sample_count = sample_next;
+	for (i = 0; i < EC_POWER_TRACE_STATE_COUNT; i++) {
+		r->state[i].time_ms = energy[i].time_us / MSEC;
+		r->state[i].input_mj = energy[i].input_uj / 1000;
+		r->state[i].battery_time_ms =
+			energy[i].battery_time_us / MSEC;
+		r->state[i].battery_mj = energy[i].battery_uj / 1000;
+	}
+	mutex_unlock(&trace_lock);
+
+	args->response_size = sizeof(*r);
+
+	return EC_RES_SUCCESS;
+}
+
+static enum ec_status hc_power_trace(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_power_trace *p = args->params;
+
+	switch (p->cmd) {
+	case EC_POWER_TRACE_CMD_GET_SAMPLES:
+		return power_trace_get_samples(p, args);
+	case EC_POWER_TRACE_CMD_GET_ENERGY:
+		return power_trace_get_energy(args);
+	case EC_POWER_TRACE_CMD_SET_PERIOD:
+		power_trace_set_period(p->period_ms);
+		return EC_RES_SUCCESS;
+	case EC_POWER_TRACE_CMD_CLEAR:
+		mutex_lock(&trace_lock);
+		ring_log_clear(&sample_log);
+		memset(energy, 0, sizeof(energy));
+		last_sample_us = 0;
+		batt_series = false;
+		mutex_unlock(&trace_lock);
+		return EC_RES_SUCCESS;
+	default:
+		return EC_RES_INVALID_PARAM;
+	}
+}
+DECLARE_HOST_COMMAND(EC_CMD_POWER_TRACE, hc_power_trace, EC_VER_MASK(0));
@@ -23,6 +23,18 @@
 #define CPRINTF(fmt, args...) cprintf(CC_RGBKBD, "RGBKBD: " fmt, ##args)
 #define CPRINTS(fmt, args...) cprints(CC_RGBKBD, "RGBKBD: " fmt, ##args)
 
+/* Colors were changed outside the RGBKBD task. */
+#define TASK_EVENT_FLUSH TASK_EVENT_CUSTOM_BIT(0)
+
+#define FRAME_PERIOD_US (SECOND / CONFIG_RGBKBD_MAX_FPS)
+BUILD_ASSERT(FRAME_PERIOD_US > 0);
+
+/*
+ * Frames a grid may fail to take in a row. After that, its dots are dropped
+ * until rgbkbd_init() resends the whole grid.
+ */
+#define FLUSH_MAX_TRIES 4
+
 test_export_static enum ec_rgbkbd_demo demo =
 #if defined(CONFIG_RGBKBD_DEMO_FLOW)
 	EC_RGBKBD_DEMO_FLOW;
@@ -39,6 +51,25 @@ test_export_static uint8_t rgbkbd_table[EC_RGBKBD_MAX_KEY_COUNT];
 
 static enum rgbkbd_state rgbkbd_state;
 
+/*
+ * Colors are written to rgbkbds[].buf (the frame buffer) and only sent to the
+ * LED ICs by the RGBKBD task, at most CONFIG_RGBKBD_MAX_FPS times a second.
+ */
+static K_MUTEX_DEFINE(frame_lock);
+/* Set when any grid has dirty dots */
+static bool frame_pending;
+
+static struct {
+	/* Frames flushed, and the LED IC writes and bytes they took */
+	uint32_t frames;
+	uint32_t writes;
+	uint32_t bytes;
+	uint32_t errors;
+	/* Dots not sent because their grid was off or kept failing */
+	uint32_t dropped;
+	timestamp_t since;
+} render_stats;
+
 const struct rgbkbd_init rgbkbd_init_default = {
 	.gcc = RGBKBD_MAX_GCC_LEVEL / 2,
 	.scale = { RGBKBD_MAX_SCALE, RGBKBD_MAX_SCALE, RGBKBD_MAX_SCALE },
@@ -69,11 +100,58 @@ static struct rgbkbd *find_grid_from_x(int x, uint8_t *col)
 	return ctx;
 }
 
+static bool is_dirty(const struct rgbkbd *ctx, int offset)
+{
+	return ctx->dirty[offset / 32] & BIT(offset % 32);
+}
+
+static void clear_dirty(struct rgbkbd *ctx, int offset, int len)
+{
+	for (; len > 0; offset++, len--)
+		ctx->dirty[offset / 32] &= ~BIT(offset % 32);
+}
+
+/*
+ * Have the whole grid sent, e.g. after its LED IC lost its colors. Must be
+ * called with frame_lock held.
+ */
+static void set_all_dirty(struct rgbkbd *ctx)
+{
+	memset(ctx->dirty, 0xff, sizeof(ctx->dirty));
+	frame_pending = true;
+}
+
+/* Whether the LED IC of a grid is powered and initialized */
+static bool grid_takes_colors(const struct rgbkbd *ctx)
+{
+	return ctx->state == RGBKBD_STATE_INITIALIZED ||
+	       ctx->state == RGBKBD_STATE_ENABLED;
+}
+
+/* Update a dot in the frame buffer. Must be called with frame_lock held. */
+static void set_dot(struct rgbkbd *ctx, int offset, struct rgb_s color)
+{
+	struct rgb_s *cur = &ctx->buf[offset];
+
+	if (cur->r == color.r && cur->g == color.g && cur->b == color.b)
+		return;
+
+	*cur = color;
+	ctx->dirty[offset / 32] |= BIT(offset % 32);
+	frame_pending = true;
+}
+
+/* Have the RGBKBD task send the frame buffer changes to the LED ICs. */
+static void request_flush(void)
+{
+	if (frame_pending && task_get_current() != TASK_ID_RGBKBD)
+		task_set_event(TASK_ID_RGBKBD, TASK_EVENT_FLUSH);
+}
+
 static int set_color_single(struct rgb_s color, int x, int y)
 {
 	struct rgbkbd *ctx = &rgbkbds[0];
 	uint8_t grid, col, offset;
-	int rv;
 
 	if (rgbkbd_hsize <= x || rgbkbd_vsize <= y) {
 		return EC_ERROR_OVERFLOW;
@@ -82,15 +160,17 @@ static int set_color_single(struct rgb_s color, int x, int y)
 	ctx = find_grid_from_x(x, &col);
 	grid = RGBKBD_CTX_TO_GRID(ctx);
 	offset = ctx->cfg->row_len * (x - col) + y;
-	ctx->buf[offset] = color;
 
-	rv = ctx->cfg->drv->set_color(ctx, offset, &ctx->buf[offset], 1);
+	mutex_lock(&frame_lock);
+	set_dot(ctx, offset, color);
+	mutex_unlock(&frame_lock);
+	request_flush();
 
-	CPRINTS("%set (%d,%d) to color=(%d,%d,%d) grid=%u offset=%u (%d)",
-		rv ? "Failed to s" : "S", x, y, color.r, color.g, color.b, grid,
-		offset, rv);
+	CPRINTS("Set (%d,%d) to color=(%d,%d,%d) grid=%u offset=%u", x, y,
+		color.r, color.g, color.b, grid, offset);
 
-	return rv;
+	/* The dot is sent later. Failures show in 'rgbk stats'. */
+	return EC_SUCCESS;
 }
 
 test_export_static uint8_t get_grid_size(const struct rgbkbd *ctx)
@@ -98,16 +178,76 @@ test_export_static uint8_t get_grid_size(const struct rgbkbd *ctx)
 	return ctx->cfg->col_len * ctx->cfg->row_len;
 }
 
-static void sync_grids(void)
+/*
+ * Send the dirty dots of each grid to its LED IC. Adjacent dirty dots are sent
+ * in one write. Dots stay dirty if their write fails, for FLUSH_MAX_TRIES
+ * frames. The dots of a grid that is off are dropped: it's sent in full when
+ * it's back on.
+ */
+static void rgbkbd_flush(void)
 {
 	struct rgbkbd *ctx;
-	uint8_t len;
-	int i;
+	int grid, len, start, end, n, e, i;
+	uint32_t writes = 0, bytes = 0;
+	bool failed, pending = false;
 
-	for (i = 0; i < rgbkbd_count; i++) {
-		ctx = &rgbkbds[i];
+	mutex_lock(&frame_lock);
+
+	for (grid = 0; grid < rgbkbd_count; grid++) {
+		ctx = &rgbkbds[grid];
 		len = get_grid_size(ctx);
-		ctx->cfg->drv->set_color(ctx, 0, ctx->buf, len);
+		failed = false;
+		for (start = 0; grid_takes_colors(ctx) && start < len;
+		     start = end + 1) {
+			end = start;
+			while (end < len && is_dirty(ctx, end))
+				end++;
+			n = end - start;
+			if (!n)
+				continue;
+
+			e = ctx->cfg->drv->set_color(ctx, start,
+						     &ctx->buf[start], n);
+			writes++;
+			bytes += n * SIZE_OF_RGB;
+			if (!e) {
+				clear_dirty(ctx, start, n);
+				continue;
+			}
+
+			/* Only report the first of the retries */
+			if (!ctx->flush_failures && !failed)
+				CPRINTS("Failed to set color of %d dots at "
+					"grid=%d offset=%d (%d)",
+					n, grid, start, e);
+			render_stats.errors++;
+			failed = true;
+		}
+
+		if (!failed) {
+			ctx->flush_failures = 0;
+		} else if (++ctx->flush_failures < FLUSH_MAX_TRIES) {
+			pending = true;
+			continue;
+		} else {
+			CPRINTS("GRID%d failed %d frames, off until re-init",
+				grid, FLUSH_MAX_TRIES);
+			ctx->state = RGBKBD_STATE_RESET;
+		}
+
+		for (i = 0; i < len; i++)
+			if (is_dirty(ctx, i))
+				render_stats.dropped++;
+		clear_dirty(ctx, 0, len);
+	}
+	frame_pending = pending;
+
+	mutex_unlock(&frame_lock);
+
+	if (writes) {
+		render_stats.frames++;
+		render_stats.writes += writes;
+		render_stats.bytes += bytes;
 	}
 }
 
@@ -129,13 +269,15 @@ static void rgbkbd_reset_color(struct rgb_s color)
 	struct rgbkbd *ctx;
 	int i, j;
 
+	mutex_lock(&frame_lock);
 	for (i = 0; i < rgbkbd_count; i++) {
 		ctx = &rgbkbds[i];
 		for (j = 0; j < get_grid_size(ctx); j++)
-			ctx->buf[j] = color;
+			set_dot(ctx, j, color);
 	}
+	mutex_unlock(&frame_lock);
 
-	sync_grids();
+	request_flush();
 }
 
 static void rgbkbd_demo_flow(void)
@@ -145,15 +287,17 @@ static void rgbkbd_demo_flow(void)
 	uint8_t len;
 	int i, g;
 
+	mutex_lock(&frame_lock);
+
 	for (g = rgbkbd_count - 1; g >= 0; g--) {
 		ctx = &rgbkbds[g];
 		len = get_grid_size(ctx);
 		for (i = len - 1; i > 0; i--)
-			ctx->buf[i] = ctx->buf[i - 1];
+			set_dot(ctx, i, ctx->buf[i - 1]);
 		if (g > 0) {
 			/* Copy the last dot of the g-1 grid to the 1st. */
 			len = get_grid_size(&rgbkbds[g - 1]);
-			ctx->buf[0] = rgbkbds[g - 1].buf[len - 1];
+			set_dot(ctx, 0, rgbkbds[g - 1].buf[len - 1]);
 		}
 	}
 
@@ -161,9 +305,9 @@ static void rgbkbd_demo_flow(void)
 	color = rotate_color(color, 32);
 
 	/* Finally, insert a new color to (0, 0). */
-	ctx->buf[0] = color;
+	set_dot(ctx, 0, color);
 
-	sync_grids();
+	mutex_unlock(&frame_lock);
 
 #ifdef TEST_BUILD
 	task_wake(TASK_ID_TEST_RUNNER);
@@ -345,6 +489,10 @@ static int rgbkbd_init(void)
 		struct rgbkbd *ctx = &rgbkbds[i];
 		uint8_t gcc = rgbkbd_init_setting->gcc;
 
+		mutex_lock(&frame_lock);
+		ctx->state = RGBKBD_STATE_RESET;
+		mutex_unlock(&frame_lock);
+
 		e = ctx->cfg->drv->init(ctx);
 		if (e) {
 			CPRINTS("Failed to init GRID%d (%d)", i, e);
@@ -360,6 +508,13 @@ static int rgbkbd_init(void)
 			continue;
 		}
 
+		/* The IC lost its colors. Resend the whole grid. */
+		mutex_lock(&frame_lock);
+		ctx->state = RGBKBD_STATE_INITIALIZED;
+		ctx->flush_failures = 0;
+		set_all_dirty(ctx);
+		mutex_unlock(&frame_lock);
+
 		CPRINTS("Initialized GRID%d", i);
 	}
 
@@ -417,8 +572,21 @@ static int rgbkbd_enable(int enable)
 			continue;
 		}
 
+		/*
+		 * Colors set while the grid was disabled were dropped. A grid
+		 * that isn't initialized stays off.
+		 */
+		mutex_lock(&frame_lock);
+		if (enable && ctx->state == RGBKBD_STATE_DISABLED)
+			set_all_dirty(ctx);
+		if (ctx->state != RGBKBD_STATE_RESET)
+			ctx->state = enable ? RGBKBD_STATE_ENABLED :
+					      RGBKBD_STATE_DISABLED;
+		mutex_unlock(&frame_lock);
+
 		CPRINTS("%s GRID%d", enable ? "Enabled" : "Disabled", i);
 	}
+	request_flush();
 
 	if (rv == EC_SUCCESS) {
 		rgbkbd_state = enable ? RGBKBD_STATE_ENABLED :
@@ -467,6 +635,13 @@ static int rgbkbd_get_enabled(void)
 
 static void rgbkbd_reset(void)
 {
+	int i;
+
+	mutex_lock(&frame_lock);
+	for (i = 0; i < rgbkbd_count; i++)
+		rgbkbds[i].state = RGBKBD_STATE_RESET;
+	mutex_unlock(&frame_lock);
+
 	board_kblight_shutdown();
 	board_kblight_init();
 	rgbkbd_state = RGBKBD_STATE_RESET;
@@ -482,12 +657,36 @@ const struct kblight_drv kblight_rgbkbd = {
 
 void rgbkbd_task(void *u)
 {
+	uint64_t now, demo_next = 0, flush_next = 0;
+	int64_t wait, until_flush;
+	uint32_t evt;
+
 	rgbkbd_init_lookup_table();
 
 	while (1) {
-		task_wait_event(demo_interval_ms * MSEC);
-		if (demo)
+		now = get_time().val;
+		wait = -1;
+		if (demo && demo_interval_ms > 0)
+			wait = MAX((int64_t)(demo_next - now), 1);
+		if (frame_pending) {
+			until_flush = MAX((int64_t)(flush_next - now), 1);
+			wait = wait < 0 ? until_flush : MIN(wait, until_flush);
+		}
+
+		evt = task_wait_event(wait);
+		now = get_time().val;
+
+		/* A flush request doesn't move the demo forward. */
+		if (demo && ((evt & TASK_EVENT_WAKE) ||
+			     (demo_interval_ms > 0 && now >= demo_next))) {
+			demo_next = now + demo_interval_ms * MSEC;
 			rgbkbd_demo_run(demo);
+		}
+
+		if (frame_pending && now >= flush_next) {
+			rgbkbd_flush();
+			flush_next = now + FRAME_PERIOD_US;
+		}
 	}
 }
 
@@ -578,6 +777,26 @@ static int int_to_rgb(const char *code, struct rgb_s *rgb)
 	return EC_SUCCESS;
 }
 
+static void print_render_stats(void)
+{
+	uint64_t elapsed = get_time().val - render_stats.since.val;
+	uint32_t frames = render_stats.frames;
+	uint32_t fps_x10 = elapsed ? frames * 10ULL * SECOND / elapsed : 0;
+	int i;
+
+	ccprintf("Max FPS: %d\n", CONFIG_RGBKBD_MAX_FPS);
+	ccprintf("Frames: %u (%u.%u fps)\n", frames, fps_x10 / 10,
+		 fps_x10 % 10);
+	ccprintf("Writes/frame: %u\n",
+		 frames ? render_stats.writes / frames : 0);
+	ccprintf("Bytes/frame: %u\n", frames ? render_stats.bytes / frames : 0);
+	ccprintf("Errors: %u\n", render_stats.errors);
+	ccprintf("Dropped dots: %u\n", render_stats.dropped);
+	for (i = 0; i < rgbkbd_count; i++)
+		ccprintf("GRID%d: state %d, failed frames %u\n", i,
+			 rgbkbds[i].state, rgbkbds[i].flush_failures);
+}
+
 test_export_static int cc_rgb(int argc, const char **argv)
 {
 	char *end, *comma;
@@ -657,6 +876,15 @@ test_export_static int cc_rgb(int argc, const char **argv)
 		if (rv)
 			return EC_ERROR_PARAM2;
 		rv = rgbkbd_reset_scale(scale);
+	} else if (!strcasecmp(argv[1], "stats")) {
+		/* Usage 7 */
+		if (argc > 2) {
+			if (strcasecmp(argv[2], "clear"))
+				return EC_ERROR_PARAM2;
+			memset(&render_stats, 0, sizeof(render_stats));
+			render_stats.since = get_time();
+		}
+		print_render_stats();
 	} else if (!strcasecmp(argv[1], "red")) {
 		rgb.r = 255;
 		rgb.g = 0;
@@ -682,6 +910,7 @@ DECLARE_CONSOLE_COMMAND(rgb, cc_rgb,
 			"3. rgb all <24-bit RGB code>\n"
 			"4. rgb demo <id>\n"
 			"5. rgb reset/enable/disable/red\n"
-			"6. rgb scale <24-bit RGB scale>\n",
+			"6. rgb scale <24-bit RGB scale>\n"
+			"7. rgb stats [clear]\n",
 			"Control RGB keyboard");
 #endif
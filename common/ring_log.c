@@ -0,0 +1,67 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Fixed-size logs of the most recent entries, read back oldest first.
+ */
+
+#include "host_command.h"
+#include "ring_log.h"
+
+#include <string.h>
+
+void *ring_log_append(const struct ring_log *log)
+{
+	uint32_t i = atomic_add(log->next, 1);
+
+	return (uint8_t *)log->entries + (i % log->capacity) * log->entry_size;
+}
+
+void ring_log_clear(const struct ring_log *log)
+{
+	atomic_clear(log->next);
+}
+
+int ring_log_read(const struct ring_log *log, uint32_t offset, void *out,
+		  int max_count, uint32_t *first, uint32_t *total)
+{
+	uint32_t next = *log->next;
+	uint32_t held = MIN(next, log->capacity);
+	uint32_t oldest = next - held;
+	uint8_t *dst = out;
+	int count = 0;
+
+	for (; offset < held && count < max_count; offset++, count++) {
+		memcpy(dst, (const uint8_t *)log->entries +
+				    ((oldest + offset) % log->capacity) *
+					    log->entry_size,
+		       log->entry_size);
+		dst += log->entry_size;
+	}
+
+	if (first)
+		*first = oldest;
+	if (total)
+		*total = held;
+
+	return count;
+}
+
+int ring_log_host_read(const struct ring_log *log,
+		       struct host_cmd_handler_args *args, size_t header_size,
+		       uint32_t offset, uint32_t *first, uint32_t *total)
+{
+	int max_count, count;
+
+	if (args->response_max < header_size)
+		return -EC_RES_RESPONSE_TOO_BIG;
+
+	max_count = MIN((args->response_max - header_size) / log->entry_size,
+			UINT8_MAX);
+	count = ring_log_read(log, offset,
+			      (uint8_t *)args->response + header_size,
+			      max_count, first, total);
+	args->response_size = header_size + count * log->entry_size;
+
+	return count;
+}
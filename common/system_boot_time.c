@@ -3,10 +3,12 @@
  * found in the LICENSE file.
  */
 
+#include "atomic.h"
 #include "common.h"
 #include "console.h"
 #include "host_command.h"
 #include "system.h"
+#include "system_boot_time.h"
 #include "util.h"
 
 #include <stdbool.h>
@@ -19,6 +21,9 @@ static struct ec_response_get_boot_time ap_boot_time;
 /* This function updates timestamp for ap boot time params */
 void update_ap_boot_time(enum boot_time_param param)
 {
+	if (param < EC_CUR_TIME)
+		boot_time_mark(EC_BOOT_TIME_EVENT_AP, 0, param);
+
 #ifdef CONFIG_SYSTEM_BOOT_TIME_LOGGING
 	static bool ap_booted; /* tracks AP booted after #PLTRST */
 	static bool pltrst_transition; /* tracks #PLTRST transtion */
@@ -94,3 +99,64 @@ host_command_get_boot_time(struct host_cmd_handler_args *args)
 DECLARE_HOST_COMMAND(EC_CMD_GET_BOOT_TIME, host_command_get_boot_time,
 		     EC_VER_MASK(0));
 #endif
+
+#ifdef CONFIG_BOOT_TIME_PROFILE
+static struct ec_boot_time_entry
+	boot_time_log[CONFIG_BOOT_TIME_PROFILE_ENTRIES];
+/* Number of events seen; only the first ones fit in boot_time_log */
+static atomic_t boot_time_count;
+
+void boot_time_mark(enum ec_boot_time_event event, uint8_t flags,
+		    uint32_t data)
+{
+	uint32_t i = atomic_add(&boot_time_count, 1);
+	struct ec_boot_time_entry *entry;
+
+	if (i >= CONFIG_BOOT_TIME_PROFILE_ENTRIES)
+		return;
+
+	entry = &boot_time_log[i];
+	entry->time_us = get_time().le.lo;
+	entry->data = data;
+	entry->event = event;
+	entry->flags = flags;
+	entry->reserved = 0;
+}
+
+static enum ec_status
+host_command_boot_time_profile(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_boot_time_profile *p = args->params;
+	struct ec_response_boot_time_profile *r = args->response;
+	uint32_t count, total;
+	int max_count, i;
+
+	if (p->flags & EC_BOOT_TIME_PROFILE_FLAG_CLEAR) {
+		atomic_clear(&boot_time_count);
+		args->response_size = 0;
+		return EC_RES_SUCCESS;
+	}
+
+	if (args->response_max < sizeof(*r))
+		return EC_RES_RESPONSE_TOO_BIG;
+
+	count = boot_time_count;
+	total = MIN(count, CONFIG_BOOT_TIME_PROFILE_ENTRIES);
+	max_count = MIN((args->response_max - sizeof(*r)) /
+				sizeof(r->entries[0]),
+			UINT8_MAX);
+
+	r->total = total;
+	r->dropped = MIN(count - total, UINT16_MAX);
+	r->count = 0;
+	memset(r->reserved, 0, sizeof(r->reserved));
+	for (i = p->offset; i < total && r->count < max_count; i++)
+		r->entries[r->count++] = boot_time_log[i];
+
+	args->response_size = sizeof(*r) + r->count * sizeof(r->entries[0]);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_BOOT_TIME_PROFILE, host_command_boot_time_profile,
+		     EC_VER_MASK(0));
+#endif /* CONFIG_BOOT_TIME_PROFILE */
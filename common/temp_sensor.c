@@ -5,6 +5,7 @@
 
 /* Temperature sensor module for Chrome EC */
 
+#include "atomic.h"
 #include "common.h"
 #include "console.h"
 #include "hooks.h"
@@ -32,6 +33,106 @@ int temp_sensor_read(enum temp_sensor_id id, int *temp_ptr)
 }
 #endif
 
+/*
+ * Latest reading of each sensor, updated once per HOOK_SECOND (or less often,
+ * see temp_sensor_set_sample_period()) so that the consumers below don't each
+ * read every sensor again.
+ */
+static struct temp_sensor_sample {
+	timestamp_t time; /* When sampled, 0 if never */
+	int temp;
+	int rv;
+	uint8_t period; /* Seconds between samples, 0 means 1 */
+} samples[TEMP_SENSOR_COUNT];
+
+/* Set to sample every sensor on the next pass, whatever its period */
+static atomic_t resample_all;
+
+/* thermal sensor read delay */
+#if defined(CONFIG_TEMP_SENSOR_POWER) && \
+	defined(CONFIG_TEMP_SENSOR_FIRST_READ_DELAY_MS)
+static int first_read_delay = CONFIG_TEMP_SENSOR_FIRST_READ_DELAY_MS;
+#endif
+
+int temp_sensor_read_cached(enum temp_sensor_id id, int *temp_ptr)
+{
+	const struct temp_sensor_sample *s;
+
+	if (id < 0 || id >= TEMP_SENSOR_COUNT)
+		return EC_ERROR_INVAL;
+	s = samples + id;
+
+	if (!s->time.val)
+		return EC_ERROR_BUSY;
+	if (s->rv == EC_SUCCESS)
+		*temp_ptr = s->temp;
+
+	return s->rv;
+}
+
+int temp_sensor_set_sample_period(enum temp_sensor_id id, int seconds)
+{
+	if (id < 0 || id >= TEMP_SENSOR_COUNT || seconds < 1 || seconds > 255)
+		return EC_ERROR_INVAL;
+
+	samples[id].period = seconds;
+
+	return EC_SUCCESS;
+}
+
+static void temp_sensor_sample(void)
+{
+	timestamp_t now;
+	int resample;
+	int i;
+
+	/* add delay to ensure thermal sensor is ready when EC boot */
+#if defined(CONFIG_TEMP_SENSOR_POWER) && \
+	defined(CONFIG_TEMP_SENSOR_FIRST_READ_DELAY_MS)
+	if (first_read_delay != 0) {
+		crec_msleep(first_read_delay);
+		first_read_delay = 0;
+	}
+#endif
+
+	resample = atomic_clear(&resample_all);
+	now = get_time();
+	for (i = 0; i < TEMP_SENSOR_COUNT; i++) {
+		struct temp_sensor_sample *s = samples + i;
+		uint64_t period = MAX(s->period, 1) * SECOND;
+
+		/*
+		 * Allow for HOOK_SECOND running a little early. A failed read
+		 * replaces the previous temperature and is retried next time.
+		 */
+		if (!resample && s->time.val && s->rv == EC_SUCCESS &&
+		    now.val - s->time.val < period - SECOND / 2)
+			continue;
+
+		s->rv = temp_sensor_read(i, &s->temp);
+		s->time = now;
+	}
+}
+/* Run after the drivers have updated their own readings */
+DECLARE_HOOK(HOOK_SECOND, temp_sensor_sample, HOOK_PRIO_TEMP_SENSOR_SAMPLE);
+DECLARE_DEFERRED(temp_sensor_sample);
+
+/*
+ * Sensors may be powered with the AP (e.g. CONFIG_TEMP_SENSOR_POWER), so a
+ * sample from the previous power state must not be served for the rest of a
+ * long sample period. Sample every sensor again right away.
+ */
+static void temp_sensor_power_change(void)
+{
+	atomic_or(&resample_all, 1);
+	hook_call_deferred(&temp_sensor_sample_data, 0);
+}
+DECLARE_HOOK(HOOK_CHIPSET_STARTUP, temp_sensor_power_change, HOOK_PRIO_DEFAULT);
+DECLARE_HOOK(HOOK_CHIPSET_RESUME, temp_sensor_power_change, HOOK_PRIO_DEFAULT);
+DECLARE_HOOK(HOOK_CHIPSET_SUSPEND, temp_sensor_power_change, HOOK_PRIO_DEFAULT);
+DECLARE_HOOK(HOOK_CHIPSET_SHUTDOWN, temp_sensor_power_change,
+	     HOOK_PRIO_DEFAULT);
+
 static void update_mapped_memory(void)
 {
 	int i, t;
@@ -47,13 +148,16 @@ static void update_mapped_memory(void)
 		else if (i >= EC_TEMP_SENSOR_ENTRIES + EC_TEMP_SENSOR_B_ENTRIES)
 			break;
 
-		switch (temp_sensor_read(i, &t)) {
+		switch (temp_sensor_read_cached(i, &t)) {
 		case EC_ERROR_NOT_POWERED:
 			*mptr = EC_TEMP_SENSOR_NOT_POWERED;
 			break;
 		case EC_ERROR_NOT_CALIBRATED:
 			*mptr = EC_TEMP_SENSOR_NOT_CALIBRATED;
 			break;
+		case EC_ERROR_BUSY:
+			/* Not sampled yet, keep the initial value */
+			break;
 		case EC_SUCCESS:
 			*mptr = t - EC_TEMP_SENSOR_OFFSET;
 			break;
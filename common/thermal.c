@@ -53,12 +53,6 @@ BUILD_ASSERT(EC_TEMP_THRESH_COUNT == 3);
 /* Keep track of which thresholds have triggered */
 static cond_t cond_hot[EC_TEMP_THRESH_COUNT];
 
-/* thermal sensor read delay */
-#if defined(CONFIG_TEMP_SENSOR_POWER) && \
-	defined(CONFIG_TEMP_SENSOR_FIRST_READ_DELAY_MS)
-static int first_read_delay = CONFIG_TEMP_SENSOR_FIRST_READ_DELAY_MS;
-#endif
-
 static void thermal_control(void)
 {
 	int i, j, t, rv;
@@ -76,15 +70,6 @@ static void thermal_control(void)
 #endif
 #endif
 
-	/* add delay to ensure thermal sensor is ready when EC boot */
-#if defined(CONFIG_TEMP_SENSOR_POWER) && \
-	defined(CONFIG_TEMP_SENSOR_FIRST_READ_DELAY_MS)
-	if (first_read_delay != 0) {
-		crec_msleep(first_read_delay);
-		first_read_delay = 0;
-	}
-#endif
-
 	/* Get ready to count things */
 	memset(count_over, 0, sizeof(count_over));
 	memset(count_under, 0, sizeof(count_under));
@@ -94,7 +79,7 @@ static void thermal_control(void)
 	/* go through all the sensors */
 	for (i = 0; i < TEMP_SENSOR_COUNT; ++i) {
 		/* read one */
-		rv = temp_sensor_read(i, &t);
+		rv = temp_sensor_read_cached(i, &t);
 
 #if defined(CONFIG_FANS) && defined(CONFIG_CUSTOM_FAN_CONTROL)
 		/* Store all sensors value */
@@ -9,6 +9,7 @@
 #include "charge_state.h"
 #include "dps.h"
 #include "system.h"
+#include "task.h"
 #include "usb_common.h"
 #include "usb_pd.h"
 #include "util.h"
@@ -54,77 +55,183 @@ static bool pd_get_usb_comm_capable(int port)
 	return !!(fixed_pdo & PDO_FIXED_COMM_CAP);
 }
 
+/**
+ * Return the power a source PDO offers this sink, or -1 if the sink would
+ * never request it.
+ *
+ * @param i index of the PDO within the source caps
+ * @param pdo raw PDO
+ * @param mv voltage of the PDO (output)
+ * @return power in uW, clamped to the board limits
+ */
+static int pdo_usable_uw(int i, uint32_t pdo, int *mv)
+{
+	int uw;
+
+	if (IS_ENABLED(CONFIG_USB_PD_ONLY_FIXED_PDOS) &&
+	    (pdo & PDO_TYPE_MASK) != PDO_TYPE_FIXED)
+		return -1;
+	/* its an unsupported Augmented PDO (PD3.0) */
+	if ((pdo & PDO_TYPE_MASK) == PDO_TYPE_AUGMENTED)
+		return -1;
+
+	*mv = PDO_FIXED_VOLTAGE(pdo);
+	/* Skip invalid voltage */
+	if (!*mv)
+		return -1;
+	/*
+	 * It's illegal to have EPR PDO in 1...7.
+	 * TODO: This is supposed to be a hard reset (8.3.3.3.8)
+	 */
+	if (i < 7 && *mv > PD_MAX_SPR_VOLTAGE)
+		return -1;
+	/* Skip any voltage not supported by this board */
+	if (!pd_is_valid_input_voltage(*mv))
+		return -1;
+
+	if ((pdo & PDO_TYPE_MASK) == PDO_TYPE_BATTERY) {
+		uw = 250000 * (pdo & 0x3FF);
+	} else {
+		int ma = PDO_FIXED_CURRENT(pdo);
+
+		ma = MIN(ma, CONFIG_USB_PD_MAX_CURRENT_MA);
+		uw = ma * *mv;
+	}
+
+	return MIN(uw, CONFIG_USB_PD_MAX_POWER_MW * 1000);
+}
+
+/*
+ * Return true if PDO a (power uw_a at mv_a) ranks ahead of PDO b: by power,
+ * then on equal power an SPR PDO ahead of an EPR one, so the sink never
+ * enters EPR mode for no extra power, then by the board's voltage preference.
+ */
+static bool pdo_ranks_before(int uw_a, int mv_a, int uw_b, int mv_b)
+{
+	if (uw_a != uw_b)
+		return uw_a > uw_b;
+	if ((mv_a > PD_MAX_SPR_VOLTAGE) != (mv_b > PD_MAX_SPR_VOLTAGE))
+		return mv_a <= PD_MAX_SPR_VOLTAGE;
+	if (IS_ENABLED(PD_PREFER_LOW_VOLTAGE))
+		return mv_a < mv_b;
+	if (IS_ENABLED(PD_PREFER_HIGH_VOLTAGE))
+		return mv_a > mv_b;
+	/* PDOs are compared in index order, so the earlier one wins */
+	return false;
+}
+
 int pd_find_pdo_index(uint32_t src_cap_cnt, const uint32_t *const src_caps,
 		      int max_mv, uint32_t *selected_pdo)
 {
 	int i, uw, mv;
 	int ret = 0;
 	int cur_uw = 0;
-	int has_preferred_pdo;
-	int prefer_cur;
-	int __attribute__((unused)) cur_mv = 0;
+	int cur_mv = 0;
 
 	/* max voltage is always limited by this boards max request */
 	max_mv = MIN(max_mv, CONFIG_USB_PD_MAX_VOLTAGE_MV);
 
 	/* Get max power that is under our max voltage input */
 	for (i = 0; i < src_cap_cnt; i++) {
-		if (IS_ENABLED(CONFIG_USB_PD_ONLY_FIXED_PDOS) &&
-		    (src_caps[i] & PDO_TYPE_MASK) != PDO_TYPE_FIXED)
-			continue;
-		/* its an unsupported Augmented PDO (PD3.0) */
-		if ((src_caps[i] & PDO_TYPE_MASK) == PDO_TYPE_AUGMENTED)
+		uw = pdo_usable_uw(i, src_caps[i], &mv);
+		if (uw < 0 || mv > max_mv)
 			continue;
 
-		mv = PDO_FIXED_VOLTAGE(src_caps[i]);
-		/* Skip invalid voltage */
-		if (!mv)
-			continue;
-		/*
-		 * It's illegal to have EPR PDO in 1...7.
-		 * TODO: This is supposed to be a hard reset (8.3.3.3.8)
-		 */
-		if (i < 7 && mv > PD_MAX_SPR_VOLTAGE)
-			continue;
-		/* Skip any voltage not supported by this board */
-		if (!pd_is_valid_input_voltage(mv))
-			continue;
+		if (pdo_ranks_before(uw, mv, cur_uw, cur_mv)) {
+			ret = i;
+			cur_uw = uw;
+			cur_mv = mv;
+		}
+	}
 
-		if ((src_caps[i] & PDO_TYPE_MASK) == PDO_TYPE_BATTERY) {
-			uw = 250000 * (src_caps[i] & 0x3FF);
-		} else {
-			int ma = PDO_FIXED_CURRENT(src_caps[i]);
+	if (selected_pdo)
+		*selected_pdo = src_caps[ret];
 
-			ma = MIN(ma, CONFIG_USB_PD_MAX_CURRENT_MA);
-			uw = ma * mv;
-		}
+	return ret;
+}
 
-		if (mv > max_mv)
+/*
+ * Per-port ranking of the source caps last stored on the port, most preferred
+ * first. pd_find_pdo_index() walks every received PDO, and the same caps are
+ * rescanned on each Request, charge manager refresh and DPS evaluation with
+ * varying voltage ceilings. The ranking is built once per caps generation
+ * (bumped by pd_invalidate_best_pdo() whenever new source caps are stored),
+ * and a query picks the first ranked PDO under its ceiling.
+ *
+ * PDOs are ranked by pdo_ranks_before(), as pd_find_pdo_index() picks them,
+ * with the lower index ahead on a tie. Augmented (PPS/AVS) PDOs are never
+ * requested, so are not ranked.
+ */
+static struct {
+	uint32_t caps_gen;
+	uint32_t ranked_gen;
+	uint8_t count;
+	uint8_t index[PDO_MAX_OBJECTS];
+	uint16_t mv[PDO_MAX_OBJECTS];
+	int uw[PDO_MAX_OBJECTS];
+} best_pdo[CONFIG_USB_PD_PORT_MAX_COUNT];
+static K_MUTEX_DEFINE(best_pdo_lock);
+
+static void rank_src_caps(int port)
+{
+	const uint32_t *const src_caps = pd_get_src_caps(port);
+	int cnt = MIN(pd_get_src_cap_cnt(port), PDO_MAX_OBJECTS);
+	int i, j, uw, mv;
+
+	best_pdo[port].count = 0;
+	for (i = 0; i < cnt; i++) {
+		uw = pdo_usable_uw(i, src_caps[i], &mv);
+		/* pd_find_pdo_index() never picks a PDO without power */
+		if (uw <= 0)
 			continue;
-		uw = MIN(uw, CONFIG_USB_PD_MAX_POWER_MW * 1000);
-		prefer_cur = 0;
-
-		/* Apply special rules in favor of voltage  */
-		if (IS_ENABLED(PD_PREFER_LOW_VOLTAGE)) {
-			if (uw == cur_uw && mv < cur_mv)
-				prefer_cur = 1;
-		} else if (IS_ENABLED(PD_PREFER_HIGH_VOLTAGE)) {
-			if (uw == cur_uw && mv > cur_mv)
-				prefer_cur = 1;
+
+		/* Insertion sort, stable for PDOs that rank the same */
+		for (j = best_pdo[port].count;
+		     j > 0 && pdo_ranks_before(uw, mv, best_pdo[port].uw[j - 1],
+					       best_pdo[port].mv[j - 1]);
+		     j--) {
+			best_pdo[port].index[j] = best_pdo[port].index[j - 1];
+			best_pdo[port].mv[j] = best_pdo[port].mv[j - 1];
+			best_pdo[port].uw[j] = best_pdo[port].uw[j - 1];
 		}
+		best_pdo[port].index[j] = i;
+		best_pdo[port].mv[j] = mv;
+		best_pdo[port].uw[j] = uw;
+		best_pdo[port].count++;
+	}
+	best_pdo[port].ranked_gen = best_pdo[port].caps_gen;
+}
 
-		/* Prefer higher power, except for tiebreaker */
-		has_preferred_pdo = prefer_cur || (uw > cur_uw);
+void pd_invalidate_best_pdo(int port)
+{
+	mutex_lock(&best_pdo_lock);
+	/* Generation 0 is never valid, so skip it on wrap */
+	if (++best_pdo[port].caps_gen == 0)
+		best_pdo[port].caps_gen = 1;
+	mutex_unlock(&best_pdo_lock);
+}
 
-		if (has_preferred_pdo) {
-			ret = i;
-			cur_uw = uw;
-			cur_mv = mv;
+int pd_get_best_pdo(int port, int max_mv, uint32_t *selected_pdo)
+{
+	int i, ret = 0;
+
+	/* max voltage is always limited by this boards max request */
+	max_mv = MIN(max_mv, CONFIG_USB_PD_MAX_VOLTAGE_MV);
+
+	mutex_lock(&best_pdo_lock);
+	if (best_pdo[port].caps_gen == 0 ||
+	    best_pdo[port].ranked_gen != best_pdo[port].caps_gen)
+		rank_src_caps(port);
+	for (i = 0; i < best_pdo[port].count; i++) {
+		if (best_pdo[port].mv[i] <= max_mv) {
+			ret = best_pdo[port].index[i];
+			break;
 		}
 	}
+	mutex_unlock(&best_pdo_lock);
 
 	if (selected_pdo)
-		*selected_pdo = src_caps[ret];
+		*selected_pdo = pd_get_src_caps(port)[ret];
 
 	return ret;
 }
@@ -140,7 +247,6 @@ void pd_build_request(int32_t vpd_vdo, uint32_t *rdo, uint32_t *ma,
 	int max_vbus;
 	int vpd_vbus_dcr;
 	int vpd_gnd_dcr;
-	uint32_t src_cap_cnt = pd_get_src_cap_cnt(port);
 	const uint32_t *const src_caps = pd_get_src_caps(port);
 	int charging_allowed;
 	int max_request_allowed;
@@ -178,8 +284,7 @@ void pd_build_request(int32_t vpd_vdo, uint32_t *rdo, uint32_t *ma,
 	 */
 	if (charging_allowed && max_request_allowed) {
 		/* find pdo index for max voltage we can request */
-		pdo_index = pd_find_pdo_index(src_cap_cnt, src_caps,
-					      max_request_mv, &pdo);
+		pdo_index = pd_get_best_pdo(port, max_request_mv, &pdo);
 	} else {
 		/* src cap 0 should be vSafe5V */
 		pdo_index = 0;
@@ -288,8 +393,7 @@ void pd_process_source_cap(int port, int cnt, uint32_t *src_caps)
 			max_mv = MIN(max_mv, dps_get_dynamic_voltage());
 
 		/* Get max power info that we could request */
-		pd_find_pdo_index(pd_get_src_cap_cnt(port),
-				  pd_get_src_caps(port), max_mv, &pdo);
+		pd_get_best_pdo(port, max_mv, &pdo);
 		pd_extract_pdo_power(pdo, &ma, &mv, &unused);
 
 		/* Set max. limit, but 2.5 W ceiling will be applied later. */
@@ -131,6 +131,9 @@ void pd_set_src_caps(int port, int cnt, uint32_t *src_caps)
 
 	for (i = 0; i < cnt; i++)
 		pd_src_caps[port][i] = *src_caps++;
+
+	if (IS_ENABLED(CONFIG_USB_PD_DUAL_ROLE))
+		pd_invalidate_best_pdo(port);
 }
 
 uint8_t pd_get_src_cap_cnt(int port)
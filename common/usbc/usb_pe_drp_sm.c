@@ -8547,6 +8547,8 @@ void pd_set_src_caps(int port, int cnt, uint32_t *src_caps)
 
 	for (i = 0; i < cnt; i++)
 		pe[port].src_caps[i] = *src_caps++;
+
+	pd_invalidate_best_pdo(port);
 }
 
 uint8_t pd_get_src_cap_cnt(int port)
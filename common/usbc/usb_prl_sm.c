@@ -18,6 +18,7 @@
 #include "hooks.h"
 #include "host_command.h"
 #include "registers.h"
+#include "ring_log.h"
 #include "system.h"
 #include "task.h"
 #include "tcpm/tcpm.h"
@@ -383,6 +384,9 @@ enum prl_event_log_state_kind {
 
 __maybe_unused static void
 prl_event_log_append(enum prl_event_log_state_kind kind, int port);
+__maybe_unused static void prl_timing_log_append(int port,
+						 enum ec_prl_timing_event event,
+						 uint32_t header);
 
 /* Common Protocol Layer Message Transmission */
 static void prl_tx_construct_message(int port);
@@ -540,8 +544,12 @@ static void set_tcpc_tx_success_ts(int port)
 
 void pd_transmit_complete(int port, int status)
 {
-	if (status == TCPC_TX_COMPLETE_SUCCESS)
+	if (status == TCPC_TX_COMPLETE_SUCCESS) {
 		set_tcpc_tx_success_ts(port);
+		prl_timing_log_append(port, EC_PRL_TIMING_TX_SUCCESS, 0);
+	} else if (status == TCPC_TX_COMPLETE_FAILED) {
+		prl_timing_log_append(port, EC_PRL_TIMING_TX_FAILED, 0);
+	}
 	prl_tx[port].xmit_status = status;
 }
 
@@ -988,6 +996,7 @@ static void prl_tx_discard_message_entry(const int port)
 	    prl_tx[port].xmit_status == TCPC_TX_COMPLETE_DISCARDED) {
 		PRL_TX_CLR_FLAG(port, PRL_FLAGS_MSG_XMIT);
 		increment_msgid_counter(port);
+		prl_timing_log_append(port, EC_PRL_TIMING_TX_DISCARD, 0);
 		pe_report_discard(port);
 	}
 
@@ -1119,6 +1128,8 @@ static void prl_tx_construct_message(const int port)
 	 * should not retry those messages. We do not support that and probably
 	 * never will (since we support chunking).
 	 */
+	prl_timing_log_append(port, EC_PRL_TIMING_TX_START,
+			      PD_HEADER_SOP(pdmsg[port].xmit_type) | header);
 	tcpm_transmit(port, pdmsg[port].xmit_type, header,
 		      pdmsg[port].tx_chk_buf);
 }
@@ -2182,6 +2193,8 @@ static void prl_rx_wait_for_phy_message(const int port, int evt)
 	    tcpm_dequeue_message(port, pdmsg[port].rx_chk_buf, &header))
 		return;
 
+	prl_timing_log_append(port, EC_PRL_TIMING_RX, header);
+
 	rx_emsg[port].header = header;
 	type = PD_HEADER_TYPE(header);
 	cnt = PD_HEADER_CNT(header);
@@ -2613,6 +2626,74 @@ prl_event_log_append(enum prl_event_log_state_kind kind, int port)
 }
 #endif
 
+#ifdef CONFIG_USB_PD_PRL_TIMING_LOG
+static struct ec_prl_timing_entry
+	prl_timing_log[CONFIG_USB_PD_PORT_MAX_COUNT]
+		      [CONFIG_USB_PD_PRL_TIMING_LOG_CAPACITY];
+static atomic_t prl_timing_log_next[CONFIG_USB_PD_PORT_MAX_COUNT];
+
+#define PRL_TIMING_LOG(port) \
+	RING_LOG(prl_timing_log[port], &prl_timing_log_next[port])
+
+/*
+ * Note this may be called from the TCPC alert (interrupt) context, so both
+ * adding entries and reading them out happen with interrupts locked.
+ */
+static void prl_timing_log_append(int port, enum ec_prl_timing_event event,
+				  uint32_t header)
+{
+	struct ec_prl_timing_entry *entry;
+	uint32_t lock_key = irq_lock();
+
+	entry = ring_log_append(&PRL_TIMING_LOG(port));
+	entry->time_us = get_time().le.lo;
+	entry->header = header & 0xffff;
+	entry->event = event;
+	entry->sop = PD_HEADER_GET_SOP(header);
+
+	irq_unlock(lock_key);
+}
+
+static enum ec_status hc_usb_pd_prl_timing(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_usb_pd_prl_timing *p = args->params;
+	struct ec_response_usb_pd_prl_timing *r = args->response;
+	uint32_t first, total, lock_key;
+	int count;
+
+	if (p->port >= board_get_usb_pd_port_count())
+		return EC_RES_INVALID_PARAM;
+
+	if (p->flags & EC_PRL_TIMING_FLAG_CLEAR) {
+		ring_log_clear(&PRL_TIMING_LOG(p->port));
+		args->response_size = 0;
+		return EC_RES_SUCCESS;
+	}
+
+	lock_key = irq_lock();
+	count = ring_log_host_read(&PRL_TIMING_LOG(p->port), args, sizeof(*r),
+				   p->offset, &first, &total);
+	irq_unlock(lock_key);
+	if (count < 0)
+		return -count;
+
+	r->first = first;
+	r->total = total;
+	r->count = count;
+	r->reserved = 0;
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_USB_PD_PRL_TIMING, hc_usb_pd_prl_timing,
+		     EC_VER_MASK(0));
+#else
+__maybe_unused static void prl_timing_log_append(int port,
+						 enum ec_prl_timing_event event,
+						 uint32_t header)
+{
+}
+#endif /* CONFIG_USB_PD_PRL_TIMING_LOG */
+
 #ifdef TEST_BUILD
 
 const struct test_sm_data test_prl_sm_data[] = {
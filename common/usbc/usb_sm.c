@@ -3,10 +3,13 @@
  * found in the LICENSE file.
  */
 
+#include "atomic.h"
 #include "common.h"
 #include "console.h"
+#include "ring_log.h"
 #include "stdbool.h"
 #include "task.h"
+#include "timer.h"
 #include "usb_pd.h"
 #include "usb_sm.h"
 #include "util.h"
@@ -29,34 +32,105 @@ struct internal_ctx {
 BUILD_ASSERT(sizeof(struct internal_ctx) ==
 	     member_size(struct sm_ctx, internal));
 
-/* Gets the first shared parent state between a and b (inclusive) */
+#ifdef CONFIG_USB_SM_TRACE
+/* Number of state transitions kept in the trace ring */
+#define SM_TRACE_DEPTH 32
+
+static struct usb_sm_trace_entry sm_trace_entries[SM_TRACE_DEPTH];
+static atomic_t sm_trace_count;
+static const struct ring_log sm_trace =
+	RING_LOG_INIT(sm_trace_entries, &sm_trace_count);
+
+static void sm_trace_add(int port, usb_state_ptr from, usb_state_ptr to)
+{
+	struct usb_sm_trace_entry *e = ring_log_append(&sm_trace);
+
+	e->time_us = get_time().le.lo;
+	e->port = port;
+	e->from = from;
+	e->to = to;
+}
+
+int usb_sm_trace_read(struct usb_sm_trace_entry *entries, int max)
+{
+	return ring_log_read(&sm_trace, 0, entries, max, NULL, NULL);
+}
+
+void usb_sm_trace_clear(void)
+{
+	ring_log_clear(&sm_trace);
+}
+
+#ifdef CONFIG_COMMON_RUNTIME
+static int command_smtrace(int argc, const char **argv)
+{
+	struct usb_sm_trace_entry entries[SM_TRACE_DEPTH];
+	int i, n;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "clear"))
+			return EC_ERROR_PARAM1;
+		usb_sm_trace_clear();
+		return EC_SUCCESS;
+	}
+
+	n = usb_sm_trace_read(entries, ARRAY_SIZE(entries));
+	for (i = 0; i < n; i++) {
+		ccprintf("%10u C%d %p -> %p\n", entries[i].time_us,
+			 entries[i].port, entries[i].from, entries[i].to);
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(smtrace, command_smtrace, "[clear]",
+			"Print recent USB state machine transitions");
+#endif /* CONFIG_COMMON_RUNTIME */
+#endif /* CONFIG_USB_SM_TRACE */
+
+/* Returns the number of ancestors of a state (0 for a top level state) */
+static int state_depth(usb_state_ptr s)
+{
+	int depth = 0;
+
+	while (s->parent != NULL) {
+		s = s->parent;
+		depth++;
+	}
+
+	return depth;
+}
+
+/*
+ * Gets the first shared parent state between a and b (inclusive).
+ *
+ * Both states are brought to the same depth in the hierarchy and then walked
+ * up in lockstep, so this is linear in the hierarchy depth rather than
+ * comparing every ancestor of a against every ancestor of b.
+ */
 static usb_state_ptr shared_parent_state(usb_state_ptr a, usb_state_ptr b)
 {
-	const usb_state_ptr orig_b = b;
+	int depth_a, depth_b;
 
 	/* There are no common ancestors */
-	if (b == NULL)
+	if (a == NULL || b == NULL)
 		return NULL;
 
+	depth_a = state_depth(a);
+	depth_b = state_depth(b);
+
+	for (; depth_a > depth_b; depth_a--)
+		a = a->parent;
+	for (; depth_b > depth_a; depth_b--)
+		b = b->parent;
+
 	/* This assumes that both A and B are NULL terminated without cycles */
-	while (a != NULL) {
-		/* We found a match return */
-		if (a == b)
-			return a;
-
-		/*
-		 * Otherwise, increment b down the list for comparison until we
-		 * run out, then increment a and start over on b for comparison
-		 */
-		if (b->parent == NULL) {
-			a = a->parent;
-			b = orig_b;
-		} else {
-			b = b->parent;
-		}
+	while (a != b) {
+		a = a->parent;
+		b = b->parent;
 	}
 
-	return NULL;
+	return a;
 }
 
 /*
@@ -116,7 +190,7 @@ void set_state(const int port, struct sm_ctx *const ctx,
 	 * intended state to transition into.
 	 */
 	if (internal->exit) {
-		CPRINTF("C%d: Ignoring set state to 0x%p within 0x%p", port,
+		CPRINTF("C%d: Ignoring set state to %p within %p", port,
 			new_state, ctx->current);
 		return;
 	}
@@ -141,6 +215,10 @@ void set_state(const int port, struct sm_ctx *const ctx,
 	ctx->previous = ctx->current;
 	ctx->current = new_state;
 
+#ifdef CONFIG_USB_SM_TRACE
+	sm_trace_add(port, ctx->previous, new_state);
+#endif
+
 	/*
 	 * Enter all new non-common states. last_entered will contain the last
 	 * state that successfully entered before another set_state was called.
@@ -59,3 +59,37 @@ fp_t fpv3_norm(const fpv3_t v)
 {
 	return fp_sqrtf(fpv3_norm_squared(v));
 }
+
+void fpv3_int16_scale_init(struct fpv3_int16_scale *s, int range)
+{
+	s->range = INT_TO_FP(range);
+#ifdef CONFIG_FPU
+	s->pos = s->range / 0x7fff;
+	s->neg = s->range / 0x8000;
+#else
+	/* Keep FP_BITS extra bits of precision for the product. */
+	s->pos = ((fp_inter_t)s->range << FP_BITS) / 0x7fff;
+	s->neg = ((fp_inter_t)s->range << FP_BITS) / 0x8000;
+#endif
+}
+
+static inline fp_t scale_int16(int16_t v, const struct fpv3_int16_scale *s)
+{
+	fp_inter_t k = v >= 0 ? s->pos : s->neg;
+	fp_t out;
+
+#ifdef CONFIG_FPU
+	out = v * k;
+#else
+	out = (fp_t)((v * k) >> FP_BITS);
+#endif
+	return CLAMP(out, -s->range, s->range);
+}
+
+void fpv3_from_int16(fpv3_t out, const int16_t *data,
+		     const struct fpv3_int16_scale *s)
+{
+	out[X] = scale_int16(data[X], s);
+	out[Y] = scale_int16(data[Y], s);
+	out[Z] = scale_int16(data[Z], s);
+}
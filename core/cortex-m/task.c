@@ -13,6 +13,7 @@
 #include "debug.h"
 #include "link_defs.h"
 #include "panic.h"
+#include "system_boot_time.h"
 #include "task.h"
 #include "timer.h"
 #include "util.h"
@@ -206,6 +207,10 @@ static atomic_t tasks_enabled = BIT(TASK_ID_HOOKS) | BIT(TASK_ID_IDLE);
 
 static int start_called; /* Has task swapping started */
 
+#ifdef CONFIG_BOOT_TIME_PROFILE
+static uint32_t tasks_run; /* Bitmap of tasks which have been switched to */
+#endif
+
 static inline task_ *__task_id_to_ptr(task_id_t id)
 {
 	return tasks + id;
@@ -345,6 +350,13 @@ void svc_handler(int desched, task_id_t resched)
 	if (next == current)
 		return;
 
+#ifdef CONFIG_BOOT_TIME_PROFILE
+	if (!(tasks_run & BIT(next - tasks))) {
+		tasks_run |= BIT(next - tasks);
+		boot_time_mark(EC_BOOT_TIME_EVENT_TASK_START, 0, next - tasks);
+	}
+#endif
+
 		/* Switch to new task */
 #ifdef CONFIG_TASK_PROFILING
 	task_switches++;
@@ -69,6 +69,21 @@ static inline atomic_val_t atomic_clear(atomic_t *addr)
 	return ret;
 }
 
+static inline atomic_val_t atomic_exchange(atomic_t *addr, atomic_val_t value)
+{
+	atomic_t ret;
+
+	__asm__ __volatile__("   cpsid   i\n"
+			     "   ldr     %0, [%1]\n"
+			     "   str     %2, [%1]\n"
+			     "   cpsie   i\n"
+			     : "=&l"(ret)
+			     : "l"(addr), "l"(value)
+			     : "cc", "memory");
+
+	return ret;
+}
+
 static inline atomic_val_t atomic_and(atomic_t *addr, atomic_val_t bits)
 {
 	return ATOMIC_OP(ands, addr, bits);
@@ -36,6 +36,11 @@ static inline atomic_val_t atomic_clear(atomic_t *addr)
 	return __atomic_exchange_n(addr, 0, __ATOMIC_SEQ_CST);
 }
 
+static inline atomic_val_t atomic_exchange(atomic_t *addr, atomic_val_t value)
+{
+	return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+}
+
 static inline atomic_val_t atomic_and(atomic_t *addr, atomic_val_t bits)
 {
 	return __atomic_fetch_and(addr, bits, __ATOMIC_SEQ_CST);
@@ -12,6 +12,7 @@
 #include "keyboard_scan.h"
 #include "stack_trace.h"
 #include "system.h"
+#include "system_boot_time.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -48,7 +49,11 @@ static int test_main(void)
 
 	timer_init();
 
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+		       EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY);
 	hook_notify(HOOK_INIT_EARLY);
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+		       EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY);
 
 #ifdef HAS_TASK_KEYSCAN
 	keyboard_scan_init();
@@ -64,6 +69,8 @@ static int test_main(void)
 		CPUTS("]\n");
 	}
 
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, 0,
+		       EC_BOOT_TIME_STAGE_TASK_START);
 	task_start();
 
 	return 0;
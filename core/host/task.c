@@ -9,6 +9,7 @@
 #include "common.h"
 #include "console.h"
 #include "host_task.h"
+#include "system_boot_time.h"
 #include "task.h"
 #include "task_id.h"
 #include "test_util.h"
@@ -463,6 +464,7 @@ void *_task_start_impl(void *a)
 	tasks[tid].event = 0;
 
 	/* Start the task routine */
+	boot_time_mark(EC_BOOT_TIME_EVENT_TASK_START, 0, tid);
 	(arg->routine)(arg->d);
 
 	/* Catch exited routine */
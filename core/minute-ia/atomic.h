@@ -65,4 +65,9 @@ static inline atomic_val_t atomic_clear(atomic_t *addr)
 	return __atomic_exchange_n(addr, 0, __ATOMIC_SEQ_CST);
 }
 
+static inline atomic_val_t atomic_exchange(atomic_t *addr, atomic_val_t value)
+{
+	return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+}
+
 #endif /* __CROS_EC_ATOMIC_H */
@@ -38,6 +38,11 @@ static inline atomic_val_t atomic_clear(atomic_t *addr)
 	return __atomic_exchange_n(addr, 0, __ATOMIC_SEQ_CST);
 }
 
+static inline atomic_val_t atomic_exchange(atomic_t *addr, atomic_val_t value)
+{
+	return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+}
+
 static inline atomic_val_t atomic_read_add(atomic_t *addr, atomic_val_t value)
 {
 	return __atomic_fetch_add(addr, value, __ATOMIC_SEQ_CST);
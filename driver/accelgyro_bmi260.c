@@ -403,7 +403,11 @@ static int irq_handler(struct motion_sensor_t *s, uint32_t *event)
 		return rv;
 
 	if (IS_ENABLED(CONFIG_ACCEL_FIFO) && has_read_fifo)
-		motion_sense_fifo_commit_data();
+		bmi_commit_fifo(s);
+
+	/* Without batching, each sample interrupts: none is left behind */
+	if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH))
+		bmi_drain_fifo(s, *event);
 
 	return EC_SUCCESS;
 }
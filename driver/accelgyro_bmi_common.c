@@ -11,10 +11,12 @@
 #include "accelgyro.h"
 #include "accelgyro_bmi_common.h"
 #include "console.h"
+#include "hwtimer.h"
 #include "i2c.h"
 #include "mag_bmm150.h"
 #include "mag_lis2mdl.h"
 #include "math_util.h"
+#include "motion_sense.h"
 #include "motion_sense_fifo.h"
 #include "spi.h"
 
@@ -409,7 +411,12 @@ enum fifo_state {
 	FIFO_DATA_CONFIG,
 };
 
+#ifdef CONFIG_ACCEL_FIFO_BATCH
+/* 2 full batches of 7 bytes frames (header and one sensor) */
+#define BMI_FIFO_BUFFER (MOTION_SENSE_FIFO_BATCH_MAX * 14)
+#else
 #define BMI_FIFO_BUFFER 64
+#endif
 static uint8_t bmi_buffer[BMI_FIFO_BUFFER];
 
 int bmi_load_fifo(struct motion_sensor_t *s, uint32_t last_ts)
@@ -547,6 +554,30 @@ int bmi_load_fifo(struct motion_sensor_t *s, uint32_t last_ts)
 	return EC_SUCCESS;
 }
 
+void bmi_commit_fifo(const struct motion_sensor_t *s)
+{
+	if (BMI_GET_DATA(s)->batch_size > 1)
+		motion_sense_fifo_mark_batch();
+	motion_sense_fifo_commit_data();
+}
+
+void bmi_drain_fifo(struct motion_sensor_t *s, uint32_t event)
+{
+	uint16_t length;
+
+	if (!(event & TASK_EVENT_MOTION_FLUSH_PENDING))
+		return;
+
+	/* Don't bother bmi_load_fifo() with an empty FIFO */
+	if (bmi_read_n(s->port, s->i2c_spi_addr_flags, BMI_FIFO_LENGTH_0(V(s)),
+		       (uint8_t *)&length, sizeof(length)) ||
+	    !(length & BMI_FIFO_LENGTH_MASK(V(s))))
+		return;
+
+	bmi_load_fifo(s, __hw_clock_source_read());
+	bmi_commit_fifo(s);
+}
+
 int bmi_set_range(struct motion_sensor_t *s, int range, int rnd)
 {
 	int ret, range_tbl_size;
@@ -670,6 +701,35 @@ int bmi_get_scale(const struct motion_sensor_t *s, uint16_t *scale,
 	return EC_SUCCESS;
 }
 
+/* Interrupt once a batch of samples of the sensors in the FIFO is there. */
+static int bmi_set_fifo_watermark(const struct motion_sensor_t *s)
+{
+	struct bmi_drv_data_t *data = BMI_GET_DATA(s);
+	const struct motion_sensor_t *accel = s - s->type;
+	const struct motion_sensor_t *sensors[MOTIONSENSE_TYPE_MAG + 1];
+	int i, bytes;
+
+	for (i = MOTIONSENSE_TYPE_ACCEL; i <= MOTIONSENSE_TYPE_MAG; i++)
+		sensors[i] = data->flags & (1 << (i + BMI_FIFO_FLAG_OFFSET)) ?
+				     accel + i :
+				     NULL;
+	data->batch_size =
+		motion_sense_fifo_batch_size(sensors, ARRAY_SIZE(sensors));
+
+	/* A frame is a header and 6 bytes per sensor. */
+	bytes = data->batch_size * 6;
+	if (V(s)) {
+		/* BMI260 watermark is in bytes */
+		RETURN_ERROR(bmi_write8(s->port, s->i2c_spi_addr_flags,
+					BMI260_FIFO_WTM_0, bytes & 0xff));
+		return bmi_write8(s->port, s->i2c_spi_addr_flags,
+				  BMI260_FIFO_WTM_1, bytes >> 8);
+	}
+	/* BMI160 watermark is in 4 bytes units */
+	return bmi_write8(s->port, s->i2c_spi_addr_flags, BMI160_FIFO_CONFIG_0,
+			  MIN(DIV_ROUND_UP(bytes, 4), 0xff));
+}
+
 int bmi_enable_fifo(const struct motion_sensor_t *s, int enable)
 {
 	struct bmi_drv_data_t *data = BMI_GET_DATA(s);
@@ -686,6 +746,9 @@ int bmi_enable_fifo(const struct motion_sensor_t *s, int enable)
 	else
 		data->flags &= ~(1 << (s->type + BMI_FIFO_FLAG_OFFSET));
 
+	if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH))
+		ret = bmi_set_fifo_watermark(s);
+
 	return ret;
 }
 
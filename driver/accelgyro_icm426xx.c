@@ -271,6 +271,14 @@ void icm426xx_interrupt(enum gpio_signal signal)
 		       CONFIG_ACCELGYRO_ICM426XX_INT_EVENT);
 }
 
+/* Commit the data staged by icm426xx_load_fifo() */
+static void icm426xx_commit_fifo(struct motion_sensor_t *s)
+{
+	if (ICM_GET_DATA(s)->batch_size > 1)
+		motion_sense_fifo_mark_batch();
+	motion_sense_fifo_commit_data();
+}
+
 /**
  * icm426xx_irq_handler - bottom half of the interrupt stack.
  * Ran from the motion_sense task, finds the events that raised the interrupt.
@@ -294,7 +302,21 @@ static int icm426xx_irq_handler(struct motion_sensor_t *s, uint32_t *event)
 	if (status & ICM426XX_FIFO_INT_STATUS) {
 		ret = icm426xx_load_fifo(s, last_interrupt_timestamp);
 		if (IS_ENABLED(CONFIG_ACCEL_FIFO) && (ret == EC_SUCCESS))
-			motion_sense_fifo_commit_data();
+			icm426xx_commit_fifo(s);
+	}
+
+	/*
+	 * With a flush pending, drain the FIFO whatever the status says:
+	 * samples batched below the watermark must reach the AP ahead of the
+	 * flush event. An empty FIFO reads as EC_ERROR_INVAL.
+	 */
+	if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH) && (ret == EC_SUCCESS) &&
+	    (*event & TASK_EVENT_MOTION_FLUSH_PENDING)) {
+		ret = icm426xx_load_fifo(s, __hw_clock_source_read());
+		if (ret == EC_SUCCESS)
+			icm426xx_commit_fifo(s);
+		else if (ret == EC_ERROR_INVAL)
+			ret = EC_SUCCESS;
 	}
 
 out_unlock:
@@ -332,7 +354,10 @@ static int icm426xx_config_interrupt(const struct motion_sensor_t *s)
 	/* clear internal FIFO enable bits tracking */
 	st->fifo_en = 0;
 
-	/* set FIFO watermark to 1 data packet (8 bytes) */
+	/*
+	 * set FIFO watermark to 1 data packet (8 bytes), raised by
+	 * icm426xx_set_watermark() with CONFIG_ACCEL_FIFO_BATCH
+	 */
 	ret = icm_write16(s, ICM426XX_REG_FIFO_WATERMARK, 8);
 	if (ret != EC_SUCCESS)
 		return ret;
@@ -398,6 +423,24 @@ static int icm426xx_enable_sensor(const struct motion_sensor_t *s, int enable)
 	return ret;
 }
 
+/* Interrupt once a batch of accel and gyro samples is in the FIFO */
+static int icm426xx_set_watermark(const struct motion_sensor_t *s)
+{
+	struct icm_drv_data_t *st = ICM_GET_DATA(s);
+	const struct motion_sensor_t *sensors[] = { st->accel, st->gyro };
+	int ret;
+
+	st->batch_size =
+		motion_sense_fifo_batch_size(sensors, ARRAY_SIZE(sensors));
+
+	/* a sample is 8 bytes, accel and gyro together are 16 bytes */
+	mutex_lock(s->mutex);
+	ret = icm_write16(s, ICM426XX_REG_FIFO_WATERMARK, st->batch_size * 8);
+	mutex_unlock(s->mutex);
+
+	return ret;
+}
+
 static int icm426xx_set_data_rate(const struct motion_sensor_t *s, int rate,
 				  int rnd)
 {
@@ -443,6 +486,8 @@ static int icm426xx_set_data_rate(const struct motion_sensor_t *s, int rate,
 		/* disable sensor */
 		ret = icm426xx_enable_sensor(s, 0);
 		data->odr = 0;
+		if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH) && ret == EC_SUCCESS)
+			ret = icm426xx_set_watermark(s);
 		return ret;
 	}
 
@@ -465,6 +510,8 @@ static int icm426xx_set_data_rate(const struct motion_sensor_t *s, int rate,
 	}
 
 	data->odr = normalized_rate;
+	if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH))
+		return icm426xx_set_watermark(s);
 	return EC_SUCCESS;
 
 out_unlock:
@@ -11,6 +11,7 @@
 #include "accelgyro.h"
 #include "builtin/stddef.h"
 #include "hwtimer.h"
+#include "motion_sense_fifo.h"
 #include "timer.h"
 
 #include <sys/types.h>
@@ -20,7 +21,10 @@
 #error "ICM must use either SPI or I2C communication"
 #endif
 
-#ifdef CONFIG_ACCEL_FIFO
+#if defined(CONFIG_ACCEL_FIFO_BATCH)
+/* reserve 2 full batches, with both sensors in 16 bytes packets */
+#define ICM_FIFO_BUFFER (MOTION_SENSE_FIFO_BATCH_MAX * 16)
+#elif defined(CONFIG_ACCEL_FIFO)
 /* reserve maximum 4 samples of 16 bytes */
 #define ICM_FIFO_BUFFER 64
 #else
@@ -34,6 +38,8 @@ struct icm_drv_data_t {
 	uint32_t stabilize_ts[2];
 	uint8_t bank;
 	uint8_t fifo_en;
+	/* samples in the FIFO that raise the watermark interrupt */
+	uint16_t batch_size;
 	uint8_t fifo_buffer[ICM_FIFO_BUFFER] __aligned(sizeof(long));
 };
 
@@ -32,6 +32,13 @@
 STATIC_IF(ACCEL_LSM6DSM_INT_ENABLE)
 volatile uint32_t last_interrupt_timestamp;
 
+#ifdef CONFIG_ACCEL_FIFO_BATCH
+/* Read a whole batch in one transaction */
+#define LSM6DSM_FIFO_READ_LEN (MOTION_SENSE_FIFO_BATCH_MAX * OUT_XYZ_SIZE)
+#else
+#define LSM6DSM_FIFO_READ_LEN FIFO_READ_LEN
+#endif
+
 /**
  * Gets the sensor type associated with the dev_fifo enum. This type can be used
  * to get the sensor number by using it as an offset from the first sensor in
@@ -73,7 +80,10 @@ __maybe_unused static int config_interrupt(const struct motion_sensor_t *accel)
 	RETURN_ERROR(st_raw_read8(accel->port, accel->i2c_spi_addr_flags,
 				  LSM6DSM_INT1_CTRL, &int1_ctrl_val));
 
-	/* As soon as one sample is ready, trigger an interrupt. */
+	/*
+	 * As soon as one sample is ready, trigger an interrupt. With
+	 * CONFIG_ACCEL_FIFO_BATCH, fifo_set_watermark() raises it.
+	 */
 	RETURN_ERROR(st_raw_write8(accel->port, accel->i2c_spi_addr_flags,
 				   LSM6DSM_FIFO_CTRL1_ADDR,
 				   OUT_XYZ_SIZE / sizeof(uint16_t)));
@@ -224,6 +234,31 @@ static int fifo_enable(const struct motion_sensor_t *accel)
 	return EC_SUCCESS;
 }
 
+/**
+ * fifo_set_watermark - Interrupt once a batch of samples is in the FIFO
+ * @accel must be the accelerometer sensor.
+ */
+static int fifo_set_watermark(const struct motion_sensor_t *accel)
+{
+	const struct motion_sensor_t *sensors[FIFO_DEV_NUM];
+	struct lsm6dsm_accel_fifo_state *fifo_state =
+		LSM6DSM_GET_DATA(accel)->accel_fifo_state;
+	int i, words;
+
+	/* Sensors are in the same order as in fifo_enable(). */
+	for (i = FIFO_DEV_GYRO; i < FIFO_DEV_NUM; i++)
+		sensors[i] = accel + get_sensor_type(i);
+
+	fifo_state->batch_size =
+		motion_sense_fifo_batch_size(sensors, FIFO_DEV_NUM);
+	words = fifo_state->batch_size * OUT_XYZ_SIZE / sizeof(uint16_t);
+
+	RETURN_ERROR(st_raw_write8(accel->port, accel->i2c_spi_addr_flags,
+				   LSM6DSM_FIFO_CTRL1_ADDR, words & 0xff));
+	return st_write_data_with_mask(accel, LSM6DSM_FIFO_CTRL2_ADDR,
+				       LSM6DSM_FIFO_CTRL2_FTH_MASK, words >> 8);
+}
+
 #ifdef ACCEL_LSM6DSM_INT_ENABLE
 /*
  * Must order FIFO read based on ODR:
@@ -334,7 +369,8 @@ static int load_fifo(struct motion_sensor_t *s, const struct fstatus *fsts)
 {
 	uint32_t interrupt_timestamp = last_interrupt_timestamp;
 	int err, left, length;
-	uint8_t fifo[FIFO_READ_LEN];
+	/* Only the motion sense task reads the FIFO. */
+	static uint8_t fifo[LSM6DSM_FIFO_READ_LEN];
 
 	/*
 	 * DIFF[11:0] are number of unread uint16 in FIFO
@@ -347,8 +383,8 @@ static int load_fifo(struct motion_sensor_t *s, const struct fstatus *fsts)
 	/* Push all data on upper side. */
 	do {
 		/* Fit len to pre-allocated static buffer. */
-		if (left > FIFO_READ_LEN)
-			length = FIFO_READ_LEN;
+		if (left > LSM6DSM_FIFO_READ_LEN)
+			length = LSM6DSM_FIFO_READ_LEN;
 		else
 			length = left;
 
@@ -408,8 +444,11 @@ static int irq_handler(struct motion_sensor_t *s, uint32_t *event)
 			RETURN_ERROR(load_fifo(s, &fsts));
 		}
 	}
-	if (IS_ENABLED(CONFIG_ACCEL_FIFO) && commit_needed)
+	if (IS_ENABLED(CONFIG_ACCEL_FIFO) && commit_needed) {
+		if (LSM6DSM_GET_DATA(s)->accel_fifo_state->batch_size > 1)
+			motion_sense_fifo_mark_batch();
 		motion_sense_fifo_commit_data();
+	}
 
 	return EC_SUCCESS;
 }
@@ -534,7 +573,10 @@ int lsm6dsm_set_data_rate(const struct motion_sensor_t *s, int rate, int rnd)
 		data->base.odr = normalized_rate;
 		fifo_state->samples_to_discard[s->type] =
 			LSM6DSM_DISCARD_SAMPLES;
-		ret = fifo_enable(accel);
+		if (IS_ENABLED(CONFIG_ACCEL_FIFO_BATCH))
+			ret = fifo_set_watermark(accel);
+		if (ret == EC_SUCCESS)
+			ret = fifo_enable(accel);
 		if (ret != EC_SUCCESS)
 			CPRINTS("Failed to enable FIFO. Error: %d", ret);
 	}
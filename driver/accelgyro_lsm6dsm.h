@@ -37,6 +37,7 @@
 #define LSM6DSM_ODR_MASK 0xf0
 
 #define LSM6DSM_FIFO_CTRL2_ADDR 0x07
+#define LSM6DSM_FIFO_CTRL2_FTH_MASK 0x07
 
 #define LSM6DSM_FIFO_CTRL3_ADDR 0x08
 #define LSM6DSM_FIFO_DEC_XL_OFF 0
@@ -303,6 +304,8 @@ struct lsm6dsm_accel_fifo_state {
 	 * initial samples with incorrect values
 	 */
 	unsigned int samples_to_discard[FIFO_DEV_NUM];
+	/* Samples in the FIFO that raise the watermark interrupt */
+	int batch_size;
 };
 
 /*
@@ -11,6 +11,30 @@
 
 #include <stdint.h>
 
+/* ManufacturerAccess command returning all cell voltages (DAStatus1) */
+#define BQ4050_MAC_DASTATUS1 0x0071
+
+/*
+ * Read the four cell voltages with one ManufacturerBlockAccess transaction
+ * instead of four CellVoltage reads. DAStatus1 starts with Cell Voltage 1..4
+ * as little-endian words, after the two-byte command echo.
+ */
+static int bq4050_read_cell_voltages(int *cell_voltage, int count)
+{
+	uint8_t data[2 + 4 * 2];
+	int i, rv;
+
+	rv = sb_read_mfgacc(BQ4050_MAC_DASTATUS1, SB_ALT_MANUFACTURER_ACCESS,
+			    data, sizeof(data));
+	if (rv)
+		return rv;
+
+	for (i = 0; i < count; i++)
+		cell_voltage[i] = data[2 + 2 * i] | data[3 + 2 * i] << 8;
+
+	return EC_SUCCESS;
+}
+
 int battery_bq4050_imbalance_mv(void)
 {
 	/*
@@ -20,13 +44,24 @@ int battery_bq4050_imbalance_mv(void)
 	 */
 	static const uint8_t cell_voltage_address[4] = { 0x3c, 0x3d, 0x3e,
 							 0x3f };
+	int cell_voltages[ARRAY_SIZE(cell_voltage_address)];
+	int block_res = EC_ERROR_UNIMPLEMENTED;
 	int i, res, cell_voltage;
 	int n_cells = 0;
 	int max_voltage = 0;
 	int min_voltage = 0xffff;
 
+	if (IS_ENABLED(CONFIG_BATTERY_BLOCK_READ))
+		block_res = bq4050_read_cell_voltages(
+			cell_voltages, ARRAY_SIZE(cell_voltages));
+
 	for (i = 0; i != ARRAY_SIZE(cell_voltage_address); ++i) {
-		res = sb_read(cell_voltage_address[i], &cell_voltage);
+		if (block_res == EC_SUCCESS) {
+			res = EC_SUCCESS;
+			cell_voltage = cell_voltages[i];
+		} else {
+			res = sb_read(cell_voltage_address[i], &cell_voltage);
+		}
 		if (res == EC_SUCCESS && cell_voltage != 0) {
 			n_cells++;
 			max_voltage = MAX(max_voltage, cell_voltage);
@@ -268,10 +268,57 @@ enum battery_present battery_is_present(void)
 	return BP_YES;
 }
 
+/*
+ * RepCap (0x05) through AvgCurrent (0x0b) hold everything battery_get_params()
+ * needs except the full charge capacity and status. With
+ * CONFIG_BATTERY_BLOCK_READ they are fetched in a single I2C transaction;
+ * the MAX17055 auto-increments the register address on multi-word reads.
+ */
+#define PARAMS_FIRST_REG REG_REMAINING_CAPACITY
+#define PARAMS_LAST_REG REG_AVERAGE_CURRENT
+#define PARAMS_REG_COUNT (PARAMS_LAST_REG - PARAMS_FIRST_REG + 1)
+
+struct max17055_params {
+	int rv;
+	uint16_t regs[PARAMS_REG_COUNT];
+};
+
+static void max17055_read_params(struct max17055_params *p)
+{
+	uint8_t buf[PARAMS_REG_COUNT * 2];
+	int i;
+
+	if (!IS_ENABLED(CONFIG_BATTERY_BLOCK_READ))
+		return;
+
+	p->rv = i2c_read_block(I2C_PORT_BATTERY, MAX17055_ADDR_FLAGS,
+			       PARAMS_FIRST_REG, buf, sizeof(buf));
+	if (p->rv)
+		return;
+
+	for (i = 0; i < PARAMS_REG_COUNT; i++)
+		p->regs[i] = buf[2 * i] | buf[2 * i + 1] << 8;
+}
+
+static int max17055_param(const struct max17055_params *p, int offset,
+			  int *data)
+{
+	if (!IS_ENABLED(CONFIG_BATTERY_BLOCK_READ) ||
+	    offset < PARAMS_FIRST_REG || offset > PARAMS_LAST_REG)
+		return max17055_read(offset, data);
+
+	if (p->rv)
+		return p->rv;
+
+	*data = p->regs[offset - PARAMS_FIRST_REG];
+	return EC_SUCCESS;
+}
+
 void battery_get_params(struct batt_params *batt)
 {
 	int reg = 0;
 	struct batt_params batt_new = { 0 };
+	struct max17055_params params = { 0 };
 
 	/*
 	 * Assuming the battery is responsive as long as
@@ -285,12 +332,14 @@ void battery_get_params(struct batt_params *batt)
 		/* Battery is not present, gauge won't report useful info. */
 		goto batt_out;
 
-	if (max17055_read(REG_TEMPERATURE, &reg))
+	max17055_read_params(&params);
+
+	if (max17055_param(&params, REG_TEMPERATURE, &reg))
 		batt_new.flags |= BATT_FLAG_BAD_TEMPERATURE;
 
 	batt_new.temperature = TEMPERATURE_CONV((int16_t)reg);
 
-	if (max17055_read(REG_STATE_OF_CHARGE, &reg) &&
+	if (max17055_param(&params, REG_STATE_OF_CHARGE, &reg) &&
 	    fake_state_of_charge < 0)
 		batt_new.flags |= BATT_FLAG_BAD_STATE_OF_CHARGE;
 
@@ -298,12 +347,12 @@ void battery_get_params(struct batt_params *batt)
 					   fake_state_of_charge :
 					   PERCENTAGE_CONV(reg);
 
-	if (max17055_read(REG_VOLTAGE, &reg))
+	if (max17055_param(&params, REG_VOLTAGE, &reg))
 		batt_new.flags |= BATT_FLAG_BAD_VOLTAGE;
 
 	batt_new.voltage = VOLTAGE_CONV(reg);
 
-	if (max17055_read(REG_AVERAGE_CURRENT, &reg))
+	if (max17055_param(&params, REG_AVERAGE_CURRENT, &reg))
 		batt_new.flags |= BATT_FLAG_BAD_CURRENT;
 
 	batt_new.current = CURRENT_CONV((int16_t)reg);
@@ -311,8 +360,10 @@ void battery_get_params(struct batt_params *batt)
 	batt_new.desired_voltage = battery_get_info()->voltage_max;
 	batt_new.desired_current = BATTERY_DESIRED_CHARGING_CURRENT;
 
-	if (battery_remaining_capacity(&batt_new.remaining_capacity))
+	if (max17055_param(&params, REG_REMAINING_CAPACITY, &reg))
 		batt_new.flags |= BATT_FLAG_BAD_REMAINING_CAPACITY;
+	else
+		batt_new.remaining_capacity = CAPACITY_CONV(reg);
 
 	if (battery_full_charge_capacity(&batt_new.full_capacity))
 		batt_new.flags |= BATT_FLAG_BAD_FULL_CAPACITY;
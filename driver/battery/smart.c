@@ -5,6 +5,7 @@
  * Smart battery driver.
  */
 
+#include "atomic.h"
 #include "battery.h"
 #include "battery_fuel_gauge.h"
 #include "battery_smart.h"
@@ -495,9 +496,138 @@ static bool battery_want_charge(struct batt_params *batt)
 	return false;
 }
 
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+#define BATT_PARAM_MEDIUM CONFIG_BATTERY_SMART_POLL_MEDIUM_MS
+#define BATT_PARAM_SLOW CONFIG_BATTERY_SMART_POLL_SLOW_MS
+#else
+#define BATT_PARAM_MEDIUM 0
+#define BATT_PARAM_SLOW 0
+#endif
+
+/* How each battery_get_params() field is read from the battery */
+static const struct {
+	/* SBS register, unless read is set */
+	uint8_t cmd;
+	int (*read)(int *value);
+	/* BATT_FLAG_BAD_* bit for this field */
+	int bad_flag;
+	/* Refresh period (ms) with CONFIG_BATTERY_SMART_POLL_TIERS */
+	uint16_t period_ms;
+} batt_param_regs[BATT_PARAM_COUNT] = {
+	[BATT_PARAM_TEMPERATURE] = { SB_TEMPERATURE, NULL,
+				     BATT_FLAG_BAD_TEMPERATURE,
+				     BATT_PARAM_MEDIUM },
+	[BATT_PARAM_STATE_OF_CHARGE] = { SB_RELATIVE_STATE_OF_CHARGE, NULL,
+					 BATT_FLAG_BAD_STATE_OF_CHARGE,
+					 BATT_PARAM_MEDIUM },
+	[BATT_PARAM_VOLTAGE] = { SB_VOLTAGE, NULL, BATT_FLAG_BAD_VOLTAGE, 0 },
+	[BATT_PARAM_CURRENT] = { SB_CURRENT, NULL, BATT_FLAG_BAD_CURRENT, 0 },
+	[BATT_PARAM_AVERAGE_CURRENT] = { SB_AVERAGE_CURRENT, NULL,
+					 BATT_FLAG_BAD_AVERAGE_CURRENT,
+					 BATT_PARAM_MEDIUM },
+	[BATT_PARAM_DESIRED_VOLTAGE] = { SB_CHARGING_VOLTAGE, NULL,
+					 BATT_FLAG_BAD_DESIRED_VOLTAGE, 0 },
+	[BATT_PARAM_DESIRED_CURRENT] = { SB_CHARGING_CURRENT, NULL,
+					 BATT_FLAG_BAD_DESIRED_CURRENT, 0 },
+	[BATT_PARAM_REMAINING_CAPACITY] = { 0, battery_remaining_capacity,
+					    BATT_FLAG_BAD_REMAINING_CAPACITY,
+					    BATT_PARAM_MEDIUM },
+	[BATT_PARAM_FULL_CAPACITY] = { 0, battery_full_charge_capacity,
+				       BATT_FLAG_BAD_FULL_CAPACITY,
+				       BATT_PARAM_SLOW },
+	[BATT_PARAM_STATUS] = { 0, battery_status, BATT_FLAG_BAD_STATUS, 0 },
+};
+BUILD_ASSERT(BATT_PARAM_SLOW <= UINT16_MAX);
+
+/* Register reads attempted by one battery_get_params() call */
+struct batt_param_poll {
+	int reads;
+	int failures;
+	/* BATT_FLAG_BAD_* bits of the fields served from the cache */
+	int cached_flags;
+};
+
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+/*
+ * Raw values last read from the battery. These are shared by all
+ * battery_get_params() callers and hold values from before compensation and
+ * faking, so that those are applied exactly once per call.
+ */
+static struct {
+	int value;
+	uint32_t read_time;
+} batt_param_cache[BATT_PARAM_COUNT];
+static atomic_t batt_param_cache_valid;
+#endif
+
+/**
+ * Read a battery parameter, or take it from the cache if it was read
+ * recently enough.
+ *
+ * @param batt		Parameters being updated; used for the read time stamps
+ * @param field		Field to read
+ * @param value		Value read (output), untouched on failure
+ * @param poll		Read bookkeeping for this battery_get_params() call
+ * @return EC_SUCCESS, or the error returned by the read
+ */
+static int batt_param_read(struct batt_params *batt,
+			   enum batt_param_field field, int *value,
+			   struct batt_param_poll *poll)
+{
+	int rv;
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+	uint32_t now = get_time().le.lo;
+
+	/*
+	 * A zero time stamp means this caller has never seen the field (e.g.
+	 * a fresh struct batt_params), so read it regardless of the cache.
+	 */
+	if ((batt_param_cache_valid & BIT(field)) && batt->read_time[field] &&
+	    (int32_t)(now - batt_param_cache[field].read_time) <
+		    batt_param_regs[field].period_ms * MSEC) {
+		*value = batt_param_cache[field].value;
+		batt->read_time[field] = batt_param_cache[field].read_time;
+		poll->cached_flags |= batt_param_regs[field].bad_flag;
+		return EC_SUCCESS;
+	}
+#endif
+
+	poll->reads++;
+	if (batt_param_regs[field].read)
+		rv = batt_param_regs[field].read(value);
+	else
+		rv = sb_read(batt_param_regs[field].cmd, value);
+	if (rv) {
+		poll->failures++;
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+		/* Retry on the next call rather than after a full period */
+		atomic_clear_bits(&batt_param_cache_valid, BIT(field));
+#endif
+		return rv;
+	}
+
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+	batt_param_cache[field].value = *value;
+	batt_param_cache[field].read_time = now ? now : 1;
+	atomic_or(&batt_param_cache_valid, BIT(field));
+	batt->read_time[field] = batt_param_cache[field].read_time;
+#endif
+	return EC_SUCCESS;
+}
+
+/* Forget cached battery parameters, e.g. when the battery goes away. */
+static void batt_param_invalidate(struct batt_params *batt)
+{
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+	atomic_clear(&batt_param_cache_valid);
+	memset(batt->read_time, 0, sizeof(batt->read_time));
+#endif
+}
+
 void battery_get_params(struct batt_params *batt)
 {
 	struct batt_params batt_new;
+	struct batt_param_poll poll = { 0 };
 	int v;
 
 	/*
@@ -513,12 +643,14 @@ void battery_get_params(struct batt_params *batt)
 	/* Hardware can tell us for certain */
 	batt_new.is_present = battery_is_present();
 	if (batt_new.is_present != BP_YES) {
+		batt_param_invalidate(batt);
 		batt->is_present = BP_NO;
 		batt->flags = BATT_FLAG_BAD_ANY;
 		return;
 	}
 #endif
-	if (sb_read(SB_TEMPERATURE, &batt_new.temperature) &&
+	if (batt_param_read(&batt_new, BATT_PARAM_TEMPERATURE,
+			    &batt_new.temperature, &poll) &&
 	    fake_temperature < 0)
 		batt_new.flags |= BATT_FLAG_BAD_TEMPERATURE;
 
@@ -526,37 +658,53 @@ void battery_get_params(struct batt_params *batt)
 	if (fake_temperature >= 0)
 		batt_new.temperature = fake_temperature;
 
-	if (sb_read(SB_RELATIVE_STATE_OF_CHARGE, &batt_new.state_of_charge) &&
+	if (batt_param_read(&batt_new, BATT_PARAM_STATE_OF_CHARGE,
+			    &batt_new.state_of_charge, &poll) &&
 	    fake_state_of_charge < 0)
 		batt_new.flags |= BATT_FLAG_BAD_STATE_OF_CHARGE;
 
-	if (sb_read(SB_VOLTAGE, &batt_new.voltage))
+	if (batt_param_read(&batt_new, BATT_PARAM_VOLTAGE, &batt_new.voltage,
+			    &poll))
 		batt_new.flags |= BATT_FLAG_BAD_VOLTAGE;
 
 	/* This is a signed 16-bit value. */
-	if (sb_read(SB_CURRENT, &v))
+	if (batt_param_read(&batt_new, BATT_PARAM_CURRENT, &v, &poll))
 		batt_new.flags |= BATT_FLAG_BAD_CURRENT;
 	else
 		batt_new.current = (int16_t)v;
 
-	if (sb_read(SB_AVERAGE_CURRENT, &v))
+	if (batt_param_read(&batt_new, BATT_PARAM_AVERAGE_CURRENT, &v, &poll))
 		batt_new.flags |= BATT_FLAG_BAD_AVERAGE_CURRENT;
 
-	if (sb_read(SB_CHARGING_VOLTAGE, &batt_new.desired_voltage))
+	if (batt_param_read(&batt_new, BATT_PARAM_DESIRED_VOLTAGE,
+			    &batt_new.desired_voltage, &poll))
 		batt_new.flags |= BATT_FLAG_BAD_DESIRED_VOLTAGE;
 
-	if (sb_read(SB_CHARGING_CURRENT, &batt_new.desired_current))
+	if (batt_param_read(&batt_new, BATT_PARAM_DESIRED_CURRENT,
+			    &batt_new.desired_current, &poll))
 		batt_new.flags |= BATT_FLAG_BAD_DESIRED_CURRENT;
 
-	if (battery_remaining_capacity(&batt_new.remaining_capacity))
+	if (batt_param_read(&batt_new, BATT_PARAM_REMAINING_CAPACITY,
+			    &batt_new.remaining_capacity, &poll))
 		batt_new.flags |= BATT_FLAG_BAD_REMAINING_CAPACITY;
 
-	if (battery_full_charge_capacity(&batt_new.full_capacity))
+	if (batt_param_read(&batt_new, BATT_PARAM_FULL_CAPACITY,
+			    &batt_new.full_capacity, &poll))
 		batt_new.flags |= BATT_FLAG_BAD_FULL_CAPACITY;
 
-	if (battery_status(&batt_new.status))
+	if (batt_param_read(&batt_new, BATT_PARAM_STATUS, &batt_new.status,
+			    &poll))
 		batt_new.flags |= BATT_FLAG_BAD_STATUS;
 
+	/*
+	 * If every register actually read failed, the battery stopped
+	 * responding: values served from the cache can't be trusted either.
+	 */
+	if (poll.reads && poll.failures == poll.reads) {
+		batt_param_invalidate(&batt_new);
+		batt_new.flags |= poll.cached_flags;
+	}
+
 	/* If any of those reads worked, the battery is responsive */
 	if ((batt_new.flags & BATT_FLAG_BAD_ANY) != BATT_FLAG_BAD_ANY)
 		batt_new.flags |= BATT_FLAG_RESPONSIVE;
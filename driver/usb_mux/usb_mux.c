@@ -66,6 +66,28 @@ enum mux_config_type {
 	USB_MUX_HPD_UPDATE,
 };
 
+static void perform_mux_chipset_config(int port, enum mux_config_type type);
+
+/*
+ * Per-port record of how long the mux chain took to configure, so slow muxes
+ * and retimers can be spotted when bringing display and USB back up.
+ */
+struct mux_config_time {
+	uint32_t set_last_us;
+	uint32_t set_max_us;
+	uint32_t resume_last_us;
+	uint32_t resume_max_us;
+};
+static struct mux_config_time config_time[CONFIG_USB_PD_PORT_MAX_COUNT];
+
+/*
+ * Chipset power state (USB_MUX_CHIPSET_IDLE or USB_MUX_CHIPSET_ACTIVE) waiting
+ * to be applied to each port's mux chain by the mux task, or 0 if none.  Only
+ * the latest transition matters, so a new one replaces any still pending
+ * instead of taking a slot in the port's mux queue, where it could be dropped.
+ */
+static atomic_t chipset_pending[CONFIG_USB_PD_PORT_MAX_COUNT];
+
 /* Define a USB mux task ID for the purpose of linking */
 #ifndef HAS_TASK_USB_MUX
 #define TASK_ID_USB_MUX TASK_ID_INVALID
@@ -202,7 +224,18 @@ __maybe_unused void usb_mux_task(void *u)
 		 * Round robin the ports, so no one port can monopolize the task
 		 */
 		for (port = 0; port < board_get_usb_pd_port_count(); port++) {
-			if (queue_count(&mux_queue[port])) {
+			enum mux_config_type chipset_type =
+				atomic_clear(&chipset_pending[port]);
+
+			/*
+			 * Apply a chipset transition ahead of the port's
+			 * queued sets, so resume is never held up behind them.
+			 */
+			if (chipset_type) {
+				perform_mux_chipset_config(port, chipset_type);
+				if (queue_count(&mux_queue[port]))
+					items_waiting = true;
+			} else if (queue_count(&mux_queue[port])) {
 				/*
 				 * Process our first item.  Leave it in the
 				 * queue until we've completed its operation so
@@ -219,20 +252,25 @@ __maybe_unused void usb_mux_task(void *u)
 				CPRINTS("C%d: Start mux set queued %d us ago",
 					port, time_since32(next.enqueued_time));
 #endif
-				if (next.type == USB_MUX_SET_MODE)
+				switch (next.type) {
+				case USB_MUX_SET_MODE:
 					perform_mux_set(port, next.index,
 							next.mux_mode,
 							next.usb_config,
 							next.polarity);
-				else if (next.type == USB_MUX_HPD_UPDATE)
+					break;
+				case USB_MUX_HPD_UPDATE:
 					perform_mux_hpd_update(port, next.index,
 							       next.mux_mode);
-				else if (next.type == USB_MUX_INIT)
+					break;
+				case USB_MUX_INIT:
 					perform_mux_init(port);
-				else
+					break;
+				default:
 					CPRINTS("Error: Unknown mux task type:"
 						"%d",
 						next.type);
+				}
 
 #ifdef DEBUG_MUX_QUEUE_TIME
 				CPRINTS("C%d: Completed mux set queued %d "
@@ -265,6 +303,8 @@ static int configure_mux(int port, int index, enum mux_config_type config,
 	int rv = EC_SUCCESS;
 	const struct usb_mux_chain *mux_chain;
 	int chip = 0;
+	timestamp_t start = get_time();
+	uint32_t elapsed_us;
 
 	if (config == USB_MUX_SET_MODE || config == USB_MUX_GET_MODE) {
 		if (mux_state == NULL)
@@ -427,6 +467,17 @@ static int configure_mux(int port, int index, enum mux_config_type config,
 		}
 	}
 
+	elapsed_us = time_since32(start);
+	if (config == USB_MUX_SET_MODE) {
+		config_time[port].set_last_us = elapsed_us;
+		config_time[port].set_max_us =
+			MAX(config_time[port].set_max_us, elapsed_us);
+	} else if (config == USB_MUX_CHIPSET_ACTIVE) {
+		config_time[port].resume_last_us = elapsed_us;
+		config_time[port].resume_max_us =
+			MAX(config_time[port].resume_max_us, elapsed_us);
+	}
+
 	if (rv)
 		CPRINTS("mux config:%d, port:%d, rv:%d", config, port, rv);
 
@@ -736,20 +787,46 @@ static void mux_chipset_reset(void)
 }
 DECLARE_HOOK(HOOK_CHIPSET_RESET, mux_chipset_reset, HOOK_PRIO_DEFAULT);
 
-static void mux_chipset_suspend_deferred(void)
+static void perform_mux_chipset_config(int port, enum mux_config_type type)
+{
+	/* Muxes in low power mode are re-initialized on their next use */
+	if (flags[port] & USB_MUX_FLAG_IN_LPM)
+		return;
+
+	configure_mux(port, TYPEC_USB_MUX_SET_ALL_CHIPS, type, NULL);
+}
+
+/*
+ * Apply a chipset power state change to every port's mux chain.  With a mux
+ * task, each port's latest transition is handed to the task, which services
+ * the ports round-robin, so one slow retimer neither stalls the hook task nor
+ * holds up the remaining ports.  A synchronous change is applied before
+ * returning, replacing any transition the task has not picked up yet.
+ */
+static void mux_chipset_config_all(enum mux_config_type type, bool sync)
 {
+	bool defer = IS_ENABLED(HAS_TASK_USB_MUX) && !sync;
 	int port;
 
+	for (port = 0; port < board_get_usb_pd_port_count(); ++port) {
+		if (defer) {
+			atomic_exchange(&chipset_pending[port], type);
+		} else {
+			atomic_clear(&chipset_pending[port]);
+			perform_mux_chipset_config(port, type);
+		}
+	}
+
+	if (defer)
+		task_wake(TASK_ID_USB_MUX);
+}
+
+static void mux_chipset_suspend_deferred(void)
+{
 	if (!chipset_in_state(CHIPSET_STATE_ANY_SUSPEND))
 		return;
 
-	for (port = 0; port < board_get_usb_pd_port_count(); ++port) {
-		if (flags[port] & USB_MUX_FLAG_IN_LPM)
-			continue;
-
-		configure_mux(port, TYPEC_USB_MUX_SET_ALL_CHIPS,
-			      USB_MUX_CHIPSET_IDLE, NULL);
-	}
+	mux_chipset_config_all(USB_MUX_CHIPSET_IDLE, false);
 }
 DECLARE_DEFERRED(mux_chipset_suspend_deferred);
 
@@ -768,18 +845,15 @@ static void mux_chipset_suspend(void)
 
 static void mux_chipset_resume(void)
 {
-	int port;
-
 	/* Cancel deferred suspend hook call if it is still pending on resume */
 	hook_call_deferred(&mux_chipset_suspend_deferred_data, -1);
 
-	for (port = 0; port < board_get_usb_pd_port_count(); ++port) {
-		if (flags[port] & USB_MUX_FLAG_IN_LPM)
-			continue;
-
-		configure_mux(port, TYPEC_USB_MUX_SET_ALL_CHIPS,
-			      USB_MUX_CHIPSET_ACTIVE, NULL);
-	}
+	/*
+	 * HOOK_CHIPSET_RESUME_INIT callers expect the muxes to be configured
+	 * by the time the hook returns.
+	 */
+	mux_chipset_config_all(USB_MUX_CHIPSET_ACTIVE,
+			       IS_ENABLED(CONFIG_CHIPSET_RESUME_INIT_HOOK));
 }
 
 #ifdef CONFIG_CHIPSET_RESUME_INIT_HOOK
@@ -831,6 +905,17 @@ static int command_typec(int argc, const char **argv)
 		return EC_SUCCESS;
 	}
 
+	if (argc == 2 && !strcasecmp(argv[1], "time")) {
+		for (port = 0; port < board_get_usb_pd_port_count(); port++)
+			ccprintf("Port %d: set last=%uus max=%uus "
+				 "resume last=%uus max=%uus\n",
+				 port, config_time[port].set_last_us,
+				 config_time[port].set_max_us,
+				 config_time[port].resume_last_us,
+				 config_time[port].resume_max_us);
+		return EC_SUCCESS;
+	}
+
 	if (argc < 2)
 		return EC_ERROR_PARAM_COUNT;
 
@@ -866,7 +951,8 @@ static int command_typec(int argc, const char **argv)
 		    polarity_rm_dts(pd_get_polarity(port)));
 	return EC_SUCCESS;
 }
-DECLARE_CONSOLE_COMMAND(typec, command_typec, "[port|debug] [none|usb|dp|dock]",
+DECLARE_CONSOLE_COMMAND(typec, command_typec,
+			"[port|debug|time] [none|usb|dp|dock]",
 			"Control type-C connector muxing");
 #endif
 
@@ -118,6 +118,21 @@ extern struct battery_static_info battery_static[];
 extern struct ec_response_battery_dynamic_info battery_dynamic[];
 
 /* Battery parameters */
+/* Fields of struct batt_params read from the battery */
+enum batt_param_field {
+	BATT_PARAM_TEMPERATURE,
+	BATT_PARAM_STATE_OF_CHARGE,
+	BATT_PARAM_VOLTAGE,
+	BATT_PARAM_CURRENT,
+	BATT_PARAM_AVERAGE_CURRENT,
+	BATT_PARAM_DESIRED_VOLTAGE,
+	BATT_PARAM_DESIRED_CURRENT,
+	BATT_PARAM_REMAINING_CAPACITY,
+	BATT_PARAM_FULL_CAPACITY,
+	BATT_PARAM_STATUS,
+	BATT_PARAM_COUNT
+};
+
 struct batt_params {
 	int temperature; /* Temperature in 0.1 K */
 	int state_of_charge; /* State of charge (percent, 0-100) */
@@ -131,6 +146,10 @@ struct batt_params {
 	int status; /* Battery status */
 	enum battery_present is_present; /* Is the battery physically present */
 	int flags; /* Flags */
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+	/* Time (us) each field was last read from the battery, 0 = never */
+	uint32_t read_time[BATT_PARAM_COUNT];
+#endif
 };
 
 /*
@@ -529,6 +548,17 @@ void battery_validate_params(struct batt_params *batt);
  */
 int update_static_battery_info(void);
 
+/**
+ * Get the generation of the main battery's static info (CONFIG_BATTERY_V2).
+ *
+ * With CONFIG_BATTERY_STATIC_INFO_CACHE, the generation is incremented each
+ * time the static info is read from a battery, rather than reused from the
+ * cache, so a change means the battery may have been swapped.
+ *
+ * @return generation number, 0 if the info was never read
+ */
+uint32_t battery_static_info_generation(void);
+
 /**
  * Read dynamic battery info from a main battery and store it in a cache.
  */
@@ -275,6 +275,29 @@ int charge_manager_get_vbus_voltage(int port);
  */
 int charge_manager_get_pd_current_uncapped(void);
 
+/* Charge port selection refresh statistics */
+struct charge_manager_refresh_stats {
+	/* Refreshes requested by charge / ceil / override changes */
+	uint32_t requests;
+	/* Refreshes actually run, after coalescing */
+	uint32_t refreshes;
+	/* Refreshes that switched the charge port or supplier */
+	uint32_t port_changes;
+	/* Time (us) the last refresh started */
+	uint32_t last_time_us;
+	/* Duration (us) of the last and the longest refresh */
+	uint32_t last_duration_us;
+	uint32_t max_duration_us;
+};
+
+/**
+ * Get charge port selection refresh statistics.
+ *
+ * @param stats		Pointer to the statistics to fill.
+ */
+void charge_manager_get_refresh_stats(
+	struct charge_manager_refresh_stats *stats);
+
 #ifdef CONFIG_USB_PD_LOGGING
 /* Save power state log entry for the given port */
 void charge_manager_save_log(int port);
@@ -48,6 +48,18 @@ int chg_ramp_allowed(int port, int supplier);
  */
 int chg_ramp_max(int port, int supplier, int sup_curr);
 
+/**
+ * Check if the input current limit should be found by binary search rather
+ * than by stepping up from the minimum (CONFIG_CHARGE_RAMP_SEARCH). The
+ * default selects BC1.2 DCP, proprietary and unknown chargers.
+ *
+ * @param port Charge ramp port
+ * @param supplier Active supplier type
+ *
+ * @return 1 to search, 0 to step
+ */
+__override_proto int chg_ramp_search_allowed(int port, int supplier);
+
 /**
  * Get the input current limit set by ramp module
  *
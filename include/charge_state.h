@@ -30,6 +30,12 @@ extern "C" {
 #define CHARGE_POLL_PERIOD_CHARGE (MSEC * 250)
 #define CHARGE_POLL_PERIOD_SHORT (MSEC * 100)
 #define CHARGE_MIN_SLEEP_USEC (MSEC * 50)
+/* Periods used with CONFIG_CHARGE_STATE_ADAPTIVE_POLL */
+#define CHARGE_POLL_PERIOD_CC SECOND
+#define CHARGE_POLL_PERIOD_AC_IDLE (SECOND * 2)
+#define CHARGE_POLL_PERIOD_AC_IDLE_SUSPEND (SECOND * 10)
+/* Battery voltage within this of the target means constant voltage taper */
+#define CHARGE_CV_MARGIN_MV 100
 /* If a board hasn't provided a max sleep, use 1 minute as default */
 #ifndef CHARGE_MAX_SLEEP_USEC
 #define CHARGE_MAX_SLEEP_USEC MINUTE
@@ -115,6 +121,18 @@ struct sustain_soc {
 	uint8_t flags; /* enum ec_charge_control_flag */
 };
 
+/* Charger task loop accounting, printed by the chgstate console command */
+struct charge_loop_stats {
+	/* Wakeups by reason, and wakeups because the poll period expired */
+	uint32_t wakeups[CHARGE_WAKEUP_COUNT];
+	uint32_t timer_wakeups;
+	/* Loop iterations and I2C transactions, by state at end of the loop */
+	uint32_t loops[CHARGE_STATE_COUNT];
+	uint32_t i2c_xfers[CHARGE_STATE_COUNT];
+	/* Last computed poll period */
+	int sleep_usec;
+};
+
 #define BAT_MAX_DISCHG_CURRENT 5000 /* mA */
 #define BAT_LOW_VOLTAGE_THRESH 3200 /* mV */
 
@@ -128,6 +146,11 @@ enum led_pwr_state led_pwr_get_state(void);
  */
 __test_only enum charge_state charge_get_state(void);
 
+/**
+ * Return the charger task loop statistics.
+ */
+__test_only const struct charge_loop_stats *charge_get_loop_stats(void);
+
 /**
  * Return non-zero if battery is so low we want to keep AP off.
  */
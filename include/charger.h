@@ -439,9 +439,26 @@ void print_charger_prochot(int chgnum);
  */
 int charger_get_min_bat_pct_for_power_on(void);
 
+/* Why the charger task was woken up, see charge_wakeup_for() */
+enum charge_wakeup_reason {
+	CHARGE_WAKEUP_GENERIC,
+	CHARGE_WAKEUP_AC_CHANGE,
+	CHARGE_WAKEUP_POWER_SUPPLY, /* Charge port or PD contract change */
+	CHARGE_WAKEUP_CHIPSET,
+	CHARGE_WAKEUP_COUNT
+};
+
 /* Wake up the task when something important happens */
 void charge_wakeup(void);
 
+/**
+ * Wake up the charger task and record the reason in the loop statistics, so
+ * the charge state is re-evaluated without waiting for the next poll period.
+ *
+ * @param reason	What changed
+ */
+void charge_wakeup_for(enum charge_wakeup_reason reason);
+
 /*
  * Ask the charger for some voltage and current. If either value is 0,
  * charging is disabled; otherwise it's enabled. Negative values are ignored.
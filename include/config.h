@@ -65,6 +65,13 @@
 /* The amount of free entries that trigger an interrupt to the AP. */
 #undef CONFIG_ACCEL_FIFO_THRES
 
+/*
+ * Let drivers raise their hardware FIFO watermark so samples are batched for
+ * as long as the AP and EC rates (ec_rate) allow, instead of interrupting the
+ * EC for every sample.
+ */
+#undef CONFIG_ACCEL_FIFO_BATCH
+
 /*
  * Sensors in this mask are in forced mode: they needed to be polled
  * at their data rate frequency.
@@ -549,6 +556,33 @@
  */
 #undef CONFIG_BATTERY_SMART
 
+/*
+ * Refresh the smart battery registers read by battery_get_params() at
+ * different rates. Voltage, current, charging request and status are read
+ * on every call; slower moving values are re-read once their period has
+ * elapsed and served from a cache otherwise.
+ */
+#undef CONFIG_BATTERY_SMART_POLL_TIERS
+
+/*
+ * Refresh period (ms) of temperature, state of charge, remaining capacity and
+ * average current when CONFIG_BATTERY_SMART_POLL_TIERS is enabled.
+ */
+#define CONFIG_BATTERY_SMART_POLL_MEDIUM_MS 2000
+
+/*
+ * Refresh period (ms) of full charge capacity when
+ * CONFIG_BATTERY_SMART_POLL_TIERS is enabled.
+ */
+#define CONFIG_BATTERY_SMART_POLL_SLOW_MS 20000
+
+/*
+ * Allow fuel gauge drivers to fetch several values in a single block read
+ * (e.g. MAX17055 consecutive registers, BQ4050 DAStatus1) where the gauge
+ * supports it.
+ */
+#undef CONFIG_BATTERY_BLOCK_READ
+
 /* Chemistry of the battery device */
 #undef CONFIG_BATTERY_DEVICE_CHEMISTRY
 
@@ -660,6 +694,13 @@
  */
 #undef CONFIG_BATTERY_COUNT
 
+/*
+ * Keep the main battery's static info (CONFIG_BATTERY_V2) across sysjumps,
+ * and only re-read it when the battery's serial number changes or the battery
+ * goes away, instead of re-reading all its strings after every jump.
+ */
+#undef CONFIG_BATTERY_STATIC_INFO_CACHE
+
 /*
  * Smart battery driver should measure the voltage cell imbalance in the battery
  * pack.  This requires a battery driver capable of the measurement.
@@ -724,6 +765,30 @@
  */
 #undef CONFIG_CHARGE_STATE_DEBUG
 
+/*
+ * Let the charger task poll less often when there is nothing to regulate
+ * (AC present and battery full or idle) or while charging at constant
+ * current, and keep the fast period for the constant voltage taper. AC, power
+ * supply and chipset changes still wake the task right away. Boards whose
+ * charger has a watchdog shorter than CHARGE_POLL_PERIOD_AC_IDLE_SUSPEND must
+ * not enable this.
+ */
+#undef CONFIG_CHARGE_STATE_ADAPTIVE_POLL
+
+/*
+ * Sample charger input and battery power into a timestamped ring and
+ * integrate the energy used per power state, for power regression testing
+ * without an external power monitor. Read and controlled with
+ * EC_CMD_POWER_TRACE (ectool powertrace).
+ */
+#undef CONFIG_POWER_TRACE
+/* Sampling period at boot, in ms; 0 leaves sampling off until requested */
+#define CONFIG_POWER_TRACE_PERIOD_MS 0
+/* Shortest sampling period the host may request, in ms */
+#define CONFIG_POWER_TRACE_MIN_PERIOD_MS 10
+/* Number of samples kept in the ring */
+#define CONFIG_POWER_TRACE_CAPACITY 128
+
 /* Include support for Bluetooth LE */
 #undef CONFIG_BLUETOOTH_LE
 
@@ -921,6 +986,14 @@
 /* Handle the external power limit host command in charge manager */
 #undef CONFIG_CHARGE_MANAGER_EXTERNAL_POWER_LIMIT
 
+/*
+ * Upper bound (in ms) on how long charge manager waits after the first of a
+ * burst of charge updates before refreshing the charge port selection. All
+ * updates arriving within the window are handled by a single refresh. 0 runs
+ * the refresh as soon as the deferred hook is serviced.
+ */
+#define CONFIG_CHARGE_MANAGER_REFRESH_WINDOW_MS 0
+
 /* Initially enter safe mode, with relaxed port / current selection rules */
 #define CONFIG_CHARGE_MANAGER_SAFE_MODE
 
@@ -933,6 +1006,20 @@
 /* Compile input current ramping support using software control */
 #undef CONFIG_CHARGE_RAMP_SW
 
+/*
+ * Let the software charge ramp binary search for the input current limit,
+ * for the suppliers chg_ramp_search_allowed() selects, rather than stepping
+ * up from the minimum.
+ */
+#undef CONFIG_CHARGE_RAMP_SEARCH
+
+/*
+ * Keep the last CONFIG_CHARGE_RAMP_HISTORY_SIZE software charge ramp results
+ * of each port, read with EC_CMD_CHG_RAMP_HISTORY.
+ */
+#undef CONFIG_CHARGE_RAMP_HISTORY
+#define CONFIG_CHARGE_RAMP_HISTORY_SIZE 8
+
 /* Enable EC support for charging splashscreen */
 #undef CONFIG_CHARGESPLASH
 #undef CONFIG_CHARGESPLASH_PERIOD
@@ -1415,6 +1502,20 @@
 /* Set a default OCPC drive limit for legacy boards */
 #define CONFIG_OCPC_DEF_DRIVELIMIT_MILLIVOLTS 10
 
+/*
+ * Step the OCPC VSYS control loop every CONFIG_OCPC_LOOP_PERIOD_MS from the
+ * charger task, between its charge state updates, using Q16 fixed point
+ * gains. 0 runs the loop once per charge state update instead.
+ */
+#define CONFIG_OCPC_LOOP_PERIOD_MS 0
+
+/*
+ * Record each OCPC control loop iteration in a ring of
+ * CONFIG_OCPC_TRACE_CAPACITY entries, read with EC_CMD_OCPC_TRACE.
+ */
+#undef CONFIG_OCPC_TRACE
+#define CONFIG_OCPC_TRACE_CAPACITY 64
+
 /* Enable trickle charging */
 #undef CONFIG_TRICKLE_CHARGING
 
@@ -2156,6 +2257,25 @@
  */
 #undef CONFIG_FAN_UPDATE_PERIOD
 
+/*
+ * Drive fans under thermal control from a PID loop in common code instead of
+ * the chip's RPM mode. The loop runs every CONFIG_FAN_PID_PERIOD_MS with
+ * tachometer feedback, limits how fast the RPM setpoint moves, reports stalls
+ * and keeps a trace readable with EC_CMD_FAN_PID_TRACE.
+ */
+#undef CONFIG_FAN_PID_CONTROL
+#define CONFIG_FAN_PID_PERIOD_MS 100
+/* Maximum change of the RPM setpoint, in RPM per second */
+#define CONFIG_FAN_PID_RAMP_RPM_PER_SEC 2000
+/* Proportional gain, in 1/1000 % duty per RPM of error */
+#define CONFIG_FAN_PID_KP 20
+/* Integral gain, in 1/1000 % duty per RPM of error per second */
+#define CONFIG_FAN_PID_KI 40
+/* How long a driven fan may stay below rpm_min / 2 before it is stalled */
+#define CONFIG_FAN_PID_STALL_MS 2000
+/* Number of controller updates kept per fan for EC_CMD_FAN_PID_TRACE */
+#define CONFIG_FAN_PID_TRACE_CAPACITY 64
+
 /*
  * Enable fan slow response control mechanism.
  * A specific type of fan needs a longer time to output the TACH
@@ -2523,6 +2643,14 @@
 #undef CONFIG_LID_ANGLE_SENSOR_BASE
 /* Which sensor is located on the lid? */
 #undef CONFIG_LID_ANGLE_SENSOR_LID
+
+/*
+ * Shortest time, in ms, between two updates of the lid angle and confidence
+ * reported to the host and to CONFIG_LID_ANGLE_UPDATE. A change of
+ * reliability is reported right away. 0 reports every calculation.
+ */
+#define CONFIG_LID_ANGLE_PUBLISH_MS 0
+
 /*
  * Allows using the lid angle measurement to determine if peripheral devices
  * should be enabled or disabled, like key scanning, trackpad interrupt.
@@ -2924,6 +3052,16 @@
 /* Support I2C HID touchpad interface. */
 #undef CONFIG_I2C_HID_TOUCHPAD
 
+/*
+ * Number of I2C HID touchpad input reports kept for the host to read. Must be
+ * a power of two. The host reads all queued reports on one interrupt, so a
+ * few reports absorb the host falling behind the touchpad frame rate.
+ */
+#define CONFIG_I2C_HID_TOUCHPAD_QUEUE_SIZE 8
+
+/* I2C HID touchpad input reports read later than this are counted as late. */
+#define CONFIG_I2C_HID_TOUCHPAD_LATE_US 16000
+
 /*
  * Add hosts-side support for entering programming mode for I2C ITE ECs.
  * Must define ite_dfu_config_t for configuration in board file.
@@ -3211,6 +3349,28 @@
 /* Add support for ADC based antighost feature */
 #undef CONFIG_KEYBOARD_SCAN_ADC
 
+/*
+ * While keys are down, only read the columns with keys down or debouncing,
+ * plus one read with all columns driven to catch keys going down in new rows.
+ * All columns are still read every CONFIG_KEYBOARD_SCAN_FULL_INTERVAL scans.
+ * Not for CONFIG_KEYBOARD_SCAN_ADC.
+ */
+#undef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+#define CONFIG_KEYBOARD_SCAN_FULL_INTERVAL 8
+
+/*
+ * Let the scan task sleep rather than spin while driven columns settle, so
+ * other tasks can run during a scan.  Not for Zephyr, which rounds sleeps up
+ * to a kernel tick, far longer than the settle time.
+ */
+#undef CONFIG_KEYBOARD_SCAN_SLEEP_SETTLE
+
+/*
+ * Timestamp key events from detection through the 8042 or MKBP queue to the
+ * host read, and keep per-path latency histograms (EC_CMD_KEYBOARD_LATENCY).
+ */
+#undef CONFIG_KEYBOARD_LATENCY_STATS
+
 /*
  * Allow the board layer keyboard customization. If define, the board layer
  * needs to implement:
@@ -3285,6 +3445,15 @@
  */
 #undef CONFIG_8042_AUX
 
+/*
+ * Depth of the 8042 queue of bytes waiting for the host to read them, and of
+ * the queue of AUX bytes received in interrupt context. Both must be powers
+ * of 2. Deeper queues ride out bursts of typing or touchpad data while the
+ * host is slow to read.
+ */
+#define CONFIG_8042_TO_HOST_QUEUE_SIZE 16
+#define CONFIG_8042_AUX_QUEUE_SIZE 16
+
 /*
  * Invert the IRQ1/IRQ12 interrupts that come from the NPCX keyboard controller
  * such that they are active low.
@@ -3871,6 +4040,15 @@
  */
 #undef CONFIG_POWER_SIGNAL_INTERRUPT_STORM_DETECT_THRESHOLD
 
+/*
+ * Record every power signal edge, power_wait_signals() call and power state
+ * transition with a 64-bit timestamp in a ring of
+ * CONFIG_POWER_SIGNAL_LOG_SIZE entries, and keep per-state dwell time and
+ * signal wait latency statistics. Read with EC_CMD_POWER_SIGNAL_LOG.
+ */
+#undef CONFIG_POWER_SIGNAL_LOG
+#define CONFIG_POWER_SIGNAL_LOG_SIZE 64
+
 /* Use part of the EC's data EEPROM to hold persistent storage for the AP. */
 #undef CONFIG_PSTORE
 
@@ -3991,6 +4169,12 @@
 #undef CONFIG_RGBKBD_DEMO_FLOW
 #undef CONFIG_RGBKBD_DEMO_DOT
 
+/*
+ * Maximum rate at which the RGB keyboard task flushes color changes to the
+ * LED controllers. Changes made between two flushes are sent together.
+ */
+#define CONFIG_RGBKBD_MAX_FPS 60
+
 #ifndef CONFIG_ZEPHYR
 /* Support Real-Time Clock (RTC) */
 #undef CONFIG_RTC
@@ -4836,6 +5020,12 @@
 /* Default USB data role when a USB PD debug accessory is seen */
 #define CONFIG_USB_PD_DEBUG_DR PD_ROLE_DFP
 
+/*
+ * Record the most recent USB state machine transitions with timestamps in a
+ * ring buffer, printed by the smtrace console command.
+ */
+#undef CONFIG_USB_SM_TRACE
+
 /*
  * Define to have a fixed PD Task debug level.
  * Undef to allow runtime change via console command.
@@ -4965,6 +5155,14 @@
  */
 #define CONFIG_USB_PD_PRL_EVENT_LOG_CAPACITY 128
 
+/*
+ * Record timestamped PRL message events (RX, TX start, TX outcome) per port,
+ * readable via EC_CMD_USB_PD_PRL_TIMING.
+ */
+#undef CONFIG_USB_PD_PRL_TIMING_LOG
+/* Number of message events kept per port in the PRL timing log */
+#define CONFIG_USB_PD_PRL_TIMING_LOG_CAPACITY 32
+
 /* The size in bytes of the FIFO used for event logging */
 #define CONFIG_EVENT_LOG_SIZE 512
 
@@ -6098,6 +6296,15 @@
 #undef CONFIG_SYSTEM_BOOT_TIME_LOGGING
 #endif /* CONFIG_ZEPHYR */
 
+/*
+ * Record timestamps of EC init stages, HOOK_INIT routines, task starts,
+ * power sequencing state transitions and AP boot milestones in a table read
+ * with EC_CMD_BOOT_TIME_PROFILE (ectool boottime).
+ */
+#undef CONFIG_BOOT_TIME_PROFILE
+/* Number of events kept; later events are dropped until the table is cleared */
+#define CONFIG_BOOT_TIME_PROFILE_ENTRIES 128
+
 /*
  * The USB port used for CCD. Defaults to 0/C0.
  */
@@ -7220,6 +7427,10 @@
 
 #endif /* CONFIG_ACCEL_FIFO */
 
+#if defined(CONFIG_ACCEL_FIFO_BATCH) && !defined(CONFIG_ACCEL_FIFO)
+#error "CONFIG_ACCEL_FIFO_BATCH requires CONFIG_ACCEL_FIFO"
+#endif
+
 /*
  * If USB PD Discharge is enabled, verify that CONFIG_USB_PD_DISCHARGE_GPIO
  * and CONFIG_USB_PD_PORT_MAX_COUNT, CONFIG_USB_PD_DISCHARGE_TCPC, or
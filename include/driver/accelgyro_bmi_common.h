@@ -264,6 +264,22 @@ int bmi_decode_header(struct motion_sensor_t *accel, enum fifo_header hdr,
  */
 int bmi_load_fifo(struct motion_sensor_t *s, uint32_t last_ts);
 
+/*
+ * Commit the data staged by bmi_load_fifo(), as a batch if the FIFO
+ * watermark is above one sample.
+ * @s: Pointer to sensor data.
+ */
+void bmi_commit_fifo(const struct motion_sensor_t *s);
+
+/*
+ * Drain the FIFO if a flush is pending, whatever the interrupt status says:
+ * samples batched below the watermark must reach the AP ahead of the flush
+ * event. Only needed with CONFIG_ACCEL_FIFO_BATCH.
+ * @s: Pointer to the accelerometer.
+ * @event: Events the irq handler was called with.
+ */
+void bmi_drain_fifo(struct motion_sensor_t *s, uint32_t event);
+
 int bmi_set_range(struct motion_sensor_t *s, int range, int rnd);
 
 int bmi_get_data_rate(const struct motion_sensor_t *s);
@@ -18,6 +18,8 @@ struct bmi_drv_data_t {
 	uint8_t flags;
 	uint8_t enabled_activities;
 	uint8_t disabled_activities;
+	/* Samples in the FIFO that raise the watermark interrupt */
+	uint16_t batch_size;
 #ifdef CONFIG_MAG_BMI_BMM150
 	struct bmm150_private_data compass;
 #endif
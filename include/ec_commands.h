@@ -3434,6 +3434,12 @@ struct ec_response_motion_sense {
 			 * LID_ANGLE_UNRELIABLE otherwise.
 			 */
 			uint16_t value;
+			/*
+			 * Confidence in the angle, in percent, 0 when
+			 * unreliable. Only returned if the response buffer has
+			 * room for it.
+			 */
+			uint16_t confidence;
 		} lid_angle;
 
 		/* Used for MOTIONSENSE_CMD_TABLET_MODE_LID_ANGLE. */
@@ -8763,6 +8769,529 @@ struct ec_response_get_boot_time {
 	uint16_t cnt;
 } __ec_align4;
 
+/*
+ * Read the PD protocol layer timing log of a port.
+ *
+ * The EC records a timestamped event each time the protocol layer receives a
+ * message from the TCPC, passes a message to the TCPC for transmission, and
+ * learns the outcome of a transmission. Entries are returned oldest first,
+ * starting at the requested offset; as many whole entries as fit in the
+ * response are returned.
+ */
+#define EC_CMD_USB_PD_PRL_TIMING 0x0605
+
+enum ec_prl_timing_event {
+	/* Message dequeued from the TCPC */
+	EC_PRL_TIMING_RX = 0,
+	/* Message passed to the TCPC for transmission */
+	EC_PRL_TIMING_TX_START,
+	/* GoodCRC received for the transmitted message */
+	EC_PRL_TIMING_TX_SUCCESS,
+	/* Transmission failed after retries */
+	EC_PRL_TIMING_TX_FAILED,
+	/* Transmission discarded due to an incoming message */
+	EC_PRL_TIMING_TX_DISCARD,
+	EC_PRL_TIMING_EVENT_COUNT,
+};
+
+/* Clear the log instead of reading it */
+#define EC_PRL_TIMING_FLAG_CLEAR BIT(0)
+
+struct ec_params_usb_pd_prl_timing {
+	uint8_t port;
+	uint8_t flags; /* EC_PRL_TIMING_FLAG_* */
+	uint16_t offset; /* Index of the first entry to return */
+} __ec_align2;
+
+struct ec_prl_timing_entry {
+	/* Lower 32 bits of the EC time of the event, in microseconds */
+	uint32_t time_us;
+	/* PD message header, for RX and TX_START events */
+	uint16_t header;
+	uint8_t event; /* enum ec_prl_timing_event */
+	uint8_t sop; /* enum tcpci_msg_type */
+} __ec_align4;
+
+struct ec_response_usb_pd_prl_timing {
+	/* Number of entries currently held in the log */
+	uint16_t total;
+	/* Number of entries in this response */
+	uint8_t count;
+	uint8_t reserved;
+	/*
+	 * Sequence number of the oldest entry held, counting from the last
+	 * clear.  Entries logged between two pages move it on, shifting the
+	 * offsets of the entries not read yet.
+	 */
+	uint32_t first;
+	struct ec_prl_timing_entry entries[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+/*
+ * Read the fan PID controller trace (CONFIG_FAN_PID_CONTROL).
+ *
+ * While a fan is under thermal control, each controller update records the
+ * requested RPM, the rate-limited setpoint, the measured RPM and the duty
+ * cycle applied. Entries are returned oldest first, starting at the requested
+ * offset; as many whole entries as fit in the response are returned.
+ */
+#define EC_CMD_FAN_PID_TRACE 0x0606
+
+/* Clear the trace instead of reading it */
+#define EC_FAN_PID_TRACE_FLAG_CLEAR BIT(0)
+
+struct ec_params_fan_pid_trace {
+	uint8_t fan_idx;
+	uint8_t flags; /* EC_FAN_PID_TRACE_FLAG_* */
+	uint16_t offset; /* Index of the first entry to return */
+} __ec_align2;
+
+/* The fan was considered stalled at this update */
+#define EC_FAN_PID_ENTRY_STALLED BIT(0)
+
+struct ec_fan_pid_trace_entry {
+	/* Lower 32 bits of the EC time of the update, in microseconds */
+	uint32_t time_us;
+	uint16_t target_rpm; /* Requested by the thermal engine */
+	uint16_t setpoint_rpm; /* After ramp rate limiting */
+	uint16_t actual_rpm; /* Measured by the tachometer */
+	uint8_t duty; /* Duty cycle applied, in percent */
+	uint8_t flags; /* EC_FAN_PID_ENTRY_* */
+} __ec_align4;
+
+struct ec_response_fan_pid_trace {
+	/* Number of entries currently held in the trace */
+	uint16_t total;
+	/* Number of entries in this response */
+	uint8_t count;
+	uint8_t reserved;
+	/* Sequence number of the oldest entry held, since the last clear */
+	uint32_t first;
+	struct ec_fan_pid_trace_entry entries[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+/*
+ * Power telemetry trace (CONFIG_POWER_TRACE).
+ *
+ * While enabled, the EC samples the charger's input current and VBUS voltage
+ * every period_ms into a ring, along with the battery current and voltage the
+ * charger task read last, and integrates input and battery energy per power
+ * state. Battery energy is integrated between battery readings.
+ */
+#define EC_CMD_POWER_TRACE 0x0607
+
+enum ec_power_trace_cmd {
+	/* Read samples, oldest first, starting at offset */
+	EC_POWER_TRACE_CMD_GET_SAMPLES = 0,
+	/* Read the energy totals and the sampling period */
+	EC_POWER_TRACE_CMD_GET_ENERGY = 1,
+	/* Set the sampling period; 0 stops sampling */
+	EC_POWER_TRACE_CMD_SET_PERIOD = 2,
+	/* Clear the samples and energy totals */
+	EC_POWER_TRACE_CMD_CLEAR = 3,
+};
+
+enum ec_power_trace_state {
+	EC_POWER_TRACE_STATE_S0 = 0,
+	EC_POWER_TRACE_STATE_SUSPEND = 1, /* S3 or S0ix */
+	EC_POWER_TRACE_STATE_OFF = 2, /* S5 or G3 */
+	EC_POWER_TRACE_STATE_COUNT,
+};
+
+struct ec_params_power_trace {
+	uint8_t cmd; /* enum ec_power_trace_cmd */
+	uint8_t reserved;
+	uint16_t period_ms; /* For EC_POWER_TRACE_CMD_SET_PERIOD */
+	uint16_t offset; /* For EC_POWER_TRACE_CMD_GET_SAMPLES */
+} __ec_align2;
+
+/* Input and battery readings are valid, respectively */
+#define EC_POWER_TRACE_SAMPLE_INPUT BIT(0)
+#define EC_POWER_TRACE_SAMPLE_BATTERY BIT(1)
+/*
+ * The battery reading is the one the previous sample held: the battery is
+ * polled by the charger task, less often than the trace samples.
+ */
+#define EC_POWER_TRACE_SAMPLE_BATTERY_REPEAT BIT(2)
+
+struct ec_power_trace_sample {
+	/* Lower 32 bits of the EC time of the sample, in microseconds */
+	uint32_t time_us;
+	uint16_t input_ma;
+	uint16_t vbus_mv;
+	int16_t battery_ma; /* Negative when discharging */
+	uint16_t battery_mv;
+	uint8_t state; /* enum ec_power_trace_state */
+	uint8_t flags; /* EC_POWER_TRACE_SAMPLE_* */
+	/* Age of the battery reading at the sample, saturated */
+	uint16_t battery_age_ms;
+} __ec_align4;
+
+struct ec_response_power_trace_samples {
+	/* Number of samples currently held in the ring */
+	uint16_t total;
+	/* Number of samples in this response */
+	uint8_t count;
+	uint8_t reserved;
+	/* Sequence number of the oldest sample held, since the last clear */
+	uint32_t first;
+	struct ec_power_trace_sample samples[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+struct ec_power_trace_energy {
+	uint32_t time_ms; /* Time spent sampling in this state */
+	uint32_t input_mj; /* Energy drawn from the charger */
+	/* Time covered by battery readings, which may lag time_ms */
+	uint32_t battery_time_ms;
+	int32_t battery_mj; /* Energy into the battery */
+} __ec_align4;
+
+struct ec_response_power_trace_energy {
+	uint16_t period_ms; /* 0 when sampling is stopped */
+	uint16_t reserved;
+	/* Number of samples taken since the last clear */
+	uint32_t sample_count;
+	/* Indexed by enum ec_power_trace_state */
+	struct ec_power_trace_energy state[EC_POWER_TRACE_STATE_COUNT];
+} __ec_align4;
+
+/*
+ * Read the boot time profile (CONFIG_BOOT_TIME_PROFILE).
+ *
+ * The EC records timestamped events during its own init (init stages, each
+ * HOOK_INIT routine, the start of each task) and afterwards for each power
+ * sequencing state transition and AP boot milestone. Recording stops when
+ * the table is full; clearing it re-arms it, e.g. to profile the next power
+ * button press. Entries are returned oldest first, starting at offset.
+ */
+#define EC_CMD_BOOT_TIME_PROFILE 0x0608
+
+/* Clear the table instead of reading it */
+#define EC_BOOT_TIME_PROFILE_FLAG_CLEAR BIT(0)
+
+struct ec_params_boot_time_profile {
+	uint8_t flags; /* EC_BOOT_TIME_PROFILE_FLAG_* */
+	uint8_t reserved;
+	uint16_t offset; /* Index of the first entry to return */
+} __ec_align2;
+
+enum ec_boot_time_event {
+	/* data is an enum ec_boot_time_stage */
+	EC_BOOT_TIME_EVENT_STAGE = 0,
+	/* data is the address of the HOOK_INIT routine */
+	EC_BOOT_TIME_EVENT_HOOK_INIT = 1,
+	/* data is the task ID */
+	EC_BOOT_TIME_EVENT_TASK_START = 2,
+	/* data is the power state of the EC's power sequencing */
+	EC_BOOT_TIME_EVENT_POWER_STATE = 3,
+	/* data is the Zephyr ap_pwrseq state */
+	EC_BOOT_TIME_EVENT_AP_PWRSEQ_STATE = 4,
+	/* data is an enum boot_time_param */
+	EC_BOOT_TIME_EVENT_AP = 5,
+};
+
+enum ec_boot_time_stage {
+	EC_BOOT_TIME_STAGE_CHIP_INIT = 0, /* cpu, DMA and UART init */
+	EC_BOOT_TIME_STAGE_I2C_INIT = 1,
+	EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY = 2,
+	EC_BOOT_TIME_STAGE_KEYBOARD_INIT = 3, /* Boot keys and buttons */
+	EC_BOOT_TIME_STAGE_VERIFIED_BOOT = 4,
+	EC_BOOT_TIME_STAGE_TASK_START = 5, /* Scheduler start */
+	EC_BOOT_TIME_STAGE_HOOK_INIT = 6,
+	EC_BOOT_TIME_STAGE_COUNT,
+};
+
+/* Flags for an entry; an entry with neither flag is a single point in time */
+#define EC_BOOT_TIME_BEGIN BIT(0)
+#define EC_BOOT_TIME_END BIT(1)
+
+struct ec_boot_time_entry {
+	/* Lower 32 bits of the EC time of the event, in microseconds */
+	uint32_t time_us;
+	uint32_t data; /* See enum ec_boot_time_event */
+	uint8_t event; /* enum ec_boot_time_event */
+	uint8_t flags; /* EC_BOOT_TIME_BEGIN or EC_BOOT_TIME_END */
+	uint16_t reserved;
+} __ec_align4;
+
+struct ec_response_boot_time_profile {
+	/* Number of entries recorded */
+	uint16_t total;
+	/* Number of events not recorded because the table was full */
+	uint16_t dropped;
+	/* Number of entries in this response */
+	uint8_t count;
+	uint8_t reserved[3];
+	struct ec_boot_time_entry entries[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+/*
+ * Power signal timeline (CONFIG_POWER_SIGNAL_LOG).
+ *
+ * The EC logs every power signal edge, the start and end of every wait for
+ * power signals and every power state transition into a ring, and keeps
+ * per-state statistics of the time spent in each state and in each wait.
+ * Entries and statistics are returned starting at offset.
+ */
+#define EC_CMD_POWER_SIGNAL_LOG 0x0609
+
+enum ec_power_signal_log_cmd {
+	/* Read the ring, oldest entry first */
+	EC_POWER_SIGNAL_LOG_CMD_GET_EVENTS = 0,
+	/* Read statistics, indexed by the EC's power state */
+	EC_POWER_SIGNAL_LOG_CMD_GET_STATS = 1,
+	/* Read the name of the power signal at index offset */
+	EC_POWER_SIGNAL_LOG_CMD_GET_SIGNAL_NAME = 2,
+	/* Empty the ring and reset the statistics */
+	EC_POWER_SIGNAL_LOG_CMD_CLEAR = 3,
+};
+
+struct ec_params_power_signal_log {
+	uint8_t cmd; /* enum ec_power_signal_log_cmd */
+	uint8_t reserved;
+	uint16_t offset;
+} __ec_align2;
+
+enum ec_power_signal_log_event {
+	/* id is the power signal index, value its new level */
+	EC_POWER_SIGNAL_LOG_EDGE = 0,
+	/* id is the power state, signals the wanted signal state */
+	EC_POWER_SIGNAL_LOG_WAIT_START = 1,
+	/* id is the power state, value is 1 if the wait timed out */
+	EC_POWER_SIGNAL_LOG_WAIT_END = 2,
+	/* id is the new power state, value the previous one */
+	EC_POWER_SIGNAL_LOG_STATE = 3,
+};
+
+struct ec_power_signal_log_entry {
+	uint64_t time_us; /* EC time of the event */
+	/* Asserted power signals after the event, one bit per signal index */
+	uint32_t signals;
+	uint8_t event; /* enum ec_power_signal_log_event */
+	uint8_t id;
+	uint8_t value;
+	uint8_t reserved;
+} __ec_align4;
+
+struct ec_response_power_signal_log_events {
+	/*
+	 * Sequence number of the oldest entry held, which is also the number of
+	 * entries lost since the last clear.
+	 */
+	uint32_t first;
+	/* Number of entries currently held in the ring */
+	uint16_t total;
+	/* Number of entries in this response */
+	uint8_t count;
+	uint8_t reserved;
+	struct ec_power_signal_log_entry entries[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+struct ec_power_signal_log_stats {
+	char name[12]; /* Power state name, e.g. "S5->S3" */
+	/* Number of times the state was entered, and time spent in it */
+	uint32_t entries;
+	uint32_t dwell_min_us;
+	uint32_t dwell_avg_us;
+	uint32_t dwell_max_us;
+	/* Number of signal waits in this state, and how long they took */
+	uint32_t waits;
+	uint32_t timeouts;
+	uint32_t wait_min_us;
+	uint32_t wait_avg_us;
+	uint32_t wait_max_us;
+} __ec_align4;
+
+struct ec_response_power_signal_log_stats {
+	/* Number of power states */
+	uint8_t total;
+	/* Number of states in this response */
+	uint8_t count;
+	uint16_t reserved;
+	struct ec_power_signal_log_stats stats[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+struct ec_response_power_signal_log_name {
+	char name[32];
+} __ec_align1;
+
+/*
+ * Read the OCPC control loop trace (CONFIG_OCPC_TRACE).
+ *
+ * On boards with one charger IC per Type-C port, the EC regulates the battery
+ * current from the secondary charger IC by adjusting its VSYS output with a
+ * PID loop. Each iteration of the loop is recorded in a ring; entries are
+ * returned oldest first, starting at offset, along with the loop's gains.
+ */
+#define EC_CMD_OCPC_TRACE 0x060A
+
+/* Clear the trace instead of reading it */
+#define EC_OCPC_TRACE_FLAG_CLEAR BIT(0)
+
+struct ec_params_ocpc_trace {
+	uint8_t flags; /* EC_OCPC_TRACE_FLAG_* */
+	uint8_t reserved;
+	uint16_t offset; /* Index of the first entry to return */
+} __ec_align2;
+
+enum ec_ocpc_phase {
+	EC_OCPC_PHASE_UNKNOWN = 0,
+	EC_OCPC_PHASE_PRECHARGE = 1,
+	EC_OCPC_PHASE_CC = 2,
+	EC_OCPC_PHASE_CV_TRIP = 3,
+	EC_OCPC_PHASE_CV_COMPLETE = 4,
+};
+
+/* VSYS was not raised because the input current limit was reached */
+#define EC_OCPC_TRACE_ICL_LIMITED BIT(0)
+/* First iteration after a reset; no correction was applied */
+#define EC_OCPC_TRACE_FIRST BIT(1)
+
+struct ec_ocpc_trace_entry {
+	/* Lower 32 bits of the EC time of the iteration, in microseconds */
+	uint32_t time_us;
+	uint16_t vsys_target_mv; /* VSYS requested from the charger IC */
+	uint16_t vsys_mv; /* VSYS measured by the charger IC */
+	int16_t ibat_ma; /* Battery current */
+	uint16_t ibat_target_ma; /* Battery current the loop regulates to */
+	uint16_t ibus_ma; /* Input current of the charger IC */
+	int16_t error_ma; /* Target minus actual current, after hysteresis */
+	int16_t integral; /* Accumulated error, in mA */
+	/* Proportional, integral and derivative terms of the drive, in mV */
+	int16_t p_mv;
+	int16_t i_mv;
+	int16_t d_mv;
+	uint8_t phase; /* enum ec_ocpc_phase */
+	uint8_t flags; /* EC_OCPC_TRACE_* */
+	uint16_t reserved;
+} __ec_align4;
+
+struct ec_response_ocpc_trace {
+	/* Number of entries currently held in the trace */
+	uint16_t total;
+	/* Number of entries in this response */
+	uint8_t count;
+	uint8_t reserved;
+	/* Sequence number of the oldest entry held, since the last clear */
+	uint32_t first;
+	uint16_t period_ms; /* Loop period, 0 if run by the charger task */
+	uint16_t drive_limit_mv; /* Largest VSYS increase per iteration */
+	/* PID gains in mV per mA, Q16 fixed point */
+	int32_t kp_q16;
+	int32_t ki_q16;
+	int32_t kd_q16;
+	struct ec_ocpc_trace_entry entries[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+/*
+ * Read the charge ramp history of a port (CONFIG_CHARGE_RAMP_HISTORY).
+ *
+ * Each time the software charge ramp settles on an input current limit, or
+ * is interrupted by the charger going away, an entry is recorded in a ring
+ * for the port. Entries are returned oldest first, starting at offset.
+ */
+#define EC_CMD_CHG_RAMP_HISTORY 0x060B
+
+/* Clear the history instead of reading it */
+#define EC_CHG_RAMP_HISTORY_FLAG_CLEAR BIT(0)
+
+struct ec_params_chg_ramp_history {
+	uint8_t port;
+	uint8_t flags; /* EC_CHG_RAMP_HISTORY_FLAG_* */
+	uint16_t offset; /* Index of the first entry to return */
+} __ec_align2;
+
+enum ec_chg_ramp_method {
+	EC_CHG_RAMP_METHOD_LINEAR = 0, /* Fixed steps up from the minimum */
+	EC_CHG_RAMP_METHOD_SEARCH = 1, /* Binary search between min and max */
+};
+
+enum ec_chg_ramp_result {
+	/* The limit reached the maximum allowed for the supplier */
+	EC_CHG_RAMP_RESULT_MAX = 0,
+	/* VBUS drooped; the limit was backed off from that point */
+	EC_CHG_RAMP_RESULT_VBUS_LOW = 1,
+	/* The limit was kept below one where the charger shut down before */
+	EC_CHG_RAMP_RESULT_OVERCURRENT = 2,
+	/* The charger went away or changed during the ramp */
+	EC_CHG_RAMP_RESULT_INTERRUPTED = 3,
+};
+
+struct ec_chg_ramp_history_entry {
+	/* Lower 32 bits of the EC time the ramp started, in microseconds */
+	uint32_t time_us;
+	uint32_t duration_ms;
+	uint16_t icl_ma; /* Input current limit chosen */
+	uint16_t max_ma; /* Maximum input current limit for the supplier */
+	uint8_t supplier; /* enum charge_supplier */
+	uint8_t method; /* enum ec_chg_ramp_method */
+	uint8_t result; /* enum ec_chg_ramp_result */
+	uint8_t steps; /* Number of limits tried */
+} __ec_align4;
+
+struct ec_response_chg_ramp_history {
+	/* Number of entries currently held for the port */
+	uint16_t total;
+	/* Number of entries in this response */
+	uint8_t count;
+	uint8_t reserved;
+	/* Sequence number of the oldest entry held, since the last clear */
+	uint32_t first;
+	struct ec_chg_ramp_history_entry entries[FLEXIBLE_ARRAY_MEMBER_SIZE];
+} __ec_align4;
+
+/*
+ * Read keypress-to-host latency statistics (CONFIG_KEYBOARD_LATENCY_STATS).
+ *
+ * Each key event is timestamped when the keyboard scan first sees the key
+ * edge, when the event is queued for the host, and when the host reads it.
+ * The three intervals are accumulated in histograms per protocol path.
+ */
+#define EC_CMD_KEYBOARD_LATENCY 0x060C
+
+/* Clear the statistics of the path instead of reading them */
+#define EC_KB_LATENCY_FLAG_CLEAR BIT(0)
+
+enum ec_kb_latency_path {
+	EC_KB_LATENCY_PATH_8042 = 0, /* Scan codes through the 8042 buffer */
+	EC_KB_LATENCY_PATH_MKBP = 1, /* Matrix state through the MKBP FIFO */
+	EC_KB_LATENCY_PATH_COUNT,
+};
+
+enum ec_kb_latency_stage {
+	EC_KB_LATENCY_STAGE_QUEUE = 0, /* Key edge seen to event queued */
+	EC_KB_LATENCY_STAGE_HOST = 1, /* Event queued to host read */
+	EC_KB_LATENCY_STAGE_TOTAL = 2, /* Key edge seen to host read */
+	EC_KB_LATENCY_STAGE_COUNT,
+};
+
+/*
+ * Bucket i counts latencies below (EC_KB_LATENCY_BUCKET_BASE_US << i), not
+ * counted by a lower bucket. The last bucket counts everything longer.
+ */
+#define EC_KB_LATENCY_BUCKET_BASE_US 125
+#define EC_KB_LATENCY_BUCKETS 12
+
+struct ec_params_keyboard_latency {
+	uint8_t path; /* enum ec_kb_latency_path */
+	uint8_t flags; /* EC_KB_LATENCY_FLAG_* */
+} __ec_align1;
+
+struct ec_kb_latency_histogram {
+	uint32_t mean_us;
+	uint32_t max_us;
+	uint32_t buckets[EC_KB_LATENCY_BUCKETS];
+} __ec_align4;
+
+struct ec_response_keyboard_latency {
+	/* Key events read by the host */
+	uint32_t events;
+	/* Key events dropped or discarded before the host read them */
+	uint32_t dropped;
+	/* Indexed by enum ec_kb_latency_stage */
+	struct ec_kb_latency_histogram stage[EC_KB_LATENCY_STAGE_COUNT];
+} __ec_align4;
+
 /*****************************************************************************/
 /*
  * Reserve a range of host commands for board-specific, experimental, or
@@ -248,6 +248,40 @@ void fan_set_count(int count);
 
 int is_thermal_control_enabled(int idx);
 
+/**
+ * CONFIG_FAN_PID_CONTROL: set the RPM the control loop should reach. The
+ * setpoint moves towards it at most CONFIG_FAN_PID_RAMP_RPM_PER_SEC.
+ *
+ * @param fan   Fan number (index into fans[])
+ * @param rpm   Target RPM, 0 to stop the fan
+ */
+void fan_pid_set_target(int fan, int rpm);
+
+/**
+ * CONFIG_FAN_PID_CONTROL: get the RPM last passed to fan_pid_set_target().
+ */
+int fan_pid_get_target(int fan);
+
+/**
+ * CONFIG_FAN_PID_CONTROL: start or stop closed-loop control of a fan. The
+ * controller state is reset so control resumes from the current fan speed.
+ *
+ * @param fan     Fan number (index into fans[])
+ * @param enable  Whether the control loop drives the fan duty cycle
+ */
+void fan_pid_enable(int fan, int enable);
+
+/**
+ * CONFIG_FAN_PID_CONTROL: return true if the control loop has driven the fan
+ * for CONFIG_FAN_PID_STALL_MS without it reaching half its minimum RPM.
+ */
+bool fan_pid_is_stalled(int fan);
+
+/**
+ * CONFIG_FAN_PID_CONTROL: print the controller state for the faninfo command.
+ */
+void fan_pid_print_info(int fan, const char *leader);
+
 #ifdef CONFIG_ZEPHYR
 extern struct fan_data fan_data[];
 
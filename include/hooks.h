@@ -70,8 +70,10 @@ enum hook_priority {
 
 	/* Specific values to lump temperature-related hooks together */
 	HOOK_PRIO_TEMP_SENSOR = 6000,
+	/* Sensor readings are cached, see temp_sensor_read_cached() */
+	HOOK_PRIO_TEMP_SENSOR_SAMPLE = HOOK_PRIO_TEMP_SENSOR + 1,
 	/* After all sensors have been polled */
-	HOOK_PRIO_TEMP_SENSOR_DONE = HOOK_PRIO_TEMP_SENSOR + 1,
+	HOOK_PRIO_TEMP_SENSOR_DONE = HOOK_PRIO_TEMP_SENSOR + 2,
 };
 
 enum hook_type {
@@ -208,6 +208,12 @@ int i2c_xfer_unlocked(const int port, const uint16_t addr_flags,
 		      const uint8_t *out, int out_size, uint8_t *in,
 		      int in_size, int flags);
 
+/**
+ * Return the number of transactions started on all ports since boot. The
+ * counter wraps; callers should only look at differences between two reads.
+ */
+uint32_t i2c_get_xfer_count(void);
+
 #define I2C_LINE_SCL_HIGH BIT(0)
 #define I2C_LINE_SDA_HIGH BIT(1)
 #define I2C_LINE_IDLE (I2C_LINE_SCL_HIGH | I2C_LINE_SDA_HIGH)
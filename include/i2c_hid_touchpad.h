@@ -56,6 +56,27 @@ struct touchpad_event {
 	} __packed finger[I2C_HID_TOUCHPAD_MAX_FINGERS];
 } __packed;
 
+/* Input report latency histogram: bucket i counts latencies below base << i */
+#define I2C_HID_TOUCHPAD_LATENCY_BUCKETS 8
+#define I2C_HID_TOUCHPAD_LATENCY_BUCKET_BASE_US 1000
+
+struct i2c_hid_touchpad_stats {
+	/* Frames compiled into input reports */
+	uint32_t queued;
+	/* Queued reports read by the host */
+	uint32_t sent;
+	/* Queued reports overwritten before the host read them */
+	uint32_t dropped;
+	/* Reports read later than CONFIG_I2C_HID_TOUCHPAD_LATE_US */
+	uint32_t late;
+	/* Input reads with nothing queued, answered with the latest report */
+	uint32_t repeated;
+	/* Time from queuing to the host read, for the sent reports */
+	uint32_t latency_max_us;
+	uint64_t latency_sum_us;
+	uint32_t latency_buckets[I2C_HID_TOUCHPAD_LATENCY_BUCKETS];
+};
+
 /* Initialize the I2C HID touchpad */
 void i2c_hid_touchpad_init(void);
 /*
@@ -76,11 +97,34 @@ int i2c_hid_touchpad_process(unsigned int len, uint8_t *buffer,
 /**
  * Compile an (outgoing) HID input report for an (incoming) touchpad event
  *
- * The compiled report would be sent next time when the host requests one.
+ * The report is queued and sent when the host reads the input register.
+ * Up to CONFIG_I2C_HID_TOUCHPAD_QUEUE_SIZE reports are kept; if the host
+ * falls further behind, the oldest one is dropped.
  *
  * @param touchpad_event	Touchpad event data
+ * @return true if the queue was empty, so the host must be interrupted.
+ *	   Otherwise the interrupt for the earlier reports is still pending and
+ *	   the host will read this one in the same batch.
+ */
+bool i2c_hid_compile_report(struct touchpad_event *event);
+
+/**
+ * Check for queued input reports.
+ *
+ * The board should keep the interrupt to the host asserted while this
+ * returns true, so the host reads all queued reports back to back.
  */
-void i2c_hid_compile_report(struct touchpad_event *event);
+bool i2c_hid_touchpad_has_report(void);
+
+/**
+ * Get the input report statistics.
+ *
+ * @param out	Filled with a snapshot of the counters
+ */
+void i2c_hid_touchpad_get_stats(struct i2c_hid_touchpad_stats *out);
+
+/* Reset the input report statistics */
+void i2c_hid_touchpad_clear_stats(void);
 
 #ifdef __cplusplus
 }
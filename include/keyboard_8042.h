@@ -86,6 +86,11 @@ __test_only void test_keyboard_8042_set_resend_command(const uint8_t *data,
  * @brief Reset typematic, RAM, and scancode set for testing purposes.
  */
 __test_only void test_keyboard_8042_reset(void);
+
+/**
+ * @brief Get the number of bytes dropped because a to-host queue was full.
+ */
+__test_only uint32_t test_keyboard_8042_get_dropped_bytes(void);
 #endif /* TEST_BUILD */
 
 #ifdef __cplusplus
@@ -0,0 +1,60 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Keypress-to-host latency statistics
+ */
+
+#ifndef __CROS_EC_KEYBOARD_LATENCY_H
+#define __CROS_EC_KEYBOARD_LATENCY_H
+
+#include "common.h"
+#include "ec_commands.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Note when the key event about to be reported was first seen.
+ *
+ * Called by the keyboard scan before handing a key change to the protocol.
+ * If several changes are marked before the protocol claims the mark, the
+ * earliest one is kept, since MKBP reports them in a single event.
+ *
+ * @param detect_us	Lower 32 bits of the time of the scan that saw the edge
+ */
+void keyboard_latency_mark(uint32_t detect_us);
+
+/**
+ * Take the detection time for a key event being queued for the host.
+ *
+ * @return the marked detection time, or the current time if the event did
+ *	   not come from the keyboard scan (e.g. simulated keys).
+ */
+uint32_t keyboard_latency_claim(void);
+
+/**
+ * Account a key event read by the host.
+ *
+ * @param path		enum ec_kb_latency_path
+ * @param detect_us	Time the key edge was seen
+ * @param enqueue_us	Time the event was queued for the host
+ * @param read_us	Time the host read the event
+ */
+void keyboard_latency_record(enum ec_kb_latency_path path, uint32_t detect_us,
+			     uint32_t enqueue_us, uint32_t read_us);
+
+/**
+ * Account key events that won't reach the host.
+ *
+ * @param path		enum ec_kb_latency_path
+ * @param count		Number of events dropped
+ */
+void keyboard_latency_dropped(enum ec_kb_latency_path path, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CROS_EC_KEYBOARD_LATENCY_H */
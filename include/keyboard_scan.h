@@ -50,6 +50,17 @@ struct keyboard_scan_config {
 #endif
 };
 
+/* Counters of the matrix scans done while polling, since boot */
+struct keyboard_scan_stats {
+	/* Scans, and how many of them read every column */
+	uint32_t scans;
+	uint32_t full_scans;
+	/* Columns read, summed over all scans */
+	uint32_t columns;
+	/* Time spent scanning, in us */
+	uint32_t scan_us;
+};
+
 /* Boot key list.  Must be in same order as enum boot_key. */
 struct boot_key_entry {
 	uint8_t col;
@@ -216,6 +227,13 @@ __test_only int keyboard_scan_get_print_state_changes(void);
  */
 __test_only void keyboard_scan_set_print_state_changes(int val);
 
+/**
+ * @brief Get the polling scan counters.
+ *
+ * @param stats		Destination for the counters
+ */
+__test_only void keyboard_scan_get_stats(struct keyboard_scan_stats *stats);
+
 /**
  * @brief Checks if keyboard scanning is currently enabled.
  *
@@ -0,0 +1,125 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Lightbar bytecode (lightbyte) interpreter, shared by the EC and host tools.
+ */
+
+#ifndef __CROS_EC_LIGHTBYTE_H
+#define __CROS_EC_LIGHTBYTE_H
+
+#include "ec_commands.h"
+#include "lb_common.h"
+#include "lightbar.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OP(NAME, BYTES, MNEMONIC) NAME,
+#include "lightbar_opcode_list.h"
+enum lightbyte_opcode { LIGHTBAR_OPCODE_TABLE MAX_OPCODE };
+#undef OP
+
+/* Fixed point 1.0 for cycle_010() */
+#define LB_FP_SCALE 10000
+
+/* Returned by lightbyte_run() when the program halts. */
+#define LIGHTBYTE_FINISHED 2
+
+/* Shortest time between two LED updates of a ramp or cycle (60 Hz) */
+#define LIGHTBYTE_FRAME_US 16667
+
+/* Time given up by a loop that doesn't wait, so it can't hog the CPU */
+#define LIGHTBYTE_YIELD_US 100
+
+/*
+ * One instruction, checked and with its jump targets resolved when the
+ * program is loaded. Other operands are kept as the program encodes them,
+ * so that an instruction takes five bytes.
+ */
+struct lightbyte_inst {
+	uint8_t op; /* enum lightbyte_opcode */
+	union {
+		/* SET_WAIT_DELAY, SET_RAMP_DELAY: big-endian */
+		uint8_t delay[4];
+		/* JUMP*: instruction indexes; JUMP_BATTERY has low and high */
+		uint8_t target[2];
+		/* SET_BRIGHTNESS */
+		uint8_t value;
+		/*
+		 * SET_COLOR_*: an LED bitmask in the high four bits of loc, then
+		 * an enum lb_control and an enum lb_color in two bits each.
+		 * SET_COLOR_SINGLE only uses rgb[0], as the value.
+		 */
+		struct {
+			uint8_t loc;
+			uint8_t rgb[3];
+		} color;
+	};
+};
+
+struct lightbyte_vm {
+	const struct lightbyte_inst *code;
+	int count;
+	int pc;
+	uint8_t led_desc[NUM_LEDS][LB_CONT_MAX][3];
+	uint32_t wait_delay;
+	uint32_t ramp_delay;
+	/* Time the program has been scheduled up to, in us */
+	uint64_t tick;
+	/* Whether the program has waited since the last jump back */
+	bool waited;
+};
+
+/**
+ * Smooth ramp from 0 up to LB_FP_SCALE and back to 0, for i from 0 to 0xff.
+ */
+int cycle_010(uint8_t i);
+
+/**
+ * Check a lightbyte program and decode it into instructions.
+ *
+ * @param prog		Program as sent with LIGHTBAR_CMD_SET_PROGRAM
+ * @param code		Array of EC_LB_PROG_LEN instructions to fill, or NULL
+ *			to only check the program.
+ * @param bad_addr	If not NULL, set to the offending byte address when
+ *			the program is invalid.
+ * @return the number of instructions, or -1 if the program is invalid.
+ */
+int lightbyte_decode(const struct lightbar_program *prog,
+		     struct lightbyte_inst *code, int *bad_addr);
+
+/**
+ * Run a decoded program from its first instruction.
+ *
+ * Waits and ramps are scheduled against vm->tick rather than the time the
+ * previous step happened to end, so instruction overhead doesn't add up.
+ *
+ * @param vm	Interpreter state; code and count must be set.
+ * @return LIGHTBYTE_FINISHED on HALT, EC_RES_INVALID_PARAM on a runtime
+ *	   error, or whatever lightbyte_wait_until() returned to stop it.
+ */
+uint32_t lightbyte_run(struct lightbyte_vm *vm);
+
+/*
+ * Provided by the program that runs the interpreter, along with the lb_*()
+ * functions from lb_common.h.
+ */
+
+/* Battery level from 0 (low) to 3 (high) */
+int lightbyte_battery_level(void);
+int lightbyte_is_charging(void);
+/* Current time in us */
+uint64_t lightbyte_now(void);
+/* Sleep until time t. A nonzero return stops the program with that value. */
+uint32_t lightbyte_wait_until(uint64_t t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CROS_EC_LIGHTBYTE_H */
@@ -34,6 +34,16 @@ extern "C" {
  */
 int motion_lid_get_angle(void);
 
+/**
+ * Get the confidence in the last calculated lid angle.
+ *
+ * It drops as the accelerometers measure more than gravity or as the hinge
+ * gets vertical, before the angle becomes unreliable.
+ *
+ * @return confidence in percent, 0 if the lid angle is unreliable.
+ */
+int motion_lid_get_confidence(void);
+
 enum ec_status host_cmd_motion_lid(struct host_cmd_handler_args *args);
 
 void motion_lid_calc(void);
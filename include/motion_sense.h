@@ -19,6 +19,7 @@
 #include "task.h"
 #include "timer.h"
 #include "util.h"
+#include "vec3.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -168,6 +169,9 @@ struct online_calib_data {
 
 	/** Timestamp for the latest temperature reading. */
 	uint32_t last_temperature_timestamp;
+
+	/** Factors to convert samples at the sensor's current range. */
+	struct fpv3_int16_scale scale;
 };
 
 struct motion_sensor_t {
@@ -323,6 +327,24 @@ int sensor_board_is_lid_angle_available(void);
  */
 void motion_sense_push_raw_xyz(struct motion_sensor_t *s);
 
+/*
+ * Sampling jitter of a sensor in forced mode: how far from its scheduled
+ * collection time each read happened. Reads ahead of time come from sensors
+ * coalesced into the pass of a sensor due just before them.
+ */
+#define MOTION_SENSE_JITTER_BUCKETS 6
+#define MOTION_SENSE_JITTER_BUCKET_BASE_US 250
+
+struct motion_sense_jitter {
+	uint32_t samples;
+	uint32_t early;
+	uint32_t late;
+	uint32_t max_early_us;
+	uint32_t max_late_us;
+	/* Bucket i counts reads less than base << i away from schedule */
+	uint32_t buckets[MOTION_SENSE_JITTER_BUCKETS];
+};
+
 /**
  * Check whether the given sensor is in force mode or not.
  *
@@ -394,9 +416,10 @@ ec_motion_sensor_fill_values(struct ec_response_motion_sensor_data *dst,
 	dst->data[2] = v[2];
 }
 
-#ifdef CONFIG_TEST
+/**
+ * Get the EC sensor config of the current power state.
+ */
 enum sensor_config motion_sense_get_ec_config(void);
-#endif
 
 #ifdef __cplusplus
 }
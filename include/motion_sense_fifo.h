@@ -12,6 +12,13 @@
 extern "C" {
 #endif
 
+/*
+ * Most samples a hardware FIFO may batch, so that draining a full batch (a
+ * timestamp and a data entry per sample) fits in the room left at the
+ * threshold.
+ */
+#define MOTION_SENSE_FIFO_BATCH_MAX (CONFIG_ACCEL_FIFO_THRES / 2)
+
 /** Allowed async events. */
 enum motion_sense_async_event {
 	ASYNC_EVENT_FLUSH = MOTIONSENSE_SENSOR_FLAG_FLUSH |
@@ -100,6 +107,33 @@ void motion_sense_fifo_stage_data(struct ec_response_motion_sensor_data *data,
  */
 void motion_sense_fifo_commit_data(void);
 
+/**
+ * Mark the data staged since the last commit as read from a batching hardware
+ * FIFO.
+ *
+ * The samples of a batch are staged with the time of the interrupt, raised
+ * when the watermark was reached: they were taken before that time, not
+ * after. On commit, their timestamps are spread backward from the last sample
+ * instead of forward from the first one.
+ */
+void motion_sense_fifo_mark_batch(void);
+
+/**
+ * Number of samples a hardware FIFO may hold before interrupting the EC.
+ *
+ * A batch lasts at most the shortest ec_rate of the AP config and the current
+ * EC config of the sensors feeding the FIFO. Without CONFIG_ACCEL_FIFO_BATCH,
+ * or when one of the sensors needs every sample right away, the batch is a
+ * single sample.
+ *
+ * @param sensors Sensors sharing the hardware FIFO. NULL entries and disabled
+ *                sensors are skipped.
+ * @param count Number of entries in sensors.
+ * @return the batch size, from 1 to MOTION_SENSE_FIFO_BATCH_MAX.
+ */
+int motion_sense_fifo_batch_size(const struct motion_sensor_t *const *sensors,
+				 int count);
+
 /**
  * Get information about the fifo.
  *
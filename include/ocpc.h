@@ -59,6 +59,25 @@ int ocpc_config_secondary_charger(int *desired_charger_input_current,
 				  int desired_batt_voltage_mv,
 				  int desired_batt_current_ma);
 
+/**
+ * Step the VSYS control loop if it is due, towards the targets last passed to
+ * ocpc_config_secondary_charger(). Does nothing without
+ * CONFIG_OCPC_LOOP_PERIOD_MS. Only call from the charger task.
+ *
+ * @param desired_charger_input_current: Pointer to desired_input_current
+ * @param ocpc: Pointer to OCPC data
+ * @return EC_SUCCESS if not due or on success, error otherwise.
+ */
+int ocpc_loop_tick(int *desired_charger_input_current, struct ocpc_data *ocpc);
+
+/**
+ * Time until the VSYS control loop is due to step, with
+ * CONFIG_OCPC_LOOP_PERIOD_MS.
+ *
+ * @return Microseconds, or -1 if the loop is not running or has no period.
+ */
+int ocpc_loop_next_us(void);
+
 /** Get the runtime data from the various ADCs.
  *
  * @param ocpc: Pointer to OCPC data
@@ -62,6 +62,10 @@ struct rgbkbd {
 	enum rgbkbd_state state;
 	/* Buffer containing color info for each dot. */
 	struct rgb_s *buf;
+	/* Dots whose color in buf hasn't been sent to the LED IC yet. */
+	uint32_t dirty[(UINT8_MAX + 31) / 32];
+	/* Frames in a row the LED IC failed to take. */
+	uint8_t flush_failures;
 };
 
 struct rgbkbd_drv {
@@ -0,0 +1,111 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Fixed-size logs of the most recent entries, read back oldest first.
+ */
+#ifndef __CROS_EC_RING_LOG_H
+#define __CROS_EC_RING_LOG_H
+
+#include "atomic.h"
+#include "common.h"
+#include "util.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct host_cmd_handler_args;
+
+/*
+ * A ring log overwrites its oldest entry once full.  It is described by its
+ * entry storage and a counter of the entries ever appended, which the ring
+ * index is taken modulo.  The counter is advanced atomically, so tasks and
+ * interrupts may append concurrently, each filling in its own slot; readers
+ * that may run while a slot is being filled in need their own locking.
+ *
+ * Entries are numbered in the order they were appended since the last clear.
+ * Readers get the sequence number of the oldest entry held along with the
+ * entries, so a host paging through the log can tell when entries appended
+ * between two pages pushed older ones out, or the log was cleared.
+ */
+struct ring_log {
+	void *entries;
+	uint16_t entry_size;
+	uint16_t capacity;
+	atomic_t *next;
+};
+
+/*
+ * Describe the ring log held in the array "entries", whose append counter is
+ * "next", e.g. RING_LOG(trace[port], &trace_next[port]).  RING_LOG_INIT is
+ * the same as an initializer.
+ */
+#define RING_LOG_INIT(entries_, next_)                   \
+	{                                                \
+		.entries = (entries_),                   \
+		.entry_size = sizeof((entries_)[0]),     \
+		.capacity = ARRAY_SIZE(entries_),        \
+		.next = (next_),                         \
+	}
+#define RING_LOG(entries_, next_) \
+	((struct ring_log)RING_LOG_INIT(entries_, next_))
+
+/**
+ * Claim the slot for a new entry, overwriting the oldest one if full.
+ *
+ * @param log	Ring log
+ * @return Entry for the caller to fill in
+ */
+void *ring_log_append(const struct ring_log *log);
+
+/**
+ * Discard all entries.
+ *
+ * @param log	Ring log
+ */
+void ring_log_clear(const struct ring_log *log);
+
+/**
+ * Copy entries out of a ring log, oldest first.
+ *
+ * @param log		Ring log
+ * @param offset	Index of the first entry to copy, 0 for the oldest
+ * @param out		Buffer for the entries
+ * @param max_count	Number of entries the buffer can hold
+ * @param first		If not NULL, receives the sequence number of the
+ *			oldest entry held
+ * @param total		If not NULL, receives the number of entries held
+ * @return Number of entries copied
+ */
+int ring_log_read(const struct ring_log *log, uint32_t offset, void *out,
+		  int max_count, uint32_t *first, uint32_t *total);
+
+/**
+ * Read a page of a ring log into a host command response.
+ *
+ * The response holds a header of header_size bytes, followed by as many whole
+ * entries as fit in the response, at most UINT8_MAX.  Sets the response size.
+ *
+ * @param log		Ring log
+ * @param args		Host command arguments
+ * @param header_size	Size of the response ahead of the entries
+ * @param offset	Index of the first entry to copy, 0 for the oldest
+ * @param first		Receives the sequence number of the oldest entry
+ *			held
+ * @param total		Receives the number of entries held
+ * @return Number of entries copied, or -EC_RES_RESPONSE_TOO_BIG if even the
+ *	   header does not fit in the response
+ */
+int ring_log_host_read(const struct ring_log *log,
+		       struct host_cmd_handler_args *args, size_t header_size,
+		       uint32_t offset, uint32_t *first, uint32_t *total);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CROS_EC_RING_LOG_H */
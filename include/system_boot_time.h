@@ -6,6 +6,7 @@
 #ifndef __CROS_EC_SYSTEM_BOOT_TIME_H
 #define __CROS_EC_SYSTEM_BOOT_TIME_H
 
+#include "common.h"
 #include "ec_commands.h"
 
 #ifdef __cplusplus
@@ -19,6 +20,23 @@ extern "C" {
  */
 void update_ap_boot_time(enum boot_time_param param);
 
+#ifdef CONFIG_BOOT_TIME_PROFILE
+/**
+ * Record an event in the boot time profile.
+ *
+ * @param event		enum ec_boot_time_event
+ * @param flags		EC_BOOT_TIME_BEGIN, EC_BOOT_TIME_END or 0
+ * @param data		Event specific, see enum ec_boot_time_event
+ */
+void boot_time_mark(enum ec_boot_time_event event, uint8_t flags,
+		    uint32_t data);
+#else
+static inline void boot_time_mark(enum ec_boot_time_event event,
+				  uint8_t flags, uint32_t data)
+{
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
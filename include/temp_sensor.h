@@ -69,6 +69,30 @@ extern const struct temp_sensor_t temp_sensors[];
  */
 int temp_sensor_read(enum temp_sensor_id id, int *temp_ptr);
 
+/**
+ * Get the temperature (in degrees K) sampled for the sensor on the last
+ * HOOK_SECOND. This doesn't access the sensor, so periodic consumers should
+ * use it instead of temp_sensor_read() to avoid reading every sensor once per
+ * consumer.
+ *
+ * @param id		Sensor ID
+ * @param temp_ptr	Destination for temperature
+ *
+ * @return Result of the last temp_sensor_read() for the sensor.
+ */
+int temp_sensor_read_cached(enum temp_sensor_id id, int *temp_ptr);
+
+/**
+ * Set how often the sensor is sampled for temp_sensor_read_cached(). Sensors
+ * which failed their last read are sampled every second regardless.
+ *
+ * @param id		Sensor ID
+ * @param seconds	Sample period, 1 to 255 seconds (default 1)
+ *
+ * @return EC_SUCCESS, or non-zero if error.
+ */
+int temp_sensor_set_sample_period(enum temp_sensor_id id, int seconds);
+
 /**
  * Print all temperature sensor values.
  *
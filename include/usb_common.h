@@ -131,6 +131,27 @@ enum tcpc_cc_polarity get_src_polarity(enum tcpc_cc_voltage_status cc1,
 int pd_find_pdo_index(uint32_t src_cap_cnt, const uint32_t *const src_caps,
 		      int max_mv, uint32_t *selected_pdo);
 
+/**
+ * Find the PDO index that offers the most power within max_mv among the
+ * source caps last received on the port. The source caps are ranked once
+ * per port each time they change, so a lookup only walks the ranking until
+ * a PDO fits within max_mv. On equal power an SPR PDO wins over an EPR one.
+ *
+ * @param port USB-C port number
+ * @param max_mv maximum voltage (or -1 if no limit)
+ * @param selected_pdo raw pdo corresponding to index (output)
+ * @return index of PDO within source cap packet
+ */
+int pd_get_best_pdo(int port, int max_mv, uint32_t *selected_pdo);
+
+/**
+ * Drop the best-PDO ranking for a port. Must be called whenever the stored
+ * source caps change.
+ *
+ * @param port USB-C port number
+ */
+void pd_invalidate_best_pdo(int port);
+
 /**
  * Extract power information out of a Power Data Object (PDO) and clamp
  * current values to board limits (CONFIG_USB_PD_MAX_POWER_MW,
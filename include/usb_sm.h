@@ -94,6 +94,31 @@ void set_state(int port, struct sm_ctx *ctx, usb_state_ptr new_state);
  */
 void run_state(int port, struct sm_ctx *ctx);
 
+#ifdef CONFIG_USB_SM_TRACE
+/* One recorded state machine transition */
+struct usb_sm_trace_entry {
+	/* Lower 32 bits of the system time of the transition, in us */
+	uint32_t time_us;
+	int port;
+	usb_state_ptr from;
+	usb_state_ptr to;
+};
+
+/**
+ * Copies the recorded transitions, oldest first.
+ *
+ * @param entries Buffer to receive the transitions
+ * @param max     Number of entries the buffer can hold
+ * @return Number of entries copied
+ */
+int usb_sm_trace_read(struct usb_sm_trace_entry *entries, int max);
+
+/**
+ * Discards all recorded transitions.
+ */
+void usb_sm_trace_clear(void);
+#endif /* CONFIG_USB_SM_TRACE */
+
 #ifdef TEST_BUILD
 /*
  * Struct for test builds that allow unit tests to easily iterate through
@@ -16,6 +16,13 @@ extern "C" {
 typedef float floatv3_t[3];
 typedef fp_t fpv3_t[3];
 
+/* Factors to convert raw sensor samples, see fpv3_int16_scale_init(). */
+struct fpv3_int16_scale {
+	fp_inter_t pos;
+	fp_inter_t neg;
+	fp_t range;
+};
+
 /**
  * Initialized a vector to all 0.0f.
  *
@@ -84,6 +91,28 @@ fp_t fpv3_norm_squared(const fpv3_t v);
  */
 fp_t fpv3_norm(const fpv3_t v);
 
+/**
+ * Compute the factors converting raw samples of a sensor to its unit.
+ *
+ * The divisions happen here, once per range change, rather than for each
+ * sample converted.
+ *
+ * @param s Pointer to the factors to compute.
+ * @param range Sensor range, the value of a full scale sample.
+ */
+void fpv3_int16_scale_init(struct fpv3_int16_scale *s, int range);
+
+/**
+ * Convert a raw sample to the sensor unit: 0x7fff (-0x8000) maps to range
+ * (-range), and the result is clamped to [-range, range].
+ *
+ * @param out Pointer to the vector that will be written to.
+ * @param data Raw sample.
+ * @param s Conversion factors for the sensor range.
+ */
+void fpv3_from_int16(fpv3_t out, const int16_t *data,
+		     const struct fpv3_int16_scale *s);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,6 +5,7 @@
 
 /* Common functionality across all chipsets */
 
+#include "atomic.h"
 #include "battery.h"
 #include "charge_state.h"
 #include "chipset.h"
@@ -21,7 +22,9 @@
 #include "power/amd_x86.h"
 #include "power/intel_x86.h"
 #include "power/qcom.h"
+#include "ring_log.h"
 #include "system.h"
+#include "system_boot_time.h"
 #include "task.h"
 #include "timer.h"
 #include "util.h"
@@ -153,6 +156,203 @@ static const char *power_signal_get_name(enum gpio_signal signal)
 }
 #endif
 
+#ifdef CONFIG_POWER_SIGNAL_LOG
+static struct ec_power_signal_log_entry
+	signal_log_entries[CONFIG_POWER_SIGNAL_LOG_SIZE];
+static atomic_t signal_log_next;
+static const struct ring_log signal_log =
+	RING_LOG_INIT(signal_log_entries, &signal_log_next);
+
+static struct {
+	uint32_t entries;
+	/* Number of times the state was left, i.e. of dwell times measured */
+	uint32_t dwells;
+	uint32_t dwell_min_us;
+	uint32_t dwell_max_us;
+	uint64_t dwell_total_us;
+	uint32_t waits;
+	uint32_t timeouts;
+	uint32_t wait_min_us;
+	uint32_t wait_max_us;
+	uint64_t wait_total_us;
+} state_stats[ARRAY_SIZE(state_names)];
+
+/* When the current state was entered, 0 before the first transition */
+static uint64_t state_enter_time;
+
+/*
+ * Entries are added from power_signal_interrupt() as well as from the chipset
+ * task, so both adding and reading them out happen with interrupts locked.
+ */
+static void signal_log_add(enum ec_power_signal_log_event event, uint8_t id,
+			   uint8_t value, uint32_t signals)
+{
+	struct ec_power_signal_log_entry *e;
+	uint32_t lock_key = irq_lock();
+
+	e = ring_log_append(&signal_log);
+	e->time_us = get_time().val;
+	e->signals = signals;
+	e->event = event;
+	e->id = id;
+	e->value = value;
+	e->reserved = 0;
+
+	irq_unlock(lock_key);
+}
+
+static void signal_log_edge(enum gpio_signal signal)
+{
+	int i;
+
+	for (i = 0; i < POWER_SIGNAL_COUNT; i++) {
+		if (power_signal_list[i].gpio != signal)
+			continue;
+		if (!(power_signal_list[i].flags & POWER_SIGNAL_NO_LOG))
+			signal_log_add(EC_POWER_SIGNAL_LOG_EDGE, i,
+				       power_signal_get_level(signal),
+				       in_signals);
+		return;
+	}
+}
+
+static void signal_log_state(enum power_state new_state)
+{
+	uint64_t now = get_time().val;
+	uint32_t dwell = now - state_enter_time;
+
+	if (state_enter_time) {
+		if (!state_stats[state].dwells ||
+		    dwell < state_stats[state].dwell_min_us)
+			state_stats[state].dwell_min_us = dwell;
+		state_stats[state].dwell_max_us =
+			MAX(state_stats[state].dwell_max_us, dwell);
+		state_stats[state].dwell_total_us += dwell;
+		state_stats[state].dwells++;
+	}
+	state_enter_time = now;
+	state_stats[new_state].entries++;
+
+	signal_log_add(EC_POWER_SIGNAL_LOG_STATE, new_state, state, in_signals);
+}
+
+static void signal_log_wait(timestamp_t start, bool timeout)
+{
+	uint32_t us = get_time().val - start.val;
+
+	if (!state_stats[state].waits || us < state_stats[state].wait_min_us)
+		state_stats[state].wait_min_us = us;
+	state_stats[state].wait_max_us =
+		MAX(state_stats[state].wait_max_us, us);
+	state_stats[state].wait_total_us += us;
+	state_stats[state].waits++;
+	if (timeout)
+		state_stats[state].timeouts++;
+
+	signal_log_add(EC_POWER_SIGNAL_LOG_WAIT_END, state, timeout,
+		       in_signals);
+}
+
+static enum ec_status
+signal_log_get_events(const struct ec_params_power_signal_log *p,
+		      struct host_cmd_handler_args *args)
+{
+	struct ec_response_power_signal_log_events *r = args->response;
+	uint32_t lock_key, first, total;
+	int count;
+
+	lock_key = irq_lock();
+	count = ring_log_host_read(&signal_log, args, sizeof(*r), p->offset,
+				   &first, &total);
+	irq_unlock(lock_key);
+	if (count < 0)
+		return -count;
+
+	r->first = first;
+	r->total = total;
+	r->count = count;
+	r->reserved = 0;
+
+	return EC_RES_SUCCESS;
+}
+
+static enum ec_status
+signal_log_get_stats(const struct ec_params_power_signal_log *p,
+		     struct host_cmd_handler_args *args)
+{
+	struct ec_response_power_signal_log_stats *r = args->response;
+	struct ec_power_signal_log_stats *out;
+	int max_count, i;
+
+	if (args->response_max < sizeof(*r))
+		return EC_RES_RESPONSE_TOO_BIG;
+
+	max_count = (args->response_max - sizeof(*r)) / sizeof(r->stats[0]);
+
+	r->total = ARRAY_SIZE(state_names);
+	r->count = 0;
+	r->reserved = 0;
+	for (i = p->offset; i < ARRAY_SIZE(state_names) && r->count < max_count;
+	     i++) {
+		out = &r->stats[r->count++];
+		strzcpy(out->name, state_names[i], sizeof(out->name));
+		out->entries = state_stats[i].entries;
+		out->dwell_min_us = state_stats[i].dwell_min_us;
+		out->dwell_max_us = state_stats[i].dwell_max_us;
+		out->dwell_avg_us = state_stats[i].dwells ?
+					    state_stats[i].dwell_total_us /
+						    state_stats[i].dwells :
+					    0;
+		out->waits = state_stats[i].waits;
+		out->timeouts = state_stats[i].timeouts;
+		out->wait_min_us = state_stats[i].wait_min_us;
+		out->wait_max_us = state_stats[i].wait_max_us;
+		out->wait_avg_us = state_stats[i].waits ?
+					   state_stats[i].wait_total_us /
+						   state_stats[i].waits :
+					   0;
+	}
+
+	args->response_size = sizeof(*r) + r->count * sizeof(r->stats[0]);
+
+	return EC_RES_SUCCESS;
+}
+
+static enum ec_status hc_power_signal_log(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_power_signal_log *p = args->params;
+	struct ec_response_power_signal_log_name *name = args->response;
+	uint32_t lock_key;
+
+	switch (p->cmd) {
+	case EC_POWER_SIGNAL_LOG_CMD_GET_EVENTS:
+		return signal_log_get_events(p, args);
+	case EC_POWER_SIGNAL_LOG_CMD_GET_STATS:
+		return signal_log_get_stats(p, args);
+	case EC_POWER_SIGNAL_LOG_CMD_GET_SIGNAL_NAME:
+		if (p->offset >= POWER_SIGNAL_COUNT)
+			return EC_RES_INVALID_PARAM;
+		strzcpy(name->name, power_signal_list[p->offset].name,
+			sizeof(name->name));
+		args->response_size = sizeof(*name);
+		return EC_RES_SUCCESS;
+	case EC_POWER_SIGNAL_LOG_CMD_CLEAR:
+		lock_key = irq_lock();
+		ring_log_clear(&signal_log);
+		memset(state_stats, 0, sizeof(state_stats));
+		/* Keep timing the current state, but from now */
+		if (state_enter_time)
+			state_enter_time = get_time().val;
+		irq_unlock(lock_key);
+		return EC_RES_SUCCESS;
+	default:
+		return EC_RES_INVALID_PARAM;
+	}
+}
+DECLARE_HOST_COMMAND(EC_CMD_POWER_SIGNAL_LOG, hc_power_signal_log,
+		     EC_VER_MASK(0));
+#endif /* CONFIG_POWER_SIGNAL_LOG */
+
 /**
  * Update input signals mask
  */
@@ -206,13 +406,23 @@ int power_wait_signals_timeout(uint32_t want, int timeout)
 
 int power_wait_mask_signals_timeout(uint32_t want, uint32_t mask, int timeout)
 {
+#ifdef CONFIG_POWER_SIGNAL_LOG
+	timestamp_t start = get_time();
+#endif
+
 	in_want = want;
 	if (!mask)
 		return EC_SUCCESS;
 
+#ifdef CONFIG_POWER_SIGNAL_LOG
+	signal_log_add(EC_POWER_SIGNAL_LOG_WAIT_START, state, 0, want);
+#endif
 	while ((in_signals & mask) != in_want) {
 		if (task_wait_event(timeout) == TASK_EVENT_TIMER) {
 			power_update_signals();
+#ifdef CONFIG_POWER_SIGNAL_LOG
+			signal_log_wait(start, true);
+#endif
 			return EC_ERROR_TIMEOUT;
 		}
 		/*
@@ -222,6 +432,9 @@ int power_wait_mask_signals_timeout(uint32_t want, uint32_t mask, int timeout)
 		 * longer in the same state we were when we started waiting.
 		 */
 	}
+#ifdef CONFIG_POWER_SIGNAL_LOG
+	signal_log_wait(start, false);
+#endif
 	return EC_SUCCESS;
 }
 
@@ -234,6 +447,10 @@ void power_set_state(enum power_state new_state)
 	/* Print out the RTC value to help correlate EC and kernel logs. */
 	print_system_rtc(CC_CHIPSET);
 
+	boot_time_mark(EC_BOOT_TIME_EVENT_POWER_STATE, 0, new_state);
+#ifdef CONFIG_POWER_SIGNAL_LOG
+	signal_log_state(new_state);
+#endif
 	state = new_state;
 
 	/*
@@ -896,6 +1113,10 @@ void power_signal_interrupt(enum gpio_signal signal)
 	/* Shadow signals and compare with our desired signal state. */
 	power_update_signals();
 
+#ifdef CONFIG_POWER_SIGNAL_LOG
+	signal_log_edge(signal);
+#endif
+
 	/* Wake up the task */
 	task_wake(TASK_ID_CHIPSET);
 }
@@ -12,6 +12,7 @@
 #include "console.h"
 #include "i2c.h"
 #include "test_util.h"
+#include "timer.h"
 #include "util.h"
 
 /* Test state */
@@ -241,6 +242,83 @@ static int test_current(void)
 	return EC_SUCCESS;
 }
 
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+static int test_poll_tiers(void)
+{
+	uint32_t temperature_time;
+	int full_reads, fast_reads;
+	int untiered, i;
+
+	sb_write(SB_TEMPERATURE, 2981);
+	sb_write(SB_FULL_CHARGE_CAPACITY, 5000);
+
+	/* A caller that has never seen the fields gets a full read */
+	reset_and_fail_on(0, 0, -1);
+	battery_get_params(&batt);
+	full_reads = read_count;
+	TEST_EQ(batt.temperature, 2981, "%d");
+	temperature_time = batt.read_time[BATT_PARAM_TEMPERATURE];
+	TEST_NE(temperature_time, 0, "%u");
+
+	/* Right after, only the fast registers are read */
+	sb_write(SB_TEMPERATURE, 3001);
+	reset_counters(0, 0);
+	battery_get_params(&batt);
+	fast_reads = read_count;
+	TEST_LT(fast_reads, full_reads, "%d");
+	TEST_EQ(batt.temperature, 2981, "%d");
+	TEST_EQ(batt.read_time[BATT_PARAM_TEMPERATURE], temperature_time,
+		"%u");
+	TEST_ASSERT(batt.flags & BATT_FLAG_RESPONSIVE);
+	TEST_ASSERT(!(batt.flags & BATT_FLAG_BAD_ANY));
+
+	/* Medium rate registers are refreshed once their period elapsed */
+	crec_msleep(CONFIG_BATTERY_SMART_POLL_MEDIUM_MS);
+	reset_counters(0, 0);
+	battery_get_params(&batt);
+	TEST_GT(read_count, fast_reads, "%d");
+	TEST_LT(read_count, full_reads, "%d");
+	TEST_EQ(batt.temperature, 3001, "%d");
+
+	/* A failed read is retried on the next call */
+	crec_msleep(CONFIG_BATTERY_SMART_POLL_MEDIUM_MS);
+	cmd_to_fail = SB_TEMPERATURE;
+	battery_get_params(&batt);
+	TEST_ASSERT(batt.flags & BATT_FLAG_BAD_TEMPERATURE);
+	cmd_to_fail = -1;
+	reset_counters(0, 0);
+	battery_get_params(&batt);
+	TEST_ASSERT(!(batt.flags & BATT_FLAG_BAD_TEMPERATURE));
+	TEST_EQ(read_count, fast_reads + 1, "%d");
+
+	/* If the battery stops responding, cached values are dropped too */
+	reset_counters(1, full_reads);
+	battery_get_params(&batt);
+	TEST_EQ(batt.flags & BATT_FLAG_BAD_ANY, BATT_FLAG_BAD_ANY, "0x%x");
+	TEST_ASSERT(!(batt.flags & BATT_FLAG_RESPONSIVE));
+	reset_counters(0, 0);
+	battery_get_params(&batt);
+	TEST_EQ(read_count, full_reads, "%d");
+
+	/*
+	 * Poll at the charging loop rate for one slow period and compare the
+	 * register reads with reading every register on every call.
+	 */
+	reset_counters(0, 0);
+	for (i = 0; i < CONFIG_BATTERY_SMART_POLL_SLOW_MS / 25; i++) {
+		battery_get_params(&batt);
+		crec_msleep(25);
+	}
+	untiered = i * full_reads;
+	ccprintf("SMBus reads per minute: %d tiered, %d untiered\n",
+		 read_count * (60000 / CONFIG_BATTERY_SMART_POLL_SLOW_MS),
+		 untiered * (60000 / CONFIG_BATTERY_SMART_POLL_SLOW_MS));
+	TEST_LT(read_count, untiered * 2 / 3, "%d");
+
+	return EC_SUCCESS;
+}
+#endif
+
 void run_test(int argc, const char **argv)
 {
 	RUN_TEST(test_param_failures);
@@ -248,6 +326,9 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_full_state_of_charge);
 	RUN_TEST(test_voltage);
 	RUN_TEST(test_current);
+#ifdef CONFIG_BATTERY_SMART_POLL_TIERS
+	RUN_TEST(test_poll_tiers);
+#endif
 
 	test_print_result();
 }
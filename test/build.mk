@@ -22,6 +22,7 @@ test-list-host  = aes
 test-list-host += always_memset
 test-list-host += battery_config
 test-list-host += battery_get_params_smart
+test-list-host += battery_get_params_smart_tiered
 test-list-host += benchmark
 test-list-host += bklight_lid
 test-list-host += bklight_passthru
@@ -32,6 +33,7 @@ test-list-host += cbi
 test-list-host += cbi_wp
 test-list-host += charge_manager
 test-list-host += charge_manager_drp_charging
+test-list-host += charge_manager_refresh_window
 test-list-host += charge_ramp
 test-list-host += chipset
 test-list-host += compile_time_macros
@@ -41,6 +43,7 @@ test-list-host += debug_unimplemented
 test-list-host += entropy
 test-list-host += extpwr_gpio
 test-list-host += fan
+test-list-host += fan_pid
 test-list-host += flash
 test-list-host += float
 test-list-host += fp
@@ -58,10 +61,13 @@ test-list-host += fpsensor_state
 test-list-host += fpsensor_utils
 test-list-host += gettimeofday
 test-list-host += gyro_cal
+test-list-host += gyro_cal_int16
+test-list-host += gyro_cal_int16_fixed
 test-list-host += hooks
 test-list-host += host_command
 test-list-host += hyperdebug
 test-list-host += i2c_bitbang
+test-list-host += i2c_hid_touchpad
 test-list-host += inductive_charging
 # This test times out in the CQ, and generally doesn't seem useful.
 # It is verifying the host test scheduler, which is never used in real boards.
@@ -194,6 +200,7 @@ assert_stdlib-y=assert_stdlib.o
 base32-y=base32.o
 battery_config-y=battery_config.o
 battery_get_params_smart-y=battery_get_params_smart.o
+battery_get_params_smart_tiered-y=battery_get_params_smart.o
 benchmark-y=benchmark.o
 bklight_lid-y=bklight_lid.o
 bklight_passthru-y=bklight_passthru.o
@@ -204,6 +211,7 @@ cbi-y=cbi.o
 cbi_wp-y=cbi_wp.o
 charge_manager-y=charge_manager.o fake_usbc.o
 charge_manager_drp_charging-y=charge_manager.o fake_usbc.o
+charge_manager_refresh_window-y=charge_manager.o fake_usbc.o
 charge_ramp-y+=charge_ramp.o
 chipset-y+=chipset.o
 compile_time_macros-y=compile_time_macros.o
@@ -217,6 +225,7 @@ exception-y=exception.o
 exit-y=exit.o
 extpwr_gpio-y=extpwr_gpio.o
 fan-y=fan.o
+fan_pid-y=fan_pid.o
 flash-y=flash.o
 flash_physical-y=flash_physical.o
 flash_write_protect-y=flash_write_protect.o
@@ -237,10 +246,14 @@ ftrapv-y=ftrapv.o
 gettimeofday-y=gettimeofday.o
 global_initialization-y=global_initialization.o
 gyro_cal-y=gyro_cal.o gyro_cal_init_for_test.o
+gyro_cal_int16-y=gyro_cal_int16.o gyro_cal_init_for_test.o
+gyro_cal_int16_fixed-y=gyro_cal_int16.o gyro_cal_init_for_test.o \
+	gyro_cal_fixed.o
 hooks-y=hooks.o
 host_command-y=host_command.o
 hyperdebug-y=hyperdebug.o
 i2c_bitbang-y=i2c_bitbang.o
+i2c_hid_touchpad-y=i2c_hid_touchpad.o
 inductive_charging-y=inductive_charging.o
 interrupt-y=interrupt.o
 irq_locking-y=irq_locking.o
@@ -792,6 +792,66 @@ static int test_unknown_dualrole_capability(void)
 	return EC_SUCCESS;
 }
 
+/*
+ * Replay an attach sequence (BC1.2, then Type-C current, then a PD contract)
+ * on a port.
+ */
+static void attach_charger(int port, int wait)
+{
+	struct charge_port_info charge;
+
+	charge.voltage = 5000;
+	charge.current = 1500;
+	charge_manager_update_charge(CHARGE_SUPPLIER_TEST7, port, &charge);
+	if (wait)
+		wait_for_charge_manager_refresh();
+	charge.current = 2000;
+	charge_manager_update_charge(CHARGE_SUPPLIER_TEST5, port, &charge);
+	if (wait)
+		wait_for_charge_manager_refresh();
+	charge.voltage = 9000;
+	charge.current = 3000;
+	charge_manager_update_charge(CHARGE_SUPPLIER_TEST2, port, &charge);
+	if (wait)
+		wait_for_charge_manager_refresh();
+}
+
+static int test_refresh_coalescing(void)
+{
+	struct charge_manager_refresh_stats before, after;
+	int port = 1;
+	int serial_port, serial_limit;
+
+	/* Updates reported one at a time each get their own refresh */
+	initialize_charge_table(0, 5000, 5000);
+	charge_manager_get_refresh_stats(&before);
+	attach_charger(port, 1);
+	charge_manager_get_refresh_stats(&after);
+	TEST_EQ(after.requests - before.requests, 3, "%u");
+	TEST_EQ(after.refreshes - before.refreshes, 3, "%u");
+	serial_port = active_charge_port;
+	serial_limit = active_charge_limit;
+	TEST_EQ(serial_port, port, "%d");
+	TEST_EQ(serial_limit, 3000, "%d");
+
+	/* A burst of the same updates is handled by a single refresh */
+	initialize_charge_table(0, 5000, 5000);
+	TEST_ASSERT(active_charge_port == CHARGE_PORT_NONE);
+	charge_manager_get_refresh_stats(&before);
+	attach_charger(port, 0);
+	wait_for_charge_manager_refresh();
+	charge_manager_get_refresh_stats(&after);
+	TEST_EQ(after.requests - before.requests, 3, "%u");
+	TEST_EQ(after.refreshes - before.refreshes, 1, "%u");
+	TEST_EQ(after.port_changes - before.port_changes, 1, "%u");
+
+	/* ...and reaches the same decision */
+	TEST_EQ(active_charge_port, serial_port, "%d");
+	TEST_EQ(active_charge_limit, serial_limit, "%d");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	test_reset();
@@ -805,6 +865,9 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_dual_role);
 	RUN_TEST(test_rejected_port);
 	RUN_TEST(test_unknown_dualrole_capability);
+	/* Refreshes are only coalesced over a window */
+	if (CONFIG_CHARGE_MANAGER_REFRESH_WINDOW_MS)
+		RUN_TEST(test_refresh_coalescing);
 
 	/* Some handlers are still running after the test ends. */
 	crec_sleep(2);
@@ -9,8 +9,10 @@
 #include "charge_ramp.h"
 #include "common.h"
 #include "console.h"
+#include "ec_commands.h"
 #include "gpio.h"
 #include "hooks.h"
+#include "host_command.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -49,6 +51,12 @@ int chg_ramp_allowed(int port, int supplier)
 	return supplier > CHARGE_SUPPLIER_TEST3;
 }
 
+/* Binary search for TEST9 and TEST10 */
+int chg_ramp_search_allowed(int port, int supplier)
+{
+	return supplier >= CHARGE_SUPPLIER_TEST9;
+}
+
 int chg_ramp_max(int port, int supplier, int sup_curr)
 {
 	if (supplier == CHARGE_SUPPLIER_TEST7)
@@ -123,6 +131,33 @@ static int is_in_range(int x, int min, int max)
 	return x >= min && x <= max;
 }
 
+static void clear_history(int port)
+{
+	struct ec_params_chg_ramp_history p = {
+		.port = port,
+		.flags = EC_CHG_RAMP_HISTORY_FLAG_CLEAR,
+	};
+
+	test_send_host_command(EC_CMD_CHG_RAMP_HISTORY, 0, &p, sizeof(p), NULL,
+			       0);
+}
+
+/* Return the number of ramps recorded, and the most recent one in *last */
+static int read_history(int port, struct ec_chg_ramp_history_entry *last)
+{
+	struct ec_params_chg_ramp_history p = { .port = port };
+	uint8_t buf[256];
+	struct ec_response_chg_ramp_history *r = (void *)buf;
+
+	if (test_send_host_command(EC_CMD_CHG_RAMP_HISTORY, 0, &p, sizeof(p),
+				   buf, sizeof(buf)) != EC_RES_SUCCESS ||
+	    !r->count)
+		return 0;
+
+	*last = r->entries[r->count - 1];
+	return r->total;
+}
+
 /* Tests */
 
 static int test_no_ramp(void)
@@ -496,6 +531,81 @@ static int test_ramp_limit(void)
 	return EC_SUCCESS;
 }
 
+static int test_search_full_ramp(void)
+{
+	struct ec_chg_ramp_history_entry e;
+
+	clear_history(0);
+	system_load_current_ma = 3000;
+	plug_charger(CHARGE_SUPPLIER_TEST9, 0, 500, 3000, 3000);
+	crec_usleep(CHARGE_DETECT_DELAY_TEST);
+	TEST_ASSERT(wait_stable_no_overcurrent());
+	TEST_ASSERT(charge_limit_ma == 3000);
+
+	TEST_EQ(read_history(0, &e), 1, "%d");
+	TEST_EQ(e.method, EC_CHG_RAMP_METHOD_SEARCH, "%d");
+	TEST_EQ(e.result, EC_CHG_RAMP_RESULT_MAX, "%d");
+	TEST_EQ(e.icl_ma, 3000, "%d");
+	TEST_EQ(e.supplier, CHARGE_SUPPLIER_TEST9, "%d");
+	/* Stepping up by 64 mA would take 40 steps */
+	TEST_LE(e.steps, 8, "%d");
+
+	TEST_ASSERT(unplug_charger_and_check());
+	return EC_SUCCESS;
+}
+
+static int test_search_vbus_droop(void)
+{
+	struct ec_chg_ramp_history_entry e;
+
+	clear_history(0);
+	system_load_current_ma = 3000;
+	/* VBUS droops above 1.5A; probing above that must back off */
+	plug_charger(CHARGE_SUPPLIER_TEST9, 0, 500, 1500, 3000);
+
+	TEST_ASSERT(wait_stable_no_overcurrent());
+	TEST_ASSERT(is_in_range(charge_limit_ma, 1300, 1500));
+
+	TEST_EQ(read_history(0, &e), 1, "%d");
+	TEST_EQ(e.result, EC_CHG_RAMP_RESULT_VBUS_LOW, "%d");
+	TEST_EQ(e.icl_ma, charge_limit_ma, "%d");
+	TEST_LE(e.steps, 8, "%d");
+
+	TEST_ASSERT(unplug_charger_and_check());
+	return EC_SUCCESS;
+}
+
+static int test_search_collapse(void)
+{
+	struct ec_chg_ramp_history_entry e;
+	int overcurrent_count = 0;
+
+	clear_history(0);
+	system_load_current_ma = 3000;
+	/* The charger shuts down above 1.5A without VBUS drooping first */
+	plug_charger(CHARGE_SUPPLIER_TEST10, 0, 500, 3000, 1500);
+	crec_usleep(CHARGE_DETECT_DELAY_TEST);
+
+	while (task_wait_event(RAMP_STABLE_DELAY) == TASK_EVENT_OVERCURRENT) {
+		/* Charger goes away but comes back after 0.6 seconds */
+		unplug_charger();
+		crec_usleep(MSEC * 600);
+		plug_charger(CHARGE_SUPPLIER_TEST10, 0, 500, 3000, 1500);
+		crec_usleep(CHARGE_DETECT_DELAY_TEST);
+		TEST_LE(++overcurrent_count, 3, "%d");
+	}
+
+	TEST_ASSERT(is_in_range(charge_limit_ma, 1300, 1500));
+
+	/* Each collapse interrupted a search, the last ramp settled */
+	TEST_EQ(read_history(0, &e), overcurrent_count + 1, "%d");
+	TEST_EQ(e.result, EC_CHG_RAMP_RESULT_OVERCURRENT, "%d");
+	TEST_EQ(e.icl_ma, charge_limit_ma, "%d");
+
+	TEST_ASSERT(unplug_charger_and_check());
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	test_reset();
@@ -520,6 +630,9 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_vbus_shift);
 	RUN_TEST(test_equal_priority_overcurrent);
 	RUN_TEST(test_ramp_limit);
+	RUN_TEST(test_search_full_ramp);
+	RUN_TEST(test_search_vbus_droop);
+	RUN_TEST(test_search_collapse);
 
 	test_print_result();
 }
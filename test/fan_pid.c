@@ -0,0 +1,303 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test the closed-loop fan controller against a simulated fan.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "fan.h"
+#include "hooks.h"
+#include "host_command.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+void set_thermal_control_enabled(int fan, int enable);
+
+/*****************************************************************************/
+/* Fan plant model */
+
+/*
+ * The fan doesn't turn below PLANT_DEAD_ZONE % duty, then speeds up linearly
+ * to a little over rpm_max, settling with a PLANT_TAU_MS time constant. This
+ * is deliberately different from the controller's feed-forward (RPM
+ * proportional to duty, rpm_max at 100 %) so the feedback terms have work to
+ * do.
+ */
+#define PLANT_DEAD_ZONE 8
+#define PLANT_RPM_PER_PCT 56
+#define PLANT_TAU_MS 500
+
+static int plant_duty;
+static double plant_rpm;
+static timestamp_t plant_time;
+static bool plant_stuck;
+
+static void plant_advance(void)
+{
+	timestamp_t now = get_time();
+	int steady = 0;
+
+	if (!plant_stuck && plant_duty > PLANT_DEAD_ZONE)
+		steady = (plant_duty - PLANT_DEAD_ZONE) * PLANT_RPM_PER_PCT;
+
+	for (; plant_time.val + MSEC <= now.val; plant_time.val += MSEC)
+		plant_rpm += (steady - plant_rpm) / PLANT_TAU_MS;
+	if (plant_stuck)
+		plant_rpm = 0;
+}
+
+void fan_set_duty(int ch, int percent)
+{
+	plant_advance();
+	plant_duty = percent;
+}
+
+int fan_get_duty(int ch)
+{
+	return plant_duty;
+}
+
+int fan_get_rpm_actual(int ch)
+{
+	plant_advance();
+	return (int)plant_rpm;
+}
+
+static void plant_reset(void)
+{
+	plant_duty = 0;
+	plant_rpm = 0;
+	plant_stuck = false;
+	plant_time = get_time();
+}
+
+/*****************************************************************************/
+/* Helpers */
+
+static int read_trace(struct ec_fan_pid_trace_entry *entries, int max)
+{
+	struct ec_params_fan_pid_trace p = { .fan_idx = 0 };
+	uint8_t buf[256];
+	struct ec_response_fan_pid_trace *r = (void *)buf;
+	int n = 0;
+
+	do {
+		if (test_send_host_command(EC_CMD_FAN_PID_TRACE, 0, &p,
+					   sizeof(p), buf,
+					   sizeof(buf)) != EC_RES_SUCCESS)
+			return -1;
+		memcpy(entries + n, r->entries,
+		       MIN(r->count, max - n) * sizeof(*entries));
+		n += MIN(r->count, max - n);
+		p.offset += r->count;
+	} while (r->count && p.offset < r->total && n < max);
+
+	return n;
+}
+
+static void clear_trace(void)
+{
+	struct ec_params_fan_pid_trace p = {
+		.fan_idx = 0,
+		.flags = EC_FAN_PID_TRACE_FLAG_CLEAR,
+	};
+
+	test_send_host_command(EC_CMD_FAN_PID_TRACE, 0, &p, sizeof(p), NULL,
+			       0);
+}
+
+static void stop_fan(void)
+{
+	fan_set_percent_needed(0, 0);
+	crec_msleep(200);
+	set_thermal_control_enabled(0, 0);
+	plant_reset();
+	clear_trace();
+}
+
+/*****************************************************************************/
+/* Tests */
+
+static int test_step_response(void)
+{
+	const int pct = 50;
+	const int target = fan_percent_to_rpm(0, pct);
+	const int band = target * 2 / 100;
+	int settle_ms = 0, peak = 0, rpm, t;
+
+	set_thermal_control_enabled(0, 1);
+	fan_set_percent_needed(0, pct);
+	TEST_EQ(fan_pid_get_target(0), target, "%d");
+
+	for (t = 50; t <= 6000; t += 50) {
+		crec_msleep(50);
+		rpm = fan_get_rpm_actual(0);
+		peak = MAX(peak, rpm);
+		if (ABS(rpm - target) > band)
+			settle_ms = t;
+	}
+
+	/* Settles within 2% in under 2 s, reaching the target ... */
+	TEST_GT(settle_ms, 0, "%d");
+	TEST_LE(settle_ms, 2000, "%d");
+	TEST_GE(peak, target, "%d");
+	/* ... with an overshoot of at most 3% */
+	TEST_LE(peak, target + target * 3 / 100, "%d");
+	TEST_ASSERT(!fan_pid_is_stalled(0));
+
+	stop_fan();
+	return EC_SUCCESS;
+}
+
+static int test_ramp_limit(void)
+{
+	static struct ec_fan_pid_trace_entry entries[64];
+	const int step = CONFIG_FAN_PID_RAMP_RPM_PER_SEC *
+			 CONFIG_FAN_PID_PERIOD_MS / 1000;
+	int n, i;
+
+	set_thermal_control_enabled(0, 1);
+	fan_set_percent_needed(0, 100);
+	crec_msleep(3000);
+
+	n = read_trace(entries, ARRAY_SIZE(entries));
+	TEST_GE(n, 20, "%d");
+
+	/* The first update kicks the fan at its start speed */
+	TEST_EQ(entries[0].setpoint_rpm, fans[0].rpm->rpm_start, "%d");
+	for (i = 1; i < n; i++) {
+		TEST_EQ(entries[i].target_rpm, fans[0].rpm->rpm_max, "%d");
+		TEST_LE(entries[i].setpoint_rpm - entries[i - 1].setpoint_rpm,
+			step, "%d");
+		TEST_LE(entries[i].duty, 100, "%d");
+		TEST_GE(entries[i].time_us - entries[i - 1].time_us,
+			CONFIG_FAN_PID_PERIOD_MS * MSEC, "%u");
+	}
+	TEST_EQ(entries[n - 1].setpoint_rpm, fans[0].rpm->rpm_max, "%d");
+
+	/* Turning the fan off stops the loop */
+	fan_set_percent_needed(0, 0);
+	crec_msleep(500);
+	n = read_trace(entries, ARRAY_SIZE(entries));
+	TEST_EQ(entries[n - 1].setpoint_rpm, 0, "%d");
+	TEST_EQ(entries[n - 1].duty, 0, "%d");
+	TEST_EQ(plant_duty, 0, "%d");
+	crec_msleep(500);
+	TEST_EQ(read_trace(entries, ARRAY_SIZE(entries)), n, "%d");
+
+	stop_fan();
+	return EC_SUCCESS;
+}
+
+static int test_stall(void)
+{
+	uint16_t *mapped = (uint16_t *)host_get_memmap(EC_MEMMAP_FAN);
+
+	set_thermal_control_enabled(0, 1);
+	fan_set_percent_needed(0, 30);
+	crec_msleep(2000);
+	TEST_ASSERT(!fan_pid_is_stalled(0));
+
+	plant_stuck = true;
+	crec_msleep(CONFIG_FAN_PID_STALL_MS + 1000);
+	TEST_ASSERT(fan_pid_is_stalled(0));
+	/* The integral term pushes the stalled fan to full duty */
+	TEST_EQ(plant_duty, 100, "%d");
+	TEST_EQ(mapped[0], EC_FAN_SPEED_STALLED, "%d");
+
+	plant_stuck = false;
+	crec_msleep(2000);
+	TEST_ASSERT(!fan_pid_is_stalled(0));
+	TEST_NE(mapped[0], EC_FAN_SPEED_STALLED, "%d");
+
+	stop_fan();
+	return EC_SUCCESS;
+}
+
+static int test_manual_override(void)
+{
+	set_thermal_control_enabled(0, 1);
+	fan_set_percent_needed(0, 50);
+	crec_msleep(1000);
+
+	/* Manual duty takes the fan away from the control loop */
+	set_thermal_control_enabled(0, 0);
+	fan_set_duty(0, 20);
+	crec_msleep(500);
+	TEST_EQ(plant_duty, 20, "%d");
+	fan_set_percent_needed(0, 80);
+	crec_msleep(500);
+	TEST_EQ(plant_duty, 20, "%d");
+
+	stop_fan();
+	return EC_SUCCESS;
+}
+
+static int read_trace_page(uint16_t offset,
+			   struct ec_response_fan_pid_trace *r, int size)
+{
+	struct ec_params_fan_pid_trace p = {
+		.fan_idx = 0,
+		.offset = offset,
+	};
+
+	return test_send_host_command(EC_CMD_FAN_PID_TRACE, 0, &p, sizeof(p),
+				      r, size);
+}
+
+static int test_trace_wrap(void)
+{
+	const int capacity = CONFIG_FAN_PID_TRACE_CAPACITY;
+	uint8_t buf[256];
+	struct ec_response_fan_pid_trace *r = (void *)buf;
+	struct ec_fan_pid_trace_entry newest;
+	uint32_t first;
+
+	/* A cleared trace numbers its entries from 0 again */
+	TEST_EQ(read_trace_page(0, r, sizeof(buf)), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->first, 0, "%u");
+	TEST_EQ(r->total, 0, "%d");
+
+	/* Log more entries than the trace holds */
+	set_thermal_control_enabled(0, 1);
+	fan_set_percent_needed(0, 50);
+	crec_msleep((capacity + 10) * CONFIG_FAN_PID_PERIOD_MS);
+
+	TEST_EQ(read_trace_page(capacity - 1, r, sizeof(buf)), EC_RES_SUCCESS,
+		"%d");
+	TEST_EQ(r->total, capacity, "%d");
+	TEST_EQ(r->count, 1, "%d");
+	TEST_GE(r->first, 10, "%u");
+	first = r->first;
+	newest = r->entries[0];
+
+	/* Newer entries push the oldest out, and shift the newest down */
+	crec_msleep(3 * CONFIG_FAN_PID_PERIOD_MS);
+	TEST_EQ(read_trace_page(0, r, sizeof(buf)), EC_RES_SUCCESS, "%d");
+	TEST_GT(r->first, first, "%u");
+	TEST_LT(r->first - first, capacity, "%u");
+	TEST_EQ(read_trace_page(first + capacity - 1 - r->first, r,
+				sizeof(buf)),
+		EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->entries[0].time_us, newest.time_us, "%u");
+
+	stop_fan();
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, const char **argv)
+{
+	plant_reset();
+
+	RUN_TEST(test_step_response);
+	RUN_TEST(test_ramp_limit);
+	RUN_TEST(test_stall);
+	RUN_TEST(test_manual_override);
+	RUN_TEST(test_trace_wrap);
+
+	test_print_result();
+}
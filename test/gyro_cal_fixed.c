@@ -0,0 +1,16 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * The gyroscope calibration, built in fixed point. CONFIG_ONLINE_CALIB, which
+ * normally builds it, requires an FPU.
+ */
+
+/*
+ * Explicitly include common.h to populate predefined macros in test_config.h
+ * early. e.g. CONFIG_FPU, which is needed in math_util.h.
+ */
+#include "common.h"
+
+#include "../common/gyro_cal.c"
+#include "../common/gyro_still_det.c"
@@ -31,15 +31,15 @@ static void gyro_still_det_initialization_for_test(struct gyro_still_det *det,
 	 * of the stillness confidence score.
 	 */
 	if (confidence_delta < var_threshold)
-		det->confidence_delta = confidence_delta;
+		det->confidence_delta = FLOAT_TO_FP(confidence_delta);
 	else
-		det->confidence_delta = var_threshold;
+		det->confidence_delta = FLOAT_TO_FP(var_threshold);
 
 	/*
 	 * Set the variance threshold parameter for the stillness
 	 * confidence score.
 	 */
-	det->var_threshold = var_threshold;
+	det->var_threshold = FLOAT_TO_FP(var_threshold);
 
 	/* Signal to start capture of next stillness data window. */
 	det->start_new_window = true;
@@ -82,13 +82,13 @@ void gyro_cal_initialization_for_test(struct gyro_cal *gyro_cal)
 	gyro_cal->gyro_window_timeout_duration_us = 5 * SECOND;
 
 	/* Load the last valid cal from system memory. */
-	gyro_cal->bias_x = 0.0f; /* [rad/sec] */
-	gyro_cal->bias_y = 0.0f; /* [rad/sec] */
-	gyro_cal->bias_z = 0.0f; /* [rad/sec] */
+	gyro_cal->bias_x = FLOAT_TO_FP(0.0f); /* [rad/sec] */
+	gyro_cal->bias_y = FLOAT_TO_FP(0.0f); /* [rad/sec] */
+	gyro_cal->bias_z = FLOAT_TO_FP(0.0f); /* [rad/sec] */
 	gyro_cal->calibration_time_us = 0;
 
 	/* Set the stillness threshold required for gyro bias calibration. */
-	gyro_cal->stillness_threshold = 0.95f;
+	gyro_cal->stillness_threshold = FLOAT_TO_FP(0.95f);
 
 	/*
 	 * Current window end-time used to assist in keeping sensor data
@@ -105,10 +105,11 @@ void gyro_cal_initialization_for_test(struct gyro_cal *gyro_cal)
 	 * Sets the stability limit for the stillness window mean acceptable
 	 * delta.
 	 */
-	gyro_cal->stillness_mean_delta_limit = 50.0f * MDEG_TO_RAD;
+	gyro_cal->stillness_mean_delta_limit =
+		FLOAT_TO_FP(50.0f * MDEG_TO_RAD);
 
 	/* Sets the min/max temperature delta limit for the stillness period. */
-	gyro_cal->temperature_delta_limit_kelvin = 1.5f;
+	gyro_cal->temperature_delta_limit_kelvin = FLOAT_TO_FP(1.5f);
 
 	/* Ensures that the data tracking functionality is reset. */
 	init_gyro_cal(gyro_cal);
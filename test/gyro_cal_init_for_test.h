@@ -9,6 +9,10 @@
 #include "gyro_cal.h"
 #include "gyro_still_det.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Initialization function used for testing the gyroscope calibration.
  * This function will initialize to the following values:
@@ -36,4 +40,8 @@
  */
 void gyro_cal_initialization_for_test(struct gyro_cal *gyro_cal);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* __CROS_EC_GYRO_CAL_INIT_FOR_TEST */
@@ -0,0 +1,255 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Check the gyroscope online calibration fed raw samples, converted with the
+ * per-range factors, against the per-sample division it replaced, and measure
+ * the per-sample cost of both.  Built both with an FPU (gyro_cal_int16) and in
+ * fixed point (gyro_cal_int16_fixed).
+ */
+
+/*
+ * Explicitly include common.h to populate predefined macros in test_config.h
+ * early. e.g. CONFIG_FPU, which is needed in math_util.h.
+ */
+#include "common.h"
+#include "benchmark.h"
+#include "gyro_cal.h"
+#include "gyro_cal_init_for_test.h"
+#include "motion_sense.h"
+#include "test_util.h"
+#include "vec3.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+struct motion_sensor_t motion_sensors[2] = {};
+
+const unsigned int motion_sensor_count = ARRAY_SIZE(motion_sensors);
+
+/* Ten seconds of samples at 400 Hz, a bias is ready after about 6 */
+constexpr int kNumSamples = 4000;
+constexpr uint32_t kPeriodUs = 2500;
+/* Full scale of the gyroscope [rad/sec], about 2000 dps */
+constexpr int kGyroRange = 35;
+/* Full scale of the accelerometer [g] */
+constexpr int kAccelRange = 4;
+constexpr int kTemperatureKelvin = 298;
+/* A still gyroscope: a bias of kGyroBias LSB plus noise */
+constexpr int kGyroBias = 8;
+/* About a fixed point LSB, far above the float rounding errors */
+constexpr float kTolerance = 2e-5f;
+
+static int16_t gyro_samples[kNumSamples][3];
+static int16_t accel_samples[kNumSamples][3];
+
+/*
+ * The conversion online_calibration.c used, with a division per axis. It is
+ * done in float here: in fixed point, INT_TO_FP(0x8000) overflowed and
+ * negative samples came out positive.
+ */
+static void data_int16_to_fp_div(const int16_t *data, int range, fpv3_t out)
+{
+	for (int i = 0; i < 3; ++i) {
+		float v = (float)data[i] / ((data[i] >= 0) ? 0x7fff : 0x8000);
+
+		out[i] = FLOAT_TO_FP(CLAMP(v * range, -range, range));
+	}
+}
+
+/*
+ * The conversion as online_calibration.c had it, in fp_t, only to time it: in
+ * fixed point, INT_TO_FP(0x8000) overflows.
+ */
+static void data_int16_to_fp_old(const int16_t *data, int range, fpv3_t out)
+{
+	fp_t r = INT_TO_FP(range);
+
+	for (int i = 0; i < 3; ++i) {
+		fp_t v = INT_TO_FP((int32_t)data[i]);
+
+		out[i] = fp_div(v, INT_TO_FP((data[i] >= 0) ? 0x7fff : 0x8000));
+		out[i] = fp_mul(out[i], r);
+		out[i] = CLAMP(out[i], -r, r);
+	}
+}
+
+test_static int test_conversion()
+{
+	static const int16_t full_scale[3] = { 0x7fff, -0x8000, 0 };
+	static const int16_t small[3] = { 1, -1, 0x4000 };
+	struct fpv3_int16_scale scale;
+	fpv3_t v, ref;
+
+	fpv3_int16_scale_init(&scale, kGyroRange);
+
+	/* Full scale maps to the range */
+	fpv3_from_int16(v, full_scale, &scale);
+	TEST_NEAR(FP_TO_FLOAT(v[X]), (float)kGyroRange, kTolerance, "%f");
+	TEST_NEAR(FP_TO_FLOAT(v[Y]), (float)-kGyroRange, kTolerance, "%f");
+	TEST_EQ(FP_TO_FLOAT(v[Z]), 0.0f, "%f");
+
+	fpv3_from_int16(v, small, &scale);
+	data_int16_to_fp_div(small, kGyroRange, ref);
+	for (int k = X; k <= Z; k++)
+		TEST_NEAR(FP_TO_FLOAT(v[k]), FP_TO_FLOAT(ref[k]), kTolerance,
+			  "%f");
+
+	for (const auto &sample : gyro_samples) {
+		fpv3_from_int16(v, sample, &scale);
+		data_int16_to_fp_div(sample, kGyroRange, ref);
+		for (int k = X; k <= Z; k++)
+			TEST_NEAR(FP_TO_FLOAT(v[k]), FP_TO_FLOAT(ref[k]),
+				  kTolerance, "%f");
+	}
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Run the calibration over all the samples, converted one way or the other,
+ * and return the bias found.
+ */
+static int run_gyro_cal(bool divide, fpv3_t bias, uint32_t *time_us)
+{
+	struct gyro_cal gyro_cal;
+	struct fpv3_int16_scale gyro_scale, accel_scale;
+	int temperature_kelvin;
+	uint32_t t = 0;
+	fpv3_t g, a;
+
+	fpv3_int16_scale_init(&gyro_scale, kGyroRange);
+	fpv3_int16_scale_init(&accel_scale, kAccelRange);
+	gyro_cal_initialization_for_test(&gyro_cal);
+
+	for (int i = 0; i < kNumSamples; i++, t += kPeriodUs) {
+		if (divide) {
+			data_int16_to_fp_div(accel_samples[i], kAccelRange, a);
+			data_int16_to_fp_div(gyro_samples[i], kGyroRange, g);
+		} else {
+			fpv3_from_int16(a, accel_samples[i], &accel_scale);
+			fpv3_from_int16(g, gyro_samples[i], &gyro_scale);
+		}
+		gyro_cal_update_accel(&gyro_cal, t, a[X], a[Y], a[Z]);
+		gyro_cal_update_gyro(&gyro_cal, t, g[X], g[Y], g[Z],
+				     kTemperatureKelvin);
+	}
+
+	TEST_ASSERT(gyro_cal_new_bias_available(&gyro_cal));
+	gyro_cal_get_bias(&gyro_cal, bias, &temperature_kelvin, time_us);
+	TEST_EQ(temperature_kelvin, kTemperatureKelvin, "%d");
+
+	return EC_SUCCESS;
+}
+
+test_static int test_gyro_cal()
+{
+	fpv3_t bias, bias_div;
+	uint32_t time_us, time_div_us;
+	float expected = (float)kGyroRange * kGyroBias / 0x7fff;
+
+	TEST_EQ(run_gyro_cal(true, bias_div, &time_div_us), EC_SUCCESS, "%d");
+	TEST_EQ(run_gyro_cal(false, bias, &time_us), EC_SUCCESS, "%d");
+
+	/* The same calibration, at the same time, as with the division */
+	TEST_EQ(time_us, time_div_us, "%u");
+	for (int k = X; k <= Z; k++) {
+		TEST_NEAR(FP_TO_FLOAT(bias[k]), FP_TO_FLOAT(bias_div[k]),
+			  kTolerance, "%f");
+		TEST_NEAR(FP_TO_FLOAT(bias[k]), expected, expected / 10, "%f");
+	}
+
+	return EC_SUCCESS;
+}
+
+/* The mean of the samples since the last reset is kept as prev_mean */
+test_static int test_still_det_reset()
+{
+	struct gyro_still_det still_det = {};
+	const fp_t v[3] = { FLOAT_TO_FP(0.25f), FLOAT_TO_FP(-0.5f),
+			    FLOAT_TO_FP(0.125f) };
+	uint32_t t = 0;
+
+	still_det.start_new_window = true;
+	for (int i = 0; i < 100; i++, t += kPeriodUs)
+		gyro_still_det_update(&still_det, 0, t, v[X], v[Y], v[Z]);
+	gyro_still_det_reset(&still_det, true);
+
+	TEST_EQ(still_det.num_acc_samples, 0U, "%u");
+	/* The reciprocal of the count is rounded in fixed point */
+	for (int k = X; k <= Z; k++)
+		TEST_NEAR(FP_TO_FLOAT(still_det.prev_mean[k]),
+			  FP_TO_FLOAT(v[k]), 1e-3f, "%f");
+
+	return EC_SUCCESS;
+}
+
+/* Time the gyroscope calibration update of a sample with either conversion */
+test_static int benchmark_per_sample()
+{
+	Benchmark benchmark({ .num_iterations = 20 });
+	struct fpv3_int16_scale scale;
+	struct gyro_cal gyro_cal;
+	uint32_t t = 0;
+
+	fpv3_int16_scale_init(&scale, kGyroRange);
+
+	gyro_cal_initialization_for_test(&gyro_cal);
+	auto divided = benchmark.run("divided", [&] {
+		fpv3_t g;
+
+		for (int i = 0; i < kNumSamples; i++, t += kPeriodUs) {
+			data_int16_to_fp_old(gyro_samples[i], kGyroRange, g);
+			gyro_cal_update_gyro(&gyro_cal, t, g[X], g[Y], g[Z],
+					     kTemperatureKelvin);
+		}
+	});
+
+	gyro_cal_initialization_for_test(&gyro_cal);
+	auto scaled = benchmark.run("scaled", [&] {
+		fpv3_t g;
+
+		for (int i = 0; i < kNumSamples; i++, t += kPeriodUs) {
+			fpv3_from_int16(g, gyro_samples[i], &scale);
+			gyro_cal_update_gyro(&gyro_cal, t, g[X], g[Y], g[Z],
+					     kTemperatureKelvin);
+		}
+	});
+
+	TEST_ASSERT(divided.has_value());
+	TEST_ASSERT(scaled.has_value());
+
+	benchmark.print_results();
+	BenchmarkResult::compare(*divided, *scaled);
+	ccprintf("Per sample (ns): %u divided, %u scaled\n",
+		 divided->average_time * 1000 / kNumSamples,
+		 scaled->average_time * 1000 / kNumSamples);
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, const char **argv)
+{
+	std::srand(1);
+	for (int i = 0; i < kNumSamples; i++) {
+		for (int k = X; k <= Z; k++) {
+			gyro_samples[i][k] = kGyroBias + std::rand() % 9 - 4;
+			accel_samples[i][k] = std::rand() % 17 - 8;
+		}
+		/* 1g down Z */
+		accel_samples[i][Z] += 0x8000 / kAccelRange;
+	}
+
+	test_reset();
+	RUN_TEST(test_conversion);
+	RUN_TEST(test_still_det_reset);
+	RUN_TEST(test_gyro_cal);
+	RUN_TEST(benchmark_per_sample);
+	test_print_result();
+}
+
+/* Mock out mkbp_send_event, should a calibration complete. */
+int mkbp_send_event(uint8_t event_type)
+{
+	return 1;
+}
@@ -7,7 +7,11 @@
 
 #include "common.h"
 #include "console.h"
+#include "ec_commands.h"
 #include "hooks.h"
+#include "host_command.h"
+#include "system_boot_time.h"
+#include "task.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
@@ -172,6 +176,102 @@ static int test_repeating_deferred(void)
 	return EC_SUCCESS;
 }
 
+static int read_boot_time(struct ec_boot_time_entry *entries, int max,
+			  int *dropped)
+{
+	struct ec_params_boot_time_profile p = {};
+	static uint8_t buf[256];
+	struct ec_response_boot_time_profile *r = (void *)buf;
+	int n = 0;
+
+	do {
+		if (test_send_host_command(EC_CMD_BOOT_TIME_PROFILE, 0, &p,
+					   sizeof(p), buf,
+					   sizeof(buf)) != EC_RES_SUCCESS)
+			return -1;
+		memcpy(entries + n, r->entries,
+		       MIN(r->count, max - n) * sizeof(*entries));
+		n += MIN(r->count, max - n);
+		p.offset += r->count;
+	} while (r->count && p.offset < r->total && n < max);
+
+	*dropped = r->dropped;
+	return n;
+}
+
+static int find_entry(const struct ec_boot_time_entry *entries, int n,
+		      enum ec_boot_time_event event, uint8_t flags,
+		      uint32_t data)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (entries[i].event == event && entries[i].flags == flags &&
+		    entries[i].data == data)
+			return i;
+	}
+	return -1;
+}
+
+static int test_boot_time_profile(void)
+{
+	static struct ec_boot_time_entry
+		entries[CONFIG_BOOT_TIME_PROFILE_ENTRIES];
+	struct ec_params_boot_time_profile p = {
+		.flags = EC_BOOT_TIME_PROFILE_FLAG_CLEAR,
+	};
+	int n, dropped, early, begin, end, hook_begin, hook_end, i;
+
+	n = read_boot_time(entries, ARRAY_SIZE(entries), &dropped);
+	TEST_GT(n, 0, "%d");
+
+	/* HOOK_INIT_EARLY runs before the scheduler, HOOK_INIT after */
+	early = find_entry(entries, n, EC_BOOT_TIME_EVENT_STAGE,
+			   EC_BOOT_TIME_END, EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY);
+	begin = find_entry(entries, n, EC_BOOT_TIME_EVENT_STAGE,
+			   EC_BOOT_TIME_BEGIN, EC_BOOT_TIME_STAGE_HOOK_INIT);
+	end = find_entry(entries, n, EC_BOOT_TIME_EVENT_STAGE,
+			 EC_BOOT_TIME_END, EC_BOOT_TIME_STAGE_HOOK_INIT);
+	TEST_GE(early, 0, "%d");
+	TEST_GT(begin, early, "%d");
+	TEST_GT(end, begin, "%d");
+	TEST_GT(find_entry(entries, n, EC_BOOT_TIME_EVENT_TASK_START, 0,
+			   TASK_ID_HOOKS),
+		early, "%d");
+
+	/* Each HOOK_INIT routine is timed inside the HOOK_INIT stage */
+	hook_begin = find_entry(entries, n, EC_BOOT_TIME_EVENT_HOOK_INIT,
+				EC_BOOT_TIME_BEGIN, (uintptr_t)init_hook);
+	hook_end = find_entry(entries, n, EC_BOOT_TIME_EVENT_HOOK_INIT,
+			      EC_BOOT_TIME_END, (uintptr_t)init_hook);
+	TEST_GT(hook_begin, begin, "%d");
+	TEST_EQ(hook_end, hook_begin + 1, "%d");
+	TEST_LT(hook_end, end, "%d");
+	for (i = begin; i < end; i++)
+		TEST_GE((int32_t)(entries[i + 1].time_us - entries[i].time_us),
+			0, "%d");
+
+	/* Clearing re-arms the table */
+	TEST_EQ(test_send_host_command(EC_CMD_BOOT_TIME_PROFILE, 0, &p,
+				       sizeof(p), NULL, 0),
+		EC_RES_SUCCESS, "%d");
+	update_ap_boot_time(PLTRST_HIGH);
+	n = read_boot_time(entries, ARRAY_SIZE(entries), &dropped);
+	TEST_EQ(n, 1, "%d");
+	TEST_EQ(entries[0].event, EC_BOOT_TIME_EVENT_AP, "%d");
+	TEST_EQ(entries[0].data, PLTRST_HIGH, "%u");
+
+	/* Once full, later events are dropped rather than older ones */
+	for (i = 0; i < CONFIG_BOOT_TIME_PROFILE_ENTRIES + 4; i++)
+		boot_time_mark(EC_BOOT_TIME_EVENT_POWER_STATE, 0, i);
+	n = read_boot_time(entries, ARRAY_SIZE(entries), &dropped);
+	TEST_EQ(n, CONFIG_BOOT_TIME_PROFILE_ENTRIES, "%d");
+	TEST_EQ(dropped, 5, "%d");
+	TEST_EQ(entries[1].data, 0, "%u");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	test_reset();
@@ -181,6 +281,7 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_ticks);
 	RUN_TEST(test_priority);
 	RUN_TEST(test_deferred);
+	RUN_TEST(test_boot_time_profile);
 	RUN_TEST(test_repeating_deferred);
 
 	test_print_result();
@@ -0,0 +1,205 @@
+/* Copyright 2024 The ChromiumOS Authors
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the I2C HID touchpad input report queue.
+ */
+#include "common.h"
+#include "i2c_hid_touchpad.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define QUEUE_SIZE CONFIG_I2C_HID_TOUCHPAD_QUEUE_SIZE
+
+/* Mouse report: header, buttons, X, Y */
+#define MOUSE_REPORT_LEN (3 + 3)
+
+static uint8_t buffer[512];
+static int response_len;
+
+static void send_response(int len)
+{
+	response_len = len;
+}
+
+static int process(const uint8_t *request, int len)
+{
+	uint8_t data;
+	int reg, cmd;
+
+	memcpy(buffer, request, len);
+	response_len = -1;
+	return i2c_hid_touchpad_process(len, buffer, send_response, &data,
+					&reg, &cmd);
+}
+
+/* Read the input register, as the host does after an interrupt */
+static int read_input(void)
+{
+	TEST_EQ(process(NULL, 0), EC_SUCCESS, "%d");
+	return response_len;
+}
+
+static void set_input_mode(uint8_t mode)
+{
+	/* SET_REPORT of the feature report 0x0C through the data register */
+	const uint8_t request[] = { 0x00, 0x30, 0x3c, 0x03, 0x00,
+				    0x30, 0x04, 0x00, 0x0c, mode };
+
+	process(request, sizeof(request));
+}
+
+static void reset_touchpad(void)
+{
+	const uint8_t reset[] = { 0x00, 0x30, 0x00, 0x01 };
+
+	i2c_hid_touchpad_init();
+	process(reset, sizeof(reset));
+	/* The host reads 2 empty bytes after a reset */
+	read_input();
+	i2c_hid_touchpad_clear_stats();
+}
+
+/* Finger 0 moves by n units in frame n, so mouse report n has X = n. */
+static bool compile_frame(int n)
+{
+	struct touchpad_event event = {};
+
+	event.finger[0].valid = true;
+	event.finger[0].x = 100 + n * (n + 1) / 2;
+	event.finger[0].y = 100;
+	return i2c_hid_compile_report(&event);
+}
+
+test_static int test_batching(void)
+{
+	struct i2c_hid_touchpad_stats stats;
+	int i;
+
+	reset_touchpad();
+	TEST_ASSERT(!i2c_hid_touchpad_has_report());
+
+	/* Only the first report of a batch needs to interrupt the host. */
+	TEST_ASSERT(compile_frame(0));
+	TEST_ASSERT(!compile_frame(1));
+	TEST_ASSERT(!compile_frame(2));
+	TEST_ASSERT(i2c_hid_touchpad_has_report());
+
+	for (i = 0; i < 3; i++) {
+		TEST_EQ(read_input(), MOUSE_REPORT_LEN, "%d");
+		TEST_EQ(buffer[0], MOUSE_REPORT_LEN, "%d");
+		TEST_EQ(buffer[2], 0x02, "%d");
+		TEST_EQ((int8_t)buffer[4], i, "%d");
+	}
+	TEST_ASSERT(!i2c_hid_touchpad_has_report());
+
+	/* Reading again repeats the latest report. */
+	TEST_EQ(read_input(), MOUSE_REPORT_LEN, "%d");
+	TEST_EQ((int8_t)buffer[4], 2, "%d");
+
+	i2c_hid_touchpad_get_stats(&stats);
+	TEST_EQ(stats.queued, 3, "%u");
+	TEST_EQ(stats.sent, 3, "%u");
+	TEST_EQ(stats.dropped, 0, "%u");
+	TEST_EQ(stats.repeated, 1, "%u");
+
+	/* The next frame starts a new batch. */
+	TEST_ASSERT(compile_frame(3));
+
+	return EC_SUCCESS;
+}
+
+test_static int test_overflow(void)
+{
+	struct i2c_hid_touchpad_stats stats;
+	int i;
+
+	reset_touchpad();
+
+	for (i = 0; i < QUEUE_SIZE + 3; i++)
+		compile_frame(i);
+
+	/*
+	 * The three oldest frames were dropped, and their movement added to
+	 * the oldest one left.
+	 */
+	TEST_EQ(read_input(), MOUSE_REPORT_LEN, "%d");
+	TEST_EQ((int8_t)buffer[4], 0 + 1 + 2 + 3, "%d");
+	for (i = 4; i < QUEUE_SIZE + 3; i++) {
+		TEST_EQ(read_input(), MOUSE_REPORT_LEN, "%d");
+		TEST_EQ((int8_t)buffer[4], i, "%d");
+	}
+	TEST_ASSERT(!i2c_hid_touchpad_has_report());
+
+	i2c_hid_touchpad_get_stats(&stats);
+	TEST_EQ(stats.queued, QUEUE_SIZE + 3, "%u");
+	TEST_EQ(stats.sent, QUEUE_SIZE, "%u");
+	TEST_EQ(stats.dropped, 3, "%u");
+
+	return EC_SUCCESS;
+}
+
+test_static int test_touch_mode(void)
+{
+	/* GET_REPORT of the input report 0x01 */
+	const uint8_t get_report[] = { 0x00, 0x30, 0x11, 0x02 };
+	int len;
+
+	reset_touchpad();
+	set_input_mode(0x03);
+
+	compile_frame(0);
+	len = read_input();
+	TEST_GT(len, MOUSE_REPORT_LEN, "%d");
+	TEST_EQ(buffer[0] | buffer[1] << 8, len, "%d");
+	TEST_EQ(buffer[2], 0x01, "%d");
+
+	/* GET_REPORT returns the latest touch report without dequeuing. */
+	compile_frame(1);
+	process(get_report, sizeof(get_report));
+	TEST_EQ(response_len, len, "%d");
+	TEST_EQ(buffer[2], 0x01, "%d");
+	TEST_ASSERT(i2c_hid_touchpad_has_report());
+
+	return EC_SUCCESS;
+}
+
+test_static int test_latency(void)
+{
+	struct i2c_hid_touchpad_stats stats;
+
+	reset_touchpad();
+
+	compile_frame(0);
+	read_input();
+	compile_frame(1);
+	crec_usleep(CONFIG_I2C_HID_TOUCHPAD_LATE_US + 5 * MSEC);
+	read_input();
+
+	i2c_hid_touchpad_get_stats(&stats);
+	TEST_EQ(stats.sent, 2, "%u");
+	TEST_EQ(stats.late, 1, "%u");
+	TEST_GE(stats.latency_max_us, CONFIG_I2C_HID_TOUCHPAD_LATE_US, "%u");
+	TEST_EQ(stats.latency_buckets[0], 1, "%u");
+	/* 21 ms lands in [16 ms, 32 ms) */
+	TEST_EQ(stats.latency_buckets[5], 1, "%u");
+
+	i2c_hid_touchpad_clear_stats();
+	i2c_hid_touchpad_get_stats(&stats);
+	TEST_EQ(stats.sent, 0, "%u");
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, const char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_batching);
+	RUN_TEST(test_overflow);
+	RUN_TEST(test_touch_mode);
+	RUN_TEST(test_latency);
+
+	test_print_result();
+}
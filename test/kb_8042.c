@@ -13,6 +13,7 @@
 #include "i8042_protocol.h"
 #include "keyboard_8042.h"
 #include "keyboard_8042_sharedlib.h"
+#include "keyboard_latency.h"
 #include "keyboard_protocol.h"
 #include "keyboard_scan.h"
 #include "lpc.h"
@@ -169,6 +170,23 @@ int _wait_for_data(int delay_ms)
 		TEST_ASSERT(queue_is_empty(&aux_to_device)); \
 	} while (0)
 
+/* Read a byte as the host would, or return -1 if none arrives */
+static int read_host_byte(bool *from_aux)
+{
+	int data;
+
+	if (_wait_for_data(30) != EC_SUCCESS)
+		return -1;
+
+	data = output_buffer.data;
+	if (from_aux)
+		*from_aux = output_buffer.from_aux;
+	output_buffer.full = false;
+	task_wake(TASK_ID_KEYPROTO);
+
+	return data;
+}
+
 static void press_key(int c, int r, int pressed)
 {
 	ccprintf("Input %s (%d, %d)\n", action[pressed], c, r);
@@ -577,6 +595,179 @@ test_static int test_single_key_press(void)
 	return EC_SUCCESS;
 }
 
+static int get_latency(struct ec_response_keyboard_latency *r, int flags)
+{
+	struct ec_params_keyboard_latency p = {
+		.path = EC_KB_LATENCY_PATH_8042,
+		.flags = flags,
+	};
+
+	return test_send_host_command(EC_CMD_KEYBOARD_LATENCY, 0, &p,
+				      sizeof(p), r, sizeof(*r));
+}
+
+test_static int test_latency_stats(void)
+{
+	struct ec_response_keyboard_latency r;
+	const struct ec_kb_latency_histogram *h = r.stage;
+
+	ENABLE_KEYSTROKE(1);
+	TEST_EQ(get_latency(&r, EC_KB_LATENCY_FLAG_CLEAR), EC_RES_SUCCESS,
+		"%d");
+
+	/* The scan saw the key 3 ms before queuing it */
+	keyboard_latency_mark(get_time().le.lo - 3 * MSEC);
+	press_key(1, 1, 1);
+	VERIFY_LPC_CHAR_DELAY("\x01", 5);
+	crec_msleep(5);
+
+	TEST_EQ(get_latency(&r, 0), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.events, 1, "%u");
+	TEST_GE(h[EC_KB_LATENCY_STAGE_QUEUE].max_us, 3 * MSEC, "%u");
+	TEST_EQ(h[EC_KB_LATENCY_STAGE_QUEUE].buckets[5], 1, "%u");
+	TEST_GE(h[EC_KB_LATENCY_STAGE_HOST].max_us, 5 * MSEC, "%u");
+	TEST_GE(h[EC_KB_LATENCY_STAGE_TOTAL].max_us, 8 * MSEC, "%u");
+
+	/* A multi-byte scan code is one event, read with its last byte */
+	press_key(12, 6, 1);
+	VERIFY_LPC_CHAR("\xe0\x4d");
+	press_key(12, 6, 0);
+	VERIFY_LPC_CHAR("\xe0\xcd");
+	press_key(1, 1, 0);
+	VERIFY_LPC_CHAR("\x81");
+	crec_msleep(5);
+
+	TEST_EQ(get_latency(&r, 0), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.events, 4, "%u");
+	TEST_EQ(r.dropped, 0, "%u");
+
+	/* Events flushed before the host read them count as dropped */
+	press_key(1, 1, 1);
+	press_key(1, 1, 0);
+	crec_msleep(5);
+	keyboard_clear_buffer();
+	output_buffer.full = false;
+	TEST_EQ(get_latency(&r, 0), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.events, 4, "%u");
+	TEST_EQ(r.dropped, 2, "%u");
+
+	return EC_SUCCESS;
+}
+
+test_static int test_key_stream_no_loss(void)
+{
+	uint32_t dropped = test_keyboard_8042_get_dropped_bytes();
+	int i;
+
+	ENABLE_KEYSTROKE(1);
+
+	/* Type more than a 16 byte queue holds while the host isn't reading */
+	for (i = 0; i < 24; i++) {
+		press_key(1, 1, 1);
+		press_key(1, 1, 0);
+	}
+	for (i = 0; i < 24; i++) {
+		TEST_EQ(read_host_byte(NULL), 0x01, "0x%x");
+		TEST_EQ(read_host_byte(NULL), 0x81, "0x%x");
+	}
+	VERIFY_NO_CHAR();
+	TEST_EQ(test_keyboard_8042_get_dropped_bytes(), dropped, "%u");
+
+	/* Past the configured depth, scan codes are dropped and counted */
+	for (i = 0; i < CONFIG_8042_TO_HOST_QUEUE_SIZE / 2 + 2; i++) {
+		press_key(1, 1, 1);
+		press_key(1, 1, 0);
+	}
+	TEST_GT(test_keyboard_8042_get_dropped_bytes(), dropped, "%u");
+
+	keyboard_clear_buffer();
+	output_buffer.full = false;
+
+	return EC_SUCCESS;
+}
+
+test_static int test_aux_stream_no_loss(void)
+{
+	uint32_t dropped = test_keyboard_8042_get_dropped_bytes();
+	int sent = 0, received = 0, i;
+	bool from_aux;
+
+	/* Enable AUX IRQ */
+	WRITE_CMD_BYTE(I8042_ENIRQ12);
+
+	/*
+	 * The touchpad sends 16 bytes for every 8 the host reads, so the
+	 * backlog outgrows the to-host queue and is held in the AUX queue.
+	 */
+	while (sent < 2 * CONFIG_8042_TO_HOST_QUEUE_SIZE + 32) {
+		for (i = 0; i < 16; i++)
+			send_aux_data_to_host_interrupt(sent++);
+		for (i = 0; i < 8; i++) {
+			TEST_EQ(read_host_byte(&from_aux), received++, "%d");
+			TEST_ASSERT(from_aux);
+		}
+	}
+	while (received < sent) {
+		TEST_EQ(read_host_byte(&from_aux), received++, "%d");
+		TEST_ASSERT(from_aux);
+	}
+	VERIFY_AUX_TO_HOST_EMPTY();
+	TEST_EQ(test_keyboard_8042_get_dropped_bytes(), dropped, "%u");
+
+	return EC_SUCCESS;
+}
+
+/* Read a byte of an AUX stream 0, 1, 2... mixed with key presses of (1, 1) */
+static int read_aux_and_key_byte(int *aux_received, int *keys_received)
+{
+	bool from_aux;
+	int data = read_host_byte(&from_aux);
+
+	TEST_NE(data, -1, "%d");
+	if (from_aux)
+		TEST_EQ(data, (*aux_received)++, "%d");
+	else
+		TEST_EQ(data, (*keys_received)++ % 2 ? 0x81 : 0x01, "0x%x");
+
+	return EC_SUCCESS;
+}
+
+#define READ_AUX_AND_KEY_BYTE()                                       \
+	TEST_EQ(read_aux_and_key_byte(&aux_received, &keys_received), \
+		EC_SUCCESS, "%d")
+
+test_static int test_aux_stream_while_typing(void)
+{
+	uint32_t dropped = test_keyboard_8042_get_dropped_bytes();
+	int aux_sent = 0, aux_received = 0;
+	int keys_sent = 0, keys_received = 0;
+	int i;
+
+	ENABLE_KEYSTROKE(1);
+	WRITE_CMD_BYTE(I8042_XLATE | I8042_ENIRQ12);
+
+	/*
+	 * As in test_aux_stream_no_loss, the AUX backlog outgrows to_host.
+	 * Keys typed once it has filled up must still get through.
+	 */
+	while (aux_sent < 2 * CONFIG_8042_TO_HOST_QUEUE_SIZE + 32) {
+		for (i = 0; i < 16; i++)
+			send_aux_data_to_host_interrupt(aux_sent++);
+		crec_msleep(1);
+		press_key(1, 1, 1);
+		press_key(1, 1, 0);
+		keys_sent += 2;
+		for (i = 0; i < 8; i++)
+			READ_AUX_AND_KEY_BYTE();
+	}
+	while (aux_received < aux_sent || keys_received < keys_sent)
+		READ_AUX_AND_KEY_BYTE();
+	VERIFY_NO_CHAR();
+	TEST_EQ(test_keyboard_8042_get_dropped_bytes(), dropped, "%u");
+
+	return EC_SUCCESS;
+}
+
 test_static int test_disable_keystroke(void)
 {
 	ENABLE_KEYSTROKE(0);
@@ -1074,6 +1265,10 @@ void run_test(int argc, const char **argv)
 		RUN_TEST(test_atkbd_set_ex_leds);
 		RUN_TEST(test_atkbd_reset);
 		RUN_TEST(test_single_key_press);
+		RUN_TEST(test_latency_stats);
+		RUN_TEST(test_key_stream_no_loss);
+		RUN_TEST(test_aux_stream_no_loss);
+		RUN_TEST(test_aux_stream_while_typing);
 		RUN_TEST(test_disable_keystroke);
 		RUN_TEST(test_typematic);
 		RUN_TEST(test_scancode_set2);
@@ -10,10 +10,12 @@
 #include "ec_commands.h"
 #include "gpio.h"
 #include "host_command.h"
+#include "keyboard_latency.h"
 #include "keyboard_mkbp.h"
 #include "keyboard_protocol.h"
 #include "keyboard_scan.h"
 #include "test_util.h"
+#include "timer.h"
 #include "util.h"
 
 static uint8_t state[KEYBOARD_COLS_MAX];
@@ -344,6 +346,60 @@ int fifo_underrun(void)
 	return EC_SUCCESS;
 }
 
+static int get_latency(struct ec_response_keyboard_latency *r, int flags)
+{
+	struct ec_params_keyboard_latency p = {
+		.path = EC_KB_LATENCY_PATH_MKBP,
+		.flags = flags,
+	};
+
+	return test_send_host_command(EC_CMD_KEYBOARD_LATENCY, 0, &p,
+				      sizeof(p), r, sizeof(*r));
+}
+
+int test_latency_stats(void)
+{
+	struct ec_response_keyboard_latency r;
+	const struct ec_kb_latency_histogram *h = r.stage;
+
+	keyboard_clear_buffer();
+	clear_state();
+	TEST_EQ(get_latency(&r, EC_KB_LATENCY_FLAG_CLEAR), EC_RES_SUCCESS,
+		"%d");
+
+	/* The scan saw the key 3 ms before queuing it */
+	keyboard_latency_mark(get_time().le.lo - 3 * MSEC);
+	TEST_ASSERT(press_key(0, 0, 1) == EC_SUCCESS);
+	clear_state();
+	TEST_ASSERT(verify_key(0, 0, 1));
+
+	TEST_EQ(get_latency(&r, 0), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.events, 1, "%u");
+	TEST_EQ(r.dropped, 0, "%u");
+	TEST_GE(h[EC_KB_LATENCY_STAGE_QUEUE].max_us, 3 * MSEC, "%u");
+	/* 3 ms falls in the [2 ms, 4 ms) bucket */
+	TEST_EQ(h[EC_KB_LATENCY_STAGE_QUEUE].buckets[5], 1, "%u");
+	TEST_GE(h[EC_KB_LATENCY_STAGE_TOTAL].max_us,
+		h[EC_KB_LATENCY_STAGE_QUEUE].max_us, "%u");
+
+	/* Without a mark the event is taken as detected when queued */
+	TEST_ASSERT(press_key(0, 0, 0) == EC_SUCCESS);
+	clear_state();
+	TEST_ASSERT(verify_key(0, 0, 0));
+	TEST_EQ(get_latency(&r, 0), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.events, 2, "%u");
+	TEST_EQ(h[EC_KB_LATENCY_STAGE_QUEUE].buckets[0], 1, "%u");
+
+	/* Events flushed before the host read them count as dropped */
+	TEST_ASSERT(press_key(0, 0, 1) == EC_SUCCESS);
+	keyboard_clear_buffer();
+	TEST_EQ(get_latency(&r, 0), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.events, 2, "%u");
+	TEST_EQ(r.dropped, 1, "%u");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	ec_int_level = 1;
@@ -357,6 +413,7 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_fifo_size);
 	RUN_TEST(test_enable);
 	RUN_TEST(fifo_underrun);
+	RUN_TEST(test_latency_stats);
 
 	test_print_result();
 }
@@ -11,6 +11,7 @@
 #include "gpio.h"
 #include "hooks.h"
 #include "host_command.h"
+#include "keyboard_latency.h"
 #include "keyboard_raw.h"
 #include "keyboard_scan.h"
 #include "lid_switch.h"
@@ -41,6 +42,12 @@ static uint8_t key_state[KEYBOARD_COLS_MAX];
 static int key_state_change[KEYBOARD_COLS_MAX][KEYBOARD_ROWS];
 static int total_key_state_change;
 
+/* Time of the last mocked key change */
+static uint32_t mock_key_us;
+/* Latency of the last key event from the scan that saw it, and the change */
+static uint32_t scan_latency_us;
+static uint32_t key_latency_us;
+
 static int column_driven;
 static int fifo_add_count;
 static int lid_open;
@@ -88,9 +95,12 @@ int keyboard_raw_read_rows(void)
 
 int mkbp_keyboard_add(const uint8_t *buffp)
 {
+	uint32_t now = get_time().le.lo;
 	int c, r;
 
 	fifo_add_count++;
+	scan_latency_us = now - keyboard_latency_claim();
+	key_latency_us = now - mock_key_us;
 
 	for (c = 0; c < KEYBOARD_COLS_MAX; c++) {
 		uint8_t diff = key_state[c] ^ buffp[c];
@@ -133,6 +143,7 @@ static void mock_key(int r, int c, int keydown)
 		mock_state[c] |= (1 << r);
 	else
 		mock_state[c] &= ~(1 << r);
+	mock_key_us = get_time().le.lo;
 }
 
 static void reset_key_state(void)
@@ -442,6 +453,58 @@ static int debounce_test(void)
 	return EC_SUCCESS;
 }
 
+static int incremental_scan_test(void)
+{
+	const struct keyboard_scan_config *config = keyboard_scan_get_config();
+	struct keyboard_scan_stats before, after;
+	int scans, cols = keyboard_get_cols();
+
+	reset_key_state();
+
+	/* Hold a key, then count how much of the matrix is read */
+	mock_key(1, 1, 1);
+	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
+	keyboard_scan_get_stats(&before);
+	crec_msleep(200);
+	keyboard_scan_get_stats(&after);
+
+	scans = after.scans - before.scans;
+	TEST_GT(scans, CONFIG_KEYBOARD_SCAN_FULL_INTERVAL, "%d");
+	TEST_LE(after.full_scans - before.full_scans,
+		scans / CONFIG_KEYBOARD_SCAN_FULL_INTERVAL + 1, "%d");
+	TEST_LT(after.columns - before.columns, scans * cols / 4, "%d");
+	/* Each scan costs a fraction of reading all the columns */
+	TEST_LT((after.scan_us - before.scan_us) / scans,
+		cols * config->output_settle_us / 2, "%d");
+
+	/* A key in a new row is found by driving all columns */
+	mock_key(2, 4, 1);
+	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
+	TEST_EQ(key_state[4], BIT(2), "0x%x");
+	TEST_LT(key_latency_us, config->stable_scan_period_us, "%d");
+	TEST_LT(scan_latency_us, config->scan_period_us, "%d");
+
+	/* One in a row with a key down waits for the next full scan */
+	mock_key(1, 6, 1);
+	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
+	TEST_EQ(key_state[6], BIT(1), "0x%x");
+	TEST_LE(key_latency_us,
+		(CONFIG_KEYBOARD_SCAN_FULL_INTERVAL + 1) *
+			config->stable_scan_period_us,
+		"%d");
+	TEST_LT(scan_latency_us, config->scan_period_us, "%d");
+
+	mock_key(1, 1, 0);
+	mock_key(2, 4, 0);
+	mock_key(1, 6, 0);
+	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
+	crec_msleep(NO_KEYDOWN_DELAY_MS);
+	TEST_EQ(key_state[1] | key_state[4] | key_state[6], 0,
+		"0x%x");
+
+	return EC_SUCCESS;
+}
+
 static int simulate_key_test(void)
 {
 	int old_count;
@@ -668,6 +731,9 @@ static void run_test_step1(void)
 	else
 		RUN_TEST(debounce_test);
 
+	if (IS_ENABLED(CONFIG_KEYBOARD_SCAN_INCREMENTAL))
+		RUN_TEST(incremental_scan_test);
+
 	if (0) /* crbug.com/976974 */
 		RUN_TEST(simulate_key_test);
 #ifdef EMU_BUILD
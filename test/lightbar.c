@@ -7,6 +7,7 @@
 #include "ec_commands.h"
 #include "host_command.h"
 #include "lightbar.h"
+#include "lightbyte.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
@@ -316,6 +317,83 @@ test_static int test_als_lightbar(void)
 	return EC_SUCCESS;
 }
 
+static int set_program(const uint8_t *data, int size)
+{
+	struct ec_params_lightbar params;
+
+	params.cmd = LIGHTBAR_CMD_SET_PROGRAM;
+	params.set_program.size = size;
+	memcpy(params.set_program.data, data, size);
+
+	return test_send_host_command(EC_CMD_LIGHTBAR_CMD, 0, &params,
+				      sizeof(params), NULL, 0);
+}
+
+test_static int test_program_decode(void)
+{
+	const uint8_t loop[] = { SET_WAIT_DELAY, 0, 0, 0, 1, WAIT, JUMP, 5 };
+	const uint8_t bad_op[] = { ON, MAX_OPCODE };
+	const uint8_t short_arg[] = { ON, SET_RAMP_DELAY, 0, 0 };
+	const uint8_t mid_jump[] = { SET_WAIT_DELAY, 0, 0, 0, 1, JUMP, 2 };
+	const uint8_t bad_color[] = { SET_COLOR_SINGLE, 0x13, 0xff, HALT };
+	static struct lightbyte_inst code[EC_LB_PROG_LEN];
+	struct lightbar_program prog;
+	int bad_addr;
+
+	/* Jumps are resolved to instruction indexes */
+	prog.size = sizeof(loop);
+	memcpy(prog.data, loop, sizeof(loop));
+	TEST_EQ(lightbyte_decode(&prog, code, NULL), 3, "%d");
+	TEST_EQ(code[0].delay[3], 1, "%u");
+	TEST_EQ(code[2].op, JUMP, "%d");
+	TEST_EQ(code[2].target[0], 1, "%d");
+	TEST_EQ(set_program(loop, sizeof(loop)), EC_RES_SUCCESS, "%d");
+
+	prog.size = sizeof(mid_jump);
+	memcpy(prog.data, mid_jump, sizeof(mid_jump));
+	TEST_EQ(lightbyte_decode(&prog, code, &bad_addr), -1, "%d");
+	TEST_EQ(bad_addr, 5, "%d");
+
+	/* Bad programs are refused when they're set */
+	TEST_EQ(set_program(bad_op, sizeof(bad_op)), EC_RES_INVALID_PARAM,
+		"%d");
+	TEST_EQ(set_program(short_arg, sizeof(short_arg)),
+		EC_RES_INVALID_PARAM, "%d");
+	TEST_EQ(set_program(mid_jump, sizeof(mid_jump)), EC_RES_INVALID_PARAM,
+		"%d");
+	TEST_EQ(set_program(bad_color, sizeof(bad_color)),
+		EC_RES_INVALID_PARAM, "%d");
+
+	return EC_SUCCESS;
+}
+
+test_static int test_program_timing(void)
+{
+	/* Ramp in 128 steps of 1 ms, then wait 4 x 25 ms */
+	/* clang-format off */
+	const uint8_t prog[] = {
+		SET_COLOR_RGB, 0xf4, 0xff, 0xff, 0xff,
+		SET_RAMP_DELAY, 0, 0, 0x03, 0xe8,
+		RAMP_ONCE,
+		SET_WAIT_DELAY, 0, 0, 0x61, 0xa8,
+		WAIT, WAIT, WAIT, WAIT,
+		HALT,
+	};
+	/* clang-format on */
+
+	TEST_ASSERT(set_seq(LIGHTBAR_S0) == EC_RES_SUCCESS);
+	crec_usleep(SECOND);
+	TEST_EQ(set_program(prog, sizeof(prog)), EC_RES_SUCCESS, "%d");
+	TEST_ASSERT(set_seq(LIGHTBAR_PROGRAM) == EC_RES_SUCCESS);
+
+	crec_msleep(200);
+	TEST_EQ(get_seq(), LIGHTBAR_PROGRAM, "%d");
+	crec_msleep(100);
+	TEST_NE(get_seq(), LIGHTBAR_PROGRAM, "%d");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	/* Ensure tasks are started before running tests */
@@ -328,5 +406,7 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_oneshots_norm_msg);
 	RUN_TEST(test_double_oneshots);
 	RUN_TEST(test_als_lightbar);
+	RUN_TEST(test_program_decode);
+	RUN_TEST(test_program_timing);
 	test_print_result();
 }
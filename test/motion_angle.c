@@ -31,7 +31,7 @@ int filler(const struct motion_sensor_t *s, const float v)
 
 static int test_lid_angle_less180(void)
 {
-	int index = 0, lid_angle;
+	int index = 0, lid_angle, confidence;
 	struct motion_sensor_t *lid =
 		&motion_sensors[CONFIG_LID_ANGLE_SENSOR_LID];
 	struct motion_sensor_t *base =
@@ -60,10 +60,15 @@ static int test_lid_angle_less180(void)
 				filler);
 		wait_for_valid_sample();
 		lid_angle = motion_lid_get_angle();
-		cprints(CC_ACCEL, "%d : LID(%d, %d, %d)/BASE(%d, %d, %d): %d",
+		confidence = motion_lid_get_confidence();
+		cprints(CC_ACCEL,
+			"%d : LID(%d, %d, %d)/BASE(%d, %d, %d): %d (%d%%)",
 			index / TEST_LID_SAMPLE_SIZE, lid->xyz[X], lid->xyz[Y],
 			lid->xyz[Z], base->xyz[X], base->xyz[Y], base->xyz[Z],
-			lid_angle);
+			lid_angle, confidence);
+		TEST_ASSERT(confidence >= 0 && confidence <= 100);
+		TEST_ASSERT(lid_angle != LID_ANGLE_UNRELIABLE ||
+			    confidence == 0);
 		/* We need few sample to debounce and enter laptop mode. */
 		TEST_ASSERT(index < TEST_LID_SAMPLE_SIZE *
 					    (TABLET_MODE_DEBOUNCE_COUNT + 2) ||
@@ -77,10 +82,15 @@ static int test_lid_angle_less180(void)
 				filler);
 		wait_for_valid_sample();
 		lid_angle = motion_lid_get_angle();
-		cprints(CC_ACCEL, "%d : LID(%d, %d, %d)/BASE(%d, %d, %d): %d",
+		confidence = motion_lid_get_confidence();
+		cprints(CC_ACCEL,
+			"%d : LID(%d, %d, %d)/BASE(%d, %d, %d): %d (%d%%)",
 			index / TEST_LID_SAMPLE_SIZE, lid->xyz[X], lid->xyz[Y],
 			lid->xyz[Z], base->xyz[X], base->xyz[Y], base->xyz[Z],
-			lid_angle);
+			lid_angle, confidence);
+		TEST_ASSERT(confidence >= 0 && confidence <= 100);
+		TEST_ASSERT(lid_angle != LID_ANGLE_UNRELIABLE ||
+			    confidence == 0);
 		TEST_ASSERT(index < TEST_LID_SAMPLE_SIZE *
 					    (TABLET_MODE_DEBOUNCE_COUNT + 2) ||
 			    tablet_get_mode());
@@ -23,6 +23,7 @@
 
 extern enum chipset_state_mask sensor_active;
 extern int wait_us;
+extern struct motion_sense_jitter sensor_jitter[];
 
 /*
  * Period in us for the motion task period.
@@ -396,11 +397,153 @@ static int test_lid_angle(void)
 	return EC_SUCCESS;
 }
 
+/*
+ * With the sensors at different rates, each one must still be read on its
+ * own schedule.
+ */
+static int test_sensor_schedule(void)
+{
+	struct motion_sensor_t *base =
+		&motion_sensors[CONFIG_LID_ANGLE_SENSOR_BASE];
+	struct motion_sensor_t *lid =
+		&motion_sensors[CONFIG_LID_ANGLE_SENSOR_LID];
+	const struct motion_sense_jitter *base_jit = &sensor_jitter[BASE];
+	const struct motion_sense_jitter *lid_jit = &sensor_jitter[LID];
+
+	lid->config[SENSOR_CONFIG_EC_S0].odr = 50000 | ROUND_UP_FLAG;
+	hook_notify(HOOK_CHIPSET_SUSPEND);
+	hook_notify(HOOK_CHIPSET_RESUME);
+	crec_msleep(50);
+	TEST_ASSERT(sensor_active == SENSOR_ACTIVE_S0);
+	TEST_EQ(lid->collection_rate, 20 * MSEC, "%u");
+	TEST_LT(base->collection_rate, 10 * MSEC, "%u");
+
+	memset(sensor_jitter, 0, sizeof(*sensor_jitter) * motion_sensor_count);
+	crec_msleep(1000);
+
+	/* One read per period, no extra reads from the other sensor's. */
+	TEST_NEAR(base_jit->samples, SECOND / base->collection_rate, 2, "%u");
+	TEST_NEAR(lid_jit->samples, SECOND / lid->collection_rate, 2, "%u");
+
+	/* Reads are never late by more than a bucket. */
+	TEST_LT(base_jit->max_late_us, MOTION_SENSE_JITTER_BUCKET_BASE_US,
+		"%u");
+	TEST_LT(lid_jit->max_late_us, MOTION_SENSE_JITTER_BUCKET_BASE_US,
+		"%u");
+
+	/* Early reads are only ever coalesced within the minimum interval. */
+	TEST_LT(base_jit->max_early_us, CONFIG_MOTION_MIN_SENSE_WAIT_TIME * MSEC,
+		"%u");
+	TEST_LT(lid_jit->max_early_us, CONFIG_MOTION_MIN_SENSE_WAIT_TIME * MSEC,
+		"%u");
+
+	lid->config[SENSOR_CONFIG_EC_S0].odr = 119000 | ROUND_UP_FLAG;
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Read the lid angle with MOTIONSENSE_CMD_LID_ANGLE into a response buffer of
+ * size bytes, and return the size of the response.
+ */
+static int host_lid_angle(struct ec_response_motion_sense *r, int size)
+{
+	struct ec_params_motion_sense params = {
+		.cmd = MOTIONSENSE_CMD_LID_ANGLE,
+	};
+	struct host_cmd_handler_args args = {
+		.command = EC_CMD_MOTION_SENSE_CMD,
+		.version = 2,
+		.params = &params,
+		.params_size = sizeof(params),
+		.response = r,
+		.response_max = size,
+	};
+
+	memset(r, 0xff, sizeof(*r));
+	if (host_command_process(&args) != EC_RES_SUCCESS)
+		return -1;
+	return args.response_size;
+}
+
+/*
+ * The confidence follows the quality of the vectors, and is reported along
+ * with the angle to hosts with room for it.
+ */
+static int test_lid_angle_confidence(void)
+{
+	struct motion_sensor_t *base =
+		&motion_sensors[CONFIG_LID_ANGLE_SENSOR_BASE];
+	struct motion_sensor_t *lid =
+		&motion_sensors[CONFIG_LID_ANGLE_SENSOR_LID];
+	struct ec_response_motion_sense r;
+	int confidence;
+
+	hook_notify(HOOK_CHIPSET_SUSPEND);
+	hook_notify(HOOK_CHIPSET_RESUME);
+	gpio_set_level(GPIO_LID_OPEN, 1);
+	crec_msleep(50);
+
+	/* Flat on a desk, lid open to 180. */
+	base->xyz[X] = 0;
+	base->xyz[Y] = 0;
+	base->xyz[Z] = ONE_G_MEASURED;
+	lid->xyz[X] = 0;
+	lid->xyz[Y] = 0;
+	lid->xyz[Z] = ONE_G_MEASURED;
+	wait_for_valid_sample();
+	TEST_EQ(motion_lid_get_angle(), 180, "%d");
+	TEST_EQ(motion_lid_get_confidence(), 100, "%d");
+	TEST_EQ(host_lid_angle(&r, sizeof(r.lid_angle)),
+		(int)sizeof(r.lid_angle), "%d");
+	TEST_EQ(r.lid_angle.value, 180, "%d");
+	TEST_EQ(r.lid_angle.confidence, 100, "%d");
+
+	/* A host with only room for the angle still gets it. */
+	TEST_EQ(host_lid_angle(&r, sizeof(r.lid_angle.value)),
+		(int)sizeof(r.lid_angle.value), "%d");
+	TEST_EQ(r.lid_angle.value, 180, "%d");
+
+	/* A magnitude further from 1g lowers the confidence. */
+	lid->xyz[Z] = ONE_G_MEASURED - ONE_G_MEASURED / 64;
+	wait_for_valid_sample();
+	confidence = motion_lid_get_confidence();
+	TEST_EQ(motion_lid_get_angle(), 180, "%d");
+	TEST_LT(confidence, 100, "%d");
+	TEST_GT(confidence, 50, "%d");
+	host_lid_angle(&r, sizeof(r));
+	TEST_EQ(r.lid_angle.confidence, confidence, "%d");
+
+	/* So does a hinge getting vertical. */
+	base->xyz[X] = ONE_G_MEASURED * 0.78;
+	base->xyz[Z] = ONE_G_MEASURED * 0.626;
+	lid->xyz[X] = ONE_G_MEASURED * 0.78;
+	lid->xyz[Z] = ONE_G_MEASURED * 0.626;
+	wait_for_valid_sample();
+	TEST_NE(motion_lid_get_angle(), LID_ANGLE_UNRELIABLE, "%d");
+	TEST_LT(motion_lid_get_confidence(), 80, "%d");
+	TEST_GT(motion_lid_get_confidence(), 0, "%d");
+
+	/* There is no confidence in an unreliable angle. */
+	base->xyz[X] = ONE_G_MEASURED;
+	base->xyz[Z] = 0;
+	wait_for_valid_sample();
+	TEST_EQ(motion_lid_get_angle(), LID_ANGLE_UNRELIABLE, "%d");
+	TEST_EQ(motion_lid_get_confidence(), 0, "%d");
+	host_lid_angle(&r, sizeof(r));
+	TEST_EQ(r.lid_angle.value, LID_ANGLE_UNRELIABLE, "%d");
+	TEST_EQ(r.lid_angle.confidence, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	test_reset();
 
 	RUN_TEST(test_lid_angle);
+	RUN_TEST(test_sensor_schedule);
+	RUN_TEST(test_lid_angle_confidence);
 
 	test_print_result();
 }
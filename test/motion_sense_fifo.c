@@ -28,6 +28,23 @@ const unsigned int motion_sensor_count = ARRAY_SIZE(motion_sensors);
 
 uint32_t mkbp_last_event_time;
 
+enum sensor_config motion_sense_get_ec_config(void)
+{
+	return SENSOR_CONFIG_EC_S0;
+}
+
+/* Data rates of the sensors, in mHz */
+static int data_rates[ARRAY_SIZE(motion_sensors)];
+
+static int get_data_rate(const struct motion_sensor_t *s)
+{
+	return data_rates[s - motion_sensors];
+}
+
+static const struct accelgyro_drv test_drv = {
+	.get_data_rate = get_data_rate,
+};
+
 static struct ec_response_motion_sensor_data data[CONFIG_ACCEL_FIFO_SIZE];
 static uint16_t data_bytes_read;
 
@@ -493,6 +510,114 @@ static int test_check_ap_interval_set_multiple_sample(void)
 	return EC_SUCCESS;
 }
 
+static int test_spread_batch(void)
+{
+	const uint32_t now = __hw_clock_source_read();
+	int read_count;
+
+	motion_sensors[0].oversampling_ratio = 1;
+	motion_sense_set_data_period(0, 20 /* us */);
+
+	/* Read right after the watermark interrupt */
+	motion_sense_fifo_stage_data(data, motion_sensors, 3, now - 5);
+	motion_sense_fifo_stage_data(data, motion_sensors, 3, now - 5);
+	motion_sense_fifo_stage_data(data, motion_sensors, 3, now - 5);
+	motion_sense_fifo_mark_batch();
+	motion_sense_fifo_commit_data();
+	read_count = motion_sense_fifo_read(
+		sizeof(data), CONFIG_ACCEL_FIFO_SIZE, data, &data_bytes_read);
+	TEST_EQ(read_count, 6, "%d");
+
+	/* The last sample was taken at the interrupt. */
+	TEST_BITS_SET(data[0].flags, MOTIONSENSE_SENSOR_FLAG_TIMESTAMP);
+	TEST_EQ(data[0].timestamp, now - 45, "%u");
+	TEST_EQ(data[2].timestamp, now - 25, "%u");
+	TEST_EQ(data[4].timestamp, now - 5, "%u");
+
+	return EC_SUCCESS;
+}
+
+static int test_spread_batch_late_read(void)
+{
+	const uint32_t now = __hw_clock_source_read();
+	int read_count;
+
+	motion_sensors[0].oversampling_ratio = 1;
+	motion_sense_set_data_period(0, 20 /* us */);
+
+	/* Read well after the interrupt: more samples came in meanwhile. */
+	motion_sense_fifo_stage_data(data, motion_sensors, 3, now - 60);
+	motion_sense_fifo_stage_data(data, motion_sensors, 3, now - 60);
+	motion_sense_fifo_mark_batch();
+	motion_sense_fifo_commit_data();
+	read_count = motion_sense_fifo_read(
+		sizeof(data), CONFIG_ACCEL_FIFO_SIZE, data, &data_bytes_read);
+	TEST_EQ(read_count, 4, "%d");
+
+	/* The last one is about half a period before the read. */
+	TEST_NEAR(data[0].timestamp, now - 30, 4, "%u");
+	TEST_NEAR(data[2].timestamp, now - 10, 4, "%u");
+	TEST_EQ(data[2].timestamp - data[0].timestamp, 20, "%u");
+
+	return EC_SUCCESS;
+}
+
+static int test_batch_size(void)
+{
+	const struct motion_sensor_t *sensors[] = {
+		&motion_sensors[BASE],
+		&motion_sensors[LID],
+	};
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(motion_sensors); i++) {
+		motion_sensors[i].drv = &test_drv;
+		data_rates[i] = 100000;
+		memset(motion_sensors[i].config, 0,
+		       sizeof(motion_sensors[i].config));
+	}
+
+	/* Nothing asks for the data, don't batch. */
+	TEST_EQ(motion_sense_fifo_batch_size(sensors, 2), 1, "%d");
+
+	/* 20 ms at 100 Hz is 2 samples of each sensor. */
+	for (i = 0; i < ARRAY_SIZE(motion_sensors); i++) {
+		motion_sensors[i].config[SENSOR_CONFIG_AP].odr = 100000;
+		motion_sensors[i].config[SENSOR_CONFIG_AP].ec_rate = 20 * MSEC;
+	}
+	TEST_EQ(motion_sense_fifo_batch_size(sensors, 2), 4, "%d");
+	TEST_EQ(motion_sense_fifo_batch_size(sensors, 1), 2, "%d");
+
+	/* A disabled sensor adds nothing. */
+	data_rates[LID] = 0;
+	TEST_EQ(motion_sense_fifo_batch_size(sensors, 2), 2, "%d");
+	data_rates[LID] = 100000;
+
+	/* The EC config may need the data sooner. */
+	motion_sensors[BASE].config[SENSOR_CONFIG_EC_S0].odr = 10000;
+	motion_sensors[BASE].config[SENSOR_CONFIG_EC_S0].ec_rate = 10 * MSEC;
+	TEST_EQ(motion_sense_fifo_batch_size(sensors, 2), 2, "%d");
+
+	/* Without an ec_rate, every sample is needed right away. */
+	motion_sensors[BASE].config[SENSOR_CONFIG_EC_S0].ec_rate = 0;
+	TEST_EQ(motion_sense_fifo_batch_size(sensors, 2), 1, "%d");
+	motion_sensors[BASE].config[SENSOR_CONFIG_EC_S0].odr = 0;
+
+	/* Batches are capped so a full one fits under the threshold. */
+	for (i = 0; i < ARRAY_SIZE(motion_sensors); i++)
+		motion_sensors[i].config[SENSOR_CONFIG_AP].ec_rate = SECOND;
+	TEST_EQ(motion_sense_fifo_batch_size(sensors, 2),
+		MOTION_SENSE_FIFO_BATCH_MAX, "%d");
+
+	for (i = 0; i < ARRAY_SIZE(motion_sensors); i++) {
+		motion_sensors[i].drv = NULL;
+		memset(motion_sensors[i].config, 0,
+		       sizeof(motion_sensors[i].config));
+	}
+
+	return EC_SUCCESS;
+}
+
 void before_test(void)
 {
 	motion_sense_fifo_commit_data();
@@ -525,6 +650,9 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_get_info_size);
 	RUN_TEST(test_check_ap_interval_set_one_sample);
 	RUN_TEST(test_check_ap_interval_set_multiple_sample);
+	RUN_TEST(test_spread_batch);
+	RUN_TEST(test_spread_batch_late_read);
+	RUN_TEST(test_batch_size);
 
 	test_print_result();
 }
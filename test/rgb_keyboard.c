@@ -6,6 +6,7 @@
  */
 #include "common.h"
 #include "console.h"
+#include "host_command.h"
 #include "keyboard_backlight.h"
 #include "rgb_keyboard.h"
 #include "task.h"
@@ -66,9 +67,11 @@ static struct rgbkbd_mock {
 	uint32_t count_drv_init;
 	uint32_t count_drv_enable;
 	uint32_t count_drv_set_color;
+	uint32_t len_drv_set_color;
 	uint32_t count_drv_set_scale;
 	uint32_t count_drv_set_gcc;
 	uint32_t gcc_level;
+	int set_color_rv;
 } mock_state;
 
 __override void board_kblight_init(void)
@@ -106,7 +109,8 @@ static int test_drv_set_color(struct rgbkbd *ctx, uint8_t offset,
 			      struct rgb_s *color, uint8_t len)
 {
 	mock_state.count_drv_set_color++;
-	return EC_SUCCESS;
+	mock_state.len_drv_set_color += len;
+	return mock_state.set_color_rv;
 }
 
 static int test_drv_set_scale(struct rgbkbd *ctx, uint8_t offset,
@@ -387,6 +391,147 @@ static int test_rgbkbd_demo_flow(void)
 	return EC_SUCCESS;
 }
 
+/* Let the RGBKBD task flush the frame buffer. */
+static void wait_for_flush(void)
+{
+	crec_msleep(2 * 1000 / CONFIG_RGBKBD_MAX_FPS);
+}
+
+static int set_key_color(uint8_t key, struct rgb_s color)
+{
+	struct {
+		struct ec_params_rgbkbd_set_color p;
+		struct rgb_s color;
+	} params = {
+		.p = { .start_key = key, .length = 1 },
+		.color = color,
+	};
+
+	return test_send_host_command(EC_CMD_RGBKBD_SET_COLOR, 0, &params,
+				      sizeof(params), NULL, 0);
+}
+
+static int clear_color(struct rgb_s color)
+{
+	struct ec_params_rgbkbd p = {
+		.subcmd = EC_RGBKBD_SUBCMD_CLEAR,
+		.color = color,
+	};
+	struct ec_response_rgbkbd r;
+
+	return test_send_host_command(EC_CMD_RGBKBD, 0, &p, sizeof(p), &r,
+				      sizeof(r));
+}
+
+static int test_rgbkbd_dirty_flush(void)
+{
+	const char *argv_demo[] = { "rgbk", "demo", "0" };
+	const char *argv_stats[] = { "rgbk", "stats", "clear" };
+	const struct rgb_s off = {}, color = { 1, 2, 3 };
+	const int size =
+		get_grid_size(&rgbkbds[0]) + get_grid_size(&rgbkbds[1]);
+
+	zassert_equal(cc_rgb(ARRAY_SIZE(argv_demo), argv_demo), EC_SUCCESS,
+		      "rgbk demo 0");
+	zassert_equal(clear_color(off), EC_RES_SUCCESS, "clear");
+	wait_for_flush();
+	zassert_equal(cc_rgb(ARRAY_SIZE(argv_stats), argv_stats), EC_SUCCESS,
+		      "rgbk stats clear");
+
+	/* Only the changed dot is written, once the task gets to it. */
+	before_test();
+	zassert_equal(set_key_color(1, color), EC_RES_SUCCESS, "set key 1");
+	zassert_equal(mock_state.count_drv_set_color, 0, "deferred");
+	wait_for_flush();
+	zassert_equal(mock_state.count_drv_set_color, 1, "one write");
+	zassert_equal(mock_state.len_drv_set_color, 1, "one dot");
+
+	/* Setting the same color again writes nothing. */
+	before_test();
+	zassert_equal(set_key_color(1, color), EC_RES_SUCCESS, "set key 1");
+	wait_for_flush();
+	zassert_equal(mock_state.count_drv_set_color, 0, "no write");
+
+	/* Changes within a frame are sent together. */
+	before_test();
+	zassert_equal(set_key_color(1, off), EC_RES_SUCCESS, "set key 1");
+	zassert_equal(set_key_color(1, color), EC_RES_SUCCESS, "set key 1");
+	wait_for_flush();
+	zassert_equal(mock_state.count_drv_set_color, 1, "one write");
+
+	/* The clean dot (1,2) splits the grid 0 update in two. */
+	before_test();
+	zassert_equal(clear_color(color), EC_RES_SUCCESS, "clear");
+	wait_for_flush();
+	zassert_equal(mock_state.count_drv_set_color, 3, "three writes");
+	zassert_equal(mock_state.len_drv_set_color, size - 1, "dirty dots");
+
+	argv_stats[2] = "";
+	zassert_equal(cc_rgb(2, argv_stats), EC_SUCCESS, "rgbk stats");
+
+	return EC_SUCCESS;
+}
+
+static int test_rgbkbd_flush_error(void)
+{
+	const char *argv_demo[] = { "rgbk", "demo", "0" };
+	const char *argv_disable[] = { "rgbk", "disable" };
+	const char *argv_enable[] = { "rgbk", "enable" };
+	const struct rgb_s off = {}, color = { 4, 5, 6 };
+	const int size =
+		get_grid_size(&rgbkbds[0]) + get_grid_size(&rgbkbds[1]);
+	uint32_t tries;
+
+	zassert_equal(cc_rgb(ARRAY_SIZE(argv_demo), argv_demo), EC_SUCCESS,
+		      "rgbk demo 0");
+	zassert_equal(clear_color(off), EC_RES_SUCCESS, "clear");
+	wait_for_flush();
+
+	/* A failed write is retried for a few frames, then given up on. */
+	before_test();
+	mock_state.set_color_rv = EC_ERROR_UNKNOWN;
+	zassert_equal(set_key_color(1, color), EC_RES_SUCCESS, "queued");
+	crec_msleep(10 * 1000 / CONFIG_RGBKBD_MAX_FPS);
+	tries = mock_state.count_drv_set_color;
+	zassert_true(tries > 1, "retried");
+	wait_for_flush();
+	zassert_equal(mock_state.count_drv_set_color, tries, "gave up");
+	zassert_equal(rgbkbds[0].state, RGBKBD_STATE_RESET, "grid 0 off");
+	zassert_equal(rgbkbds[1].state, RGBKBD_STATE_ENABLED, "grid 1 on");
+
+	/* Writes to the grid are queued and dropped until it's re-inited. */
+	mock_state.set_color_rv = EC_SUCCESS;
+	before_test();
+	zassert_equal(set_key_color(1, off), EC_RES_SUCCESS, "queued");
+	zassert_equal(clear_color(color), EC_RES_SUCCESS, "queued");
+	wait_for_flush();
+	zassert_equal(mock_state.count_drv_set_color, 1, "grid 1 only");
+	zassert_equal(mock_state.len_drv_set_color, get_grid_size(&rgbkbds[1]),
+		      "grid 1 only");
+
+	/* Re-init sends both grids in full. */
+	before_test();
+	zassert_equal(cc_rgb(ARRAY_SIZE(argv_demo), argv_demo), EC_SUCCESS,
+		      "rgbk demo 0");
+	wait_for_flush();
+	zassert_equal(rgbkbds[0].state, RGBKBD_STATE_ENABLED, "grid 0 on");
+	zassert_equal(mock_state.len_drv_set_color, size, "all dots");
+
+	/* Colors set while disabled are sent once enabled. */
+	zassert_equal(cc_rgb(ARRAY_SIZE(argv_disable), argv_disable),
+		      EC_SUCCESS, "rgbk disable");
+	before_test();
+	zassert_equal(set_key_color(1, off), EC_RES_SUCCESS, "queued");
+	wait_for_flush();
+	zassert_equal(mock_state.count_drv_set_color, 0, "dropped");
+	zassert_equal(cc_rgb(ARRAY_SIZE(argv_enable), argv_enable),
+		      EC_SUCCESS, "rgbk enable");
+	wait_for_flush();
+	zassert_equal(mock_state.len_drv_set_color, size, "all dots");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	RUN_TEST(test_rgbkbd_startup);
@@ -394,5 +539,7 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_rgbkbd_rotate_color);
 	RUN_TEST(test_rgbkbd_demo_flow);
 	RUN_TEST(test_rgbkbd_map);
+	RUN_TEST(test_rgbkbd_dirty_flush);
+	RUN_TEST(test_rgbkbd_flush_error);
 	test_print_result();
 }
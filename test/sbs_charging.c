@@ -103,6 +103,15 @@ int charger_profile_override(struct charge_state_data *curr)
 	return 0;
 }
 
+/* Count the string reads done to fetch the battery's static info */
+test_static int device_name_reads;
+int battery_device_name(char *dest, int size)
+{
+	device_name_reads++;
+	strzcpy(dest, "MOCKBATT", size);
+	return EC_SUCCESS;
+}
+
 test_static uint32_t meh;
 enum ec_status charger_profile_override_get_param(uint32_t param,
 						  uint32_t *value)
@@ -1123,6 +1132,224 @@ test_static int test_battery_sustainer_with_idle(void)
 	return EC_SUCCESS;
 }
 
+test_static int test_charge_loop_stats(void)
+{
+	const struct charge_loop_stats *stats = charge_get_loop_stats();
+	struct charge_loop_stats prev;
+
+	test_setup(1);
+	TEST_ASSERT(charge_get_state() == ST_CHARGE);
+
+	/* A power supply change runs the loop right away */
+	prev = *stats;
+	charge_wakeup_for(CHARGE_WAKEUP_POWER_SUPPLY);
+	crec_msleep(10);
+	TEST_EQ(stats->wakeups[CHARGE_WAKEUP_POWER_SUPPLY],
+		prev.wakeups[CHARGE_WAKEUP_POWER_SUPPLY] + 1, "%u");
+	TEST_EQ(stats->loops[ST_CHARGE], prev.loops[ST_CHARGE] + 1, "%u");
+	TEST_GT(stats->i2c_xfers[ST_CHARGE], prev.i2c_xfers[ST_CHARGE], "%u");
+	TEST_EQ(stats->timer_wakeups, prev.timer_wakeups, "%u");
+	TEST_LE(stats->sleep_usec, CHARGE_POLL_PERIOD_CHARGE, "%d");
+	TEST_GT(stats->sleep_usec, CHARGE_POLL_PERIOD_SHORT, "%d");
+
+	/* Unplugging AC is an event too */
+	prev = *stats;
+	gpio_set_level(GPIO_AC_PRESENT, 0);
+	sb_write(SB_CURRENT, -1000);
+	crec_msleep(50);
+	TEST_GT(stats->wakeups[CHARGE_WAKEUP_AC_CHANGE],
+		prev.wakeups[CHARGE_WAKEUP_AC_CHANGE], "%u");
+	TEST_ASSERT(charge_get_state() == ST_DISCHARGE);
+
+	/* Discharging with the AP on polls every CHARGE_POLL_PERIOD_LONG */
+	prev = *stats;
+	crec_usleep(CHARGE_POLL_PERIOD_LONG * 4 + CHARGE_POLL_PERIOD_LONG / 2);
+	TEST_GE(stats->timer_wakeups, prev.timer_wakeups + 4, "%u");
+	TEST_LE(stats->timer_wakeups, prev.timer_wakeups + 5, "%u");
+	TEST_EQ(stats->loops[ST_DISCHARGE] - prev.loops[ST_DISCHARGE],
+		stats->timer_wakeups - prev.timer_wakeups, "%u");
+
+	return EC_SUCCESS;
+}
+
+test_static int test_power_trace(void)
+{
+	const struct battery_info *bat_info = battery_get_info();
+	struct ec_params_power_trace p = {};
+	struct ec_response_power_trace_energy energy;
+	static uint8_t buf[256];
+	struct ec_response_power_trace_samples *r = (void *)buf;
+	struct ec_power_trace_sample prev = {};
+	const struct ec_power_trace_sample *s;
+	int expect_mj, battery_mj = 0, time_ms = 0, battery_time_ms = 0;
+	int fresh = 0;
+	bool repeat;
+	int i;
+
+	test_setup(0);
+	sb_write(SB_CURRENT, -1000);
+	/* Battery readings come from the charger task's last poll */
+	charge_wakeup();
+	crec_msleep(10);
+
+	p.cmd = EC_POWER_TRACE_CMD_CLEAR;
+	TEST_ASSERT(test_send_host_command(EC_CMD_POWER_TRACE, 0, &p,
+					   sizeof(p), NULL,
+					   0) == EC_RES_SUCCESS);
+	p.cmd = EC_POWER_TRACE_CMD_SET_PERIOD;
+	p.period_ms = 10;
+	TEST_ASSERT(test_send_host_command(EC_CMD_POWER_TRACE, 0, &p,
+					   sizeof(p), NULL,
+					   0) == EC_RES_SUCCESS);
+	crec_msleep(1005);
+	p.period_ms = 0;
+	TEST_ASSERT(test_send_host_command(EC_CMD_POWER_TRACE, 0, &p,
+					   sizeof(p), NULL,
+					   0) == EC_RES_SUCCESS);
+
+	/* 1 s at 10 ms intervals, integrated from the second sample on */
+	p.cmd = EC_POWER_TRACE_CMD_GET_ENERGY;
+	TEST_ASSERT(test_send_host_command(EC_CMD_POWER_TRACE, 0, &p,
+					   sizeof(p), &energy,
+					   sizeof(energy) - 1) ==
+		    EC_RES_RESPONSE_TOO_BIG);
+	TEST_ASSERT(test_send_host_command(EC_CMD_POWER_TRACE, 0, &p,
+					   sizeof(p), &energy,
+					   sizeof(energy)) == EC_RES_SUCCESS);
+	TEST_EQ(energy.period_ms, 0, "%d");
+	TEST_GE(energy.sample_count, 100, "%u");
+	TEST_LE(energy.sample_count, 102, "%u");
+	for (i = 0; i < EC_POWER_TRACE_STATE_COUNT; i++) {
+		/* No AC: input readings are valid and zero */
+		TEST_EQ(energy.state[i].input_mj, 0, "%u");
+		time_ms += energy.state[i].time_ms;
+		battery_time_ms += energy.state[i].battery_time_ms;
+		battery_mj += energy.state[i].battery_mj;
+	}
+	TEST_NEAR(time_ms, 1000, 20, "%d");
+	/* Battery energy only counts the time between the charger's polls */
+	expect_mj = -battery_time_ms * bat_info->voltage_normal / 1000;
+	TEST_NEAR(battery_mj, expect_mj, ABS(expect_mj) / 100, "%d");
+
+	/* Samples are kept oldest first */
+	p.cmd = EC_POWER_TRACE_CMD_GET_SAMPLES;
+	for (p.offset = 0; p.offset < energy.sample_count;
+	     p.offset += r->count) {
+		TEST_ASSERT(test_send_host_command(EC_CMD_POWER_TRACE, 0, &p,
+						   sizeof(p), buf,
+						   sizeof(buf)) ==
+			    EC_RES_SUCCESS);
+		TEST_EQ(r->total, energy.sample_count, "%d");
+		TEST_EQ(r->first, 0, "%u");
+		if (!p.offset)
+			TEST_EQ(r->count,
+				(int)((sizeof(buf) - sizeof(*r)) /
+				      sizeof(r->samples[0])),
+				"%d");
+		TEST_GT(r->count, 0, "%d");
+		for (i = 0; i < r->count; i++) {
+			s = &r->samples[i];
+			repeat = s->flags & EC_POWER_TRACE_SAMPLE_BATTERY_REPEAT;
+			TEST_EQ(s->flags & ~EC_POWER_TRACE_SAMPLE_BATTERY_REPEAT,
+				EC_POWER_TRACE_SAMPLE_INPUT |
+					EC_POWER_TRACE_SAMPLE_BATTERY,
+				"%d");
+			TEST_EQ(s->battery_ma, -1000, "%d");
+			TEST_EQ(s->battery_mv, bat_info->voltage_normal, "%d");
+			if (!p.offset && !i) {
+				/* The first sample starts a series */
+				TEST_ASSERT(!repeat);
+			} else {
+				TEST_NEAR((int)(s->time_us - prev.time_us),
+					  10 * MSEC, MSEC, "%d");
+				/* Between polls, the reading ages a period */
+				if (repeat)
+					TEST_NEAR(s->battery_age_ms,
+						  prev.battery_age_ms + 10, 1,
+						  "%d");
+				else
+					fresh++;
+			}
+			if (!repeat)
+				TEST_LE(s->battery_age_ms, 11, "%d");
+			prev = *s;
+		}
+	}
+	/* The discharging battery is polled every CHARGE_POLL_PERIOD_LONG */
+	TEST_NEAR(fresh, 2, 1, "%d");
+	TEST_NEAR(battery_time_ms, fresh * CHARGE_POLL_PERIOD_LONG / MSEC, 20,
+		  "%d");
+
+	/* The mock charger can't measure input current */
+	test_setup(1);
+	p.cmd = EC_POWER_TRACE_CMD_CLEAR;
+	test_send_host_command(EC_CMD_POWER_TRACE, 0, &p, sizeof(p), NULL, 0);
+	p.cmd = EC_POWER_TRACE_CMD_SET_PERIOD;
+	p.period_ms = 1;
+	test_send_host_command(EC_CMD_POWER_TRACE, 0, &p, sizeof(p), NULL, 0);
+	crec_msleep(100);
+	p.period_ms = 0;
+	test_send_host_command(EC_CMD_POWER_TRACE, 0, &p, sizeof(p), NULL, 0);
+
+	p.cmd = EC_POWER_TRACE_CMD_GET_SAMPLES;
+	p.offset = 0;
+	TEST_ASSERT(test_send_host_command(EC_CMD_POWER_TRACE, 0, &p,
+					   sizeof(p), buf,
+					   sizeof(buf)) == EC_RES_SUCCESS);
+	/* The period is raised to CONFIG_POWER_TRACE_MIN_PERIOD_MS */
+	TEST_NEAR(r->total, 100 / CONFIG_POWER_TRACE_MIN_PERIOD_MS, 1, "%d");
+	TEST_EQ(r->samples[0].flags, EC_POWER_TRACE_SAMPLE_BATTERY, "%d");
+	TEST_EQ(r->samples[0].battery_ma, 1000, "%d");
+
+	return EC_SUCCESS;
+}
+
+test_static int test_static_info_cache(void)
+{
+	const struct battery_static_info *bs = &battery_static[BATT_IDX_MAIN];
+	uint32_t generation;
+	int reads, serial;
+
+	test_setup(1);
+
+	/* A battery with another serial number is read in full */
+	TEST_ASSERT(!sb_read(SB_SERIAL_NUMBER, &serial));
+	sb_write(SB_SERIAL_NUMBER, serial + 1);
+	generation = battery_static_info_generation();
+	reads = device_name_reads;
+	TEST_EQ(update_static_battery_info(), EC_SUCCESS, "%d");
+	TEST_EQ(device_name_reads, reads + 1, "%d");
+	TEST_EQ(battery_static_info_generation(), generation + 1, "%u");
+	TEST_ASSERT(!strcmp(bs->model_ext, "MOCKBATT"));
+
+	/* The same battery is only identified, its strings are kept */
+	sb_write(SB_CYCLE_COUNT, 42);
+	TEST_EQ(update_static_battery_info(), EC_SUCCESS, "%d");
+	TEST_EQ(device_name_reads, reads + 1, "%d");
+	TEST_EQ(battery_static_info_generation(), generation + 1, "%u");
+	TEST_ASSERT(!strcmp(bs->model_ext, "MOCKBATT"));
+	TEST_EQ(bs->cycle_count, 42, "%d");
+
+	/* Once the battery goes away, it is read in full when it's back */
+	TEST_ASSERT(test_detach_i2c(I2C_PORT_BATTERY, BATTERY_ADDR_FLAGS) ==
+		    EC_SUCCESS);
+	crec_msleep(BATTERY_DETACH_DELAY);
+	wait_charging_state();
+	test_attach_i2c(I2C_PORT_BATTERY, BATTERY_ADDR_FLAGS);
+	wait_charging_state();
+	TEST_GT(device_name_reads, reads + 1, "%d");
+	TEST_GT(battery_static_info_generation(), generation + 1, "%u");
+
+	/* ... and the cache is good again */
+	reads = device_name_reads;
+	generation = battery_static_info_generation();
+	TEST_EQ(update_static_battery_info(), EC_SUCCESS, "%d");
+	TEST_EQ(device_name_reads, reads, "%d");
+	TEST_EQ(battery_static_info_generation(), generation, "%u");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	RUN_TEST(test_charge_state);
@@ -1131,6 +1358,8 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_cold_battery_with_ac);
 	RUN_TEST(test_cold_battery_no_ac);
 	RUN_TEST(test_external_funcs);
+	RUN_TEST(test_charge_loop_stats);
+	RUN_TEST(test_power_trace);
 	RUN_TEST(test_hc_charge_state);
 	RUN_TEST(test_hc_current_limit);
 	RUN_TEST(test_hc_current_limit_v1);
@@ -1140,6 +1369,7 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_battery_sustainer_without_idle);
 	RUN_TEST(test_battery_sustainer_with_idle);
 	RUN_TEST(test_deep_charge_battery);
+	RUN_TEST(test_static_info_cache);
 
 	test_print_result();
 }
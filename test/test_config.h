@@ -67,20 +67,29 @@ enum battery_type {
 #define CONFIG_KEYBOARD_PROTOCOL_8042
 #define CONFIG_8042_AUX
 #define CONFIG_KEYBOARD_DEBUG
+#define CONFIG_KEYBOARD_LATENCY_STATS
+#undef CONFIG_8042_TO_HOST_QUEUE_SIZE
+#define CONFIG_8042_TO_HOST_QUEUE_SIZE 64
+#undef CONFIG_8042_AUX_QUEUE_SIZE
+#define CONFIG_8042_AUX_QUEUE_SIZE 64
 #endif
 
 #ifdef TEST_KB_MKBP
 #define CONFIG_KEYBOARD_PROTOCOL_MKBP
 #define CONFIG_MKBP_EVENT
 #define CONFIG_MKBP_USE_GPIO
+#define CONFIG_KEYBOARD_LATENCY_STATS
 #endif
 
 #if defined(TEST_KB_SCAN) || defined(TEST_KB_SCAN_STRICT)
 #define CONFIG_KEYBOARD_PROTOCOL_MKBP
 #define CONFIG_MKBP_EVENT
 #define CONFIG_MKBP_USE_GPIO
+#define CONFIG_KEYBOARD_LATENCY_STATS
 #ifdef TEST_KB_SCAN_STRICT
 #define CONFIG_KEYBOARD_STRICT_DEBOUNCE
+#else
+#define CONFIG_KEYBOARD_SCAN_INCREMENTAL
 #endif
 #endif
 
@@ -155,6 +164,7 @@ enum battery_type {
 #define CONFIG_ACCEL_FIFO
 #define CONFIG_ACCEL_FIFO_SIZE 256
 #define CONFIG_ACCEL_FIFO_THRES 10
+#define CONFIG_ACCEL_FIFO_BATCH
 #endif
 
 #ifdef TEST_KASA
@@ -212,13 +222,19 @@ enum battery_type {
 #define CONFIG_ONLINE_CALIB_SPOOF_MODE
 #endif /* TEST_ONLINE_CALIBRATION_SPOOF */
 
-#ifdef TEST_GYRO_CAL
+#if defined(TEST_GYRO_CAL) || defined(TEST_GYRO_CAL_INT16)
 #define CONFIG_FPU
 #define CONFIG_ONLINE_CALIB
 #define CONFIG_MKBP_EVENT
 #define CONFIG_MKBP_USE_GPIO
 #endif
 
+#ifdef TEST_GYRO_CAL_INT16_FIXED
+#undef CONFIG_FPU
+/* For vec3.c and math_util.c, gyro_cal_fixed.c builds the rest */
+#define CONFIG_MAG_CALIBRATE
+#endif
+
 #if defined(CONFIG_ONLINE_CALIB) && !defined(CONFIG_TEMP_CACHE_STALE_THRES)
 #define CONFIG_TEMP_CACHE_STALE_THRES (1 * SECOND)
 #endif /* CONFIG_ONLINE_CALIB && !CONFIG_TEMP_CACHE_STALE_THRES */
@@ -226,7 +242,8 @@ enum battery_type {
 #if defined(CONFIG_ONLINE_CALIB) || defined(TEST_BODY_DETECTION) ||        \
 	defined(TEST_MOTION_ANGLE) || defined(TEST_MOTION_ANGLE_TABLET) || \
 	defined(TEST_MOTION_LID) || defined(TEST_MOTION_SENSE_FIFO) ||     \
-	defined(TEST_TABLET_BROKEN_SENSOR)
+	defined(TEST_TABLET_BROKEN_SENSOR) ||                               \
+	defined(TEST_GYRO_CAL_INT16_FIXED)
 enum sensor_id {
 	BASE,
 	LID,
@@ -312,6 +329,7 @@ enum sensor_id {
 #define CONFIG_BATTERY_COUNT 1
 #define CONFIG_BATTERY_MOCK
 #define CONFIG_BATTERY_SMART
+#define CONFIG_BATTERY_STATIC_INFO_CACHE
 #define CONFIG_CHARGER
 #define CONFIG_CHARGER_PROFILE_OVERRIDE
 #define CONFIG_CHARGER_DEFAULT_CURRENT_LIMIT 4032
@@ -319,6 +337,7 @@ enum sensor_id {
 #define CONFIG_CHARGER_DISCHARGE_ON_AC_CUSTOM
 #define CONFIG_I2C
 #define CONFIG_I2C_CONTROLLER
+#define CONFIG_POWER_TRACE
 int board_discharge_on_ac(int enabled);
 #define I2C_PORT_MASTER 0
 #define I2C_PORT_BATTERY 0
@@ -345,6 +364,15 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_FANS 1
 #endif
 
+#ifdef TEST_HOOKS
+#define CONFIG_BOOT_TIME_PROFILE
+#endif
+
+#ifdef TEST_FAN_PID
+#define CONFIG_FANS 1
+#define CONFIG_FAN_PID_CONTROL
+#endif
+
 #ifdef TEST_BUTTON
 #define CONFIG_KEYBOARD_PROTOCOL_8042
 #undef CONFIG_KEYBOARD_VIVALDI
@@ -352,7 +380,8 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_HOSTCMD_BUTTON
 #endif
 
-#ifdef TEST_BATTERY_GET_PARAMS_SMART
+#if defined(TEST_BATTERY_GET_PARAMS_SMART) || \
+	defined(TEST_BATTERY_GET_PARAMS_SMART_TIERED)
 #define CONFIG_BATTERY_MOCK
 #define CONFIG_BATTERY_SMART
 #define CONFIG_CHARGER_DEFAULT_CURRENT_LIMIT 4032
@@ -363,6 +392,14 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define I2C_PORT_CHARGER 0
 #endif
 
+#ifdef TEST_BATTERY_GET_PARAMS_SMART_TIERED
+#define CONFIG_BATTERY_SMART_POLL_TIERS
+#undef CONFIG_BATTERY_SMART_POLL_MEDIUM_MS
+#define CONFIG_BATTERY_SMART_POLL_MEDIUM_MS 100
+#undef CONFIG_BATTERY_SMART_POLL_SLOW_MS
+#define CONFIG_BATTERY_SMART_POLL_SLOW_MS 1000
+#endif
+
 #ifdef TEST_LIGHTBAR
 #define CONFIG_I2C
 #define CONFIG_I2C_CONTROLLER
@@ -394,6 +431,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #if defined(TEST_USB_SM_FRAMEWORK_H3) || defined(TEST_USB_SM_FRAMEWORK_H2) || \
 	defined(TEST_USB_SM_FRAMEWORK_H1) || defined(TEST_USB_SM_FRAMEWORK_H0)
 #define CONFIG_TEST_SM
+#define CONFIG_USB_SM_TRACE
 #endif
 
 #if defined(TEST_USB_PRL_OLD) || defined(TEST_USB_PRL_NOEXTENDED)
@@ -434,6 +472,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #undef CONFIG_USB_PD_HOST_CMD
 #define CONFIG_USB_PRL_SM
 #define CONFIG_USB_POWER_DELIVERY
+#define CONFIG_USB_PD_PRL_TIMING_LOG
 #endif
 
 #if defined(TEST_USB_PE_DRP_OLD) || defined(TEST_USB_PE_DRP_OLD_NOEXTENDED)
@@ -460,6 +499,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_USB_PD_DISCOVERY
 #define CONFIG_USBC_SS_MUX
 #define CONFIG_USB_PD_3A_PORTS 0 /* Host does not define a 3.0 A PDO */
+#define CONFIG_USB_SM_TRACE
 #endif
 
 #if defined(TEST_USB_PE_DRP) || defined(TEST_USB_PE_DRP_NOEXTENDED)
@@ -488,6 +528,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define I2C_PORT_HOST_TCPC 0
 #define CONFIG_CHARGE_MANAGER
 #define CONFIG_USB_PD_3A_PORTS 0 /* Host does not define a 3.0 A PDO */
+#define CONFIG_USB_SM_TRACE
 #endif /* TEST_USB_PE_DRP || TEST_USB_PE_DRP_NOEXTENDED */
 
 /* Common TypeC tests defines */
@@ -575,6 +616,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_USB_PD_EXTENDED_MESSAGES
 #define CONFIG_USB_PD_DECODE_SOP
 #define CONFIG_USB_PD_3A_PORTS 0 /* Host does not define a 3.0 A PDO */
+#define CONFIG_USB_SM_TRACE
 #endif
 
 #ifdef TEST_USB_PD_INT
@@ -636,10 +678,13 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #undef CONFIG_USB_DPM_SM
 #endif
 
-#if defined(TEST_CHARGE_MANAGER) || defined(TEST_CHARGE_MANAGER_DRP_CHARGING)
+#if defined(TEST_CHARGE_MANAGER) ||                  \
+	defined(TEST_CHARGE_MANAGER_DRP_CHARGING) || \
+	defined(TEST_CHARGE_MANAGER_REFRESH_WINDOW)
 #define CONFIG_CHARGE_MANAGER
 #define CONFIG_USB_CHARGER
 #define CONFIG_USB_PD_3A_PORTS 0 /* Host does not define a 3.0 A PDO */
+#define CONFIG_USB_SM_TRACE
 #define CONFIG_USB_PD_DUAL_ROLE
 #define CONFIG_USB_PD_PORT_MAX_COUNT 2
 #define CONFIG_USB_POWER_DELIVERY
@@ -651,6 +696,11 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #undef CONFIG_USB_PD_HOST_CMD
 #endif /* TEST_CHARGE_MANAGER_* */
 
+#ifdef TEST_CHARGE_MANAGER_REFRESH_WINDOW
+#undef CONFIG_CHARGE_MANAGER_REFRESH_WINDOW_MS
+#define CONFIG_CHARGE_MANAGER_REFRESH_WINDOW_MS 20
+#endif
+
 #ifdef TEST_CHARGE_MANAGER_DRP_CHARGING
 #define CONFIG_CHARGE_MANAGER_DRP_CHARGING
 #else
@@ -659,6 +709,8 @@ int ncp15wb_calculate_temp(uint16_t adc);
 
 #ifdef TEST_CHARGE_RAMP
 #define CONFIG_CHARGE_RAMP_SW
+#define CONFIG_CHARGE_RAMP_SEARCH
+#define CONFIG_CHARGE_RAMP_HISTORY
 #define CONFIG_USB_PD_PORT_MAX_COUNT 2
 #undef CONFIG_USB_PD_HOST_CMD
 #endif
@@ -690,6 +742,23 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_CURVE25519
 #endif /* TEST_X25519 */
 
+#ifdef TEST_I2C_HID_TOUCHPAD
+#define CONFIG_I2C_HID_TOUCHPAD
+#define I2C_HID_TOUCHPAD_VENDOR_ID 0x18d1
+#define I2C_HID_TOUCHPAD_PRODUCT_ID 0x0000
+#define I2C_HID_TOUCHPAD_FW_VERSION 0x0001
+#define I2C_HID_TOUCHPAD_MAX_X 3000
+#define I2C_HID_TOUCHPAD_MAX_Y 2000
+#define I2C_HID_TOUCHPAD_MAX_PHYSICAL_X 100
+#define I2C_HID_TOUCHPAD_MAX_PHYSICAL_Y 70
+#define I2C_HID_TOUCHPAD_MAX_WIDTH 255
+#define I2C_HID_TOUCHPAD_MAX_HEIGHT 255
+#define I2C_HID_TOUCHPAD_MAX_PRESSURE 255
+#define I2C_HID_TOUCHPAD_MAX_ORIENTATION 1
+#define I2C_HID_TOUCHPAD_MOUSE_SCALE_X 1
+#define I2C_HID_TOUCHPAD_MOUSE_SCALE_Y 1
+#endif
+
 #ifdef TEST_I2C_BITBANG
 #define CONFIG_I2C
 #define CONFIG_I2C_CONTROLLER
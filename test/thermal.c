@@ -32,6 +32,7 @@ BUILD_ASSERT(EC_TEMP_THRESH_COUNT == 3);
 /* Mock functions */
 
 static int mock_temp[TEMP_SENSOR_COUNT];
+static int mock_reads[TEMP_SENSOR_COUNT];
 static int host_throttled;
 static int cpu_throttled;
 static int cpu_shutdown;
@@ -40,6 +41,7 @@ static int no_temps_read;
 
 int mock_temp_get_val(int idx, int *temp_ptr)
 {
+	mock_reads[idx]++;
 	if (mock_temp[idx] >= 0) {
 		*temp_ptr = mock_temp[idx];
 		return EC_SUCCESS;
@@ -478,6 +480,65 @@ static int test_several_limits(void)
 	return EC_SUCCESS;
 }
 
+static int test_sample_cache(void)
+{
+	uint8_t *mptr = host_get_memmap(EC_MEMMAP_TEMP_SENSOR);
+	int t;
+
+	reset_mocks();
+	all_temps(300);
+	thermal_params[2].temp_fan_off = 100;
+	thermal_params[2].temp_fan_max = 400;
+	TEST_EQ(temp_sensor_set_sample_period(1, 3), EC_SUCCESS, "%d");
+	TEST_EQ(temp_sensor_set_sample_period(1, 0), EC_ERROR_INVAL, "%d");
+	crec_sleep(3);
+
+	/* Thermal control and host memmap share one read per second */
+	memset(mock_reads, 0, sizeof(mock_reads));
+	crec_sleep(6);
+	TEST_EQ(mock_reads[0], 6, "%d");
+	TEST_EQ(mock_reads[1], 2, "%d");
+	TEST_EQ(temp_sensor_read_cached(0, &t), EC_SUCCESS, "%d");
+	TEST_EQ(t, 300, "%d");
+	TEST_EQ(mptr[0], 300 - EC_TEMP_SENSOR_OFFSET, "%d");
+	TEST_EQ(fan_pct, 66, "%d");
+
+	/* Readings don't change until the next sample */
+	all_temps(250);
+	TEST_EQ(temp_sensor_read_cached(0, &t), EC_SUCCESS, "%d");
+	TEST_EQ(t, 300, "%d");
+	crec_sleep(1);
+	TEST_EQ(temp_sensor_read_cached(0, &t), EC_SUCCESS, "%d");
+	TEST_EQ(t, 250, "%d");
+	TEST_EQ(mptr[0], 250 - EC_TEMP_SENSOR_OFFSET, "%d");
+
+	/* Failed sensors are retried every second */
+	mock_temp[1] = -1;
+	crec_sleep(3);
+	memset(mock_reads, 0, sizeof(mock_reads));
+	crec_sleep(3);
+	TEST_EQ(mock_reads[1], 3, "%d");
+	TEST_EQ(temp_sensor_read_cached(1, &t), EC_ERROR_NOT_POWERED, "%d");
+	TEST_EQ(mptr[1], EC_TEMP_SENSOR_NOT_POWERED, "%d");
+
+	/* A chipset power change resamples right away, whatever the period */
+	mock_temp[1] = 300;
+	/* Halfway between two HOOK_SECONDs */
+	crec_msleep(1500);
+	TEST_EQ(temp_sensor_read_cached(1, &t), EC_SUCCESS, "%d");
+	mock_temp[1] = -1;
+	memset(mock_reads, 0, sizeof(mock_reads));
+	hook_notify(HOOK_CHIPSET_SHUTDOWN);
+	crec_msleep(10);
+	TEST_EQ(mock_reads[0], 1, "%d");
+	TEST_EQ(mock_reads[1], 1, "%d");
+	TEST_EQ(temp_sensor_read_cached(1, &t), EC_ERROR_NOT_POWERED, "%d");
+
+	TEST_EQ(temp_sensor_set_sample_period(1, 1), EC_SUCCESS, "%d");
+
+	return EC_SUCCESS;
+}
+
 /* Tests for ncp15wb thermistor ADC-to-temp calculation */
 #define LOW_ADC_TEST_VALUE 887 /* 0 C */
 #define HIGH_ADC_TEST_VALUE 100 /* > 100C */
@@ -635,6 +696,7 @@ void run_test(int argc, const char **argv)
 
 	RUN_TEST(test_one_limit);
 	RUN_TEST(test_several_limits);
+	RUN_TEST(test_sample_cache);
 
 	RUN_TEST(test_ncp15wb_adc_to_temp);
 	RUN_TEST(test_thermistor_linear_interpolate);
@@ -4,8 +4,10 @@
  *
  * Test USB common module.
  */
+#include "console.h"
 #include "test_util.h"
 #include "usb_common.h"
+#include "usb_pd.h"
 
 #define PDO_FIXED_FLAGS \
 	(PDO_FIXED_DUAL_ROLE | PDO_FIXED_DATA_SWAP | PDO_FIXED_COMM_CAP)
@@ -41,9 +43,145 @@ test_static int test_pd_find_pdo_index(void)
 	return EC_SUCCESS;
 }
 
+/* Test that the cached selection matches a full scan of the source caps. */
+test_static int test_pd_get_best_pdo(void)
+{
+	uint32_t src_caps[] = {
+		PDO_FIXED(5000, 3000, PDO_FIXED_FLAGS),
+		PDO_FIXED(9000, 3000, PDO_FIXED_FLAGS),
+		PDO_FIXED(12000, 3000, PDO_FIXED_FLAGS),
+		PDO_FIXED(15000, 3000, PDO_FIXED_FLAGS),
+		PDO_FIXED(20000, 3000, PDO_FIXED_FLAGS),
+	};
+	const int port = 0;
+	uint32_t pdo;
+	int mv;
+
+	pd_set_src_caps(port, ARRAY_SIZE(src_caps), src_caps);
+
+	for (mv = 5000; mv <= 20000; mv += 1000) {
+		uint32_t expect_pdo;
+		int expect = pd_find_pdo_index(ARRAY_SIZE(src_caps), src_caps,
+					       mv, &expect_pdo);
+
+		/* Second lookup is served from the cache */
+		TEST_EQ(pd_get_best_pdo(port, mv, &pdo), expect, "%d");
+		TEST_EQ(pdo, expect_pdo, "0x%08x");
+		TEST_EQ(pd_get_best_pdo(port, mv, &pdo), expect, "%d");
+		TEST_EQ(pdo, expect_pdo, "0x%08x");
+	}
+
+	return EC_SUCCESS;
+}
+
+/* Test that storing new source caps drops the cached selection. */
+test_static int test_pd_get_best_pdo_invalidate(void)
+{
+	uint32_t src_caps[] = {
+		PDO_FIXED(5000, 3000, PDO_FIXED_FLAGS),
+		PDO_FIXED(9000, 3000, PDO_FIXED_FLAGS),
+		PDO_FIXED(15000, 3000, PDO_FIXED_FLAGS),
+	};
+	const int port = 0;
+	uint32_t pdo;
+
+	pd_set_src_caps(port, ARRAY_SIZE(src_caps), src_caps);
+	TEST_EQ(pd_get_best_pdo(port, 20000, &pdo), 2, "%d");
+	TEST_EQ(pdo, src_caps[2], "0x%08x");
+
+	/* Same ceiling, new caps: the 15 V PDO is gone */
+	pd_set_src_caps(port, 2, src_caps);
+	TEST_EQ(pd_get_best_pdo(port, 20000, &pdo), 1, "%d");
+	TEST_EQ(pdo, src_caps[1], "0x%08x");
+
+	/* Caps contents change without a count change */
+	src_caps[1] = PDO_FIXED(9000, 1000, PDO_FIXED_FLAGS);
+	pd_set_src_caps(port, 2, src_caps);
+	TEST_EQ(pd_get_best_pdo(port, 20000, &pdo), 0, "%d");
+	TEST_EQ(pdo, src_caps[0], "0x%08x");
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Test that the ranking picks the same PDO as a full scan, for random source
+ * caps of every PDO type and every voltage ceiling.
+ */
+test_static int test_pd_get_best_pdo_synthetic(void)
+{
+	uint32_t src_caps[PDO_MAX_OBJECTS];
+	const int port = 0;
+	uint32_t seed = 0x1234;
+	uint32_t pdo, expect_pdo;
+	int set, cnt, i, mv, expect;
+
+	for (set = 0; set < 1000; set++) {
+		cnt = 1 + (seed = prng(seed)) % ARRAY_SIZE(src_caps);
+		src_caps[0] = PDO_FIXED(5000, 3000, PDO_FIXED_FLAGS);
+		for (i = 1; i < cnt; i++) {
+			int v = 5000 + (seed = prng(seed)) % 16 * 1000;
+			int ma = 500 + (seed = prng(seed)) % 6 * 500;
+
+			switch ((seed = prng(seed)) % 4) {
+			case 0:
+				src_caps[i] = PDO_FIXED(v, ma, 0);
+				break;
+			case 1:
+				src_caps[i] = PDO_VAR(v - 1000, v, ma);
+				break;
+			case 2:
+				src_caps[i] =
+					PDO_BATT(v - 1000, v, v * ma / 1000);
+				break;
+			default:
+				src_caps[i] = PDO_AUG(3300, v, ma);
+				break;
+			}
+		}
+		pd_set_src_caps(port, cnt, src_caps);
+
+		for (mv = 4000; mv <= 21000; mv += 500) {
+			expect = pd_find_pdo_index(cnt, src_caps, mv,
+						   &expect_pdo);
+			TEST_EQ(pd_get_best_pdo(port, mv, &pdo), expect, "%d");
+			TEST_EQ(pdo, expect_pdo, "0x%08x");
+		}
+	}
+
+	return EC_SUCCESS;
+}
+
+/* Test that PDOs offering the same power keep the lowest index. */
+test_static int test_pd_get_best_pdo_tie(void)
+{
+	uint32_t src_caps[] = {
+		PDO_FIXED(5000, 3000, PDO_FIXED_FLAGS),
+		PDO_FIXED(15000, 2000, PDO_FIXED_FLAGS),
+		PDO_FIXED(20000, 1500, PDO_FIXED_FLAGS),
+		PDO_AUG(3300, 21000, 3000),
+		PDO_FIXED(9000, 3000, PDO_FIXED_FLAGS),
+	};
+	const int port = 0;
+	uint32_t pdo;
+
+	pd_set_src_caps(port, ARRAY_SIZE(src_caps), src_caps);
+	TEST_EQ(pd_get_best_pdo(port, 20000, &pdo), 1, "%d");
+	TEST_EQ(pdo, src_caps[1], "0x%08x");
+	TEST_EQ(pd_get_best_pdo(port, 14000, &pdo), 4, "%d");
+	TEST_EQ(pdo, src_caps[4], "0x%08x");
+	TEST_EQ(pd_get_best_pdo(port, 4000, &pdo), 0, "%d");
+	TEST_EQ(pdo, src_caps[0], "0x%08x");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, const char **argv)
 {
 	RUN_TEST(test_pd_find_pdo_index);
+	RUN_TEST(test_pd_get_best_pdo);
+	RUN_TEST(test_pd_get_best_pdo_invalidate);
+	RUN_TEST(test_pd_get_best_pdo_synthetic);
+	RUN_TEST(test_pd_get_best_pdo_tie);
 
 	test_print_result();
 }
@@ -147,6 +147,81 @@ static int test_discard_queued_tx_when_rx_happens(void)
 	return EC_SUCCESS;
 }
 
+static int test_timing_log(void)
+{
+	int port = PORT0;
+	uint16_t header = PD_HEADER(PD_CTRL_DR_SWAP,
+				    get_partner_power_role(port),
+				    get_partner_data_role(port),
+				    mock_tc_port[port].msg_rx_id, 0,
+				    mock_tc_port[port].rev, 0);
+	struct ec_params_usb_pd_prl_timing params = {
+		.port = port,
+		.flags = EC_PRL_TIMING_FLAG_CLEAR,
+	};
+	struct {
+		struct ec_response_usb_pd_prl_timing r;
+		struct ec_prl_timing_entry entries[8];
+	} resp;
+
+	TEST_EQ(test_send_host_command(EC_CMD_USB_PD_PRL_TIMING, 0, &params,
+				       sizeof(params), &resp, sizeof(resp)),
+		EC_RES_SUCCESS, "%d");
+
+	/* Receive a message, then send and complete the response. */
+	mock_tcpm_rx_msg(port, header, 0, NULL);
+	task_wait_event(10 * MSEC);
+	prl_send_ctrl_msg(port, TCPCI_MSG_SOP, PD_CTRL_ACCEPT);
+	task_wait_event(MSEC);
+	pd_transmit_complete(port, TCPC_TX_COMPLETE_SUCCESS);
+	task_wait_event(10 * MSEC);
+
+	params.flags = 0;
+	TEST_EQ(test_send_host_command(EC_CMD_USB_PD_PRL_TIMING, 0, &params,
+				       sizeof(params), &resp, sizeof(resp)),
+		EC_RES_SUCCESS, "%d");
+	/* Exactly one RX, one TX start and one GoodCRC */
+	TEST_EQ(resp.r.total, 3, "%d");
+	TEST_EQ(resp.r.count, 3, "%d");
+
+	TEST_EQ(resp.r.entries[0].event, EC_PRL_TIMING_RX, "%d");
+	TEST_EQ(resp.r.entries[0].header, header, "0x%x");
+	TEST_EQ(resp.r.entries[1].event, EC_PRL_TIMING_TX_START, "%d");
+	TEST_EQ(PD_HEADER_TYPE(resp.r.entries[1].header), PD_CTRL_ACCEPT,
+		"%d");
+	TEST_EQ(resp.r.entries[1].sop, TCPCI_MSG_SOP, "%d");
+	TEST_EQ(resp.r.entries[2].event, EC_PRL_TIMING_TX_SUCCESS, "%d");
+	TEST_LE(resp.r.entries[0].time_us, resp.r.entries[1].time_us, "%u");
+	TEST_LE(resp.r.entries[1].time_us, resp.r.entries[2].time_us, "%u");
+
+	/* Reading from an offset skips the older entries */
+	params.offset = 2;
+	TEST_EQ(test_send_host_command(EC_CMD_USB_PD_PRL_TIMING, 0, &params,
+				       sizeof(params), &resp, sizeof(resp)),
+		EC_RES_SUCCESS, "%d");
+	TEST_EQ(resp.r.total, 3, "%d");
+	TEST_EQ(resp.r.count, 1, "%d");
+	TEST_EQ(resp.r.entries[0].event, EC_PRL_TIMING_TX_SUCCESS, "%d");
+
+	/* A page holds as many whole entries as fit in the response */
+	params.offset = 0;
+	TEST_EQ(test_send_host_command(EC_CMD_USB_PD_PRL_TIMING, 0, &params,
+				       sizeof(params), &resp,
+				       sizeof(resp.r) +
+					       2 * sizeof(resp.entries[0]) - 1),
+		EC_RES_SUCCESS, "%d");
+	TEST_EQ(resp.r.total, 3, "%d");
+	TEST_EQ(resp.r.count, 1, "%d");
+	TEST_EQ(resp.r.entries[0].event, EC_PRL_TIMING_RX, "%d");
+
+	TEST_EQ(test_send_host_command(EC_CMD_USB_PD_PRL_TIMING, 0, &params,
+				       sizeof(params), &resp,
+				       sizeof(resp.r) - 1),
+		EC_RES_RESPONSE_TOO_BIG, "%d");
+
+	return EC_SUCCESS;
+}
+
 void before_test(void)
 {
 	mock_tc_port_reset();
@@ -171,6 +246,7 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_receive_control_msg);
 	RUN_TEST(test_send_control_msg);
 	RUN_TEST(test_discard_queued_tx_when_rx_happens);
+	RUN_TEST(test_timing_log);
 	/* TODO add tests here */
 
 	/* Do basic state machine validity checks last. */
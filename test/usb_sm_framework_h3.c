@@ -1021,6 +1021,28 @@ test_static int test_set_state_from_parents(void)
 	return EC_SUCCESS;
 }
 
+test_static int test_transition_trace(void)
+{
+	int port = PORT0;
+	struct usb_sm_trace_entry entries[4];
+
+	usb_sm_trace_clear();
+	TEST_EQ(usb_sm_trace_read(entries, ARRAY_SIZE(entries)), 0, "%d");
+
+	set_state_sm(port, SM_TEST_A4);
+	set_state_sm(port, SM_TEST_B4);
+
+	TEST_EQ(usb_sm_trace_read(entries, ARRAY_SIZE(entries)), 2, "%d");
+	TEST_EQ(entries[0].port, port, "%d");
+	TEST_ASSERT(entries[0].from == NULL);
+	TEST_ASSERT(entries[0].to == &states[SM_TEST_A4]);
+	TEST_ASSERT(entries[1].from == &states[SM_TEST_A4]);
+	TEST_ASSERT(entries[1].to == &states[SM_TEST_B4]);
+	TEST_ASSERT(entries[1].time_us >= entries[0].time_us);
+
+	return EC_SUCCESS;
+}
+
 #ifdef TEST_USB_SM_FRAMEWORK_H3
 #define TEST_AT_LEAST_3
 #endif
@@ -1139,6 +1161,70 @@ static const struct usb_state states[] = {
 	},
 };
 
+/* Number of super states above SM_TEST_A4 and SM_TEST_B4 */
+#if defined(TEST_AT_LEAST_3)
+#define SUPER_DEPTH 3
+#elif defined(TEST_AT_LEAST_2)
+#define SUPER_DEPTH 2
+#elif defined(TEST_AT_LEAST_1)
+#define SUPER_DEPTH 1
+#else
+#define SUPER_DEPTH 0
+#endif
+
+/* Number of A4 -> B4 -> A4 round trips made by test_transition_sequence */
+#define ROUND_TRIPS 100
+
+/*
+ * Check the exit and entry sequence of a transition from the deepest state of
+ * one hierarchy to the deepest state of the other, which share no parents.
+ */
+static int check_transition(const int *exits, const int *entries)
+{
+	int port = PORT0;
+	int i;
+
+	/* The whole old chain exits, then the whole new chain enters */
+	TEST_EQ(sm[port].idx, 2 * (SUPER_DEPTH + 1), "%d");
+	for (i = 0; i <= SUPER_DEPTH; i++) {
+		TEST_EQ(sm[port].seq[i], exits[i], "%d");
+		TEST_EQ(sm[port].seq[SUPER_DEPTH + 1 + i],
+			entries[3 - SUPER_DEPTH + i], "%d");
+	}
+
+	return EC_SUCCESS;
+}
+
+test_static int test_transition_sequence(void)
+{
+	static const int exit_a[] = { EXIT_A4, EXIT_A3, EXIT_A2, EXIT_A1 };
+	static const int enter_a[] = { ENTER_A1, ENTER_A2, ENTER_A3, ENTER_A4 };
+	static const int exit_b[] = { EXIT_B4, EXIT_B3, EXIT_B2, EXIT_B1 };
+	static const int enter_b[] = { ENTER_B1, ENTER_B2, ENTER_B3, ENTER_B4 };
+	int port = PORT0;
+	int calls = 0;
+	int i;
+
+	set_state_sm(port, SM_TEST_A4);
+
+	for (i = 0; i < ROUND_TRIPS; i++) {
+		sm[port].idx = 0;
+		set_state_sm(port, SM_TEST_B4);
+		TEST_EQ(check_transition(exit_a, enter_b), EC_SUCCESS, "%d");
+		calls += sm[port].idx;
+
+		sm[port].idx = 0;
+		set_state_sm(port, SM_TEST_A4);
+		TEST_EQ(check_transition(exit_b, enter_a), EC_SUCCESS, "%d");
+		calls += sm[port].idx;
+	}
+
+	TEST_EQ(calls, ROUND_TRIPS * 4 * (SUPER_DEPTH + 1), "%d");
+	TEST_ASSERT(sm[port].ctx.current == &states[SM_TEST_A4]);
+
+	return EC_SUCCESS;
+}
+
 /* Run before each RUN_TEST line */
 void before_test(void)
 {
@@ -1174,5 +1260,7 @@ void run_test(int argc, const char **argv)
 #else
 	RUN_TEST(test_hierarchy_0);
 #endif
+	RUN_TEST(test_transition_trace);
+	RUN_TEST(test_transition_sequence);
 	test_print_result();
 }
@@ -58,6 +58,7 @@ void run_test(int argc, const char **argv)
 	RUN_TEST(test_connect_as_nonpd_sink);
 	RUN_TEST(test_retry_count_sop);
 	RUN_TEST(test_retry_count_hard_reset);
+	RUN_TEST(test_sm_trace_snk_negotiation);
 
 	test_print_result();
 }
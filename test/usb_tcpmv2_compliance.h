@@ -91,5 +91,6 @@ int test_td_pd_vndi3_e3_ufp(void);
 int test_connect_as_nonpd_sink(void);
 int test_retry_count_sop(void);
 int test_retry_count_hard_reset(void);
+int test_sm_trace_snk_negotiation(void);
 
 #endif /* USB_TCPMV2_COMPLIANCE_H */
@@ -9,9 +9,12 @@
 #include "test_util.h"
 #include "timer.h"
 #include "usb_prl_sm.h"
+#include "usb_sm.h"
 #include "usb_tc_sm.h"
 #include "usb_tcpmv2_compliance.h"
 
+extern const struct test_sm_data test_pe_sm_data[];
+
 int test_connect_as_nonpd_sink(void)
 {
 	task_wait_event(10 * SECOND);
@@ -105,3 +108,53 @@ int test_retry_count_hard_reset(void)
 
 	return EC_SUCCESS;
 }
+
+/*
+ * Walk a full sink contract negotiation and check the Policy Engine
+ * transitions recorded in the state machine trace.
+ */
+int test_sm_trace_snk_negotiation(void)
+{
+	static const char *const expected[] = {
+		"PE_SNK_Wait_for_Capabilities", "PE_SNK_Evaluate_Capability",
+		"PE_SNK_Select_Capability",	"PE_SNK_Transition_Sink",
+		"PE_SNK_Ready",
+	};
+	const struct test_sm_data *pe = &test_pe_sm_data[0];
+	struct usb_sm_trace_entry entries[32];
+	usb_state_ptr prev = NULL;
+	int n, i, matched = 0;
+
+	TEST_EQ(tcpci_startup(), EC_SUCCESS, "%d");
+	TEST_EQ(proc_pd_e1(PD_ROLE_UFP, INITIAL_ATTACH), EC_SUCCESS, "%d");
+
+	usb_sm_trace_clear();
+	TEST_EQ(proc_pd_e1(PD_ROLE_UFP, ALREADY_ATTACHED), EC_SUCCESS, "%d");
+
+	/*
+	 * The Policy Engine must step through the negotiation one state at a
+	 * time, with no other PE transition in between; the Protocol Layer
+	 * transitions interleaved with them are skipped.
+	 */
+	n = usb_sm_trace_read(entries, ARRAY_SIZE(entries));
+	for (i = 0; i < n && matched < ARRAY_SIZE(expected); i++) {
+		const char *name;
+
+		if (entries[i].to < pe->base ||
+		    entries[i].to >= pe->base + pe->size)
+			continue;
+
+		name = pe->names[entries[i].to - pe->base];
+		if (matched == 0 && strcmp(name, expected[0]))
+			continue;
+
+		TEST_ASSERT(strcmp(name, expected[matched]) == 0);
+		if (matched > 0)
+			TEST_ASSERT(entries[i].from == prev);
+		prev = entries[i].to;
+		matched++;
+	}
+	TEST_EQ(matched, (int)ARRAY_SIZE(expected), "%d");
+
+	return EC_SUCCESS;
+}
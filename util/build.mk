@@ -38,6 +38,7 @@ ectool-objs+=ectool_pdc_pcap.o
 ectool-objs+=../common/crc.o
 ectool_servo-objs=$(ectool-objs) comm-servo-spi.o
 lbplay-objs=lbplay.o $(comm-objs)
+lbcc-objs=lbcc.o ../common/lightbyte.o
 
 util/ectool.cc: $(out)/ec_version.h
 
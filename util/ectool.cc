@@ -33,6 +33,7 @@
 #include <string.h>
 #include <time.h>
 
+#include <algorithm>
 #include <getopt.h>
 #include <iomanip>
 #include <iostream>
@@ -3654,6 +3655,132 @@ int cmd_fanduty(int argc, char *argv[])
 	return 0;
 }
 
+/*
+ * Read all the entries of an EC ring log, oldest first, a page per command.
+ * Each response carries the sequence number of the oldest entry held, which
+ * tells when entries logged since the previous page shifted the offsets of
+ * those not read yet: the page is then read again from the right offset, or
+ * from the start if entries not read yet were overwritten or the log was
+ * cleared.  get_entries() returns the entries of a response, and first, if
+ * not NULL, receives the sequence number of the first entry read.
+ */
+template <typename Response, typename Params, typename Entry, typename Get>
+static int read_ring_log(int command, Params &p, std::vector<Entry> &entries,
+			 Get get_entries, uint32_t *first = NULL)
+{
+	const Response *r = (const Response *)ec_inbuf;
+	const Entry *page;
+	/* Sequence numbers of the page's first entry, and of the next wanted */
+	uint32_t start, next = 0;
+	int retries = 0;
+	int rv;
+
+	entries.clear();
+	p.offset = 0;
+	while (1) {
+		rv = ec_command(command, 0, &p, sizeof(p), ec_inbuf,
+				ec_max_insize);
+		if (rv < 0)
+			return rv;
+
+		start = r->first + p.offset;
+		if (!p.offset) {
+			next = start;
+			if (first)
+				*first = start;
+		} else if (start != next) {
+			if (++retries > 8) {
+				fprintf(stderr, "Log changing faster than it "
+						"can be read.\n");
+				return -1;
+			}
+			if (r->first <= next && next - r->first <= r->total) {
+				p.offset = next - r->first;
+			} else {
+				entries.clear();
+				p.offset = 0;
+			}
+			continue;
+		}
+
+		page = get_entries(r);
+		entries.insert(entries.end(), page, page + r->count);
+		next += r->count;
+		p.offset += r->count;
+		if (!r->count || p.offset >= r->total)
+			return 0;
+	}
+}
+
+int cmd_fantrace(int argc, char *argv[])
+{
+	struct ec_params_fan_pid_trace p = {};
+	std::vector<struct ec_fan_pid_trace_entry> entries;
+	size_t start = 0, settled = 0;
+	int peak = 0;
+	char *e;
+	int rv;
+
+	if (argc < 2 || argc > 3 ||
+	    (argc == 3 && strcmp(argv[2], "clear") != 0)) {
+		fprintf(stderr, "Usage: %s <fan> [clear]\n", argv[0]);
+		return -1;
+	}
+
+	p.fan_idx = strtol(argv[1], &e, 0);
+	if (e && *e) {
+		fprintf(stderr, "Bad fan index.\n");
+		return -1;
+	}
+
+	if (argc == 3) {
+		p.flags = EC_FAN_PID_TRACE_FLAG_CLEAR;
+		rv = ec_command(EC_CMD_FAN_PID_TRACE, 0, &p, sizeof(p), NULL,
+				0);
+		return rv < 0 ? rv : 0;
+	}
+
+	rv = read_ring_log<struct ec_response_fan_pid_trace>(
+		EC_CMD_FAN_PID_TRACE, p, entries,
+		[](const auto *r) { return r->entries; });
+	if (rv < 0)
+		return rv;
+
+	printf("   time_us target setpoint actual duty\n");
+	for (size_t i = 0; i < entries.size(); i++) {
+		const struct ec_fan_pid_trace_entry *ent = &entries[i];
+
+		printf("%10u %6u %8u %6u %3u%%%s\n", ent->time_us,
+		       ent->target_rpm, ent->setpoint_rpm, ent->actual_rpm,
+		       ent->duty,
+		       ent->flags & EC_FAN_PID_ENTRY_STALLED ? " stalled" : "");
+
+		if (i && ent->target_rpm != entries[i - 1].target_rpm)
+			start = i;
+	}
+
+	if (entries.empty() || !entries.back().target_rpm)
+		return 0;
+
+	/* Summarize the response to the most recent target change */
+	const int target = entries.back().target_rpm;
+
+	for (size_t i = start; i < entries.size(); i++) {
+		peak = std::max<int>(peak, entries[i].actual_rpm);
+		if (abs(entries[i].actual_rpm - target) > target / 50)
+			settled = i + 1;
+	}
+	if (settled < entries.size())
+		printf("Settled within 2%% of %d rpm in %u ms", target,
+		       (entries[settled].time_us - entries[start].time_us) /
+			       1000);
+	else
+		printf("Not settled to %d rpm", target);
+	printf(", overshoot %d rpm\n", std::max(peak - target, 0));
+
+	return 0;
+}
+
 #define LBMSG(state) #state
 #include "lightbar_msg_list.h"
 static const char *const lightbar_cmds[] = { LIGHTBAR_MSG_LIST };
@@ -5754,6 +5881,10 @@ static int cmd_motionsense(int argc, char **argv)
 			printf("unreliable\n");
 		else
 			printf("%d\n", resp->lid_angle.value);
+		/* Older ECs only return the angle. */
+		if (rv >= (int)sizeof(resp->lid_angle))
+			printf("Confidence: %d%%\n",
+			       resp->lid_angle.confidence);
 
 		return 0;
 	}
@@ -6390,6 +6521,119 @@ static void print_pd_power_info(struct ec_response_usb_pd_power_info *r)
 	printf("\n");
 }
 
+/* PD spec tReceiverResponse: time allowed to respond to a message */
+#define PD_T_RECEIVER_RESPONSE_US 15000
+/* PD spec tReceive: time allowed for the GoodCRC of a single attempt */
+#define PD_T_RECEIVE_US 1100
+
+static void print_latency_percentiles(const char *name,
+				      std::vector<uint32_t> &latencies,
+				      uint32_t budget_us)
+{
+	size_t over;
+
+	printf("%s: ", name);
+	if (latencies.empty()) {
+		printf("no samples\n");
+		return;
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	over = latencies.end() - std::upper_bound(latencies.begin(),
+						  latencies.end(), budget_us);
+	printf("n=%zu p50=%u p90=%u p99=%u max=%u us, %zu over %u us\n",
+	       latencies.size(), latencies[latencies.size() * 50 / 100],
+	       latencies[latencies.size() * 90 / 100],
+	       latencies[latencies.size() * 99 / 100], latencies.back(), over,
+	       budget_us);
+}
+
+int cmd_usb_pd_prl_timing(int argc, char *argv[])
+{
+	/* Indexed by enum ec_prl_timing_event */
+	static const char *const event_names[] = {
+		"RX", "TX", "GoodCRC", "TX failed", "TX discard",
+	};
+	struct ec_params_usb_pd_prl_timing p = {};
+	std::vector<struct ec_prl_timing_entry> entries;
+	std::vector<uint32_t> response_us, goodcrc_us;
+	const struct ec_prl_timing_entry *rx = NULL, *tx = NULL;
+	char *e;
+	int rv;
+
+	if (argc < 2 || argc > 3 ||
+	    (argc == 3 && strcmp(argv[2], "clear") != 0)) {
+		fprintf(stderr, "Usage: %s <port> [clear]\n", argv[0]);
+		return -1;
+	}
+
+	p.port = strtol(argv[1], &e, 0);
+	if (e && *e) {
+		fprintf(stderr, "Bad port.\n");
+		return -1;
+	}
+
+	if (argc == 3) {
+		p.flags = EC_PRL_TIMING_FLAG_CLEAR;
+		rv = ec_command(EC_CMD_USB_PD_PRL_TIMING, 0, &p, sizeof(p),
+				NULL, 0);
+		return rv < 0 ? rv : 0;
+	}
+
+	rv = read_ring_log<struct ec_response_usb_pd_prl_timing>(
+		EC_CMD_USB_PD_PRL_TIMING, p, entries,
+		[](const auto *r) { return r->entries; });
+	if (rv < 0)
+		return rv;
+
+	printf("   time_us    delta  event       sop type cnt id\n");
+	for (size_t i = 0; i < entries.size(); i++) {
+		const struct ec_prl_timing_entry *ent = &entries[i];
+		uint32_t delta = i ? ent->time_us - entries[i - 1].time_us : 0;
+
+		printf("%10u %8u  %-10s", ent->time_us, delta,
+		       ent->event < ARRAY_SIZE(event_names) ?
+			       event_names[ent->event] :
+			       "?");
+		if (ent->event == EC_PRL_TIMING_RX ||
+		    ent->event == EC_PRL_TIMING_TX_START)
+			printf("  %3u %4u %3u %2u", ent->sop,
+			       PD_HEADER_TYPE(ent->header),
+			       PD_HEADER_CNT(ent->header),
+			       PD_HEADER_ID(ent->header));
+		printf("\n");
+
+		switch (ent->event) {
+		case EC_PRL_TIMING_RX:
+			rx = ent;
+			break;
+		case EC_PRL_TIMING_TX_START:
+			if (rx && rx->sop == ent->sop)
+				response_us.push_back(ent->time_us -
+						      rx->time_us);
+			rx = NULL;
+			tx = ent;
+			break;
+		case EC_PRL_TIMING_TX_SUCCESS:
+			if (tx)
+				goodcrc_us.push_back(ent->time_us -
+						     tx->time_us);
+			tx = NULL;
+			break;
+		default:
+			tx = NULL;
+			break;
+		}
+	}
+
+	print_latency_percentiles("RX to TX start", response_us,
+				  PD_T_RECEIVER_RESPONSE_US);
+	print_latency_percentiles("TX start to GoodCRC", goodcrc_us,
+				  PD_T_RECEIVE_US);
+
+	return 0;
+}
+
 int cmd_usb_pd_mux_info(int argc, char *argv[])
 {
 	struct ec_params_usb_pd_mux_info p;
@@ -6617,6 +6861,62 @@ int cmd_keyboard_get_config(int argc, char *argv[])
 	return 0;
 }
 
+/* Indexed by enum ec_ocpc_phase */
+static const char *const ocpc_phases[] = { "?", "pre", "cc", "cv_trip",
+					   "cv" };
+
+int cmd_ocpctrace(int argc, char *argv[])
+{
+	struct ec_params_ocpc_trace p = {};
+	struct ec_response_ocpc_trace *r =
+		(struct ec_response_ocpc_trace *)ec_inbuf;
+	std::vector<struct ec_ocpc_trace_entry> entries;
+	int rv;
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "clear") != 0)) {
+		fprintf(stderr, "Usage: %s [clear]\n", argv[0]);
+		return -1;
+	}
+
+	if (argc == 2) {
+		p.flags = EC_OCPC_TRACE_FLAG_CLEAR;
+		rv = ec_command(EC_CMD_OCPC_TRACE, 0, &p, sizeof(p), NULL, 0);
+		return rv < 0 ? rv : 0;
+	}
+
+	rv = read_ring_log<struct ec_response_ocpc_trace>(
+		EC_CMD_OCPC_TRACE, p, entries,
+		[](const auto *r) { return r->entries; });
+	if (rv < 0)
+		return rv;
+
+	if (r->period_ms)
+		printf("Loop period %u ms", r->period_ms);
+	else
+		printf("Loop run by the charger task");
+	printf(", drive limit %u mV, Kp %.4f Ki %.4f Kd %.4f mV/mA\n",
+	       r->drive_limit_mv, r->kp_q16 / 65536.0, r->ki_q16 / 65536.0,
+	       r->kd_q16 / 65536.0);
+
+	printf("   time_us phase   vsys_tgt vsys ibat_tgt  ibat  ibus  error "
+	       "integral   p_mV   i_mV   d_mV\n");
+	for (const auto &e : entries) {
+		printf("%10u %-7s %8u %4u %8u %5d %5u %6d %8d %6d %6d "
+		       "%6d%s%s\n",
+		       e.time_us,
+		       e.phase < ARRAY_SIZE(ocpc_phases) ?
+			       ocpc_phases[e.phase] :
+			       "?",
+		       e.vsys_target_mv, e.vsys_mv, e.ibat_target_ma,
+		       e.ibat_ma, e.ibus_ma, e.error_ma, e.integral, e.p_mv,
+		       e.i_mv, e.d_mv,
+		       e.flags & EC_OCPC_TRACE_ICL_LIMITED ? " icl" : "",
+		       e.flags & EC_OCPC_TRACE_FIRST ? " first" : "");
+	}
+
+	return 0;
+}
+
 int cmd_panic_info(int argc, char *argv[])
 {
 	int rv;
@@ -6695,6 +6995,281 @@ int cmd_power_info(int argc, char *argv[])
 	return 0;
 }
 
+/* Indexed by enum ec_power_trace_state */
+static const char *const power_trace_states[] = { "S0", "suspend", "off" };
+BUILD_ASSERT(ARRAY_SIZE(power_trace_states) == EC_POWER_TRACE_STATE_COUNT);
+
+static int power_trace_print_samples(void)
+{
+	struct ec_params_power_trace p = {};
+	std::vector<struct ec_power_trace_sample> samples;
+	int rv;
+
+	p.cmd = EC_POWER_TRACE_CMD_GET_SAMPLES;
+	rv = read_ring_log<struct ec_response_power_trace_samples>(
+		EC_CMD_POWER_TRACE, p, samples,
+		[](const auto *r) { return r->samples; });
+	if (rv < 0)
+		return rv;
+
+	/* A '*' marks a battery reading repeated from the previous sample */
+	printf("   time_us state    in_mA  vbus_mV  in_mW  bat_mA  bat_mV  "
+	       "bat_mW  bat_age_ms\n");
+	for (const auto &s : samples) {
+		printf("%10u %-7s", s.time_us,
+		       s.state < ARRAY_SIZE(power_trace_states) ?
+			       power_trace_states[s.state] :
+			       "?");
+		if (s.flags & EC_POWER_TRACE_SAMPLE_INPUT)
+			printf(" %7u %8u %6u", s.input_ma, s.vbus_mv,
+			       s.input_ma * s.vbus_mv / 1000);
+		else
+			printf(" %7s %8s %6s", "-", "-", "-");
+		if (s.flags & EC_POWER_TRACE_SAMPLE_BATTERY)
+			printf(" %7d %7u %7d %10u%s", s.battery_ma,
+			       s.battery_mv, s.battery_ma * s.battery_mv / 1000,
+			       s.battery_age_ms,
+			       s.flags & EC_POWER_TRACE_SAMPLE_BATTERY_REPEAT ?
+				       "*" :
+				       "");
+		else
+			printf(" %7s %7s %7s %10s", "-", "-", "-", "-");
+		printf("\n");
+	}
+
+	return 0;
+}
+
+static int power_trace_print_energy(void)
+{
+	struct ec_params_power_trace p = {};
+	struct ec_response_power_trace_energy r;
+	int rv, i;
+
+	p.cmd = EC_POWER_TRACE_CMD_GET_ENERGY;
+	rv = ec_command(EC_CMD_POWER_TRACE, 0, &p, sizeof(p), &r, sizeof(r));
+	if (rv < 0)
+		return rv;
+
+	if (r.period_ms)
+		printf("Sampling every %u ms, %u samples\n", r.period_ms,
+		       r.sample_count);
+	else
+		printf("Sampling stopped, %u samples\n", r.sample_count);
+
+	printf("state         time_ms   in_mJ  in_mW  bat_time_ms   bat_mJ  "
+	       "bat_mW\n");
+	for (i = 0; i < EC_POWER_TRACE_STATE_COUNT; i++) {
+		const struct ec_power_trace_energy *e = &r.state[i];
+
+		printf("%-8s %12u %7u %6u %12u %8d %7d\n",
+		       power_trace_states[i], e->time_ms, e->input_mj,
+		       e->time_ms ? (uint32_t)((uint64_t)e->input_mj * 1000 /
+					       e->time_ms) :
+				    0,
+		       e->battery_time_ms, e->battery_mj,
+		       e->battery_time_ms ?
+			       (int32_t)((int64_t)e->battery_mj * 1000 /
+					 e->battery_time_ms) :
+			       0);
+	}
+
+	return 0;
+}
+
+int cmd_power_trace(int argc, char *argv[])
+{
+	struct ec_params_power_trace p = {};
+	char *e;
+	int rv;
+
+	if (argc == 1) {
+		rv = power_trace_print_samples();
+		return rv < 0 ? rv : power_trace_print_energy();
+	}
+
+	if (!strcmp(argv[1], "energy") && argc == 2)
+		return power_trace_print_energy();
+
+	if (!strcmp(argv[1], "start") && argc == 3) {
+		p.cmd = EC_POWER_TRACE_CMD_SET_PERIOD;
+		p.period_ms = strtol(argv[2], &e, 0);
+		if ((e && *e) || !p.period_ms) {
+			fprintf(stderr, "Bad period.\n");
+			return -1;
+		}
+	} else if (!strcmp(argv[1], "stop") && argc == 2) {
+		p.cmd = EC_POWER_TRACE_CMD_SET_PERIOD;
+		p.period_ms = 0;
+	} else if (!strcmp(argv[1], "clear") && argc == 2) {
+		p.cmd = EC_POWER_TRACE_CMD_CLEAR;
+	} else {
+		fprintf(stderr,
+			"Usage: %s [energy | start <period_ms> | stop | clear]\n",
+			argv[0]);
+		return -1;
+	}
+
+	rv = ec_command(EC_CMD_POWER_TRACE, 0, &p, sizeof(p), NULL, 0);
+	return rv < 0 ? rv : 0;
+}
+
+static int
+power_signal_log_get_stats(std::vector<struct ec_power_signal_log_stats> &stats)
+{
+	struct ec_params_power_signal_log p = {};
+	struct ec_response_power_signal_log_stats *r =
+		(struct ec_response_power_signal_log_stats *)ec_inbuf;
+	int rv;
+
+	p.cmd = EC_POWER_SIGNAL_LOG_CMD_GET_STATS;
+	do {
+		rv = ec_command(EC_CMD_POWER_SIGNAL_LOG, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+		stats.insert(stats.end(), r->stats, r->stats + r->count);
+		p.offset += r->count;
+	} while (r->count && p.offset < r->total);
+
+	return 0;
+}
+
+static std::string power_signal_log_state(
+	const std::vector<struct ec_power_signal_log_stats> &stats,
+	unsigned int state)
+{
+	if (state < stats.size())
+		return std::string(stats[state].name,
+				   strnlen(stats[state].name,
+					   sizeof(stats[state].name)));
+	return "state " + std::to_string(state);
+}
+
+static std::string power_signal_log_signal(std::vector<std::string> &names,
+					   unsigned int signal)
+{
+	struct ec_params_power_signal_log p = {};
+	struct ec_response_power_signal_log_name r;
+
+	if (signal >= names.size())
+		names.resize(signal + 1);
+	if (names[signal].empty()) {
+		p.cmd = EC_POWER_SIGNAL_LOG_CMD_GET_SIGNAL_NAME;
+		p.offset = signal;
+		if (ec_command(EC_CMD_POWER_SIGNAL_LOG, 0, &p, sizeof(p), &r,
+			       sizeof(r)) < 0)
+			names[signal] = "signal " + std::to_string(signal);
+		else
+			names[signal] = std::string(
+				r.name, strnlen(r.name, sizeof(r.name)));
+	}
+
+	return names[signal];
+}
+
+static int power_signal_log_print_events(
+	const std::vector<struct ec_power_signal_log_stats> &stats)
+{
+	struct ec_params_power_signal_log p = {};
+	std::vector<struct ec_power_signal_log_entry> entries;
+	std::vector<std::string> names;
+	uint64_t prev = 0;
+	/* Sequence number of the first entry read, the entries lost */
+	uint32_t lost = 0;
+	int rv;
+
+	p.cmd = EC_POWER_SIGNAL_LOG_CMD_GET_EVENTS;
+	rv = read_ring_log<struct ec_response_power_signal_log_events>(
+		EC_CMD_POWER_SIGNAL_LOG, p, entries,
+		[](const auto *r) { return r->entries; }, &lost);
+	if (rv < 0)
+		return rv;
+
+	if (lost)
+		printf("%u older entries lost\n", lost);
+
+	printf("         time_us    delta_us  signals  event\n");
+	for (const auto &e : entries) {
+		printf("%16" PRIu64 " %+11" PRId64 "  0x%06x  ", e.time_us,
+		       prev ? (int64_t)(e.time_us - prev) : 0, e.signals);
+		prev = e.time_us;
+
+		switch (e.event) {
+		case EC_POWER_SIGNAL_LOG_EDGE:
+			printf("%s => %u\n",
+			       power_signal_log_signal(names, e.id).c_str(),
+			       e.value);
+			break;
+		case EC_POWER_SIGNAL_LOG_WAIT_START:
+			printf("wait for 0x%06x in %s\n", e.signals,
+			       power_signal_log_state(stats, e.id).c_str());
+			break;
+		case EC_POWER_SIGNAL_LOG_WAIT_END:
+			printf("wait %s\n", e.value ? "timed out" : "done");
+			break;
+		case EC_POWER_SIGNAL_LOG_STATE:
+			printf("%s -> %s\n",
+			       power_signal_log_state(stats, e.value).c_str(),
+			       power_signal_log_state(stats, e.id).c_str());
+			break;
+		default:
+			printf("event %u\n", e.event);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static void power_signal_log_print_stats(
+	const std::vector<struct ec_power_signal_log_stats> &stats)
+{
+	printf("state        entered  dwell_min_us  dwell_avg_us  dwell_max_us"
+	       "  waits  timeouts  wait_min_us  wait_avg_us  wait_max_us\n");
+	for (const auto &s : stats) {
+		if (!s.entries && !s.waits)
+			continue;
+		printf("%-10.*s %9u %13u %13u %13u %6u %9u %12u %12u %12u\n",
+		       (int)sizeof(s.name), s.name, s.entries, s.dwell_min_us,
+		       s.dwell_avg_us, s.dwell_max_us, s.waits, s.timeouts,
+		       s.wait_min_us, s.wait_avg_us, s.wait_max_us);
+	}
+}
+
+int cmd_power_signal_log(int argc, char *argv[])
+{
+	struct ec_params_power_signal_log p = {};
+	std::vector<struct ec_power_signal_log_stats> stats;
+	int rv;
+
+	if (argc == 2 && !strcmp(argv[1], "clear")) {
+		p.cmd = EC_POWER_SIGNAL_LOG_CMD_CLEAR;
+		rv = ec_command(EC_CMD_POWER_SIGNAL_LOG, 0, &p, sizeof(p), NULL,
+				0);
+		return rv < 0 ? rv : 0;
+	}
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "stats"))) {
+		fprintf(stderr, "Usage: %s [stats | clear]\n", argv[0]);
+		return -1;
+	}
+
+	rv = power_signal_log_get_stats(stats);
+	if (rv < 0)
+		return rv;
+
+	if (argc == 1) {
+		rv = power_signal_log_print_events(stats);
+		if (rv < 0)
+			return rv;
+		printf("\n");
+	}
+	power_signal_log_print_stats(stats);
+
+	return 0;
+}
+
 int cmd_pse(int argc, char *argv[])
 {
 	struct ec_params_pse p;
@@ -7352,6 +7927,59 @@ int cmd_ext_power_limit(int argc, char *argv[])
 			  0);
 }
 
+/* Indexed by enum ec_chg_ramp_result */
+static const char *const chg_ramp_results[] = { "max", "vbus_low", "oc",
+						"interrupted" };
+
+int cmd_chgramp(int argc, char *argv[])
+{
+	struct ec_params_chg_ramp_history p = {};
+	std::vector<struct ec_chg_ramp_history_entry> entries;
+	char *e;
+	int rv;
+
+	if (argc < 2 || argc > 3 ||
+	    (argc == 3 && strcmp(argv[2], "clear") != 0)) {
+		fprintf(stderr, "Usage: %s <port> [clear]\n", argv[0]);
+		return -1;
+	}
+
+	p.port = strtol(argv[1], &e, 0);
+	if (e && *e) {
+		fprintf(stderr, "Bad port.\n");
+		return -1;
+	}
+
+	if (argc == 3) {
+		p.flags = EC_CHG_RAMP_HISTORY_FLAG_CLEAR;
+		rv = ec_command(EC_CMD_CHG_RAMP_HISTORY, 0, &p, sizeof(p), NULL,
+				0);
+		return rv < 0 ? rv : 0;
+	}
+
+	rv = read_ring_log<struct ec_response_chg_ramp_history>(
+		EC_CMD_CHG_RAMP_HISTORY, p, entries,
+		[](const auto *r) { return r->entries; });
+	if (rv < 0)
+		return rv;
+
+	printf("   time_us supplier method   icl_mA max_mA result      "
+	       "steps duration_ms\n");
+	for (const auto &h : entries) {
+		printf("%10u %8u %-8s %6u %6u %-11s %5u %11u\n", h.time_us,
+		       h.supplier,
+		       h.method == EC_CHG_RAMP_METHOD_SEARCH ? "search" :
+							       "linear",
+		       h.icl_ma, h.max_ma,
+		       h.result < ARRAY_SIZE(chg_ramp_results) ?
+			       chg_ramp_results[h.result] :
+			       "?",
+		       h.steps, h.duration_ms);
+	}
+
+	return 0;
+}
+
 static void cmd_charge_current_limit_help(const char *cmd)
 {
 	fprintf(stderr,
@@ -8863,11 +9491,160 @@ int cmd_board_version(int argc, char *argv[])
 	return rv;
 }
 
+/* Indexed by enum ec_boot_time_stage */
+static const char *const boot_time_stages[] = {
+	"chip_init",	 "i2c_init",   "hook_init_early", "keyboard_init",
+	"verified_boot", "task_start", "hook_init",
+};
+BUILD_ASSERT(ARRAY_SIZE(boot_time_stages) == EC_BOOT_TIME_STAGE_COUNT);
+
+/* Indexed by enum boot_time_param */
+static const char *const boot_time_params[] = {
+	"arail", "rsmrst", "espirst", "pltrst_low", "pltrst_high",
+};
+
+static std::string boot_time_name(const struct ec_boot_time_entry *e)
+{
+	char name[32];
+
+	switch (e->event) {
+	case EC_BOOT_TIME_EVENT_STAGE:
+		if (e->data < ARRAY_SIZE(boot_time_stages))
+			return boot_time_stages[e->data];
+		snprintf(name, sizeof(name), "stage_%u", e->data);
+		break;
+	case EC_BOOT_TIME_EVENT_HOOK_INIT:
+		snprintf(name, sizeof(name), "hook_0x%08x", e->data);
+		break;
+	case EC_BOOT_TIME_EVENT_TASK_START:
+		snprintf(name, sizeof(name), "task_%u", e->data);
+		break;
+	case EC_BOOT_TIME_EVENT_POWER_STATE:
+		snprintf(name, sizeof(name), "power_state_%u", e->data);
+		break;
+	case EC_BOOT_TIME_EVENT_AP_PWRSEQ_STATE:
+		snprintf(name, sizeof(name), "ap_pwrseq_%u", e->data);
+		break;
+	case EC_BOOT_TIME_EVENT_AP:
+		if (e->data < ARRAY_SIZE(boot_time_params))
+			return boot_time_params[e->data];
+		snprintf(name, sizeof(name), "ap_%u", e->data);
+		break;
+	default:
+		snprintf(name, sizeof(name), "event_%u_%u", e->event, e->data);
+		break;
+	}
+	return name;
+}
+
+/*
+ * Print BEGIN/END spans as folded stacks ("a;b;c self_us"), the input format
+ * of flamegraph.pl, and power states as spans lasting until the next one.
+ */
+static void boot_time_print_folded(
+	const std::vector<struct ec_boot_time_entry> &entries)
+{
+	struct frame {
+		const struct ec_boot_time_entry *begin;
+		uint32_t child_us;
+	};
+	std::vector<struct frame> stack;
+	const struct ec_boot_time_entry *state[2] = { NULL, NULL };
+
+	for (const auto &e : entries) {
+		if (e.flags & EC_BOOT_TIME_BEGIN) {
+			stack.push_back({ &e, 0 });
+		} else if (e.flags & EC_BOOT_TIME_END) {
+			std::string path = "ec";
+			uint32_t dur_us;
+
+			if (stack.empty() || stack.back().begin->event != e.event ||
+			    stack.back().begin->data != e.data)
+				continue;
+
+			for (const auto &f : stack)
+				path += ";" + boot_time_name(f.begin);
+			dur_us = e.time_us - stack.back().begin->time_us;
+			printf("%s %u\n", path.c_str(),
+			       dur_us - stack.back().child_us);
+			stack.pop_back();
+			if (!stack.empty())
+				stack.back().child_us += dur_us;
+		} else if (e.event == EC_BOOT_TIME_EVENT_POWER_STATE ||
+			   e.event == EC_BOOT_TIME_EVENT_AP_PWRSEQ_STATE) {
+			const struct ec_boot_time_entry **prev =
+				&state[e.event ==
+				       EC_BOOT_TIME_EVENT_AP_PWRSEQ_STATE];
+
+			if (*prev)
+				printf("power;%s %u\n",
+				       boot_time_name(*prev).c_str(),
+				       e.time_us - (*prev)->time_us);
+			*prev = &e;
+		}
+	}
+}
+
+static int cmd_boottime_profile(int argc, char *argv[])
+{
+	struct ec_params_boot_time_profile p = {};
+	struct ec_response_boot_time_profile *r =
+		(struct ec_response_boot_time_profile *)ec_inbuf;
+	std::vector<struct ec_boot_time_entry> entries;
+	int rv;
+
+	if (argc == 3 && !strcmp(argv[2], "clear")) {
+		p.flags = EC_BOOT_TIME_PROFILE_FLAG_CLEAR;
+		rv = ec_command(EC_CMD_BOOT_TIME_PROFILE, 0, &p, sizeof(p),
+				NULL, 0);
+		return rv < 0 ? rv : 0;
+	}
+
+	do {
+		rv = ec_command(EC_CMD_BOOT_TIME_PROFILE, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+		entries.insert(entries.end(), r->entries,
+			       r->entries + r->count);
+		p.offset += r->count;
+	} while (r->count && p.offset < r->total);
+
+	if (argc == 3 && !strcmp(argv[2], "folded")) {
+		boot_time_print_folded(entries);
+		return 0;
+	}
+
+	printf("   time_us    delta  event\n");
+	for (size_t i = 0; i < entries.size(); i++) {
+		const struct ec_boot_time_entry *e = &entries[i];
+
+		printf("%10u %8u  %s%s\n", e->time_us,
+		       i ? e->time_us - entries[i - 1].time_us : 0,
+		       boot_time_name(e).c_str(),
+		       (e->flags & EC_BOOT_TIME_BEGIN) ? " begin" :
+		       (e->flags & EC_BOOT_TIME_END)   ? " end" :
+							 "");
+	}
+	if (r->dropped)
+		printf("%u events dropped, table full\n", r->dropped);
+
+	return 0;
+}
+
 int cmd_boottime(int argc, char *argv[])
 {
 	struct ec_response_get_boot_time response;
 	int rv;
 
+	if (argc >= 2 && !strcmp(argv[1], "profile") && argc <= 3)
+		return cmd_boottime_profile(argc, argv);
+	if (argc != 1) {
+		fprintf(stderr, "Usage: %s [profile [folded | clear]]\n",
+			argv[0]);
+		return -1;
+	}
+
 	rv = ec_command(EC_CMD_GET_BOOT_TIME, 0, NULL, 0, &response,
 			sizeof(response));
 	if (rv < 0)
@@ -9722,18 +10499,77 @@ static int show_fields(struct ec_mkbp_config *config, int argc, char *argv[])
 	return 0;
 }
 
+/* Indexed by enum ec_kb_latency_path and enum ec_kb_latency_stage */
+static const char *const kb_latency_paths[] = { "8042", "MKBP" };
+static const char *const kb_latency_stages[] = { "queue", "host", "total" };
+
+static int print_kb_latency(void)
+{
+	struct ec_params_keyboard_latency p = {};
+	struct ec_response_keyboard_latency r;
+	char label[16];
+	uint32_t us;
+	int rv, i;
+
+	for (p.path = 0; p.path < EC_KB_LATENCY_PATH_COUNT; p.path++) {
+		rv = ec_command(EC_CMD_KEYBOARD_LATENCY, 0, &p, sizeof(p), &r,
+				sizeof(r));
+		if (rv < 0)
+			return rv;
+
+		printf("%s latency: %u events, %u dropped\n",
+		       kb_latency_paths[p.path], r.events, r.dropped);
+		printf("  stage  mean_us   max_us");
+		for (i = 0; i < EC_KB_LATENCY_BUCKETS; i++) {
+			us = EC_KB_LATENCY_BUCKET_BASE_US << i;
+			if (i == EC_KB_LATENCY_BUCKETS - 1)
+				snprintf(label, sizeof(label), "more");
+			else if (us < 1000)
+				snprintf(label, sizeof(label), "<%uus", us);
+			else
+				snprintf(label, sizeof(label), "<%ums",
+					 us / 1000);
+			printf(" %7s", label);
+		}
+		printf("\n");
+		for (const auto &h : r.stage) {
+			printf("  %-5s %8u %8u",
+			       kb_latency_stages[&h - r.stage], h.mean_us,
+			       h.max_us);
+			for (i = 0; i < EC_KB_LATENCY_BUCKETS; i++)
+				printf(" %7u", h.buckets[i]);
+			printf("\n");
+		}
+	}
+
+	return 0;
+}
+
 static int cmd_kbinfo(int argc, char *argv[])
 {
 	struct ec_params_mkbp_info info = {
 		.info_type = EC_MKBP_INFO_KBD,
 	};
 	struct ec_response_mkbp_info resp;
+	struct ec_params_keyboard_latency p = {};
 	int rv;
 
-	if (argc > 1) {
-		fprintf(stderr, "Too many args\n");
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "clear") != 0)) {
+		fprintf(stderr, "Usage: %s [clear]\n", argv[0]);
 		return -1;
 	}
+
+	if (argc == 2) {
+		p.flags = EC_KB_LATENCY_FLAG_CLEAR;
+		for (p.path = 0; p.path < EC_KB_LATENCY_PATH_COUNT; p.path++) {
+			rv = ec_command(EC_CMD_KEYBOARD_LATENCY, 0, &p,
+					sizeof(p), NULL, 0);
+			if (rv < 0)
+				return rv;
+		}
+		return 0;
+	}
+
 	rv = ec_command(EC_CMD_MKBP_INFO, 0, &info, sizeof(info), &resp,
 			sizeof(resp));
 	if (rv < 0)
@@ -9742,6 +10578,9 @@ static int cmd_kbinfo(int argc, char *argv[])
 	printf("Matrix rows: %d\n", resp.rows);
 	printf("Matrix columns: %d\n", resp.cols);
 
+	if (ec_cmd_version_supported(EC_CMD_KEYBOARD_LATENCY, 0))
+		return print_kb_latency();
+
 	return 0;
 }
 
@@ -12301,7 +13140,9 @@ const struct command commands[] = {
 	  "\n\tRead or write board-specific battery parameter." },
 	{ "bcfg", cmd_battery_config, "\n\tPrint an active battery config." },
 	{ "boardversion", cmd_board_version, "\n\tPrints the board version." },
-	{ "boottime", cmd_boottime, "\n\tGet boot time." },
+	{ "boottime", cmd_boottime,
+	  "[profile [folded | clear]]\n"
+	  "\tGet boot time, or the EC boot time profile." },
 	{ "button", cmd_button,
 	  "[vup|vdown|rec] <Delay-ms>\n\tSimulates button press." },
 	{ "cbi", cmd_cbi, "\n\tGet/Set/Remove Cros Board Info." },
@@ -12318,6 +13159,8 @@ const struct command commands[] = {
 	  "\n\tShow and manipulate chargesplash variables." },
 	{ "chargestate", cmd_charge_state,
 	  "\n\tHandle commands related to charge state v2 (and later)." },
+	{ "chgramp", cmd_chgramp,
+	  "<port> [clear]\n\tPrints or clears the charge ramp history." },
 	{ "chipinfo", cmd_chipinfo, "\n\tPrints chip info." },
 	{ "cmdversions", cmd_cmdversions,
 	  "<cmd>\n\tPrints supported version mask for a command number." },
@@ -12353,6 +13196,8 @@ const struct command commands[] = {
 	  "\n\tSet the maximum external power limit." },
 	{ "fanduty", cmd_fanduty,
 	  "<percent>\n\tForces the fan PWM to a constant duty cycle." },
+	{ "fantrace", cmd_fantrace,
+	  "<fan> [clear]\n\tPrints or clears the fan speed control trace." },
 	{ "flasherase", cmd_flash_erase,
 	  "<offset> <size>\n\tErases EC flash." },
 	{ "flasheraseasync", cmd_flash_erase,
@@ -12433,7 +13278,9 @@ const struct command commands[] = {
 	  "\n\tScan out keyboard if any pins are shorted." },
 	{ "kbgetconfig", cmd_keyboard_get_config,
 	  "\n\tGet keyboard Vivaldi configuration." },
-	{ "kbinfo", cmd_kbinfo, "\n\tDump keyboard matrix dimensions." },
+	{ "kbinfo", cmd_kbinfo,
+	  "[clear]\n\tDump keyboard matrix dimensions and keypress latency,"
+	  "\n\tor clear the latency statistics." },
 	{ "kbpress", cmd_kbpress, "\n\tSimulate key press." },
 	{ "keyconfig", cmd_keyconfig,
 	  "get [<param>] | set [<param>> <value>]\n"
@@ -12463,6 +13310,9 @@ const struct command commands[] = {
 	  "[CMDS]\n"
 	  "\tVarious motion sense control commands." },
 	{ "nextevent", cmd_next_event, "\n\tGet the next pending MKBP event." },
+	{ "ocpctrace", cmd_ocpctrace,
+	  "[clear]\n"
+	  "\tPrints or clears the OCPC charge control loop trace." },
 	{ "panicinfo", cmd_panic_info, "\n\tPrints saved panic info." },
 	{ "pause_in_s5", cmd_s5,
 	  "[on|off]\n"
@@ -12477,6 +13327,9 @@ const struct command commands[] = {
 	  "[suspend|resume|reset|disable|on]\n"
 	  "\tControls the PD chip." },
 	{ "pdctrace", cmd_pdc_trace, cmd_pdc_trace_usage },
+	{ "pdtrace", cmd_usb_pd_prl_timing,
+	  "<port> [clear]\n"
+	  "\tDump PD protocol layer message timing on <port>." },
 	{ "pdgetmode", cmd_pd_get_amode,
 	  "<port>\n"
 	  "\tGet All USB-PD alternate SVIDs and modes on <port>." },
@@ -12493,6 +13346,12 @@ const struct command commands[] = {
 	  "\n\tPrint history of port 80 write." },
 	{ "powerinfo", cmd_power_info,
 	  "\n\tPrints power-related information." },
+	{ "powersiglog", cmd_power_signal_log,
+	  "[stats | clear]\n"
+	  "\tPrints the power signal timeline and wait latencies." },
+	{ "powertrace", cmd_power_trace,
+	  "[energy | start <period_ms> | stop | clear]\n"
+	  "\tPrints or controls the input and battery power trace." },
 	{ "protoinfo", cmd_proto_info,
 	  "\n\tPrints EC host protocol information." },
 	{ "pse", cmd_pse, "\n\tGet and set PoE PSE port power status." },
@@ -8,8 +8,10 @@
 #include "ec_commands.h"
 #include "lb_common.h"
 #include "lightbar.h"
+#include "lightbyte.h"
 
 #include <errno.h>
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -27,6 +29,10 @@ static const char usage[] =
 	"Options:\n"
 	"  -d         Decode binary to ascii\n"
 	"  -v         Decode output should be verbose\n"
+	"  -p MS      Instead of the output, print the LED colors over the\n"
+	"             first MS milliseconds of running the program\n"
+	"  -b LEVEL   Battery level (0-3) seen by the preview, default 3\n"
+	"  -c         The preview sees the battery charging\n"
 	"\n";
 
 /* globals */
@@ -65,11 +71,6 @@ struct safe_lightbar_program {
 	uint8_t zeros[LB_PROG_MAX_OPERANDS];
 } __packed;
 
-#define OP(NAME, BYTES, MNEMONIC) NAME,
-#include "lightbar_opcode_list.h"
-enum lightbyte_opcode { LIGHTBAR_OPCODE_TABLE MAX_OPCODE };
-#undef OP
-
 #define OP(NAME, BYTES, MNEMONIC) BYTES,
 #include "lightbar_opcode_list.h"
 static const int num_operands[] = { LIGHTBAR_OPCODE_TABLE };
@@ -399,6 +400,7 @@ static void compile(FILE *fp, struct safe_lightbar_program *prog)
 	char *s;
 	int line = 0, chopping = 0;
 	uint8_t addr = 0;
+	int bad_addr;
 	int opcode;
 	int wnum, wordcnt;
 	int i;
@@ -578,12 +580,156 @@ static void compile(FILE *fp, struct safe_lightbar_program *prog)
 
 	if (!prog->p.size)
 		Error("input file produced no output bytes\n");
+
+	/* The EC refuses programs its decoder doesn't accept. */
+	if (!hit_errors && lightbyte_decode(&prog->p, NULL, &bad_addr) < 0)
+		Error("invalid instruction or jump target at 0x%02x\n",
+		      bad_addr);
+}
+
+/****************************************************************************/
+/* Preview, running the EC's interpreter on a simulated lightbar and clock */
+
+static struct {
+	uint64_t now_us;
+	uint64_t end_us;
+	int battery_level;
+	int charging;
+	int on;
+	uint8_t brightness;
+	uint8_t rgb[NUM_LEDS][3];
+	/* Whether anything changed since the last line printed */
+	int changed;
+	FILE *fp;
+} sim = { .battery_level = 3 };
+
+void lb_set_rgb(unsigned int led, int red, int green, int blue)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_LEDS; i++) {
+		if (led < NUM_LEDS && i != led)
+			continue;
+		sim.rgb[i][0] = red;
+		sim.rgb[i][1] = green;
+		sim.rgb[i][2] = blue;
+	}
+	sim.changed = 1;
+}
+
+int lb_get_rgb(unsigned int led, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+	if (led >= NUM_LEDS)
+		return EC_RES_INVALID_PARAM;
+
+	*red = sim.rgb[led][0];
+	*green = sim.rgb[led][1];
+	*blue = sim.rgb[led][2];
+	return EC_RES_SUCCESS;
+}
+
+void lb_set_brightness(unsigned int newval)
+{
+	sim.brightness = newval;
+	sim.changed = 1;
+}
+
+uint8_t lb_get_brightness(void)
+{
+	return sim.brightness;
+}
+
+void lb_on(void)
+{
+	sim.on = 1;
+	sim.changed = 1;
+}
+
+void lb_off(void)
+{
+	sim.on = 0;
+	sim.changed = 1;
+}
+
+int lightbyte_battery_level(void)
+{
+	return sim.battery_level;
+}
+
+int lightbyte_is_charging(void)
+{
+	return sim.charging;
+}
+
+uint64_t lightbyte_now(void)
+{
+	return sim.now_us;
+}
+
+static void print_sim_state(void)
+{
+	int i;
+
+	fprintf(sim.fp, "%6" PRIu64 ".%03" PRIu64 " ms  %s %3d ",
+		sim.now_us / 1000, sim.now_us % 1000, sim.on ? "on " : "off",
+		sim.brightness);
+	for (i = 0; i < NUM_LEDS; i++)
+		fprintf(sim.fp, "  %02x%02x%02x", sim.rgb[i][0], sim.rgb[i][1],
+			sim.rgb[i][2]);
+	fprintf(sim.fp, "\n");
+	sim.changed = 0;
+}
+
+uint32_t lightbyte_wait_until(uint64_t t)
+{
+	/* The LEDs show what was set before the wait, so print it now. */
+	if (sim.changed)
+		print_sim_state();
+
+	if (t > sim.now_us)
+		sim.now_us = t;
+
+	return sim.now_us >= sim.end_us;
+}
+
+static void preview(FILE *fp, const struct lightbar_program *prog, int ms)
+{
+	static struct lightbyte_inst code[EC_LB_PROG_LEN];
+	struct lightbyte_vm vm = {};
+	uint32_t rc;
+	int addr;
+
+	vm.code = code;
+	vm.count = lightbyte_decode(prog, code, &addr);
+	if (vm.count < 0) {
+		Error("invalid instruction or jump target at 0x%02x\n", addr);
+		return;
+	}
+
+	sim.fp = fp;
+	sim.end_us = (uint64_t)ms * 1000;
+	/* Set up like the EC does before running a program */
+	lb_on();
+	lb_set_brightness(255);
+
+	fprintf(fp, "# time       on  bri  led0    led1    led2    led3\n");
+	rc = lightbyte_run(&vm);
+	if (sim.changed)
+		print_sim_state();
+
+	if (rc == LIGHTBYTE_FINISHED)
+		fprintf(fp, "# halted at instruction %d\n", vm.pc - 1);
+	else if (sim.now_us >= sim.end_us)
+		fprintf(fp, "# still running at %d ms\n", ms);
+	else
+		Error("program failed at instruction %d\n", vm.pc - 1);
 }
 
 int main(int argc, char *argv[])
 {
 	struct safe_lightbar_program safe_prog;
 	int opt_decode = 0;
+	int opt_preview_ms = 0;
 	int c;
 	int errorcnt = 0;
 	const char *infile, *outfile;
@@ -596,7 +742,7 @@ int main(int argc, char *argv[])
 		progname = argv[0];
 
 	opterr = 0; /* quiet, you */
-	while ((c = getopt(argc, argv, ":dv")) != -1) {
+	while ((c = getopt(argc, argv, ":dvp:b:c")) != -1) {
 		switch (c) {
 		case 'd':
 			opt_decode = 1;
@@ -604,6 +750,20 @@ int main(int argc, char *argv[])
 		case 'v':
 			opt_verbose = 1;
 			break;
+		case 'p':
+			opt_preview_ms = atoi(optarg);
+			if (opt_preview_ms <= 0) {
+				fprintf(stderr, "%s: invalid preview time %s\n",
+					progname, optarg);
+				errorcnt++;
+			}
+			break;
+		case 'b':
+			sim.battery_level = atoi(optarg);
+			break;
+		case 'c':
+			sim.charging = 1;
+			break;
 
 		case '?':
 			fprintf(stderr, "%s: unrecognized switch: -%c\n",
@@ -654,7 +814,17 @@ int main(int argc, char *argv[])
 		ofp = stdout;
 	}
 
-	if (opt_decode) {
+	if (opt_preview_ms) {
+		memset(&safe_prog, 0, sizeof(safe_prog));
+		if (opt_decode)
+			read_binary(ifp, &safe_prog);
+		else
+			compile(ifp, &safe_prog);
+		fclose(ifp);
+		if (!hit_errors)
+			preview(ofp, &safe_prog.p, opt_preview_ms);
+		fclose(ofp);
+	} else if (opt_decode) {
 		read_binary(ifp, &safe_prog);
 		fclose(ifp);
 		if (hit_errors)
@@ -13,6 +13,7 @@
 #include "keyboard_scan.h"
 #include "lpc.h"
 #include "system.h"
+#include "system_boot_time.h"
 #include "usbc/pd_task_intel_altmode.h"
 #include "vboot.h"
 #include "watchdog.h"
@@ -76,9 +77,15 @@ void ec_app_main(void)
 	 * it. Callbacks of this type are expected to handle multiple calls.
 	 */
 	if (IS_ENABLED(CONFIG_PLATFORM_EC_HOOKS)) {
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+			       EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY);
 		hook_notify(HOOK_INIT_EARLY);
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+			       EC_BOOT_TIME_STAGE_HOOK_INIT_EARLY);
 	}
 
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+		       EC_BOOT_TIME_STAGE_KEYBOARD_INIT);
 	if (IS_ENABLED(HAS_TASK_KEYSCAN)) {
 		keyboard_scan_init();
 	}
@@ -87,6 +94,8 @@ void ec_app_main(void)
 	    IS_ENABLED(CONFIG_VOLUME_BUTTONS)) {
 		button_init();
 	}
+	boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+		       EC_BOOT_TIME_STAGE_KEYBOARD_INIT);
 
 	if (IS_ENABLED(CONFIG_PLATFORM_EC_VBOOT_EFS2)) {
 		/*
@@ -95,7 +104,11 @@ void ec_app_main(void)
 		 *   In normal boot, it verifies and jumps to RW.
 		 * For RW, it returns immediately.
 		 */
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+			       EC_BOOT_TIME_STAGE_VERIFIED_BOOT);
 		vboot_main();
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+			       EC_BOOT_TIME_STAGE_VERIFIED_BOOT);
 	}
 
 #ifdef CONFIG_AP_PWRSEQ_DRIVER
@@ -111,7 +124,11 @@ void ec_app_main(void)
 
 	/* Call init hooks before main tasks start */
 	if (IS_ENABLED(CONFIG_PLATFORM_EC_HOOKS)) {
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_BEGIN,
+			       EC_BOOT_TIME_STAGE_HOOK_INIT);
 		hook_notify(HOOK_INIT);
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, EC_BOOT_TIME_END,
+			       EC_BOOT_TIME_STAGE_HOOK_INIT);
 	}
 
 	/*
@@ -131,6 +148,8 @@ void ec_app_main(void)
 
 	/* Start the EC tasks after performing all main initialization */
 	if (IS_ENABLED(CONFIG_SHIMMED_TASKS)) {
+		boot_time_mark(EC_BOOT_TIME_EVENT_STAGE, 0,
+			       EC_BOOT_TIME_STAGE_TASK_START);
 		start_ec_tasks();
 	}
 
@@ -17,6 +17,11 @@ static inline atomic_val_t atomic_clear_bits(atomic_t *addr, atomic_val_t bits)
 	return atomic_and(addr, ~bits);
 }
 
+static inline atomic_val_t atomic_exchange(atomic_t *addr, atomic_val_t value)
+{
+	return atomic_set(addr, value);
+}
+
 #ifdef __cplusplus
 }
 #endif
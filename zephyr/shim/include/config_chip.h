@@ -220,6 +220,11 @@ extern "C" {
 #define CONFIG_HOSTCMD_BATTERY_V2
 #endif
 
+#undef CONFIG_BATTERY_STATIC_INFO_CACHE
+#ifdef CONFIG_PLATFORM_EC_BATTERY_STATIC_INFO_CACHE
+#define CONFIG_BATTERY_STATIC_INFO_CACHE
+#endif
+
 #undef CONFIG_BATTERY_COUNT
 #define CONFIG_BATTERY_COUNT CONFIG_PLATFORM_EC_BATTERY_COUNT
 
@@ -228,6 +233,22 @@ extern "C" {
 #define CONFIG_BATTERY_SMART
 #endif
 
+#undef CONFIG_BATTERY_SMART_POLL_TIERS
+#undef CONFIG_BATTERY_SMART_POLL_MEDIUM_MS
+#undef CONFIG_BATTERY_SMART_POLL_SLOW_MS
+#ifdef CONFIG_PLATFORM_EC_BATTERY_SMART_POLL_TIERS
+#define CONFIG_BATTERY_SMART_POLL_TIERS
+#define CONFIG_BATTERY_SMART_POLL_MEDIUM_MS \
+	CONFIG_PLATFORM_EC_BATTERY_SMART_POLL_MEDIUM_MS
+#define CONFIG_BATTERY_SMART_POLL_SLOW_MS \
+	CONFIG_PLATFORM_EC_BATTERY_SMART_POLL_SLOW_MS
+#endif
+
+#undef CONFIG_BATTERY_BLOCK_READ
+#ifdef CONFIG_PLATFORM_EC_BATTERY_BLOCK_READ
+#define CONFIG_BATTERY_BLOCK_READ
+#endif
+
 #undef CONFIG_I2C_VIRTUAL_BATTERY
 #undef I2C_PORT_VIRTUAL_BATTERY
 #ifdef CONFIG_PLATFORM_EC_I2C_VIRTUAL_BATTERY
@@ -342,6 +363,18 @@ extern "C" {
 	CONFIG_PLATFORM_EC_OCPC_DEF_DRIVELIMIT_MILLIVOLTS
 #endif
 
+#undef CONFIG_OCPC_LOOP_PERIOD_MS
+#ifdef CONFIG_PLATFORM_EC_OCPC_LOOP_PERIOD_MS
+#define CONFIG_OCPC_LOOP_PERIOD_MS CONFIG_PLATFORM_EC_OCPC_LOOP_PERIOD_MS
+#endif
+
+#undef CONFIG_OCPC_TRACE
+#undef CONFIG_OCPC_TRACE_CAPACITY
+#ifdef CONFIG_PLATFORM_EC_OCPC_TRACE
+#define CONFIG_OCPC_TRACE
+#define CONFIG_OCPC_TRACE_CAPACITY CONFIG_PLATFORM_EC_OCPC_TRACE_CAPACITY
+#endif
+
 #undef CONFIG_CHARGER_SINGLE_CHIP
 #ifdef CONFIG_PLATFORM_EC_CHARGER_SINGLE_CHIP
 #define CONFIG_CHARGER_SINGLE_CHIP
@@ -773,6 +806,25 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_FAN_DYNAMIC_CONFIG
 #endif
 
+#undef CONFIG_FAN_PID_CONTROL
+#undef CONFIG_FAN_PID_PERIOD_MS
+#undef CONFIG_FAN_PID_RAMP_RPM_PER_SEC
+#undef CONFIG_FAN_PID_KP
+#undef CONFIG_FAN_PID_KI
+#undef CONFIG_FAN_PID_STALL_MS
+#undef CONFIG_FAN_PID_TRACE_CAPACITY
+#ifdef CONFIG_PLATFORM_EC_FAN_PID_CONTROL
+#define CONFIG_FAN_PID_CONTROL
+#define CONFIG_FAN_PID_PERIOD_MS CONFIG_PLATFORM_EC_FAN_PID_PERIOD_MS
+#define CONFIG_FAN_PID_RAMP_RPM_PER_SEC \
+	CONFIG_PLATFORM_EC_FAN_PID_RAMP_RPM_PER_SEC
+#define CONFIG_FAN_PID_KP CONFIG_PLATFORM_EC_FAN_PID_KP
+#define CONFIG_FAN_PID_KI CONFIG_PLATFORM_EC_FAN_PID_KI
+#define CONFIG_FAN_PID_STALL_MS CONFIG_PLATFORM_EC_FAN_PID_STALL_MS
+#define CONFIG_FAN_PID_TRACE_CAPACITY \
+	CONFIG_PLATFORM_EC_FAN_PID_TRACE_CAPACITY
+#endif
+
 #undef CONFIG_FAN_BYPASS_SLOW_RESPONSE
 #ifdef PLATFORM_EC_FAN_BYPASS_SLOW_RESPONSE
 #define CONFIG_FAN_BYPASS_SLOW_RESPONSE
@@ -810,8 +862,13 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #endif
 
 #undef CONFIG_KEYBOARD_PROTOCOL_8042
+#undef CONFIG_8042_TO_HOST_QUEUE_SIZE
+#undef CONFIG_8042_AUX_QUEUE_SIZE
 #ifdef CONFIG_PLATFORM_EC_KEYBOARD_PROTOCOL_8042
 #define CONFIG_KEYBOARD_PROTOCOL_8042
+#define CONFIG_8042_TO_HOST_QUEUE_SIZE \
+	CONFIG_PLATFORM_EC_8042_TO_HOST_QUEUE_SIZE
+#define CONFIG_8042_AUX_QUEUE_SIZE CONFIG_PLATFORM_EC_8042_AUX_QUEUE_SIZE
 #endif /* CONFIG_PLATFORM_EC_KEYBOARD_PROTOCOL_8042 */
 
 #undef CONFIG_KEYBOARD_PROTOCOL_MKBP
@@ -967,6 +1024,19 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_KEYBOARD_STRICT_DEBOUNCE
 #endif
 
+#undef CONFIG_KEYBOARD_SCAN_INCREMENTAL
+#undef CONFIG_KEYBOARD_SCAN_FULL_INTERVAL
+#ifdef CONFIG_PLATFORM_EC_KEYBOARD_SCAN_INCREMENTAL
+#define CONFIG_KEYBOARD_SCAN_INCREMENTAL
+#define CONFIG_KEYBOARD_SCAN_FULL_INTERVAL \
+	CONFIG_PLATFORM_EC_KEYBOARD_SCAN_FULL_INTERVAL
+#endif
+
+#undef CONFIG_KEYBOARD_LATENCY_STATS
+#ifdef CONFIG_PLATFORM_EC_KEYBOARD_LATENCY_STATS
+#define CONFIG_KEYBOARD_LATENCY_STATS
+#endif
+
 #undef CONFIG_KEYBOARD_BOOT_KEYS
 #ifdef CONFIG_PLATFORM_EC_KEYBOARD_BOOT_KEYS
 #define CONFIG_KEYBOARD_BOOT_KEYS
@@ -977,6 +1047,11 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_KEYBOARD_RUNTIME_KEYS
 #endif
 
+#undef CONFIG_RGBKBD_MAX_FPS
+#ifdef CONFIG_PLATFORM_EC_RGB_KEYBOARD
+#define CONFIG_RGBKBD_MAX_FPS CONFIG_PLATFORM_EC_RGBKBD_MAX_FPS
+#endif
+
 #undef CONFIG_LED_COMMON
 #ifdef CONFIG_PLATFORM_EC_LED_COMMON
 #define CONFIG_LED_COMMON
@@ -1077,6 +1152,13 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_POWER_SLEEP_FAILURE_DETECTION
 #endif
 
+#undef CONFIG_POWER_SIGNAL_LOG
+#undef CONFIG_POWER_SIGNAL_LOG_SIZE
+#ifdef CONFIG_PLATFORM_EC_POWER_SIGNAL_LOG
+#define CONFIG_POWER_SIGNAL_LOG
+#define CONFIG_POWER_SIGNAL_LOG_SIZE CONFIG_PLATFORM_EC_POWER_SIGNAL_LOG_SIZE
+#endif
+
 #undef CONFIG_POWERSEQ_S0IX_COUNTER
 #ifdef CONFIG_PLATFORM_EC_POWERSEQ_S0IX_COUNTER
 #define CONFIG_POWERSEQ_S0IX_COUNTER
@@ -1209,6 +1291,11 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_USB_PD_TCPMV2
 #endif
 
+#undef CONFIG_USB_SM_TRACE
+#ifdef CONFIG_PLATFORM_EC_USB_SM_TRACE
+#define CONFIG_USB_SM_TRACE
+#endif
+
 #undef CONFIG_USB_PD_CONTROLLER
 #ifdef CONFIG_PLATFORM_EC_USB_PD_CONTROLLER
 #define CONFIG_USB_PD_CONTROLLER
@@ -1258,6 +1345,10 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_CHARGE_MANAGER_EXTERNAL_POWER_LIMIT
 #endif
 
+#undef CONFIG_CHARGE_MANAGER_REFRESH_WINDOW_MS
+#define CONFIG_CHARGE_MANAGER_REFRESH_WINDOW_MS \
+	CONFIG_PLATFORM_EC_CHARGE_MANAGER_REFRESH_WINDOW_MS
+
 /* TODO: Put these charger defines in the devicetree? */
 #define CONFIG_CHARGER_SENSE_RESISTOR 10
 #define CONFIG_CHARGER_SENSE_RESISTOR_AC 10
@@ -1273,6 +1364,23 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_CHARGE_STATE_DEBUG
 #endif
 
+#undef CONFIG_CHARGE_STATE_ADAPTIVE_POLL
+#ifdef CONFIG_PLATFORM_EC_CHARGE_STATE_ADAPTIVE_POLL
+#define CONFIG_CHARGE_STATE_ADAPTIVE_POLL
+#endif
+
+#undef CONFIG_POWER_TRACE
+#undef CONFIG_POWER_TRACE_PERIOD_MS
+#undef CONFIG_POWER_TRACE_MIN_PERIOD_MS
+#undef CONFIG_POWER_TRACE_CAPACITY
+#ifdef CONFIG_PLATFORM_EC_POWER_TRACE
+#define CONFIG_POWER_TRACE
+#define CONFIG_POWER_TRACE_PERIOD_MS CONFIG_PLATFORM_EC_POWER_TRACE_PERIOD_MS
+#define CONFIG_POWER_TRACE_MIN_PERIOD_MS \
+	CONFIG_PLATFORM_EC_POWER_TRACE_MIN_PERIOD_MS
+#define CONFIG_POWER_TRACE_CAPACITY CONFIG_PLATFORM_EC_POWER_TRACE_CAPACITY
+#endif
+
 #undef CONFIG_CHARGE_DEBUG
 #ifdef CONFIG_PLATFORM_EC_CHARGE_DEBUG
 #define CONFIG_CHARGE_DEBUG
@@ -1356,6 +1464,19 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_CHARGE_RAMP_HW
 #endif
 
+#undef CONFIG_CHARGE_RAMP_SEARCH
+#ifdef CONFIG_PLATFORM_EC_CHARGE_RAMP_SEARCH
+#define CONFIG_CHARGE_RAMP_SEARCH
+#endif
+
+#undef CONFIG_CHARGE_RAMP_HISTORY
+#undef CONFIG_CHARGE_RAMP_HISTORY_SIZE
+#ifdef CONFIG_PLATFORM_EC_CHARGE_RAMP_HISTORY
+#define CONFIG_CHARGE_RAMP_HISTORY
+#define CONFIG_CHARGE_RAMP_HISTORY_SIZE \
+	CONFIG_PLATFORM_EC_CHARGE_RAMP_HISTORY_SIZE
+#endif
+
 #undef CONFIG_CMD_CHGRAMP
 #ifdef CONFIG_PLATFORM_EC_CONSOLE_CMD_CHGRAMP
 #define CONFIG_CMD_CHGRAMP
@@ -1577,6 +1698,17 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 	CONFIG_PLATFORM_EC_USB_PD_PRL_EVENT_LOG_CAPACITY
 #endif
 
+#undef CONFIG_USB_PD_PRL_TIMING_LOG
+#ifdef CONFIG_PLATFORM_EC_USB_PD_PRL_TIMING_LOG
+#define CONFIG_USB_PD_PRL_TIMING_LOG
+#endif
+
+#undef CONFIG_USB_PD_PRL_TIMING_LOG_CAPACITY
+#ifdef CONFIG_PLATFORM_EC_USB_PD_PRL_TIMING_LOG_CAPACITY
+#define CONFIG_USB_PD_PRL_TIMING_LOG_CAPACITY \
+	CONFIG_PLATFORM_EC_USB_PD_PRL_TIMING_LOG_CAPACITY
+#endif
+
 #undef CONFIG_USBC_OCP
 #ifdef CONFIG_PLATFORM_EC_USBC_OCP
 #define CONFIG_USBC_OCP
@@ -2389,6 +2521,11 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #define CONFIG_ACCEL_FIFO_THRES CONFIG_PLATFORM_EC_ACCEL_FIFO_THRES
 #endif /* CONFIG_PLATFORM_EC_ACCEL_FIFO */
 
+#undef CONFIG_ACCEL_FIFO_BATCH
+#ifdef CONFIG_PLATFORM_EC_ACCEL_FIFO_BATCH
+#define CONFIG_ACCEL_FIFO_BATCH
+#endif /* CONFIG_PLATFORM_EC_ACCEL_FIFO_BATCH */
+
 #undef CONFIG_BODY_DETECTION
 #undef CONFIG_BODY_DETECTION_SENSOR
 #undef CONFIG_BODY_DETECTION_MAX_WINDOW_SIZE
@@ -2486,8 +2623,10 @@ extern char mock_jump_data[CONFIG_PLATFORM_EC_PRESERVED_END_OF_RAM_SIZE];
 #endif
 
 #undef CONFIG_LID_ANGLE
+#undef CONFIG_LID_ANGLE_PUBLISH_MS
 #ifdef CONFIG_PLATFORM_EC_LID_ANGLE
 #define CONFIG_LID_ANGLE
+#define CONFIG_LID_ANGLE_PUBLISH_MS CONFIG_PLATFORM_EC_LID_ANGLE_PUBLISH_MS
 #endif
 
 #undef CONFIG_LID_ANGLE_UPDATE
@@ -2825,6 +2964,14 @@ BUILD_ASSERT((DT_NUM_INST_STATUS_OKAY(maxim_max695x)) == 1,
 #define CONFIG_SYSTEM_UNLOCKED
 #endif
 
+#undef CONFIG_BOOT_TIME_PROFILE
+#undef CONFIG_BOOT_TIME_PROFILE_ENTRIES
+#ifdef CONFIG_PLATFORM_EC_BOOT_TIME_PROFILE
+#define CONFIG_BOOT_TIME_PROFILE
+#define CONFIG_BOOT_TIME_PROFILE_ENTRIES \
+	CONFIG_PLATFORM_EC_BOOT_TIME_PROFILE_ENTRIES
+#endif
+
 #undef CONFIG_CMD_GPIO_EXTENDED
 #ifdef CONFIG_PLATFORM_EC_CMD_GPIO_EXTENDED
 #define CONFIG_CMD_GPIO_EXTENDED
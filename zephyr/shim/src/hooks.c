@@ -8,6 +8,7 @@
 #include "ec_tasks.h"
 #include "hook_types.h"
 #include "hooks.h"
+#include "system_boot_time.h"
 #include "task.h"
 #include "timer.h"
 
@@ -161,8 +162,20 @@ void hook_notify(enum hook_type type)
 		/* Call each handler with the located priority */
 		for (const struct zephyr_shim_hook_info *p = start; p != end;
 		     p++) {
-			if (p->priority == prio)
+			if (p->priority != prio)
+				continue;
+
+			if (type == HOOK_INIT) {
+				boot_time_mark(EC_BOOT_TIME_EVENT_HOOK_INIT,
+					       EC_BOOT_TIME_BEGIN,
+					       (uintptr_t)p->routine);
+				p->routine();
+				boot_time_mark(EC_BOOT_TIME_EVENT_HOOK_INIT,
+					       EC_BOOT_TIME_END,
+					       (uintptr_t)p->routine);
+			} else {
 				p->routine();
+			}
 		}
 	};
 }
@@ -6,6 +6,7 @@
 #include "common.h"
 #include "ec_tasks.h"
 #include "host_command.h"
+#include "system_boot_time.h"
 #include "task.h"
 #include "timer.h"
 #include "zephyr_console_shim.h"
@@ -391,6 +392,7 @@ void start_ec_tasks(void)
 			continue;
 		}
 #endif
+		boot_time_mark(EC_BOOT_TIME_EVENT_TASK_START, 0, i);
 		k_thread_start(task_to_k_tid[i]);
 	}
 
@@ -4,6 +4,7 @@
  */
 
 #include "ap_pwrseq_drv_sm.h"
+#include "system_boot_time.h"
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
@@ -191,6 +192,8 @@ static void ap_pwrseq_thread(void *arg, void *unused1, void *unused2)
 			}
 			LOG_INF("%s -> %s", ap_pwrseq_get_state_str(cur_state),
 				ap_pwrseq_get_state_str(new_state));
+			boot_time_mark(EC_BOOT_TIME_EVENT_AP_PWRSEQ_STATE, 0,
+				       new_state);
 
 			ap_pwrseq_send_exit_callback(dev, new_state, cur_state);
 
@@ -135,6 +135,7 @@ void pwr_sm_set_state(enum power_states_ndsx new_state)
 	LOG_DBG("Power state: %s --> %s",
 		pwr_sm_get_state_name(pwrseq_ctx.power_state),
 		pwr_sm_get_state_name(new_state));
+	boot_time_mark(EC_BOOT_TIME_EVENT_POWER_STATE, 0, new_state);
 	pwrseq_ctx.power_state = new_state;
 }
 
@@ -6,6 +6,8 @@
 #include "test/drivers/stubs.h"
 #include "test/drivers/test_state.h"
 #include "test/drivers/utils.h"
+#include "hooks.h"
+#include "power.h"
 #include "usb_mux.h"
 
 #include <zephyr/ztest.h>
@@ -94,3 +96,33 @@ ZTEST(ap_mux_control, test_set_muxes)
 	zassert_equal(status.mux_state, set_mode,
 		      "Mux set to unexpected state");
 }
+
+ZTEST(ap_mux_control, test_mux_state_after_resume)
+{
+	int i;
+
+	usb_mux_set(USBC_PORT_C0, USB_PD_MUX_DOCK, USB_SWITCH_CONNECT, 0);
+	k_sleep(K_SECONDS(1));
+
+	/* Suspend and let the deferred idle mode entry run */
+	power_set_state(POWER_S3);
+	hook_notify(HOOK_CHIPSET_SUSPEND);
+	hook_notify(HOOK_CHIPSET_SUSPEND_COMPLETE);
+	k_sleep(K_SECONDS(3));
+
+	/*
+	 * Fill the port's mux queue, then resume.  The resume must still be
+	 * applied, and must not displace the queued sets.
+	 */
+	for (i = 0; i < 4; i++)
+		usb_mux_set(USBC_PORT_C0,
+			    (i & 1) ? USB_PD_MUX_DOCK : USB_PD_MUX_USB_ENABLED,
+			    USB_SWITCH_CONNECT, 0);
+	hook_notify(HOOK_CHIPSET_RESUME_INIT);
+	hook_notify(HOOK_CHIPSET_RESUME);
+	power_set_state(POWER_S0);
+	k_sleep(K_SECONDS(1));
+
+	zassert_equal(usb_mux_get(USBC_PORT_C0), USB_PD_MUX_DOCK,
+		      "Mux set to unexpected state after resume");
+}
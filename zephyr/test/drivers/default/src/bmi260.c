@@ -9,6 +9,7 @@
 #include "emul/emul_bmi.h"
 #include "emul/emul_common_i2c.h"
 #include "i2c.h"
+#include "motion_sense.h"
 #include "motion_sense_fifo.h"
 #include "test/drivers/test_mocks.h"
 #include "test/drivers/test_state.h"
@@ -1962,6 +1963,64 @@ ZTEST_USER(bmi260, test_bmi_acc_fifo_stuck)
 		      "Failed to read FIFO in irq handler");
 }
 
+/** Test that a pending flush drains the FIFO, ahead of the flush event */
+ZTEST_USER(bmi260, test_bmi_acc_fifo_drain_on_flush)
+{
+	const struct emul *emul = EMUL_DT_GET(BMI_NODE);
+	struct motion_sensor_t *ms = &motion_sensors[BMI_ACC_SENSOR_ID];
+	struct motion_sensor_t *ms_gyr = &motion_sensors[BMI_GYR_SENSOR_ID];
+	struct ec_response_motion_sensor_data vector;
+	struct bmi_emul_frame f;
+	uint32_t event = BMI_INT_EVENT;
+	bool flushed = false;
+	int samples = 0;
+	uint16_t size;
+
+	bmi_init_emul();
+	ms->oversampling_ratio = 1;
+	ms_gyr->oversampling_ratio = 1;
+	zassert_equal(EC_SUCCESS, ms->drv->set_data_rate(ms, 50000, 0));
+	while (motion_sense_fifo_read(sizeof(vector), 1, &vector, &size))
+		;
+
+	/* A sample below the watermark sets no interrupt status */
+	bmi_emul_set_reg(emul, BMI260_INT_STATUS_0, 0);
+	bmi_emul_set_reg(emul, BMI260_INT_STATUS_1, 0);
+	f.type = BMI_EMUL_FRAME_ACC;
+	f.acc_x = BMI_EMUL_1G / 10;
+	f.acc_y = BMI_EMUL_1G / 20;
+	f.acc_z = -(int)BMI_EMUL_1G / 30;
+	f.next = NULL;
+	bmi_emul_append_frame(emul, &f);
+
+	/* It stays in the sensor FIFO on an interrupt ... */
+	zassert_equal(EC_SUCCESS, ms->drv->irq_handler(ms, &event));
+	zassert_equal(0, motion_sense_fifo_read(sizeof(vector), 1, &vector,
+						&size));
+
+	/* ... but is read when a flush is pending, as the task does it */
+	event |= TASK_EVENT_MOTION_FLUSH_PENDING;
+	zassert_equal(EC_SUCCESS, ms->drv->irq_handler(ms, &event));
+	motion_sense_fifo_insert_async_event(ms, ASYNC_EVENT_FLUSH);
+
+	while (motion_sense_fifo_read(sizeof(vector), 1, &vector, &size)) {
+		if (vector.flags & MOTIONSENSE_SENSOR_FLAG_FLUSH) {
+			flushed = true;
+		} else if (!(vector.flags & MOTIONSENSE_SENSOR_FLAG_TIMESTAMP)) {
+			zassert_false(flushed, "Sample after the flush event");
+			zassert_equal(BMI_ACC_SENSOR_ID, vector.sensor_num);
+			samples++;
+		}
+	}
+	zassert_equal(1, samples);
+	zassert_true(flushed);
+
+	/* With nothing left, a pending flush reads nothing */
+	zassert_equal(EC_SUCCESS, ms->drv->irq_handler(ms, &event));
+	zassert_equal(0, motion_sense_fifo_read(sizeof(vector), 1, &vector,
+						&size));
+}
+
 ZTEST_USER(bmi260, test_unsupported_configs)
 {
 	/*
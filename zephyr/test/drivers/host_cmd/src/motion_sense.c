@@ -954,6 +954,8 @@ ZTEST(host_cmd_motion_sense, test_get_lid_angle)
 
 	zassert_ok(rv, "Got %d", rv);
 	zassert_equal(motion_lid_get_angle(), response.lid_angle.value);
+	zassert_equal(motion_lid_get_confidence(),
+		      response.lid_angle.confidence);
 }
 
 ZTEST(host_cmd_motion_sense, test_tablet_mode_lid_angle)
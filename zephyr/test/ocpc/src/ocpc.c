@@ -173,6 +173,7 @@ ZTEST(ocpc, test_ocpc_config_secondary_charger__fet_disabled)
 
 	/* Try again and we should hit the rate limiter */
 	battery_is_charge_fet_disabled_fake.return_val = false;
+	k_sleep(K_MSEC(CONFIG_OCPC_LOOP_PERIOD_MS));
 
 	zassert_equal(EC_ERROR_BUSY,
 		      ocpc_config_secondary_charger(NULL, NULL, 0, 1000));
@@ -288,6 +289,84 @@ ZTEST(ocpc, test_ocpc_config_secondary_charger__second_loop)
 		      expected_last_error + initial_integral);
 }
 
+ZTEST(ocpc, test_ocpc_trace)
+{
+	int desired_charger_input_current = 2;
+	struct ocpc_data test_ocpc = {
+		/* Non-first run through loop */
+		.last_vsys = 0,
+	};
+	struct ec_params_ocpc_trace params = {
+		.flags = EC_OCPC_TRACE_FLAG_CLEAR,
+	};
+	struct {
+		struct ec_response_ocpc_trace r;
+		struct ec_ocpc_trace_entry entries[4];
+	} response;
+	struct host_cmd_handler_args args =
+		BUILD_HOST_COMMAND(EC_CMD_OCPC_TRACE, 0, response, params);
+
+	zassert_ok(host_command_process(&args));
+
+	charge_set_active_chg_chip(CHARGER_SECONDARY);
+	charger_set_vsys_compensation_fake.return_val = EC_ERROR_UNIMPLEMENTED;
+	zassert_ok(ocpc_config_secondary_charger(&desired_charger_input_current,
+						 &test_ocpc, 10000, 1000));
+
+	params.flags = 0;
+	zassert_ok(host_command_process(&args));
+	zassert_equal(1, response.r.total);
+	zassert_equal(1, response.r.count);
+
+	/* The gains are the default constants in Q16 */
+	zassert_equal((1 << 16) / 4, response.r.kp_q16);
+	zassert_equal((1 << 16) / 15, response.r.ki_q16);
+	zassert_equal((1 << 16) / 10, response.r.kd_q16);
+
+	zassert_equal(test_ocpc.last_error, response.entries[0].error_ma);
+	zassert_equal(test_ocpc.integral, response.entries[0].integral);
+}
+
+ZTEST(ocpc, test_ocpc_loop_period)
+{
+	int desired_charger_input_current = 2;
+	struct ocpc_data test_ocpc = {
+		.last_vsys = OCPC_UNINIT,
+	};
+
+	if (CONFIG_OCPC_LOOP_PERIOD_MS == 0)
+		ztest_test_skip();
+
+	charge_set_active_chg_chip(CHARGER_SECONDARY);
+	charger_set_vsys_compensation_fake.return_val = EC_SUCCESS;
+	zassert_equal(-1, ocpc_loop_next_us());
+
+	/* The first request steps the loop right away */
+	zassert_ok(ocpc_config_secondary_charger(&desired_charger_input_current,
+						 &test_ocpc, 10000, 1000));
+	zassert_equal(1, charger_set_vsys_compensation_fake.call_count);
+
+	/* Within the period, requests only latch the targets */
+	zassert_ok(ocpc_config_secondary_charger(&desired_charger_input_current,
+						 &test_ocpc, 9000, 500));
+	zassert_ok(ocpc_loop_tick(&desired_charger_input_current, &test_ocpc));
+	zassert_equal(1, charger_set_vsys_compensation_fake.call_count);
+	zassert_between_inclusive(ocpc_loop_next_us(), 1,
+				  CONFIG_OCPC_LOOP_PERIOD_MS * USEC_PER_MSEC);
+
+	/* Once due, a tick steps towards the latched targets */
+	k_sleep(K_MSEC(CONFIG_OCPC_LOOP_PERIOD_MS));
+	zassert_equal(0, ocpc_loop_next_us());
+	zassert_ok(ocpc_loop_tick(&desired_charger_input_current, &test_ocpc));
+	zassert_equal(2, charger_set_vsys_compensation_fake.call_count);
+	zassert_equal(500, charger_set_vsys_compensation_fake.arg2_history[1]);
+	zassert_equal(9000, charger_set_vsys_compensation_fake.arg3_history[1]);
+
+	/* Resetting OCPC stops the loop */
+	trigger_ocpc_reset();
+	zassert_equal(-1, ocpc_loop_next_us());
+}
+
 ZTEST(ocpc, test_ocpc_calc_resistances__not_charging)
 {
 	struct ocpc_data test_ocpc;
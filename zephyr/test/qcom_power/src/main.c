@@ -587,6 +587,78 @@ ZTEST(qcom_power, test_chipset_power_on)
 		      power_get_state());
 }
 
+/* The power signal log records the power on, and what each state took. */
+ZTEST(qcom_power, test_power_signal_log)
+{
+	static uint8_t buf[sizeof(struct ec_response_power_signal_log_events) +
+			   CONFIG_POWER_SIGNAL_LOG_SIZE *
+				   sizeof(struct ec_power_signal_log_entry)]
+		__aligned(8);
+	struct ec_response_power_signal_log_events *r = (void *)buf;
+	struct ec_response_power_signal_log_stats *s = (void *)buf;
+	struct ec_params_power_signal_log p = {
+		.cmd = EC_POWER_SIGNAL_LOG_CMD_CLEAR,
+	};
+	struct host_cmd_handler_args args =
+		BUILD_HOST_COMMAND(EC_CMD_POWER_SIGNAL_LOG, 0, buf, p);
+	const struct ec_power_signal_log_entry *state;
+	int waits = 0;
+
+	zassert_ok(host_command_process(&args));
+
+	power_set_state(POWER_G3);
+	k_sleep(K_MSEC(100));
+	chipset_power_on();
+	k_sleep(K_MSEC(500));
+	zassert_equal(power_get_state(), POWER_S0, "power_state=%d",
+		      power_get_state());
+
+	p.cmd = EC_POWER_SIGNAL_LOG_CMD_GET_EVENTS;
+	p.offset = 0;
+	zassert_ok(host_command_process(&args));
+	zassert_true(r->count > 1);
+	zassert_equal(r->count, r->total);
+	zassert_equal(r->first, 0);
+	zassert_equal(args.response_size,
+		      sizeof(*r) + r->count * sizeof(r->entries[0]));
+
+	/* Oldest first: S0 -> G3, then each state follows the previous one */
+	state = &r->entries[0];
+	zassert_equal(state->event, EC_POWER_SIGNAL_LOG_STATE);
+	zassert_equal(state->id, POWER_G3);
+	zassert_equal(state->value, POWER_S0);
+	for (int i = 1; i < r->count; i++) {
+		const struct ec_power_signal_log_entry *e = &r->entries[i];
+
+		zassert_true(e->time_us >= r->entries[i - 1].time_us);
+		if (e->event == EC_POWER_SIGNAL_LOG_STATE) {
+			zassert_equal(e->value, state->id);
+			state = e;
+		} else if (e->event == EC_POWER_SIGNAL_LOG_WAIT_START) {
+			waits++;
+		} else if (e->event == EC_POWER_SIGNAL_LOG_WAIT_END) {
+			zassert_equal(e->value, 0, "wait timed out");
+			waits--;
+		}
+	}
+	zassert_equal(state->id, POWER_S0);
+	zassert_equal(waits, 0);
+
+	/* G3 was entered once and left after the 100 ms sleep */
+	p.cmd = EC_POWER_SIGNAL_LOG_CMD_GET_STATS;
+	p.offset = POWER_G3;
+	zassert_ok(host_command_process(&args));
+	zassert_equal(strcmp(s->stats[0].name, "G3"), 0);
+	zassert_equal(s->stats[0].entries, 1);
+	zassert_true(s->stats[0].dwell_min_us >= 100 * USEC_PER_MSEC);
+	zassert_equal(s->stats[0].dwell_min_us, s->stats[0].dwell_max_us);
+
+	p.offset = POWER_S0;
+	zassert_ok(host_command_process(&args));
+	zassert_equal(strcmp(s->stats[0].name, "S0"), 0);
+	zassert_equal(s->stats[0].entries, 1);
+}
+
 static jmp_buf assert_jumpdata;
 static int num_asserts;
 